@@ -1,6 +1,10 @@
 #include "AuxiliaryFunctions.h"
+#include "Migration.h"
 #include "scai/partitioning/Partitioning.hpp"
+#include <scai/dmemo/CommunicationPlan.hpp>
 #include <numeric>
+#include <map>
+#include <tuple>
 
 
 namespace ITI {
@@ -35,158 +39,22 @@ scai::dmemo::DistributionPtr aux<IndexType,ValueType>::redistributeFromPartition
     //
 
     if( renumberPEs ) {
-        scai::hmemo::ReadAccess<IndexType> rPart( partition.getLocalValues() );
-        //std::map<IndexType,IndexType> blockSizes;
-        //scai::lama::SparseVector<IndexType> blockSizes( numPEs, 0 );
-        std::vector<IndexType> blockSizes( numPEs, 0 );
-        for (IndexType i = 0; i < localN; i++) {
-            blockSizes[ rPart[i] ] += (IndexType) 1;
-        }
-
-        //sort block IDs based on their local size
-        std::vector<IndexType> indices( numPEs );
-        std::iota( indices.begin(), indices.end(), 0);
-        std::sort( indices.begin(), indices.end(), [&](IndexType i1, IndexType i2) {
-            return blockSizes[i1] > blockSizes[i2];
-        });
-        std::sort( blockSizes.begin(), blockSizes.end(), std::greater<IndexType>() ); //sort also block sizes
-
-        SCAI_ASSERT_EQ_ERROR( std::accumulate(indices.begin(), indices.end(), 0), numPEs*(numPEs-1)/2, "wrong indices vector" );//not needed?
-
-        //for profiling/debugging, count the non-zero values, i.e., number of blocks owned by this PE
-        const IndexType numBlocksOwned = std::count_if( blockSizes.begin(), blockSizes.end(), [&](IndexType bSize) {
-            return bSize>0;
-        } );
-        if( settings.debugMode ) {
-            PRINT(*comm<<": owns "<< numBlocksOwned << " blocks");
-        }
-
-        //the claimed PE id and size for the claimed block
-        std::vector<IndexType> allClaimedIDs( numPEs, 0 );
-        std::vector<IndexType> allClaimedSizes( numPEs, 0 );
-        std::vector<IndexType> finalMapping( numPEs, 0 );
-
-        //TODO: check bitset
-        std::vector<bool> mappedPEs ( numPEs, false); //none is mapped
-        std::vector<bool> availableIDs( numPEs, true); //all PE IDs are available to claim
-
-        IndexType preference = 0; //the index of the block I want to claim, start with the first, heaviest block
-
-        while( std::accumulate(mappedPEs.begin(), mappedPEs.end(), 0)!=numPEs ) { //all 1's
-
-            //TODO: send 2-3 claimed indices at once so you have less global sum rounds
-
-            //need to set to 0 because of the global sum
-            allClaimedIDs.assign( numPEs, 0);
-            allClaimedSizes.assign( numPEs, 0);
-
-            //TODO: find a better way to solve this problem
-            //set the ID you claim and its weight
-
-            //if I am already mapped send previous choice
-            if( mappedPEs[thisPE] ) {
-                //set again otherwise the global sum will destroy the old values
-                allClaimedIDs[thisPE] = finalMapping[thisPE]; //the block id that I claim
-                allClaimedSizes[thisPE] = thisPE;  //it does not matter
-            } else {
-                //no point of asking an ID of a block I own nothing
-                while( preference<numBlocksOwned ) {
-                    //if the prefered ID is available
-                    if( availableIDs[ indices[preference] ] ) {
-                        allClaimedIDs[thisPE] = indices[preference]; //the block id that I claim
-                        allClaimedSizes[thisPE] = blockSizes[preference]; //and its weight
-                        break;
-                    } else {
-                        preference++;
-                    }
-                }
-                //TODO: not so great solution, can pick non local blocks
-                //that means that all the block IDs that I want are already taken. pick one ID at random
-                if( preference==numBlocksOwned) {
-                    srand( thisPE*thisPE ); //TODO: do something better here
-                    IndexType ind = rand()%numPEs;
-                    while( not availableIDs[ind] ) {
-                        ind = (ind+1)%numPEs;
-                    }
-                    allClaimedIDs[thisPE] = ind;
-                    allClaimedSizes[thisPE] = thisPE;
-                    PRINT( thisPE <<": all preferences are taken, pick ID " << ind << " at random" );
-                }
-            }
-            SCAI_ASSERT_LE_ERROR( preference, numBlocksOwned, "index out of bounds" );
-
-            //PRINT( thisPE <<": claims ID " << allClaimedIDs[thisPE] << " with size " << allClaimedSizes[thisPE] );
-
-            //global sum to gather all claimed IDs for all PEs
-            comm->sumImpl( allClaimedIDs.data(), allClaimedIDs.data(), numPEs, scai::common::TypeTraits<IndexType>::stype );
-            comm->sumImpl( allClaimedSizes.data(), allClaimedSizes.data(), numPEs, scai::common::TypeTraits<IndexType>::stype );
-
-            //go over the gathered claims and resolve conflicts
-
-            std::vector<IndexType> indicesAfterSum( numPEs );
-            std::iota( indicesAfterSum.begin(), indicesAfterSum.end(), 0);
-            std::sort( indicesAfterSum.begin(), indicesAfterSum.end(),
-            [&](IndexType i1, IndexType i2) {
-                if( allClaimedIDs[i1]==allClaimedIDs[i2] ) {
-                    return allClaimedSizes[i1]<allClaimedSizes[i2];
-                }
-                return allClaimedIDs[i1]<allClaimedIDs[i2];
-            });
-            SCAI_ASSERT_EQ_ERROR( std::accumulate(indicesAfterSum.begin(), indicesAfterSum.end(), 0), numPEs*(numPEs-1)/2, "wrong indices vector" );
-
-            for( IndexType i=0; i<numPEs-1; i++ ) {
-                IndexType index = indicesAfterSum[i]; //go over according to sorting
-                IndexType nextIndex = indicesAfterSum[i+1];
-                //since we sort them, only adjacent claimed IDs can have a conflict
-                if( allClaimedIDs[index]==allClaimedIDs[nextIndex] ) {
-                    // coflict: the last one will be mapped since it has larger size
-                    SCAI_ASSERT_LE_ERROR( allClaimedSizes[index], allClaimedSizes[nextIndex], "for index " << index << "; sorting gonne wrong?");
-                } else {
-                    finalMapping[index] = allClaimedIDs[index];
-                    mappedPEs[index]= true; //this PE got mapped for this round
-                    availableIDs[ allClaimedIDs[index]  ] = false;
-                    //PRINT0( index << ": claims ID " << allClaimedIDs[index] << " with size " << allClaimedSizes[index] );
-                }
-            }//for i<numPEs-1
-
-            {
-                //this way, the last index always takes what it asked for
-                const IndexType lastIndex = indicesAfterSum.back();
-                //PRINT0( lastIndex << ": claims ID " << allClaimedIDs[lastIndex] << " with size " << allClaimedSizes[lastIndex] );
-                finalMapping[lastIndex] = allClaimedIDs[lastIndex];
-                mappedPEs[lastIndex] = true; //this PE got mapped for this round
-                availableIDs[ allClaimedIDs[lastIndex] ] = false;  //ID becomes unavailable
-            }
-
-            //PRINT0("there are " << std::accumulate(mappedPEs.begin(), mappedPEs.end(), 0) << " mapped PEs");
+        const std::vector<IndexType> blockRenumbering = renumberBlocksToPEs( partition, settings );
 
-        }//while //TODO/WARNING:not sure at all that this will always finish
-
-        //here. allClaimedIDs should have the final claimed ID for every PE
-        SCAI_ASSERT_EQ_ERROR( std::accumulate(finalMapping.begin(), finalMapping.end(), 0), numPEs*(numPEs-1)/2, "wrong indices vector" );
-
-        //instead of renumber the PEs, renumber the blocks
-        std::vector<IndexType> blockRenumbering( numPEs ); //this should be k, but the whole functions works only when k=p
-
-        //if every PE got the same ID as the one laready has
+        //go over local partition and renumber if some IDs changes
         bool nothingChanged = true;
-
-        //reverse the renumbering from PEs to blocks: if PE 3 claimed ID 5, then renumber block 5 to 3
-        for( IndexType i=0; i<numPEs; i++) {
-            blockRenumbering[ finalMapping[i] ] = i;
-            //PRINT0("block " << finalMapping[i] << " is mapped to " << i );
-            if( finalMapping[i]!=i )
+        for( IndexType b=0; b<numPEs; b++) {
+            if( blockRenumbering[b]!=b ) {
                 nothingChanged = false;
+                break;
+            }
         }
-
-        //go over local partition and renumber if some IDs changes
         if( not nothingChanged ) {
             scai::hmemo::WriteAccess<IndexType> partAccess( partition.getLocalValues() );
             for( IndexType i=0; i<localN; i++) {
                 partAccess[i] = blockRenumbering[ partAccess[i] ];
             }
         }
-
     }// if( renumberPEs )
 
     if( settings.debugMode ) {
@@ -210,13 +78,16 @@ scai::dmemo::DistributionPtr aux<IndexType,ValueType>::redistributeFromPartition
     scai::dmemo::DistributionPtr distFromPartition;
 
     if( useRedistributor ) {
-        scai::dmemo::RedistributePlan resultRedist = scai::dmemo::redistributePlanByNewOwners(partition.getLocalValues(), partition.getDistributionPtr());
-        distFromPartition = resultRedist.getTargetDistributionPtr();
-        SCAI_ASSERT_EQ_ERROR( partition.getDistribution(), graph.getRowDistribution(), "Distributions do not agree");
-        
-        scai::dmemo::RedistributePlan redistributor = scai::dmemo::redistributePlanByNewDistribution( distFromPartition, graph.getRowDistributionPtr());
-    
-        redistributeInput( redistributor, partition, graph, coordinates, nodeWeights);      
+        // one plan and one packed exchange for all data; afterwards, every PE owns exactly its block
+        std::vector<DenseVector<ValueType>*> valueVectors;
+        for (DenseVector<ValueType>& coords : coordinates) {
+            valueVectors.push_back( &coords );
+        }
+        for (DenseVector<ValueType>& weights : nodeWeights) {
+            valueVectors.push_back( &weights );
+        }
+        distFromPartition = Migration<IndexType,ValueType>::migrateByNewOwners( partition.getLocalValues(), &graph, valueVectors, {} );
+        partition = DenseVector<IndexType>( distFromPartition, thisPE );
     } else {
         // create new distribution from partition
         distFromPartition = scai::dmemo::generalDistributionByNewOwners( partition.getDistribution(), partition.getLocalValues());
@@ -233,6 +104,165 @@ scai::dmemo::DistributionPtr aux<IndexType,ValueType>::redistributeFromPartition
 }//redistributeFromPartition
 //---------------------------------------------------------------------------------------
 
+template<typename IndexType, typename ValueType>
+std::vector<IndexType> aux<IndexType,ValueType>::renumberBlocksToPEs(
+    const DenseVector<IndexType>& partition,
+    const Settings settings,
+    const IndexType numProposals,
+    const IndexType maxRounds ) {
+
+    SCAI_REGION( "aux.renumberBlocksToPEs" )
+
+    const scai::dmemo::CommunicatorPtr comm = partition.getDistributionPtr()->getCommunicatorPtr();
+    const IndexType numPEs = comm->getSize();
+    const IndexType thisPE = comm->getRank();
+    const IndexType localN = partition.getDistributionPtr()->getLocalSize();
+
+    //the local size of every block
+    std::map<IndexType,IndexType> blockSizes;
+    {
+        scai::hmemo::ReadAccess<IndexType> rPart( partition.getLocalValues() );
+        for (IndexType i = 0; i < localN; i++) {
+            SCAI_ASSERT_VALID_INDEX_DEBUG( rPart[i], numPEs, "block id too large" );
+            blockSizes[ rPart[i] ]++;
+        }
+    }
+
+    //
+    // every PE proposes to keep its heaviest local blocks; proposals are sent to the PE with the same id as the block
+    //
+
+    std::vector<std::pair<IndexType,IndexType>> heaviest( blockSizes.begin(), blockSizes.end() );
+    std::sort( heaviest.begin(), heaviest.end(), [](const std::pair<IndexType,IndexType>& a, const std::pair<IndexType,IndexType>& b) {
+        return a.second > b.second or (a.second == b.second and a.first < b.first);
+    });
+    if( IndexType(heaviest.size()) > numProposals ) {
+        heaviest.resize( numProposals );
+    }
+    //communication plans are ordered by PE id
+    std::sort( heaviest.begin(), heaviest.end() );
+
+    const IndexType numMyProposals = heaviest.size();
+    std::vector<IndexType> quantities( numPEs, 0 );
+    std::vector<IndexType> sendSizes( numMyProposals );
+    for (IndexType j = 0; j < numMyProposals; j++) {
+        quantities[ heaviest[j].first ] = 1;
+        sendSizes[j] = heaviest[j].second;
+    }
+    scai::dmemo::CommunicationPlan proposalPlan( quantities.data(), numPEs );
+    scai::dmemo::CommunicationPlan blockPlan = comm->transpose( proposalPlan );
+    const IndexType numReceived = blockPlan.totalQuantity();
+
+    std::vector<IndexType> recvSizes( numReceived );
+    comm->exchangeByPlan( recvSizes.data(), blockPlan, sendSizes.data(), proposalPlan );
+
+    //the proposals for my block, with the proposing PE and its position in the messages, heaviest first
+    std::vector<std::tuple<IndexType,IndexType,IndexType>> proposals;
+    for (IndexType e = 0; e < blockPlan.size(); e++) {
+        const scai::dmemo::CommunicationPlan::Entry entry = blockPlan[e];
+        proposals.push_back( std::make_tuple( recvSizes[entry.offset], entry.partitionId, entry.offset ) );
+    }
+    std::sort( proposals.begin(), proposals.end(), [](const std::tuple<IndexType,IndexType,IndexType>& a, const std::tuple<IndexType,IndexType,IndexType>& b) {
+        return std::get<0>(a) > std::get<0>(b) or (std::get<0>(a) == std::get<0>(b) and std::get<1>(a) < std::get<1>(b));
+    });
+
+    //
+    // matching rounds: every unmatched block offers itself to its heaviest remaining proposer,
+    // every PE accepts the heaviest offer it gets. A rejected offer means that the PE is matched, so it is skipped.
+    // Every round needs two exchanges with the partners of the proposals only and one global sum. A block can have
+    // up to p proposers, so the rounds are capped; the blocks and PEs left over are paired greedily below.
+    //
+
+    IndexType myBlockMatchedTo = -1; //the PE that keeps my block
+    IndexType myPEMatchedTo = -1;    //the block that this PE keeps
+    IndexType nextProposal = 0;
+    IndexType numRounds = 0;
+
+    std::vector<IndexType> offers( numReceived );
+    std::vector<IndexType> recvOffers( numMyProposals );
+    std::vector<IndexType> replies( numMyProposals );
+    std::vector<IndexType> recvReplies( numReceived );
+
+    while( numRounds < maxRounds ) {
+        const bool offering = myBlockMatchedTo == -1 and nextProposal < IndexType(proposals.size());
+        if( comm->sum( IndexType(offering) ) == 0 ) {
+            break;
+        }
+        numRounds++;
+
+        std::fill( offers.begin(), offers.end(), 0 );
+        if( offering ) {
+            offers[ std::get<2>(proposals[nextProposal]) ] = 1;
+        }
+        comm->exchangeByPlan( recvOffers.data(), proposalPlan, offers.data(), blockPlan );
+
+        //accept the heaviest offered block
+        IndexType accepted = -1;
+        if( myPEMatchedTo == -1 ) {
+            for (IndexType j = 0; j < numMyProposals; j++) {
+                if( recvOffers[j] and (accepted == -1 or heaviest[j].second > heaviest[accepted].second) ) {
+                    accepted = j;
+                }
+            }
+        }
+        for (IndexType j = 0; j < numMyProposals; j++) {
+            replies[j] = (j == accepted);
+        }
+        if( accepted != -1 ) {
+            myPEMatchedTo = heaviest[accepted].first;
+        }
+        comm->exchangeByPlan( recvReplies.data(), blockPlan, replies.data(), proposalPlan );
+
+        if( offering ) {
+            if( recvReplies[ std::get<2>(proposals[nextProposal]) ] ) {
+                myBlockMatchedTo = std::get<1>(proposals[nextProposal]);
+            } else {
+                nextProposal++;
+            }
+        }
+    }
+
+    //
+    // gather the matching and assign the remaining PEs and blocks in increasing order
+    //
+
+    std::vector<IndexType> finalMapping( numPEs, 0 );
+    finalMapping[thisPE] = myPEMatchedTo + 1;
+    comm->sumImpl( finalMapping.data(), finalMapping.data(), numPEs, scai::common::TypeTraits<IndexType>::stype );
+
+    std::vector<bool> blockTaken( numPEs, false );
+    for (IndexType pe = 0; pe < numPEs; pe++) {
+        finalMapping[pe]--;
+        if( finalMapping[pe] >= 0 ) {
+            SCAI_ASSERT_ERROR( not blockTaken[finalMapping[pe]], "Block " << finalMapping[pe] << " is kept by two PEs" );
+            blockTaken[ finalMapping[pe] ] = true;
+        }
+    }
+    IndexType nextFreeBlock = 0;
+    for (IndexType pe = 0; pe < numPEs; pe++) {
+        if( finalMapping[pe] < 0 ) {
+            while( blockTaken[nextFreeBlock] ) {
+                nextFreeBlock++;
+            }
+            finalMapping[pe] = nextFreeBlock;
+            blockTaken[nextFreeBlock] = true;
+        }
+    }
+    SCAI_ASSERT_EQ_ERROR( std::accumulate(finalMapping.begin(), finalMapping.end(), 0), numPEs*(numPEs-1)/2, "wrong indices vector" );
+
+    if( settings.debugMode ) {
+        PRINT0("renumbering blocks needed " << numRounds << " matching rounds" );
+    }
+
+    //reverse the renumbering from PEs to blocks: if PE 3 keeps block 5, then renumber block 5 to 3
+    std::vector<IndexType> blockRenumbering( numPEs );
+    for( IndexType i=0; i<numPEs; i++) {
+        blockRenumbering[ finalMapping[i] ] = i;
+    }
+    return blockRenumbering;
+}
+//---------------------------------------------------------------------------------------
+
 template<typename IndexType, typename ValueType>
 void aux<IndexType,ValueType>::redistributeInput(
     const scai::dmemo::DistributionPtr targetDistribution,
@@ -241,20 +271,15 @@ void aux<IndexType,ValueType>::redistributeInput(
     std::vector<DenseVector<ValueType>>& coordinates,
     std::vector<DenseVector<ValueType>>& nodeWeights){
 
-    for (IndexType d=0; d<coordinates.size(); d++) {
-        coordinates[d].redistribute( targetDistribution );
+    std::vector<DenseVector<ValueType>*> valueVectors;
+    for (DenseVector<ValueType>& coords : coordinates) {
+        valueVectors.push_back( &coords );
     }
-
-    for(int w=0; w<nodeWeights.size(); w++){
-        nodeWeights[w].redistribute( targetDistribution );
+    for (DenseVector<ValueType>& weights : nodeWeights) {
+        valueVectors.push_back( &weights );
     }
 
-    //column are not distributed
-    const IndexType globalN = coordinates[0].getDistributionPtr()->getGlobalSize();
-    const scai::dmemo::DistributionPtr noDist(new scai::dmemo::NoDistribution(globalN));
-
-    graph.redistribute( targetDistribution, noDist );
-    partition.redistribute( targetDistribution );
+    Migration<IndexType,ValueType>::migrateToDistribution( targetDistribution, &graph, valueVectors, { &partition } );
 } 
 
 //---------------------------------------------------------------------------------------
@@ -267,21 +292,7 @@ void  aux<IndexType,ValueType>::redistributeInput(
     std::vector<DenseVector<ValueType>>& coordinates,
     std::vector<DenseVector<ValueType>>& nodeWeights){
 
-    for (IndexType d=0; d<coordinates.size(); d++) {
-        coordinates[d].redistribute(redistributor);
-    }
-    for(int w=0; w<nodeWeights.size(); w++){
-        nodeWeights[w].redistribute(redistributor);
-    }
-
-    //column are not distributed
-    const IndexType globalN = coordinates[0].getDistributionPtr()->getGlobalSize();
-    const scai::dmemo::DistributionPtr noDist(new scai::dmemo::NoDistribution(globalN));
-
-    graph.redistribute( redistributor, noDist );
-    partition.redistribute(redistributor);
-    //30/09/19: below is older code that seems wrong
-    //partition = DenseVector<IndexType>( distFromPartition, comm->getRank());
+    redistributeInput( redistributor.getTargetDistributionPtr(), partition, graph, coordinates, nodeWeights );
 } 
 
 //---------------------------------------------------------------------------------------
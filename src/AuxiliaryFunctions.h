@@ -318,7 +318,8 @@ public:
     	@param[out] graph The graph to be redistributed.
     	@param[out] coordinates The coordinates of the graoh to be redistributed.
     	@param[out] nodeWeights The node weights to be redistributed.
-    	@param[in] useRedistributor Flag if we should use or not a redistributor object.
+    	@param[in] useRedistributor If true, the data is moved directly to the new owners; otherwise, the distribution is
+    	created from the partition first and the data is moved to it. Both use one fused migration, see Migration.
     	@param[in] renumberPEs Flag if we should renumber some PE if this reduces the communication volume.
     	@return The distribution pointer of the created distribution.
     **/
@@ -333,6 +334,28 @@ public:
         bool renumberPEs = true );
 
 
+    /** Computes a renumbering of the blocks such that as many vertices as possible stay on their PE when every PE gets the
+    	block with its own id. This is a greedy matching between PEs and blocks, weighted by the number of local vertices:
+    	every PE proposes its numProposals heaviest local blocks, and in every round each unmatched block is offered to its
+    	heaviest remaining proposer, which accepts its heaviest offer. Each round only communicates with the partners of
+    	the proposals plus one global sum. There are at most maxRounds rounds, independent of p; the PEs and blocks that
+    	are still unmatched after them are paired in increasing order at the end.
+
+    	@param[in] partition The partition, with k=p blocks.
+    	@param[in] settings The settings.
+    	@param[in] numProposals How many local blocks every PE proposes to keep.
+    	@param[in] maxRounds The maximum number of matching rounds.
+    	@return For every block, its new id.
+    **/
+    static std::vector<IndexType> renumberBlocksToPEs(
+        const DenseVector<IndexType>& partition,
+        const Settings settings,
+        const IndexType numProposals = 4,
+        const IndexType maxRounds = 8 );
+
+    /** Redistribute the graph, coordinates, node weights and partition to the target distribution with one fused
+        migration, see Migration. The columns of the graph are not distributed afterwards.
+    **/
     static void redistributeInput(
         const scai::dmemo::DistributionPtr targetDistribution,
         scai::lama::DenseVector<IndexType>& partition,
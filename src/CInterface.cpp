@@ -0,0 +1,239 @@
+/*
+ * CInterface.cpp
+ *
+ * C interface to partition a distributed graph in the format used by ParMetis.
+ */
+
+#include <scai/dmemo/GenBlockDistribution.hpp>
+#include <scai/hmemo/ReadAccess.hpp>
+#include <scai/hmemo/WriteAccess.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CInterface.h"
+#include "ParcoRepart.h"
+#include "Settings.h"
+#include "Metrics.h"
+
+using ITI::IndexType;
+typedef geographer_real_t ValueType;
+
+struct geographer_handle_s {
+    ITI::Settings settings;
+    std::vector<geographer_idx_t> vtxdist;          // the vtxdist of the last call
+    scai::dmemo::DistributionPtr dist;              // and the distribution created from it
+    std::string lastError;
+};
+
+namespace {
+
+/** Checks the arguments of this PE. Local operation.
+@return An error message, empty if the arguments are valid. */
+std::string checkInput(const ITI::Settings& settings, const geographer_idx_t* vtxdist, const int ncon, const geographer_real_t* xyz, const geographer_idx_t* sendCounts, const IndexType numPEs) {
+    if (ncon < 1 or xyz == nullptr) {
+        return "at least one weight per vertex and the coordinates are needed";
+    }
+    if (sendCounts != nullptr and settings.numBlocks != numPEs) {
+        return "sendCounts can only be computed if the number of blocks equals the number of PEs";
+    }
+    for (IndexType p = 0; p < numPEs; p++) {
+        if (vtxdist[p+1] < vtxdist[p]) {
+            return "vtxdist must be non-decreasing";
+        }
+    }
+    return "";
+}
+
+/** Creates the distribution, which is reused if vtxdist did not change. */
+void prepareDistribution(geographer_handle handle, const geographer_idx_t* vtxdist, const scai::dmemo::CommunicatorPtr comm) {
+    const IndexType numPEs = comm->getSize();
+
+    if (handle->dist and std::equal(handle->vtxdist.begin(), handle->vtxdist.end(), vtxdist)) {
+        return;
+    }
+
+    std::vector<IndexType> localSizes(numPEs);
+    for (IndexType p = 0; p < numPEs; p++) {
+        localSizes[p] = vtxdist[p+1] - vtxdist[p];
+    }
+    handle->dist = scai::dmemo::genBlockDistributionBySizes(localSizes, comm);
+    handle->vtxdist.assign(vtxdist, vtxdist + numPEs + 1);
+}
+
+} // anonymous namespace
+
+//---------------------------------------------------------------------------------------
+
+extern "C" {
+
+geographer_handle geographer_create(int dimensions, geographer_idx_t numBlocks) {
+    if (dimensions < 1 or numBlocks < 1) {
+        return nullptr;
+    }
+    geographer_handle handle = new geographer_handle_s();
+    handle->settings.dimensions = dimensions;
+    handle->settings.numBlocks = numBlocks;
+    return handle;
+}
+
+void geographer_free(geographer_handle handle) {
+    delete handle;
+}
+
+int geographer_set_epsilon(geographer_handle handle, double epsilon) {
+    if (epsilon < 0) {
+        handle->lastError = "epsilon must not be negative";
+        return GEOGRAPHER_ERROR_INPUT;
+    }
+    handle->settings.epsilon = epsilon;
+    return GEOGRAPHER_OK;
+}
+
+int geographer_set_tool(geographer_handle handle, const char* tool) {
+    std::istringstream in(tool);
+    in >> handle->settings.initialPartition;
+    if (in.fail()) {
+        handle->lastError = std::string("unknown tool ") + tool;
+        return GEOGRAPHER_ERROR_INPUT;
+    }
+    return GEOGRAPHER_OK;
+}
+
+int geographer_set_refinement(geographer_handle handle, int refine) {
+    handle->settings.noRefinement = not refine;
+    return GEOGRAPHER_OK;
+}
+
+int geographer_partition(
+    geographer_handle handle,
+    const geographer_idx_t* vtxdist,
+    const geographer_idx_t* xadj,
+    const geographer_idx_t* adjncy,
+    const geographer_real_t* adjwgt,
+    int ncon,
+    const geographer_real_t* vwgt,
+    const geographer_real_t* xyz,
+    geographer_idx_t* part,
+    geographer_idx_t* sendCounts) {
+
+    SCAI_REGION( "CInterface.geographer_partition" )
+
+    handle->lastError.clear();
+
+    try {
+        const scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+        const IndexType numPEs = comm->getSize();
+        ITI::Settings settings = handle->settings;
+        const IndexType dimensions = settings.dimensions;
+
+        // either all PEs return or none, otherwise the others would wait in the next collective operation
+        const std::string inputError = checkInput(settings, vtxdist, ncon, xyz, sendCounts, numPEs);
+        if (comm->any(not inputError.empty())) {
+            handle->lastError = inputError.empty() ? "invalid input on another PE" : inputError;
+            return GEOGRAPHER_ERROR_INPUT;
+        }
+
+        prepareDistribution(handle, vtxdist, comm);
+        const scai::dmemo::DistributionPtr dist = handle->dist;
+        const IndexType globalN = dist->getGlobalSize();
+        const IndexType localN = dist->getLocalSize();
+        const IndexType localM = xadj[localN] - xadj[0];
+
+        //
+        // build the graph; every array of the caller is copied exactly once, into the memory owned by LAMA
+        //
+
+        scai::hmemo::HArray<IndexType> ia(localN+1);
+        scai::hmemo::HArray<IndexType> ja(localM);
+        scai::hmemo::HArray<ValueType> values(localM);
+        {
+            scai::hmemo::WriteOnlyAccess<IndexType> wIA(ia, localN+1);
+            scai::hmemo::WriteOnlyAccess<IndexType> wJA(ja, localM);
+            scai::hmemo::WriteOnlyAccess<ValueType> wValues(values, localM);
+            for (IndexType i = 0; i <= localN; i++) {
+                wIA[i] = xadj[i] - xadj[0];
+            }
+            IndexType numInvalid = 0;
+            #pragma omp parallel for reduction(+:numInvalid)
+            for (IndexType e = 0; e < localM; e++) {
+                const geographer_idx_t neighbor = adjncy[xadj[0] + e];
+                numInvalid += (neighbor < 0 or neighbor >= globalN);
+                wJA[e] = neighbor;
+                wValues[e] = adjwgt == nullptr ? 1 : adjwgt[xadj[0] + e];
+            }
+            if (comm->sum(numInvalid) > 0) {
+                handle->lastError = "adjncy contains invalid vertex ids";
+                return GEOGRAPHER_ERROR_INPUT;
+            }
+        }
+        scai::lama::CSRSparseMatrix<ValueType> graph(dist, scai::lama::CSRStorage<ValueType>(localN, globalN, std::move(ia), std::move(ja), std::move(values)));
+
+        //
+        // coordinates and weights are given interleaved, one vector per dimension and weight is needed
+        //
+
+        std::vector<scai::lama::DenseVector<ValueType>> coordinates(dimensions);
+        for (IndexType d = 0; d < dimensions; d++) {
+            scai::hmemo::HArray<ValueType> localCoords(localN);
+            {
+                scai::hmemo::WriteOnlyAccess<ValueType> wCoords(localCoords, localN);
+                #pragma omp parallel for
+                for (IndexType i = 0; i < localN; i++) {
+                    wCoords[i] = xyz[i*dimensions + d];
+                }
+            }
+            coordinates[d] = scai::lama::DenseVector<ValueType>(dist, std::move(localCoords));
+        }
+
+        std::vector<scai::lama::DenseVector<ValueType>> nodeWeights(ncon);
+        for (IndexType c = 0; c < ncon; c++) {
+            if (vwgt == nullptr) {
+                nodeWeights[c] = scai::lama::DenseVector<ValueType>(dist, 1);
+                continue;
+            }
+            scai::hmemo::HArray<ValueType> localWeights(localN);
+            {
+                scai::hmemo::WriteOnlyAccess<ValueType> wWeights(localWeights, localN);
+                #pragma omp parallel for
+                for (IndexType i = 0; i < localN; i++) {
+                    wWeights[i] = vwgt[i*ncon + c];
+                }
+            }
+            nodeWeights[c] = scai::lama::DenseVector<ValueType>(dist, std::move(localWeights));
+        }
+        settings.numNodeWeights = ncon;
+
+        //
+        // partition and return the result in the distribution of the caller
+        //
+
+        ITI::Metrics<ValueType> metrics(settings);
+        scai::lama::DenseVector<IndexType> partition = ITI::ParcoRepart<IndexType, ValueType>::partitionGraph(graph, coordinates, nodeWeights, comm, settings, metrics);
+        partition.redistribute(dist);
+
+        scai::hmemo::ReadAccess<IndexType> rPart(partition.getLocalValues());
+        for (IndexType i = 0; i < localN; i++) {
+            part[i] = rPart[i];
+        }
+        if (sendCounts != nullptr) {
+            std::fill(sendCounts, sendCounts + numPEs, 0);
+            for (IndexType i = 0; i < localN; i++) {
+                sendCounts[rPart[i]]++;
+            }
+        }
+    } catch (const std::exception& e) {
+        handle->lastError = e.what();
+        return GEOGRAPHER_ERROR;
+    }
+
+    return GEOGRAPHER_OK;
+}
+
+const char* geographer_last_error(geographer_handle handle) {
+    return handle->lastError.c_str();
+}
+
+} // extern "C"
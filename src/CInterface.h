@@ -0,0 +1,80 @@
+/*
+ * CInterface.h
+ *
+ * C interface to partition a distributed graph in the format used by ParMetis.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Vertex ids, offsets and block ids. */
+typedef int64_t geographer_idx_t;
+/** Coordinates and weights. */
+typedef double geographer_real_t;
+
+/** Return codes. */
+#define GEOGRAPHER_OK 0
+#define GEOGRAPHER_ERROR_INPUT 1
+#define GEOGRAPHER_ERROR 2
+
+/** @brief A persistent partitioner: the settings and the distribution of the input are kept between calls,
+so repeated calls with the same vtxdist, e.g., in every time step of a simulation, do not rebuild them.
+All calls are collective over the default communicator of LAMA.
+*/
+typedef struct geographer_handle_s* geographer_handle;
+
+/** Creates a handle to partition a graph with coordinates of the given dimension into numBlocks blocks.
+Returns NULL on failure. */
+geographer_handle geographer_create(int dimensions, geographer_idx_t numBlocks);
+
+/** Releases all memory of the handle. */
+void geographer_free(geographer_handle handle);
+
+/** Sets the maximum allowed imbalance, e.g., 0.03 for 3%. */
+int geographer_set_epsilon(geographer_handle handle, double epsilon);
+
+/** Sets the algorithm used for the partition, as named by the --initialPartition option, e.g., "geoKmeans" or "geoSFC". */
+int geographer_set_tool(geographer_handle handle, const char* tool);
+
+/** Enables (1) or disables (0) the multilevel refinement with the graph. */
+int geographer_set_refinement(geographer_handle handle, int refine);
+
+/** @brief Partitions a distributed graph with coordinates and node weights. Collective operation.
+
+    The local vertices of this PE are vtxdist[rank] to vtxdist[rank+1]-1; localN denotes their number.
+
+    @param[in] vtxdist Size numPEs+1, the prefix sum of the number of vertices per PE; must be equal on all PEs.
+    @param[in] xadj Size localN+1, the offsets of the neighbors of every local vertex in adjncy.
+    @param[in] adjncy The global ids of the neighbors.
+    @param[in] adjwgt The weights of the edges in the same order as adjncy, or NULL for unit weights.
+    @param[in] ncon The number of weights per vertex.
+    @param[in] vwgt Size ncon*localN, the weights of vertex i are vwgt[i*ncon],...,vwgt[i*ncon+ncon-1]; or NULL for unit weights.
+    @param[in] xyz Size dimensions*localN, the coordinates of vertex i are xyz[i*dimensions],...,xyz[i*dimensions+dimensions-1].
+    @param[out] part Size localN, the block of every local vertex, in the original order.
+    @param[out] sendCounts Can be NULL. Otherwise, size numPEs: the number of local vertices that move to every PE if
+        block b is assigned to PE b. Only allowed if numBlocks equals the number of PEs.
+    @return GEOGRAPHER_OK on success, GEOGRAPHER_ERROR_INPUT for invalid input and GEOGRAPHER_ERROR if the partitioning failed.
+*/
+int geographer_partition(
+    geographer_handle handle,
+    const geographer_idx_t* vtxdist,
+    const geographer_idx_t* xadj,
+    const geographer_idx_t* adjncy,
+    const geographer_real_t* adjwgt,
+    int ncon,
+    const geographer_real_t* vwgt,
+    const geographer_real_t* xyz,
+    geographer_idx_t* part,
+    geographer_idx_t* sendCounts);
+
+/** The message of the last error of this handle, or an empty string. */
+const char* geographer_last_error(geographer_handle handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,219 @@
+#include <scai/lama.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "CInterface.h"
+
+namespace ITI {
+
+class CInterfaceTest : public ::testing::Test {
+protected:
+    /** The local part of an a x b grid graph in the arrays of the C interface. PE p owns the vertices
+        vtxdist[p] to vtxdist[p+1]-1; the edges along the x axis have weight 2, the others weight 1.
+        Every vertex has two weights, 1 and 1+x, and the coordinates are interleaved. */
+    struct LocalGraph {
+        std::vector<geographer_idx_t> xadj;
+        std::vector<geographer_idx_t> adjncy;
+        std::vector<geographer_real_t> adjwgt;
+        std::vector<geographer_real_t> vwgt;
+        std::vector<geographer_real_t> xyz;
+    };
+
+    LocalGraph createLocalGrid(const geographer_idx_t a, const geographer_idx_t b, const std::vector<geographer_idx_t>& vtxdist, const IndexType rank) {
+        LocalGraph local;
+        local.xadj.push_back(0);
+        for (geographer_idx_t v = vtxdist[rank]; v < vtxdist[rank+1]; v++) {
+            const geographer_idx_t x = v / b;
+            const geographer_idx_t y = v % b;
+            if (x > 0) {
+                local.adjncy.push_back(v - b);
+                local.adjwgt.push_back(2);
+            }
+            if (x+1 < a) {
+                local.adjncy.push_back(v + b);
+                local.adjwgt.push_back(2);
+            }
+            if (y > 0) {
+                local.adjncy.push_back(v - 1);
+                local.adjwgt.push_back(1);
+            }
+            if (y+1 < b) {
+                local.adjncy.push_back(v + 1);
+                local.adjwgt.push_back(1);
+            }
+            local.xadj.push_back(local.adjncy.size());
+            local.vwgt.push_back(1);
+            local.vwgt.push_back(1 + x);
+            local.xyz.push_back(x);
+            local.xyz.push_back(y);
+        }
+        return local;
+    }
+
+    /** The vtxdist of an uneven distribution, the share of PE p is (p+shift)%numPEs+1. */
+    std::vector<geographer_idx_t> getUnevenVtxdist(const geographer_idx_t n, const IndexType numPEs, const IndexType shift) {
+        std::vector<geographer_idx_t> shares(numPEs);
+        for (IndexType p = 0; p < numPEs; p++) {
+            shares[p] = (p + shift) % numPEs + 1;
+        }
+        const geographer_idx_t totalShares = std::accumulate(shares.begin(), shares.end(), geographer_idx_t(0));
+        std::vector<geographer_idx_t> vtxdist(numPEs+1, 0);
+        for (IndexType p = 0; p < numPEs; p++) {
+            vtxdist[p+1] = vtxdist[p] + n*shares[p]/totalShares;
+        }
+        vtxdist[numPEs] = n;
+        return vtxdist;
+    }
+
+    /** The weighted cut of the local part with the global partition. */
+    geographer_real_t getLocalCut(const LocalGraph& local, const std::vector<geographer_idx_t>& vtxdist, const IndexType rank, const std::vector<geographer_idx_t>& globalPart) {
+        geographer_real_t cut = 0;
+        const geographer_idx_t localN = vtxdist[rank+1] - vtxdist[rank];
+        for (geographer_idx_t i = 0; i < localN; i++) {
+            for (geographer_idx_t e = local.xadj[i]; e < local.xadj[i+1]; e++) {
+                if (globalPart[vtxdist[rank] + i] != globalPart[local.adjncy[e]]) {
+                    cut += local.adjwgt[e];
+                }
+            }
+        }
+        return cut;
+    }
+};
+
+//-----------------------------------------------------------------
+
+TEST_F(CInterfaceTest, testPartitionRoundTrip) {
+    const scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType numPEs = comm->getSize();
+    const IndexType rank = comm->getRank();
+    const geographer_idx_t a = 40;
+    const geographer_idx_t b = 30;
+    const geographer_idx_t n = a*b;
+    const int ncon = 2;
+
+    const std::vector<geographer_idx_t> vtxdist = getUnevenVtxdist(n, numPEs, 0);
+    const LocalGraph local = createLocalGrid(a, b, vtxdist, rank);
+    const geographer_idx_t localN = vtxdist[rank+1] - vtxdist[rank];
+
+    geographer_handle handle = geographer_create(2, numPEs);
+    ASSERT_NE( handle, nullptr );
+    ASSERT_EQ( geographer_set_epsilon(handle, 0.05), GEOGRAPHER_OK );
+    ASSERT_EQ( geographer_set_tool(handle, "geoKmeans"), GEOGRAPHER_OK );
+
+    std::vector<geographer_idx_t> part(localN, -1);
+    std::vector<geographer_idx_t> sendCounts(numPEs, -1);
+    const int status = geographer_partition(handle, vtxdist.data(), local.xadj.data(), local.adjncy.data(), local.adjwgt.data(),
+                                            ncon, local.vwgt.data(), local.xyz.data(), part.data(), sendCounts.data());
+    ASSERT_EQ( status, GEOGRAPHER_OK ) << geographer_last_error(handle);
+    EXPECT_STREQ( geographer_last_error(handle), "" );
+
+    // the blocks are valid and sendCounts counts them
+    std::vector<geographer_idx_t> counts(numPEs, 0);
+    for (geographer_idx_t i = 0; i < localN; i++) {
+        ASSERT_GE( part[i], 0 );
+        ASSERT_LT( part[i], numPEs );
+        counts[part[i]]++;
+    }
+    EXPECT_EQ( counts, sendCounts );
+
+    // the result is in the order of the caller: a geometric partition of the grid has a small cut only then
+    std::vector<geographer_idx_t> globalPart(n, 0);
+    std::copy(part.begin(), part.end(), globalPart.begin() + vtxdist[rank]);
+    comm->sumImpl( globalPart.data(), globalPart.data(), n, scai::common::TypeTraits<geographer_idx_t>::stype );
+    const geographer_real_t cut = comm->sum(getLocalCut(local, vtxdist, rank, globalPart)) / 2;
+    const geographer_real_t totalEdgeWeight = comm->sum(std::accumulate(local.adjwgt.begin(), local.adjwgt.end(), geographer_real_t(0))) / 2;
+    EXPECT_LE( cut, 0.25*totalEdgeWeight );
+
+    // the first weight is balanced
+    std::vector<geographer_real_t> blockWeights(numPEs, 0);
+    for (geographer_idx_t v = 0; v < n; v++) {
+        blockWeights[globalPart[v]] += 1;
+    }
+    EXPECT_LE( *std::max_element(blockWeights.begin(), blockWeights.end()), 1.2*n/numPEs );
+
+    geographer_free(handle);
+}
+//-----------------------------------------------------------------
+
+TEST_F(CInterfaceTest, testHandleReuse) {
+    const scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType numPEs = comm->getSize();
+    const IndexType rank = comm->getRank();
+    const geographer_idx_t a = 30;
+    const geographer_idx_t b = 30;
+    const geographer_idx_t n = a*b;
+    const geographer_idx_t k = 2*numPEs;
+
+    geographer_handle handle = geographer_create(2, k);
+    ASSERT_NE( handle, nullptr );
+    ASSERT_EQ( geographer_set_tool(handle, "geoSFC"), GEOGRAPHER_OK );
+    ASSERT_EQ( geographer_set_refinement(handle, 0), GEOGRAPHER_OK );
+
+    // two calls with the same distribution give the same result, the third uses another distribution
+    std::vector<std::vector<geographer_idx_t>> globalParts;
+    for (const IndexType shift : {0, 0, 1}) {
+        const std::vector<geographer_idx_t> vtxdist = getUnevenVtxdist(n, numPEs, shift);
+        const LocalGraph local = createLocalGrid(a, b, vtxdist, rank);
+        const geographer_idx_t localN = vtxdist[rank+1] - vtxdist[rank];
+
+        std::vector<geographer_idx_t> part(localN, -1);
+        const int status = geographer_partition(handle, vtxdist.data(), local.xadj.data(), local.adjncy.data(), nullptr,
+                                                1, nullptr, local.xyz.data(), part.data(), nullptr);
+        ASSERT_EQ( status, GEOGRAPHER_OK ) << geographer_last_error(handle);
+
+        std::vector<geographer_idx_t> globalPart(n, 0);
+        std::copy(part.begin(), part.end(), globalPart.begin() + vtxdist[rank]);
+        comm->sumImpl( globalPart.data(), globalPart.data(), n, scai::common::TypeTraits<geographer_idx_t>::stype );
+        globalParts.push_back(globalPart);
+    }
+    EXPECT_EQ( globalParts[0], globalParts[1] );
+    EXPECT_GE( *std::min_element(globalParts[2].begin(), globalParts[2].end()), 0 );
+    EXPECT_LT( *std::max_element(globalParts[2].begin(), globalParts[2].end()), k );
+
+    // sendCounts needs k=p, the error is returned on all PEs
+    {
+        const std::vector<geographer_idx_t> vtxdist = getUnevenVtxdist(n, numPEs, 0);
+        const LocalGraph local = createLocalGrid(a, b, vtxdist, rank);
+        std::vector<geographer_idx_t> part(vtxdist[rank+1] - vtxdist[rank]);
+        std::vector<geographer_idx_t> sendCounts(numPEs);
+        EXPECT_EQ( GEOGRAPHER_ERROR_INPUT, geographer_partition(handle, vtxdist.data(), local.xadj.data(), local.adjncy.data(), nullptr,
+                   1, nullptr, local.xyz.data(), part.data(), sendCounts.data()) );
+        EXPECT_STRNE( geographer_last_error(handle), "" );
+    }
+
+    geographer_free(handle);
+}
+//-----------------------------------------------------------------
+
+TEST_F(CInterfaceTest, testInvalidInputOnOnePE) {
+    const scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType numPEs = comm->getSize();
+    const IndexType rank = comm->getRank();
+    const geographer_idx_t a = 20;
+    const geographer_idx_t b = 20;
+
+    const std::vector<geographer_idx_t> vtxdist = getUnevenVtxdist(a*b, numPEs, 0);
+    const LocalGraph local = createLocalGrid(a, b, vtxdist, rank);
+    std::vector<geographer_idx_t> part(vtxdist[rank+1] - vtxdist[rank]);
+
+    geographer_handle handle = geographer_create(2, numPEs);
+    ASSERT_NE( handle, nullptr );
+
+    // only the last PE passes no coordinates; all PEs must return instead of waiting for it
+    const geographer_real_t* xyz = rank == numPEs-1 ? nullptr : local.xyz.data();
+    const int status = geographer_partition(handle, vtxdist.data(), local.xadj.data(), local.adjncy.data(), nullptr,
+                                            1, nullptr, xyz, part.data(), nullptr);
+    EXPECT_EQ( status, GEOGRAPHER_ERROR_INPUT );
+    EXPECT_STRNE( geographer_last_error(handle), "" );
+
+    // the handle is still usable
+    EXPECT_EQ( GEOGRAPHER_OK, geographer_partition(handle, vtxdist.data(), local.xadj.data(), local.adjncy.data(), nullptr,
+               1, nullptr, local.xyz.data(), part.data(), nullptr) ) << geographer_last_error(handle);
+
+    geographer_free(handle);
+}
+
+} //namespace ITI
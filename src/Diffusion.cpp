@@ -7,10 +7,12 @@
 #include <assert.h>
 #include <vector>
 #include <random>
+#include <algorithm>
 
 #include <scai/hmemo/ReadAccess.hpp>
 #include <scai/hmemo/WriteAccess.hpp>
 #include <scai/solver.hpp>
+#include <scai/tracing.hpp>
 
 #include "Diffusion.h"
 
@@ -94,6 +96,7 @@ DenseVector<ValueType> Diffusion<IndexType, ValueType>::potentialsFromSource(con
 
 template<typename IndexType, typename ValueType>
 DenseMatrix<ValueType> Diffusion<IndexType, ValueType>::multiplePotentials(const scai::lama::CSRSparseMatrix<ValueType>& laplacian, const scai::lama::DenseVector<ValueType>& nodeWeights, const std::vector<IndexType>& sources, ValueType eps) {
+    SCAI_REGION( "Diffusion.multiplePotentials" )
     using scai::hmemo::HArray;
 
     if (!laplacian.getRowDistributionPtr()->isReplicated() or !nodeWeights.getDistributionPtr()->isReplicated()) {
@@ -101,27 +104,150 @@ DenseMatrix<ValueType> Diffusion<IndexType, ValueType>::multiplePotentials(const
     }
 
     const IndexType l = sources.size();
-    [[maybe_unused]] const IndexType n = laplacian.getNumRows();
+    const IndexType n = laplacian.getNumRows();
     const IndexType localN = laplacian.getLocalNumRows();
-
-    HArray<ValueType> resultContainer(localN*l);
-    IndexType offset = 0;
+    assert(localN == n);
 
     scai::dmemo::DistributionPtr dist(laplacian.getRowDistributionPtr());
     scai::dmemo::DistributionPtr lDist(new scai::dmemo::NoDistribution(l));
 
-    //get potentials and copy them into common vector
-    for (IndexType landmark : sources) {
-        DenseVector<ValueType> potentials = potentialsFromSource(laplacian, nodeWeights, landmark, eps);
-        assert(potentials.size() == n);
+    // All systems L*x_j = d_j are solved together with a preconditioned CG per right hand side that shares
+    // the matrix traversal, i.e., one sparse matrix times dense block product per iteration instead of l SpMVs.
+    // Blocks are stored row-major: entry (i,j) of a block is at i*l+j.
+
+    const ValueType weightSum = nodeWeights.sum();
+
+    const scai::lama::CSRStorage<ValueType>& localStorage = laplacian.getLocalStorage();
+    ReadAccess<IndexType> ia(localStorage.getIA());
+    ReadAccess<IndexType> ja(localStorage.getJA());
+    ReadAccess<ValueType> values(localStorage.getValues());
+    ReadAccess<ValueType> rWeights(nodeWeights.getLocalValues());
+
+    // Jacobi preconditioner
+    std::vector<ValueType> invDiagonal(n, 1);
+    for (IndexType i = 0; i < n; i++) {
+        for (IndexType j = ia[i]; j < ia[i+1]; j++) {
+            if (ja[j] == i and values[j] != 0) {
+                invDiagonal[i] = 1/values[j];
+            }
+        }
+    }
+
+    // the demand of landmark j: every vertex sinks its weight, the source emits the total weight
+    std::vector<ValueType> r(n*l);
+    for (IndexType i = 0; i < n; i++) {
+        for (IndexType c = 0; c < l; c++) {
+            r[i*l+c] = -rWeights[i];
+        }
+    }
+    for (IndexType c = 0; c < l; c++) {
+        SCAI_ASSERT_VALID_INDEX_ERROR(sources[c], n, "Invalid source");
+        r[sources[c]*l+c] += weightSum;
+    }
+
+    // computes the dot products of the columns of two blocks
+    auto columnDots = [&](const std::vector<ValueType>& a, const std::vector<ValueType>& b) {
+        std::vector<double> dots(l, 0.0);
+        for (IndexType i = 0; i < n; i++) {
+            for (IndexType c = 0; c < l; c++) {
+                dots[c] += double(a[i*l+c])*b[i*l+c];
+            }
+        }
+        return dots;
+    };
+
+    std::vector<ValueType> x(n*l, 0);
+    std::vector<ValueType> z(n*l);
+    std::vector<ValueType> q(n*l);
+
+    for (IndexType i = 0; i < n; i++) {
+        for (IndexType c = 0; c < l; c++) {
+            z[i*l+c] = invDiagonal[i]*r[i*l+c];
+        }
+    }
+    std::vector<ValueType> p(z);
+
+    std::vector<double> rz = columnDots(r, z);
+    std::vector<double> initialNorm = columnDots(r, r);
+    std::vector<bool> converged(l);
+    for (IndexType c = 0; c < l; c++) {
+        converged[c] = initialNorm[c] == 0;
+    }
+
+    // same as ResidualCheck::Relative in computeFlow: stop when ||r|| <= eps*||r_0||
+    const IndexType maxIterations = 10*n;
+    IndexType iter = 0;
+    for (; iter < maxIterations; iter++) {
+        if (std::all_of(converged.begin(), converged.end(), [](bool b){return b;})) {
+            break;
+        }
+
+        // q = L*p for all right hand sides at once
+        {
+            SCAI_REGION( "Diffusion.multiplePotentials.SpMM" )
+            std::fill(q.begin(), q.end(), 0);
+            for (IndexType i = 0; i < n; i++) {
+                ValueType* qRow = q.data() + i*l;
+                for (IndexType j = ia[i]; j < ia[i+1]; j++) {
+                    const ValueType v = values[j];
+                    const ValueType* pRow = p.data() + ja[j]*l;
+                    for (IndexType c = 0; c < l; c++) {
+                        qRow[c] += v*pRow[c];
+                    }
+                }
+            }
+        }
+
+        const std::vector<double> pq = columnDots(p, q);
+        std::vector<ValueType> alpha(l, 0);
+        for (IndexType c = 0; c < l; c++) {
+            if (!converged[c] and pq[c] != 0) {
+                alpha[c] = rz[c]/pq[c];
+            }
+        }
+        for (IndexType i = 0; i < n*l; i++) {
+            x[i] += alpha[i%l]*p[i];
+            r[i] -= alpha[i%l]*q[i];
+        }
+
+        const std::vector<double> rr = columnDots(r, r);
+        for (IndexType c = 0; c < l; c++) {
+            if (rr[c] <= eps*eps*initialNorm[c]) {
+                converged[c] = true;
+            }
+        }
+
+        for (IndexType i = 0; i < n; i++) {
+            for (IndexType c = 0; c < l; c++) {
+                z[i*l+c] = invDiagonal[i]*r[i*l+c];
+            }
+        }
+        const std::vector<double> rzNew = columnDots(r, z);
+        for (IndexType c = 0; c < l; c++) {
+            const ValueType beta = (converged[c] or rz[c] == 0) ? 0 : rzNew[c]/rz[c];
+            rz[c] = rzNew[c];
+            for (IndexType i = 0; i < n; i++) {
+                p[i*l+c] = converged[c] ? 0 : z[i*l+c] + beta*p[i*l+c];
+            }
+        }
+    }
+
+    if (iter == maxIterations) {
+        std::cout << "Warning: in Diffusion::multiplePotentials, not all systems converged after " << iter << " iterations." << std::endl;
+    }
+
+    // the Laplacian is singular, shift every potential to mean zero and transpose into one row per landmark
+    const std::vector<double> sums = columnDots(x, std::vector<ValueType>(n*l, 1));
+    HArray<ValueType> resultContainer(localN*l);
+    {
         WriteAccess<ValueType> wResult(resultContainer);
-        ReadAccess<ValueType> rPotentials(potentials.getLocalValues());
-        assert(rPotentials.size() == localN);
-        assert(offset < wResult.size());
-        std::copy(rPotentials.get(), rPotentials.get()+localN, wResult.get()+offset);
-        offset += localN;
+        for (IndexType c = 0; c < l; c++) {
+            const ValueType mean = sums[c]/n;
+            for (IndexType i = 0; i < n; i++) {
+                wResult[c*localN+i] = x[i*l+c] - mean;
+            }
+        }
     }
-    assert(offset == localN*l);
 
     //the matrix is transposed, not sure if this is a problem.
     return scai::lama::distribute<DenseMatrix<ValueType>>(DenseStorage<ValueType>(l, localN, resultContainer), lDist, dist);
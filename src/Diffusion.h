@@ -49,7 +49,9 @@ public:
     static scai::lama::DenseVector<ValueType> potentialsFromSource(const scai::lama::CSRSparseMatrix<ValueType>& laplacian, const scai::lama::DenseVector<ValueType>& nodeWeights, IndexType source, ValueType eps=1e-6);
 
     /**
-     * @brief Calls potentialsFromSource several times, once for each source in sources
+     * @brief Computes the same potentials as calling potentialsFromSource once for each source in sources, but solves all systems
+     * together: a preconditioned CG per source, where all sources share one traversal of the Laplacian per iteration.
+     * Every row of the result is shifted to have mean zero.
      *
      * @param laplacian The laplacian of the graph
      * @param nodeWeights The demand at each (non-source) node. When in doubt, set uniformly to 1.
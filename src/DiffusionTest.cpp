@@ -105,6 +105,35 @@ TYPED_TEST(DiffusionTest, testMultiplePotentials) {
 
 }
 
+TYPED_TEST(DiffusionTest, testMultiplePotentialsAgreeWithSingle) {
+    using ValueType = TypeParam;
+
+    std::string file = DiffusionTest<ValueType>::graphPath + "Grid16x16";
+    CSRSparseMatrix<ValueType> graph = FileIO<IndexType, ValueType>::readGraph(file );
+    const IndexType n = graph.getNumRows();
+    scai::dmemo::DistributionPtr noDist(new scai::dmemo::NoDistribution(n));
+    graph.redistribute(noDist, noDist);
+
+    CSRSparseMatrix<ValueType> L = GraphUtils<IndexType, ValueType>::constructLaplacian(graph);
+    DenseVector<ValueType> nodeWeights(L.getRowDistributionPtr(), 1);
+
+    const std::vector<IndexType> landmarks = {0, 17, 135, n-1};
+    const ValueType epsilon = 1e-5;
+    DenseMatrix<ValueType> potentials = Diffusion<IndexType, ValueType>::multiplePotentials(L, nodeWeights, landmarks, epsilon);
+    ASSERT_EQ(landmarks.size(), potentials.getNumRows());
+
+    for (IndexType j = 0; j < landmarks.size(); j++) {
+        DenseVector<ValueType> single = Diffusion<IndexType, ValueType>::potentialsFromSource(L, nodeWeights, landmarks[j], epsilon);
+        DenseVector<ValueType> batched(n, 0);
+        potentials.getLocalRow(batched.getLocalValues(), j);
+
+        const ValueType tolerance = 1e-3*single.maxNorm();
+        for (IndexType i = 0; i < n; i++) {
+            EXPECT_NEAR(single.getValue(i), batched.getValue(i), tolerance);
+        }
+    }
+}
+
 TYPED_TEST(DiffusionTest, testConstructFJLTMatrix) {
     using ValueType = TypeParam;
 
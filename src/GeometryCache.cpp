@@ -0,0 +1,169 @@
+/*
+ * GeometryCache.cpp
+ *
+ * Bounding boxes of coordinate vectors and of the blocks of a partition.
+ */
+
+#include <scai/hmemo/ReadAccess.hpp>
+#include <scai/common/TypeTraits.hpp>
+
+#include <limits>
+#include <algorithm>
+
+#include "GeometryCache.h"
+
+namespace ITI {
+
+template<typename IndexType, typename ValueType>
+GeometryCache<IndexType, ValueType>::GeometryCache(const std::vector<DenseVector<ValueType>>& coordinates) : coordinates(coordinates) {
+    SCAI_ASSERT_GT_ERROR( coordinates.size(), 0, "No coordinates given" );
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+GeometryCache<IndexType, ValueType>::GeometryCache(const std::vector<DenseVector<ValueType>>& coordinates, const GeometryCache& other) : GeometryCache(coordinates) {
+    SCAI_ASSERT_EQ_ERROR( coordinates.size(), other.coordinates.size(), "Dimension mismatch" );
+    globalBox = other.globalBox;
+    hasGlobalBox = other.hasGlobalBox;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+void GeometryCache<IndexType, ValueType>::invalidate() {
+    hasLocalBox = false;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+const typename GeometryCache<IndexType, ValueType>::BoundingBox& GeometryCache<IndexType, ValueType>::getLocalBoundingBox() {
+    if (not hasLocalBox) {
+        localBox = computeLocalBoundingBox(coordinates);
+        hasLocalBox = true;
+    }
+    return localBox;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+const typename GeometryCache<IndexType, ValueType>::BoundingBox& GeometryCache<IndexType, ValueType>::getGlobalBoundingBox() {
+    if (not hasGlobalBox) {
+        globalBox = reduceBoundingBox(getLocalBoundingBox(), coordinates[0].getDistributionPtr()->getCommunicatorPtr());
+        hasGlobalBox = true;
+    }
+    return globalBox;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+typename GeometryCache<IndexType, ValueType>::BoundingBox GeometryCache<IndexType, ValueType>::computeGlobalBoundingBox(const std::vector<DenseVector<ValueType>>& coordinates) {
+    SCAI_REGION( "GeometryCache.computeGlobalBoundingBox" )
+    return reduceBoundingBox(computeLocalBoundingBox(coordinates), coordinates[0].getDistributionPtr()->getCommunicatorPtr());
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+typename GeometryCache<IndexType, ValueType>::BoundingBox GeometryCache<IndexType, ValueType>::reduceBoundingBox(const BoundingBox& localBox, const scai::dmemo::CommunicatorPtr comm) {
+    const IndexType dim = localBox.first.size();
+
+    // one reduction for min and max of all dimensions: the minimum is the negated maximum of the negated values
+    std::vector<ValueType> minMax(2*dim);
+    for (IndexType d = 0; d < dim; d++) {
+        minMax[d] = -localBox.first[d];
+        minMax[dim+d] = localBox.second[d];
+    }
+    comm->maxImpl( minMax.data(), minMax.data(), 2*dim, scai::common::TypeTraits<ValueType>::stype );
+
+    BoundingBox globalBox( std::vector<ValueType>(dim), std::vector<ValueType>(dim) );
+    for (IndexType d = 0; d < dim; d++) {
+        globalBox.first[d] = -minMax[d];
+        globalBox.second[d] = minMax[dim+d];
+    }
+    return globalBox;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+std::vector<typename GeometryCache<IndexType, ValueType>::BoundingBox> GeometryCache<IndexType, ValueType>::getBlockBoundingBoxes(const std::vector<DenseVector<ValueType>>& coordinates, const DenseVector<IndexType>& partition, const IndexType k) {
+    SCAI_REGION( "GeometryCache.getBlockBoundingBoxes" )
+
+    const scai::dmemo::CommunicatorPtr comm = coordinates[0].getDistributionPtr()->getCommunicatorPtr();
+    const IndexType dim = coordinates.size();
+    const IndexType localN = coordinates[0].getLocalValues().size();
+    SCAI_ASSERT_EQ_ERROR( partition.getLocalValues().size(), localN, "Partition and coordinates do not agree" );
+
+    // negated minima of all blocks followed by the maxima of all blocks, entry b*dim+d
+    std::vector<ValueType> minMax(2*k*dim, std::numeric_limits<ValueType>::lowest());
+    {
+        scai::hmemo::ReadAccess<IndexType> rPart(partition.getLocalValues());
+        for (IndexType d = 0; d < dim; d++) {
+            scai::hmemo::ReadAccess<ValueType> rCoords(coordinates[d].getLocalValues());
+
+            // every thread collects the boxes of its points, they are merged at the end
+            #pragma omp parallel
+            {
+                std::vector<ValueType> threadMin(k, std::numeric_limits<ValueType>::lowest());
+                std::vector<ValueType> threadMax(k, std::numeric_limits<ValueType>::lowest());
+
+                #pragma omp for
+                for (IndexType i = 0; i < localN; i++) {
+                    const IndexType block = rPart[i];
+                    SCAI_ASSERT_VALID_INDEX_DEBUG( block, k, "Wrong block id" );
+                    threadMin[block] = std::max( threadMin[block], -rCoords[i] );
+                    threadMax[block] = std::max( threadMax[block], rCoords[i] );
+                }
+
+                #pragma omp critical
+                for (IndexType b = 0; b < k; b++) {
+                    minMax[b*dim+d] = std::max( minMax[b*dim+d], threadMin[b] );
+                    minMax[k*dim + b*dim+d] = std::max( minMax[k*dim + b*dim+d], threadMax[b] );
+                }
+            }
+        }
+    }
+    comm->maxImpl( minMax.data(), minMax.data(), minMax.size(), scai::common::TypeTraits<ValueType>::stype );
+
+    std::vector<BoundingBox> result(k, BoundingBox(std::vector<ValueType>(dim), std::vector<ValueType>(dim)));
+    for (IndexType b = 0; b < k; b++) {
+        for (IndexType d = 0; d < dim; d++) {
+            result[b].first[d] = -minMax[b*dim+d];
+            result[b].second[d] = minMax[k*dim + b*dim+d];
+        }
+    }
+    return result;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+typename GeometryCache<IndexType, ValueType>::BoundingBox GeometryCache<IndexType, ValueType>::computeLocalBoundingBox(const std::vector<DenseVector<ValueType>>& coordinates) {
+    SCAI_REGION( "GeometryCache.computeLocalBoundingBox" )
+
+    const IndexType dim = coordinates.size();
+    const IndexType localN = coordinates[0].getLocalValues().size();
+
+    BoundingBox box( std::vector<ValueType>(dim, std::numeric_limits<ValueType>::max()), std::vector<ValueType>(dim, std::numeric_limits<ValueType>::lowest()) );
+
+    for (IndexType d = 0; d < dim; d++) {
+        SCAI_ASSERT_EQ_ERROR( coordinates[d].getLocalValues().size(), localN, "Coordinate vectors have different sizes" );
+        scai::hmemo::ReadAccess<ValueType> rCoords(coordinates[d].getLocalValues());
+        const ValueType* localData = rCoords.get();
+        ValueType minCoord = std::numeric_limits<ValueType>::max();
+        ValueType maxCoord = std::numeric_limits<ValueType>::lowest();
+
+        #pragma omp parallel for reduction(min:minCoord) reduction(max:maxCoord)
+        for (IndexType i = 0; i < localN; i++) {
+            minCoord = std::min(minCoord, localData[i]);
+            maxCoord = std::max(maxCoord, localData[i]);
+        }
+
+        box.first[d] = minCoord;
+        box.second[d] = maxCoord;
+    }
+
+    return box;
+}
+//---------------------------------------------------------------------------------------
+
+template class GeometryCache<IndexType, double>;
+template class GeometryCache<IndexType, float>;
+
+} //namespace ITI
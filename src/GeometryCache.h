@@ -0,0 +1,100 @@
+/*
+ * GeometryCache.h
+ *
+ * Bounding boxes of coordinate vectors and of the blocks of a partition.
+ */
+
+#pragma once
+
+#include <scai/lama/DenseVector.hpp>
+#include <scai/dmemo/Distribution.hpp>
+#include <scai/tracing.hpp>
+
+#include <vector>
+#include <utility>
+
+#include "Settings.h"
+
+namespace ITI {
+
+using scai::lama::DenseVector;
+
+/** @brief Computes bounding boxes of coordinates and keeps them for the caller.
+
+The bounding box of a set of coordinates is computed with an OpenMP-parallel pass over the local coordinates and a single
+reduction for the minima and maxima of all dimensions. The static functions compute the boxes on every call. A function
+that needs a box several times holds a GeometryCache object for its coordinates, which computes every box at most once.
+
+There is no shared state: an object belongs to the caller and refers to one set of coordinate vectors. The first call
+to getGlobalBoundingBox() is a global operation, so all PEs must create and use the object in the same way.
+
+The global box does not depend on the distribution of the coordinates. After the coordinates were redistributed in place,
+invalidate() drops only the local box; for a redistributed copy of the coordinates, a new object takes the global box over.
+
+@warning The coordinates must outlive the object and must not change while it is used.
+*/
+
+template <typename IndexType, typename ValueType>
+class GeometryCache {
+public:
+    /** The minimum (first) and maximum (second) coordinate for every dimension. */
+    typedef std::pair<std::vector<ValueType>, std::vector<ValueType>> BoundingBox;
+
+    /** @brief Keeps the boxes of these coordinates, they are computed on the first request. Local operation.
+
+    @param[in] coordinates The coordinates, coordinates.size() is the dimension.
+    */
+    explicit GeometryCache(const std::vector<DenseVector<ValueType>>& coordinates);
+
+    /** @brief Keeps the boxes of a redistributed copy of the coordinates of other. Local operation.
+
+    @param[in] coordinates The redistributed coordinates.
+    @param[in] other The object of the original coordinates, its global box is taken over if it was computed already.
+    */
+    GeometryCache(const std::vector<DenseVector<ValueType>>& coordinates, const GeometryCache& other);
+
+    /** @brief Drops the local box, must be called after the coordinates were redistributed. The global box is kept. Local operation.
+    */
+    void invalidate();
+
+    /** @brief The bounding box of the local coordinates of this PE. Local operation.
+    @return The local minimum and maximum in every dimension. If this PE has no points, min is the largest and max the lowest value of ValueType.
+    */
+    const BoundingBox& getLocalBoundingBox();
+
+    /** @brief The bounding box of all coordinates. Global operation on the first call, local afterwards.
+    @return The global minimum and maximum in every dimension.
+    */
+    const BoundingBox& getGlobalBoundingBox();
+
+    /** @brief The bounding box of the local coordinates of this PE, without an object. Local operation.
+    \sa getLocalBoundingBox()
+    */
+    static BoundingBox computeLocalBoundingBox(const std::vector<DenseVector<ValueType>>& coordinates);
+
+    /** @brief The bounding box of all coordinates, without an object. Global operation.
+    \sa getGlobalBoundingBox()
+    */
+    static BoundingBox computeGlobalBoundingBox(const std::vector<DenseVector<ValueType>>& coordinates);
+
+    /** @brief The bounding box of every block of a partition, with one parallel pass and one reduction for all blocks. Global operation.
+
+    @param[in] coordinates The coordinates.
+    @param[in] partition The partition, must have the same distribution as the coordinates.
+    @param[in] k The number of blocks.
+    @return For every block, its global minimum and maximum in every dimension. Empty blocks get min=max() and max=lowest().
+    */
+    static std::vector<BoundingBox> getBlockBoundingBoxes(const std::vector<DenseVector<ValueType>>& coordinates, const DenseVector<IndexType>& partition, const IndexType k);
+
+private:
+    /** The global box from a local box, with one reduction. */
+    static BoundingBox reduceBoundingBox(const BoundingBox& localBox, const scai::dmemo::CommunicatorPtr comm);
+
+    const std::vector<DenseVector<ValueType>>& coordinates;
+    BoundingBox localBox;
+    BoundingBox globalBox;
+    bool hasLocalBox = false;
+    bool hasGlobalBox = false;
+};
+
+} //namespace ITI
@@ -8,6 +8,7 @@
 #include <assert.h>
 #include <queue>
 #include <unordered_set>
+#include <unordered_map>
 #include <chrono>
 
 #include <scai/dmemo/mpi/MPICommunicator.hpp>
@@ -22,6 +23,7 @@
 #include <JanusSort.hpp>
 
 #include "GraphUtils.h"
+#include "LocalizedGraph.h"
 
 
 
@@ -298,7 +300,7 @@ IndexType GraphUtils<IndexType,ValueType>::getLocalBlockDiameter(const CSRSparse
 }
 
 template<typename IndexType, typename ValueType>
-ValueType GraphUtils<IndexType,ValueType>::computeCut(const CSRSparseMatrix<ValueType> &input, const DenseVector<IndexType> &part, const bool weighted) {
+ValueType GraphUtils<IndexType,ValueType>::computeCut(const CSRSparseMatrix<ValueType> &input, const DenseVector<IndexType> &part, const bool weighted, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
     SCAI_REGION( "ParcoRepart.computeCut" )
     const scai::dmemo::DistributionPtr inputDist = input.getRowDistributionPtr();
     const scai::dmemo::DistributionPtr partDist = part.getDistributionPtr();
@@ -309,7 +311,6 @@ ValueType GraphUtils<IndexType,ValueType>::computeCut(const CSRSparseMatrix<Valu
         std::cout.flush();
     }
 
-    [[maybe_unused]] const IndexType n = inputDist->getGlobalSize();
     const IndexType localN = inputDist->getLocalSize();
 
     std::chrono::time_point<std::chrono::steady_clock> startTime =  std::chrono::steady_clock::now();
@@ -319,40 +320,32 @@ ValueType GraphUtils<IndexType,ValueType>::computeCut(const CSRSparseMatrix<Valu
         throw std::runtime_error("partition has " + std::to_string(partDist->getLocalSize()) + " local values, but matrix has " + std::to_string(localN));
     }
 
+    SCAI_ASSERT_ERROR( partDist->isEqual(*inputDist), "Graph and partition distributions must agree" );
+
     const CSRStorage<ValueType>& localStorage = input.getLocalStorage();
+    const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::get(input, localization);
     scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
-    scai::hmemo::ReadAccess<IndexType> ja(localStorage.getJA());
-    scai::hmemo::HArray<IndexType> localData = part.getLocalValues();
+    scai::hmemo::ReadAccess<IndexType> ja(localized->getJA());
+    const scai::hmemo::HArray<IndexType>& localData = part.getLocalValues();
     scai::hmemo::ReadAccess<IndexType> partAccess(localData);
 
     scai::hmemo::ReadAccess<ValueType> values(localStorage.getValues());
-    scai::dmemo::HaloExchangePlan partHalo = buildNeighborHalo(input);
-    scai::hmemo::HArray<IndexType> haloData;
-    partHalo.updateHalo( haloData, localData, partDist->getCommunicator() );
+    const scai::hmemo::HArray<IndexType> haloData = localized->updateHalo(localData);
+    scai::hmemo::ReadAccess<IndexType> rHaloData(haloData);
 
     ValueType result = 0;
+    #pragma omp parallel for reduction(+:result)
     for (IndexType i = 0; i < localN; i++) {
         const IndexType beginCols = ia[i];
         const IndexType endCols = ia[i+1];
         assert(ja.size() >= endCols);
 
-        const IndexType globalI = inputDist->local2Global(i);
-        //assert(partDist->isLocal(globalI));
-        SCAI_ASSERT_ERROR(partDist->isLocal(globalI), "non-local index, globalI= " << globalI << " for PE " << comm->getRank() );
-
-        IndexType thisBlock = partAccess[i];
+        const IndexType thisBlock = partAccess[i];
 
         for (IndexType j = beginCols; j < endCols; j++) {
-            IndexType neighbor = ja[j];
-            assert(neighbor >= 0);
-            assert(neighbor < n);
-
-            IndexType neighborBlock;
-            if (partDist->isLocal(neighbor)) {
-                neighborBlock = partAccess[partDist->global2Local(neighbor)];
-            } else {
-                neighborBlock = haloData[partHalo.global2Halo(neighbor)];
-            }
+            // localized column: local vertex or position in the halo
+            const IndexType neighbor = ja[j];
+            const IndexType neighborBlock = neighbor < localN ? partAccess[neighbor] : rHaloData[neighbor-localN];
 
             if (neighborBlock != thisBlock) {
                 if (weighted) {
@@ -378,7 +371,6 @@ ValueType GraphUtils<IndexType,ValueType>::computeCut(const CSRSparseMatrix<Valu
 
     return result / 2; //counted each edge from both sides
 }
-
 //---------------------------------------------------------------------------------------
 
 template<typename IndexType, typename ValueType>
@@ -648,7 +640,7 @@ std::vector<IndexType> GraphUtils<IndexType, ValueType>::getNodesWithNonLocalNei
 /* The results returned is already distributed
  */
 template<typename IndexType, typename ValueType>
-DenseVector<IndexType> GraphUtils<IndexType, ValueType>::getBorderNodes( const CSRSparseMatrix<ValueType> &adjM, const DenseVector<IndexType> &part) {
+DenseVector<IndexType> GraphUtils<IndexType, ValueType>::getBorderNodes( const CSRSparseMatrix<ValueType> &adjM, const DenseVector<IndexType> &part, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
 
     const scai::dmemo::DistributionPtr dist = adjM.getRowDistributionPtr();
     const scai::dmemo::CommunicatorPtr comm = dist->getCommunicatorPtr();
@@ -666,25 +658,20 @@ DenseVector<IndexType> GraphUtils<IndexType, ValueType>::getBorderNodes( const C
     }
 
     const CSRStorage<ValueType>& localStorage = adjM.getLocalStorage();
+    const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::get(adjM, localization);
     const scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
-    const scai::hmemo::ReadAccess<IndexType> ja(localStorage.getJA());
+    const scai::hmemo::ReadAccess<IndexType> ja(localized->getJA());
     const scai::hmemo::ReadAccess<IndexType> partAccess(localPart);
 
-    auto partHalo = buildNeighborHalo(adjM);
-    auto haloData = partHalo.updateHaloF( localPart, dist->getCommunicator() );
+    auto haloData = localized->updateHalo( localPart );
 
     auto rHaloData = scai::hmemo::hostReadAccess( haloData );
 
     for(IndexType i=0; i<localN; i++) {   // for all local nodes
         IndexType thisBlock = localPart[i];
         for(IndexType j=ia[i]; j<ia[i+1]; j++) {                  // for all the edges of a node
-            IndexType neighbor = ja[j];
-            IndexType neighborBlock;
-            if (dist->isLocal(neighbor)) {
-                neighborBlock = partAccess[dist->global2Local(neighbor)];
-            } else {
-                neighborBlock = rHaloData[partHalo.global2Halo(neighbor)];
-            }
+            const IndexType neighbor = ja[j];
+            const IndexType neighborBlock = neighbor < localN ? partAccess[neighbor] : rHaloData[neighbor-localN];
             assert( neighborBlock < max +1 );
             if (thisBlock != neighborBlock) {
                 localBorder[i] = 1;
@@ -699,7 +686,7 @@ DenseVector<IndexType> GraphUtils<IndexType, ValueType>::getBorderNodes( const C
 //---------------------------------------------------------------------------------------
 
 template<typename IndexType, typename ValueType>
-std::pair<std::vector<IndexType>,std::vector<IndexType>> GraphUtils<IndexType, ValueType>::getNumBorderInnerNodes( const CSRSparseMatrix<ValueType> &adjM, const DenseVector<IndexType> &part, const struct Settings settings) {
+std::pair<std::vector<IndexType>,std::vector<IndexType>> GraphUtils<IndexType, ValueType>::getNumBorderInnerNodes( const CSRSparseMatrix<ValueType> &adjM, const DenseVector<IndexType> &part, const struct Settings settings, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
 
     const scai::dmemo::DistributionPtr dist = adjM.getRowDistributionPtr();
     const scai::dmemo::CommunicatorPtr comm = dist->getCommunicatorPtr();
@@ -732,12 +719,12 @@ std::pair<std::vector<IndexType>,std::vector<IndexType>> GraphUtils<IndexType, V
     }
 
     const CSRStorage<ValueType>& localStorage = adjM.getLocalStorage();
+    const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::get(adjM, localization);
     const scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
-    const scai::hmemo::ReadAccess<IndexType> ja(localStorage.getJA());
+    const scai::hmemo::ReadAccess<IndexType> ja(localized->getJA());
     const scai::hmemo::ReadAccess<IndexType> partAccess(localPart);
 
-    auto partHalo = buildNeighborHalo(adjM);
-    auto haloData = partHalo.updateHaloF( localPart, dist->getCommunicator() );
+    auto haloData = localized->updateHalo( localPart );
     auto rHaloData = scai::hmemo::hostReadAccess( haloData );
 
     for(IndexType i=0; i<localN; i++) {   // for all local nodes
@@ -746,13 +733,8 @@ std::pair<std::vector<IndexType>,std::vector<IndexType>> GraphUtils<IndexType, V
         bool isBorderNode = false;
 
         for(IndexType j=ia[i]; j<ia[i+1]; j++) {     // for all the edges of a node
-            IndexType neighbor = ja[j];
-            IndexType neighborBlock;
-            if (dist->isLocal(neighbor)) {
-                neighborBlock = partAccess[dist->global2Local(neighbor)];
-            } else {
-                neighborBlock = rHaloData[partHalo.global2Halo(neighbor)];
-            }
+            const IndexType neighbor = ja[j];
+            const IndexType neighborBlock = neighbor < localN ? partAccess[neighbor] : rHaloData[neighbor-localN];
             SCAI_ASSERT_LE_ERROR( neighborBlock, max, "Wrong block id." );
             if (thisBlock != neighborBlock) {
                 borderNodesPerBlock[thisBlock]++;   //increase number of border nodes found
@@ -781,7 +763,7 @@ std::pair<std::vector<IndexType>,std::vector<IndexType>> GraphUtils<IndexType, V
 //---------------------------------------------------------------------------------------
 
 template<typename IndexType, typename ValueType>
-std::vector<IndexType> GraphUtils<IndexType, ValueType>::computeCommVolume( const CSRSparseMatrix<ValueType> &adjM, const DenseVector<IndexType> &part, Settings settings) {
+std::vector<IndexType> GraphUtils<IndexType, ValueType>::computeCommVolume( const CSRSparseMatrix<ValueType> &adjM, const DenseVector<IndexType> &part, Settings settings, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
     const scai::dmemo::DistributionPtr dist = adjM.getRowDistributionPtr();
     const scai::dmemo::CommunicatorPtr comm = dist->getCommunicatorPtr();
     const IndexType numBlocks = settings.numBlocks;
@@ -805,12 +787,12 @@ std::vector<IndexType> GraphUtils<IndexType, ValueType>::computeCommVolume( cons
     }
 
     const CSRStorage<ValueType>& localStorage = adjM.getLocalStorage();
+    const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::get(adjM, localization);
     const scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
-    const scai::hmemo::ReadAccess<IndexType> ja(localStorage.getJA());
+    const scai::hmemo::ReadAccess<IndexType> ja(localized->getJA());
     const scai::hmemo::ReadAccess<IndexType> partAccess(localPart);
 
-    auto partHalo = buildNeighborHalo(adjM);
-    auto haloData = partHalo.updateHaloF( localPart, dist->getCommunicator() );
+    auto haloData = localized->updateHalo( localPart );
     auto rHaloData = scai::hmemo::hostReadAccess( haloData );
 
     for(IndexType i=0; i<localN; i++) {   // for all local nodes
@@ -819,13 +801,8 @@ std::vector<IndexType> GraphUtils<IndexType, ValueType>::computeCommVolume( cons
         std::set<IndexType> allNeighborBlocks;
 
         for(IndexType j=ia[i]; j<ia[i+1]; j++) {      // for all the edges of a node
-            IndexType neighbor = ja[j];
-            IndexType neighborBlock;
-            if (dist->isLocal(neighbor)) {
-                neighborBlock = partAccess[dist->global2Local(neighbor)];
-            } else {
-                neighborBlock = rHaloData[partHalo.global2Halo(neighbor)];
-            }
+            const IndexType neighbor = ja[j];
+            const IndexType neighborBlock = neighbor < localN ? partAccess[neighbor] : rHaloData[neighbor-localN];
             SCAI_ASSERT_LE_ERROR( neighborBlock, numBlocks, "Wrong block id." );
 
             // found a neighbor that belongs to a different block
@@ -861,7 +838,8 @@ template<typename IndexType, typename ValueType>
 std::tuple<std::vector<IndexType>, std::vector<IndexType>, std::vector<IndexType>> GraphUtils<IndexType, ValueType>::computeCommBndInner(
             const CSRSparseMatrix<ValueType> &adjM,
             const DenseVector<IndexType> &part,
-            Settings settings) {
+            Settings settings,
+            const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
 
     const IndexType numBlocks = settings.numBlocks;
     const scai::dmemo::DistributionPtr dist = adjM.getRowDistributionPtr();
@@ -890,12 +868,12 @@ std::tuple<std::vector<IndexType>, std::vector<IndexType>, std::vector<IndexType
     }
 
     const CSRStorage<ValueType>& localStorage = adjM.getLocalStorage();
+    const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::get(adjM, localization);
     const scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
-    const scai::hmemo::ReadAccess<IndexType> ja(localStorage.getJA());
+    const scai::hmemo::ReadAccess<IndexType> ja(localized->getJA());
     const scai::hmemo::ReadAccess<IndexType> partAccess(localPart);
 
-    auto partHalo = buildNeighborHalo(adjM);
-    auto haloData = partHalo.updateHaloF( localPart, dist->getCommunicator() );
+    auto haloData = localized->updateHalo( localPart );
     auto rHaloData = scai::hmemo::hostReadAccess( haloData );
 
     for(IndexType i=0; i<localN; i++) {   // for all local nodes
@@ -905,13 +883,8 @@ std::tuple<std::vector<IndexType>, std::vector<IndexType>, std::vector<IndexType
         std::set<IndexType> allNeighborBlocks;
 
         for(IndexType j=ia[i]; j<ia[i+1]; j++) {       // for all the edges of a node
-            IndexType neighbor = ja[j];
-            IndexType neighborBlock;
-            if (dist->isLocal(neighbor)) {
-                neighborBlock = partAccess[dist->global2Local(neighbor)];
-            } else {
-                neighborBlock = rHaloData[partHalo.global2Halo(neighbor)];
-            }
+            const IndexType neighbor = ja[j];
+            const IndexType neighborBlock = neighbor < localN ? partAccess[neighbor] : rHaloData[neighbor-localN];
             SCAI_ASSERT_LT_ERROR( neighborBlock, numBlocks, "Wrong block id." );
 
             // found a neighbor that belongs to a different block
@@ -972,8 +945,8 @@ IndexType GraphUtils<IndexType, ValueType>::getGraphMaxDegree( const scai::lama:
     const scai::lama::CSRStorage<ValueType>& localStorage = adjM.getLocalStorage();
     scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
 
-    // local maximum degree
-    IndexType maxDegree = ia[1]-ia[0];
+    // local maximum degree; a PE can have no local rows
+    IndexType maxDegree = 0;
 
     for(int i=1; i<ia.size(); i++) {
         IndexType thisDegree = ia[i]-ia[i-1];
@@ -996,9 +969,9 @@ std::pair<IndexType,IndexType> GraphUtils<IndexType, ValueType>::computeBlockGra
     if( comm->getRank()==0 ) {
         std::cout<<"Computing the block graph communication..." << std::endl;
     }
-    IndexType k = part.max()-1;
-    //TODO: getting the block graph probably fails for p>5000,
-    scai::lama::CSRSparseMatrix<ValueType> blockGraph = getBlockGraph( adjM, part, k);
+    IndexType k = part.max()+1;
+    //the distributed block graph is enough, max degree and number of edges do not need a replicated graph
+    scai::lama::CSRSparseMatrix<ValueType> blockGraph = getDistBlockGraph( adjM, part, k);
 
     IndexType maxComm = getGraphMaxDegree( blockGraph );
     IndexType totalComm = blockGraph.getNumValues()/2;
@@ -1009,133 +982,20 @@ std::pair<IndexType,IndexType> GraphUtils<IndexType, ValueType>::computeBlockGra
 
 template<typename IndexType, typename ValueType>
 scai::lama::CSRSparseMatrix<ValueType>  GraphUtils<IndexType, ValueType>::getBlockGraph( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, const IndexType k) {
-    SCAI_REGION("ParcoRepart.getLocalBlockGraphEdges");
-
-    const scai::dmemo::DistributionPtr dist = adjM.getRowDistributionPtr();
-    const scai::dmemo::CommunicatorPtr comm = dist->getCommunicatorPtr();    
-    const scai::dmemo::DistributionPtr partDist = part.getDistributionPtr();
-    //TODO/check: should dist==partDist??
-    const IndexType localN = partDist->getLocalSize();
-    SCAI_ASSERT( partDist->isEqual(*dist), "Graph and partition distributions must agree" );
-
-    if( !dist->isEqual( part.getDistribution() ) ) {
-        std::cout<< __FILE__<< "  "<< __LINE__<< ", matrix dist: " << *dist<< " and partition dist: "<< part.getDistribution() << std::endl;
-        throw std::runtime_error( "Distributions: should (?) be equal.");
-    }
-
-    //access to graph and partition
-    const scai::lama::CSRStorage<ValueType>& localStorage = adjM.getLocalStorage();
-    const scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
-    const scai::hmemo::ReadAccess<IndexType> ja(localStorage.getJA());
-    const scai::hmemo::ReadAccess<ValueType> values(localStorage.getValues());
-
-    //assert( max(ja)<globalN);
-
-    const scai::hmemo::HArray<IndexType>& localPart= part.getLocalValues();
-    const scai::hmemo::ReadAccess<IndexType> partAccess(localPart);
-
-    //get halo for non-local values
-    scai::dmemo::HaloExchangePlan partHalo = buildNeighborHalo( adjM );
-    scai::hmemo::HArray<IndexType> haloData;
-    partHalo.updateHalo( haloData, localPart, partDist->getCommunicator() );
-
-    // TODO: memory costly for big k
-    IndexType size= k*k;
-    //localBlockGraphEdges[i] = w, is the weight for edge (i/k,i%k)
-    scai::hmemo::HArray<ValueType> localBlockGraphEdges( size,  static_cast<ValueType>(0.0) );
-
-    //go over local data
-    for (IndexType i = 0; i < localN; i++) {
-        const IndexType beginCols = ia[i];
-        const IndexType endCols = ia[i+1];
-        assert(ja.size() >= endCols);
+    SCAI_REGION("ParcoRepart.getBlockGraph");
 
-        const IndexType globalI = dist->local2Global(i);
-        //assert(partDist->isLocal(globalI));
-        SCAI_ASSERT_ERROR(partDist->isLocal(globalI), "non-local index, globalI= " << globalI << " for PE " << comm->getRank() );
-
-        IndexType thisBlock = partAccess[i];
-
-        for (IndexType j = beginCols; j < endCols; j++) {
-            IndexType neighbor = ja[j];
-            IndexType neighborBlock;
-            if (partDist->isLocal(neighbor)) {
-                neighborBlock = partAccess[partDist->global2Local(neighbor)];
-            } else {
-                neighborBlock = haloData[partHalo.global2Halo(neighbor)];
-            }
+    scai::lama::CSRSparseMatrix<ValueType> blockGraph = getDistBlockGraph( adjM, part, k );
 
-            if (neighborBlock != thisBlock) {
-                IndexType index = thisBlock*k + neighborBlock;
-                localBlockGraphEdges[index] = localBlockGraphEdges[index] + values[j];
-            }
-        }
-    }//for
+    //replicate; this only needs as much memory as the edges of the block graph
+    const scai::dmemo::DistributionPtr noDist(new scai::dmemo::NoDistribution( k ));
+    blockGraph.redistribute( noDist, noDist );
 
-    comm->sumArray( localBlockGraphEdges );
-    //now, localBlockGraphEdges contains the global summed values; it should be the same in every PE
-
-    //count number of edges
-    IndexType numEdges=0;
-    {
-        scai::hmemo::ReadAccess<ValueType> globalEdges( localBlockGraphEdges );
-        for(IndexType i=0; i<globalEdges.size(); i++) {
-            if( globalEdges[i]>0 )
-                ++numEdges;
-        }
-    }
-
-    //convert the k*k HArray to a [k x k] CSRSparseMatrix
-    scai::lama::CSRStorage<ValueType> localMatrix;
-    localMatrix.allocate( k,k );
-
-    scai::hmemo::HArray<IndexType> csrIA;
-    scai::hmemo::HArray<IndexType> csrJA;
-    scai::hmemo::HArray<ValueType> csrValues( numEdges, 0.0 );
-    {
-        IndexType numNZ = numEdges;     // this equals the number of edges of the graph
-        scai::hmemo::WriteOnlyAccess<IndexType> ia( csrIA, k +1 );
-        scai::hmemo::WriteOnlyAccess<IndexType> ja( csrJA, numNZ );
-        scai::hmemo::WriteOnlyAccess<ValueType> values( csrValues );
-        scai::hmemo::ReadAccess<ValueType> globalEdges( localBlockGraphEdges );
-        ia[0]= 0;
-
-        IndexType rowCounter = 0; // count rows
-        IndexType nnzCounter = 0; // count non-zero elements
-
-        for(IndexType i=0; i<k; i++) {
-            IndexType rowNums=0;
-            // traverse the part of the HArray that represents a row and find how many elements are in this row
-            for(IndexType j=0; j<k; j++) {
-                if( globalEdges[i*k+j] >0  ) {
-                    ++rowNums;
-                }
-            }
-            ia[rowCounter+1] = ia[rowCounter] + rowNums;
-
-            for(IndexType j=0; j<k; j++) {
-                if( globalEdges[i*k +j] >0) {  // there exist edge (i,j)
-                    ja[nnzCounter] = j;
-                    //values[nnzCounter] = 1;
-                    values[nnzCounter] = globalEdges[i*k +j];
-                    //PRINT0("edge ["<< i <<", "<< j << "]= " << values[nnzCounter] );
-                    ++nnzCounter;
-                }
-            }
-            ++rowCounter;
-        }
-    }
-    SCAI_REGION_START("ParcoRepart.getBlockGraph.swapAndAssign");
-    scai::lama::CSRSparseMatrix<ValueType> matrix;
-    localMatrix.swap( csrIA, csrJA, csrValues );
-    matrix.assign(localMatrix);
-    SCAI_REGION_END("ParcoRepart.getBlockGraph.swapAndAssign");
-    return matrix;
+    return blockGraph;
 }
 //-----------------------------------------------------------------------------------
 
 template<typename IndexType, typename ValueType>
-scai::lama::CSRSparseMatrix<ValueType>  GraphUtils<IndexType, ValueType>::getBlockGraph_dist( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, const IndexType k) {
+scai::lama::CSRSparseMatrix<ValueType>  GraphUtils<IndexType, ValueType>::getBlockGraph_dist( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, const IndexType k, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
 
     const scai::dmemo::DistributionPtr dist = adjM.getRowDistributionPtr();
     const scai::dmemo::CommunicatorPtr comm = dist->getCommunicatorPtr();
@@ -1158,17 +1018,17 @@ scai::lama::CSRSparseMatrix<ValueType>  GraphUtils<IndexType, ValueType>::getBlo
     {
         //access to graph and partition
         const scai::lama::CSRStorage<ValueType>& localStorage = adjM.getLocalStorage();
+        const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::get(adjM, localization);
         const scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
-        const scai::hmemo::ReadAccess<IndexType> ja(localStorage.getJA());
+        const scai::hmemo::ReadAccess<IndexType> ja(localized->getJA());
         const scai::hmemo::ReadAccess<ValueType> values(localStorage.getValues());
 
         const scai::hmemo::HArray<IndexType>& localPart= part.getLocalValues();
         const scai::hmemo::ReadAccess<IndexType> partAccess(localPart);
 
-        //get halo for non-local values
-        scai::dmemo::HaloExchangePlan partHalo = buildNeighborHalo( adjM );
-        scai::hmemo::HArray<IndexType> haloData;
-        partHalo.updateHalo( haloData, localPart, partDist->getCommunicator() );
+        //get halo for non-local values, in the order of the localized columns
+        const scai::hmemo::HArray<IndexType> haloData = localized->updateHalo( localPart );
+        const scai::hmemo::ReadAccess<IndexType> rHalo( haloData );
 
         //go over local data
         for (IndexType i = 0; i < localN; i++) {
@@ -1183,13 +1043,8 @@ scai::lama::CSRSparseMatrix<ValueType>  GraphUtils<IndexType, ValueType>::getBlo
             IndexType thisBlock = partAccess[i];
 
             for (IndexType j = beginCols; j < endCols; j++) {
-                IndexType neighbor = ja[j];
-                IndexType neighborBlock;
-                if (partDist->isLocal(neighbor)) {
-                    neighborBlock = partAccess[partDist->global2Local(neighbor)];
-                } else {
-                    neighborBlock = haloData[partHalo.global2Halo(neighbor)];
-                }
+                const IndexType neighbor = ja[j];
+                const IndexType neighborBlock = neighbor < localN ? partAccess[neighbor] : rHalo[neighbor-localN];
 
                 //found an edge between two blocks
                 if (neighborBlock != thisBlock) {
@@ -1321,6 +1176,141 @@ scai::lama::CSRSparseMatrix<ValueType>  GraphUtils<IndexType, ValueType>::getBlo
 }
 //-----------------------------------------------------------------------------------
 
+template<typename IndexType, typename ValueType>
+scai::lama::CSRSparseMatrix<ValueType> GraphUtils<IndexType, ValueType>::getDistBlockGraph( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, const IndexType k, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
+    SCAI_REGION("GraphUtils.getDistBlockGraph");
+
+    const scai::dmemo::DistributionPtr dist = adjM.getRowDistributionPtr();
+    const scai::dmemo::CommunicatorPtr comm = dist->getCommunicatorPtr();
+    const scai::dmemo::DistributionPtr partDist = part.getDistributionPtr();
+    const IndexType localN = partDist->getLocalSize();
+    const IndexType numPEs = comm->getSize();
+
+    if( !dist->isEqual( part.getDistribution() ) ) {
+        std::cout<< __FILE__<< "  "<< __LINE__<< ", matrix dist: " << *dist<< " and partition dist: "<< part.getDistribution() << std::endl;
+        throw std::runtime_error( "Distributions: should (?) be equal.");
+    }
+
+    //the vertices of the block graph are block distributed; the owner of block b gets the row of b
+    const scai::dmemo::DistributionPtr blockDist(new scai::dmemo::BlockDistribution(k, comm));
+
+    //the key of edge (u,v) is u*k+v, do not use IndexType since k*k can overflow
+    typedef unsigned long long int edgeKey;
+    std::unordered_map<edgeKey,ValueType> localEdges;
+
+    {
+        SCAI_REGION("GraphUtils.getDistBlockGraph.accumulate");
+        const scai::lama::CSRStorage<ValueType>& localStorage = adjM.getLocalStorage();
+        const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::get(adjM, localization);
+        const scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
+        const scai::hmemo::ReadAccess<IndexType> ja(localized->getJA());
+        const scai::hmemo::ReadAccess<ValueType> values(localStorage.getValues());
+
+        const scai::hmemo::HArray<IndexType>& localPart= part.getLocalValues();
+        const scai::hmemo::ReadAccess<IndexType> partAccess(localPart);
+
+        //get halo for non-local values, in the order of the localized columns
+        const scai::hmemo::HArray<IndexType> haloData = localized->updateHalo( localPart );
+        scai::hmemo::ReadAccess<IndexType> rHalo( haloData );
+
+        for (IndexType i = 0; i < localN; i++) {
+            const IndexType thisBlock = partAccess[i];
+            SCAI_ASSERT_LT_ERROR( thisBlock, k, "Wrong block id." );
+
+            for (IndexType j = ia[i]; j < ia[i+1]; j++) {
+                const IndexType neighbor = ja[j];
+                const IndexType neighborBlock = neighbor < localN ? partAccess[neighbor] : rHalo[neighbor-localN];
+
+                if (neighborBlock != thisBlock) {
+                    localEdges[ edgeKey(thisBlock)*k + neighborBlock ] += values[j];
+                }
+            }
+        }
+    }
+
+    //
+    // sort the local edges by their first vertex, i.e., by the PE that owns them, and send
+    //
+
+    const IndexType numLocalEdges = localEdges.size();
+    std::vector<std::pair<edgeKey,ValueType>> sortedEdges( localEdges.begin(), localEdges.end() );
+    localEdges.clear();
+    std::sort( sortedEdges.begin(), sortedEdges.end() );
+
+    std::vector<IndexType> quantities( numPEs, 0 );
+    std::vector<IndexType> sendFirst( numLocalEdges );
+    std::vector<IndexType> sendSecond( numLocalEdges );
+    std::vector<ValueType> sendWeights( numLocalEdges );
+
+    {
+        IndexType lastBlock = -1;
+        IndexType owner = -1;
+        for (IndexType e = 0; e < numLocalEdges; e++) {
+            const IndexType u = sortedEdges[e].first / k;
+            const IndexType v = sortedEdges[e].first % k;
+            //edges are sorted, so we look up the owner once per block
+            if (u != lastBlock) {
+                owner = blockDist->getAnyOwner(u);
+                lastBlock = u;
+            }
+            SCAI_ASSERT_LT_ERROR( owner, numPEs, "Wrong owner for block " << u );
+            quantities[owner]++;
+            sendFirst[e] = u;
+            sendSecond[e] = v;
+            sendWeights[e] = sortedEdges[e].second;
+        }
+    }
+    sortedEdges.clear();
+
+    scai::dmemo::CommunicationPlan sendPlan( quantities.data(), numPEs );
+    scai::dmemo::CommunicationPlan recvPlan = comm->transpose( sendPlan );
+    const IndexType numRecvEdges = recvPlan.totalQuantity();
+
+    std::vector<IndexType> recvFirst( numRecvEdges );
+    std::vector<IndexType> recvSecond( numRecvEdges );
+    std::vector<ValueType> recvWeights( numRecvEdges );
+
+    {
+        SCAI_REGION("GraphUtils.getDistBlockGraph.exchange");
+        comm->exchangeByPlan( recvFirst.data(), recvPlan, sendFirst.data(), sendPlan );
+        comm->exchangeByPlan( recvSecond.data(), recvPlan, sendSecond.data(), sendPlan );
+        comm->exchangeByPlan( recvWeights.data(), recvPlan, sendWeights.data(), sendPlan );
+    }
+
+    //
+    // sum up the received edges and build the local rows
+    //
+
+    const IndexType localK = blockDist->getLocalSize();
+
+    std::vector<std::map<IndexType,ValueType>> rows( localK );
+    for (IndexType e = 0; e < numRecvEdges; e++) {
+        const IndexType localU = blockDist->global2Local( recvFirst[e] );
+        SCAI_ASSERT_NE_ERROR( localU, scai::invalidIndex, "Received edge for non-local block " << recvFirst[e] );
+        rows[localU][ recvSecond[e] ] += recvWeights[e];
+    }
+
+    std::vector<IndexType> ia( localK+1, 0 );
+    std::vector<IndexType> ja;
+    std::vector<ValueType> values;
+
+    for (IndexType u = 0; u < localK; u++) {
+        for (const auto& neighbor : rows[u]) {
+            ja.push_back( neighbor.first );
+            values.push_back( neighbor.second );
+        }
+        ia[u+1] = ja.size();
+    }
+
+    scai::lama::CSRStorage<ValueType> myStorage( localK, k,
+            scai::hmemo::HArray<IndexType>(ia.size(), ia.data()),
+            scai::hmemo::HArray<IndexType>(ja.size(), ja.data()),
+            scai::hmemo::HArray<ValueType>(values.size(), values.data()));
+
+    return scai::lama::CSRSparseMatrix<ValueType>( blockDist, std::move(myStorage) );
+}
+//-----------------------------------------------------------------------------------
+
 template<typename IndexType, typename ValueType>
 scai::lama::CSRSparseMatrix<ValueType> GraphUtils<IndexType, ValueType>::getPEGraph( const CSRSparseMatrix<ValueType> &adjM) {
     SCAI_REGION("ParcoRepart.getPEGraph");
@@ -17,6 +17,7 @@
 #include <scai/dmemo/GeneralDistribution.hpp>
 
 #include "Settings.h"
+#include "LocalizedGraph.h"
 
 namespace ITI {
 
@@ -90,10 +91,11 @@ public:
      * @param[in] input The adjacency matrix of the graph.
      * @param[in] part The partition vector for the input graph.
      * @param[in] weighted If edges are weighted or not.
+     * @param[in] localization The localization of the graph with its current distribution, built here if nullptr.
 
      * @return The value of the cut, i.e., the weigh of the edges if the edges have weights or the number of edges otherwise.
      */
-    static ValueType computeCut(const scai::lama::CSRSparseMatrix<ValueType> &input, const scai::lama::DenseVector<IndexType> &part, bool weighted = false);
+    static ValueType computeCut(const scai::lama::CSRSparseMatrix<ValueType> &input, const scai::lama::DenseVector<IndexType> &part, bool weighted = false, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr);
 
     /**
      * This method takes a (possibly distributed) partition and computes its imbalance.
@@ -169,31 +171,34 @@ public:
 
     * @param[in] adjM Adjacency matrix of the input graph
     * @param[in] part A partition of the graph.
+    * @param[in] localization The localization of adjM with its current distribution, built here if nullptr.
 
     * @return A distributed vector that contains 0 or 1: of retunr[i]=1 then the i-th vertex is a border node, if 0 it is not.
     */
-    static scai::lama::DenseVector<IndexType> getBorderNodes( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part);
+    static scai::lama::DenseVector<IndexType> getBorderNodes( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr);
 
     /** Returns two vectors each of size k: the first contains the number of border nodes per block and the second one the number of inner nodes per blocks.
 
      * @param[in] adjM Adjacency matrix of the input graph
      * @param[in] part A partition of the graph.
      * @param[in] settings Settings struct
+     * @param[in] localization The localization of adjM with its current distribution, built here if nullptr.
 
      * @return First vector is the number of border vertices per block, second vector is the number of inner vertices per block.
      Since these two are disjoint, ret.first[i]+ret.second[i] = size of block i.
      */
-    static std::pair<std::vector<IndexType>,std::vector<IndexType>> getNumBorderInnerNodes( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, Settings settings);
+    static std::pair<std::vector<IndexType>,std::vector<IndexType>> getNumBorderInnerNodes( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, Settings settings, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr);
 
     /** Computes the communication volume for every block.
      * @param[in] adjM Adjacency matrix of the input graph
      * @param[in] part A partition of the graph.
      * @param[in] settings Settings struct
+     * @param[in] localization The localization of adjM with its current distribution, built here if nullptr.
 
      * @return Vector of size k (=numBlocks) with the communication volume for every part. Note that the vector is replicated in every PE.
     */
 // TODO: Should the result is gathered in the root PE and not be replicated?
-    static std::vector<IndexType> computeCommVolume( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, Settings settings );
+    static std::vector<IndexType> computeCommVolume( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, Settings settings, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr );
 
     /**Computes the communication volume, boundary and inner nodes in one pass to save time.
      *
@@ -202,13 +207,13 @@ public:
 
      @sa  getNumBorderInnerNodes(), computeCommVolume()
      */
-    static std::tuple<std::vector<IndexType>, std::vector<IndexType>, std::vector<IndexType>> computeCommBndInner( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, Settings settings );
+    static std::tuple<std::vector<IndexType>, std::vector<IndexType>, std::vector<IndexType>> computeCommBndInner( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, Settings settings, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr );
 
 
     /** Builds the block (aka, communication) graph of the given partition. Every vertex corresponds to a block and two vertices u and v
      * are adjacent in the block graph if there is a vertex in (block) u and one in (block) v that are adjacent in the input graph.
-     * Creates an HArray that is passed around in numPEs (=comm->getSize()) rounds and every time
-     * a processor writes in the array its part.
+     * The graph is first built distributed with getDistBlockGraph() and then replicated,
+     * so the memory needed is proportional to the edges of the block graph and not k*k.
      *
      * The returned matrix is replicated in all PEs.
      *
@@ -225,10 +230,24 @@ public:
     The difference with getBlockGraph() is that now, every PE sends its local adjacent list to a root PE, the block is constructed
     there and then it is broadcast back to all PEs. This avoids the k*k space needed in getBlockGraph().
 
-    Input parameter and return value are the same as for getBlockGraph().
+    Input parameter and return value are the same as for getBlockGraph(); the optional localization of adjM is built here if nullptr.
     */
 
-    static scai::lama::CSRSparseMatrix<ValueType>  getBlockGraph_dist( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, const IndexType k);
+    static scai::lama::CSRSparseMatrix<ValueType>  getBlockGraph_dist( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, const IndexType k, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr);
+
+    /** Constructs the block (aka, communication) graph of the partition (@sa getBlockGraph()) as a distributed matrix.
+    Every PE accumulates the weights of its local (thisBlock, neighborBlock) pairs in a hash map and sends them to the
+    PE that owns thisBlock in a block distribution of the k block-graph vertices. The owners sum the received weights
+    and assemble their rows. Neither a k*k array nor a replicated edge list is needed, so this also works for large k.
+
+    @param[in] adjM The adjacency matrix of the input graph.
+    @param[in] part The partition of the input graph; must have the same distribution as adjM.
+    @param[in] k Number of blocks.
+    @param[in] localization The localization of adjM with its current distribution, built here if nullptr.
+
+    @return The adjacency matrix of the block graph, with a block distribution of its k rows and no column distribution.
+    */
+    static scai::lama::CSRSparseMatrix<ValueType> getDistBlockGraph( const scai::lama::CSRSparseMatrix<ValueType> &adjM, const scai::lama::DenseVector<IndexType> &part, const IndexType k, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr);
 
     /** @brief Get the maximum degree of a graph.
     */
@@ -6,6 +6,7 @@
 #include "FileIO.h"
 #include "GraphUtils.h"
 #include "MeshGenerator.h"
+#include "LocalizedGraph.h"
 
 #include <scai/dmemo/CyclicDistribution.hpp>
 #include <scai/hmemo/ReadAccess.hpp>
@@ -724,6 +725,54 @@ TYPED_TEST ( GraphUtilsTest, testGetBlockGraph) {
 }
 //------------------------------------------------------------------------------
 
+TYPED_TEST ( GraphUtilsTest, testGetDistBlockGraph) {
+    using ValueType = TypeParam;
+
+    std::string file = GraphUtilsTest<ValueType>::graphPath + "trace-00008.graph";
+    const IndexType dimensions= 2;
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType k = 2*comm->getSize()+1; //so that not every PE owns the same number of blocks
+
+    CSRSparseMatrix<ValueType> graph = FileIO<IndexType, ValueType>::readGraph( file );
+    const IndexType N = graph.getNumRows();
+    std::vector<DenseVector<ValueType>> coords = FileIO<IndexType, ValueType>::readCoords( std::string(file + ".xyz"), N, dimensions);
+
+    struct Settings settings;
+    settings.numBlocks= k;
+    settings.epsilon = 0.1;
+    settings.dimensions = dimensions;
+    settings.noRefinement = true;
+    settings.initialPartition = Tool::geoKmeans;
+    Metrics<ValueType> metrics(settings);
+
+    scai::lama::DenseVector<IndexType> partition = ParcoRepart<IndexType, ValueType>::partitionGraph(graph, coords, settings, metrics);
+
+    scai::lama::CSRSparseMatrix<ValueType> distBlockGraph = GraphUtils<IndexType, ValueType>::getDistBlockGraph( graph, partition, k);
+
+    EXPECT_EQ( distBlockGraph.getNumRows(), k );
+    EXPECT_EQ( distBlockGraph.getNumColumns(), k );
+    EXPECT_EQ( comm->sum(distBlockGraph.getLocalNumRows()), k );
+    EXPECT_TRUE( distBlockGraph.isConsistent() );
+    EXPECT_TRUE( distBlockGraph.checkSymmetry() );
+
+    //compare with the version that gathers the edges in the root
+    scai::lama::CSRSparseMatrix<ValueType> blockGraph = GraphUtils<IndexType, ValueType>::getBlockGraph_dist( graph, partition, k);
+    EXPECT_EQ( distBlockGraph.getNumValues(), blockGraph.getNumValues() );
+
+    ValueType edgeSum = 0;
+    for(int i=0; i<k; i++ ) {
+        for( int j=0; j<k; j++) {
+            EXPECT_EQ( distBlockGraph.getValue(i,j), blockGraph.getValue(i,j) ) << "for position ["<<i <<"," << j << "]";
+            edgeSum += distBlockGraph.getValue(i,j);
+        }
+    }
+
+    ValueType cut = GraphUtils<IndexType, ValueType>::computeCut(graph, partition, true);
+    EXPECT_EQ( cut*2, edgeSum );
+}
+//------------------------------------------------------------------------------
+
 TYPED_TEST ( GraphUtilsTest, testPEGraphBlockGraph_k_equal_p_Distributed) {
     using ValueType = TypeParam;
     
@@ -807,4 +856,60 @@ TYPED_TEST ( GraphUtilsTest, testPEGraphBlockGraph_k_equal_p_Distributed) {
 }
 //------------------------------------------------------------------------------
 
+TYPED_TEST(GraphUtilsTest, testLocalizedGraph) {
+    using ValueType = TypeParam;
+
+    std::string file = GraphUtilsTest<ValueType>::graphPath + "Grid8x8";
+    CSRSparseMatrix<ValueType> graph = FileIO<IndexType, ValueType>::readGraph(file );
+    const IndexType n = graph.getNumRows();
+    const scai::dmemo::CommunicatorPtr comm = graph.getRowDistributionPtr()->getCommunicatorPtr();
+
+    //a cyclic distribution, so most neighbors are not local
+    const scai::dmemo::DistributionPtr dist( new scai::dmemo::CyclicDistribution(n, 2, comm) );
+    graph.redistribute(dist, graph.getColDistributionPtr());
+    const IndexType localN = dist->getLocalSize();
+
+    const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::create(graph);
+    EXPECT_EQ( localized->getLocalN(), localN );
+
+    //the halo values of the global ids must be the global ids of the columns
+    DenseVector<IndexType> globalIds(dist, 0);
+    dist->getOwnedIndexes(globalIds.getLocalValues());
+    const scai::hmemo::HArray<IndexType> haloIds = localized->updateHalo(globalIds.getLocalValues());
+    ASSERT_EQ( haloIds.size(), localized->getHaloN() );
+
+    {
+        const scai::hmemo::ReadAccess<IndexType> ja(graph.getLocalStorage().getJA());
+        const scai::hmemo::ReadAccess<IndexType> localJA(localized->getJA());
+        const scai::hmemo::ReadAccess<IndexType> rIds(globalIds.getLocalValues());
+        const scai::hmemo::ReadAccess<IndexType> rHaloIds(haloIds);
+        ASSERT_EQ( ja.size(), localJA.size() );
+
+        for (IndexType j = 0; j < ja.size(); j++) {
+            const IndexType col = localJA[j];
+            ASSERT_LT( col, localN + localized->getHaloN() );
+            const IndexType globalCol = col < localN ? rIds[col] : rHaloIds[col-localN];
+            EXPECT_EQ( globalCol, ja[j] );
+            EXPECT_EQ( col < localN, dist->isLocal(ja[j]) );
+        }
+    }
+
+    //the kernels give the same results with the localization of the caller
+    EXPECT_TRUE( localized->isLocalizationOf(graph) );
+    DenseVector<IndexType> part = scai::lama::fill<DenseVector<IndexType>>(dist, comm->getRank());
+    Settings settings;
+    settings.numBlocks = comm->getSize();
+    EXPECT_EQ( (GraphUtils<IndexType, ValueType>::computeCut(graph, part, true)), (GraphUtils<IndexType, ValueType>::computeCut(graph, part, true, localized)) );
+    EXPECT_EQ( (GraphUtils<IndexType, ValueType>::computeCommVolume(graph, part, settings)), (GraphUtils<IndexType, ValueType>::computeCommVolume(graph, part, settings, localized)) );
+
+    //the object does not refer to the graph, it keeps the old local size after a redistribution and cannot be reused
+    const scai::dmemo::DistributionPtr newDist( new scai::dmemo::CyclicDistribution(n, 3, comm) );
+    graph.redistribute(newDist, graph.getColDistributionPtr());
+    EXPECT_EQ( localized->getLocalN(), localN );
+    EXPECT_EQ( (LocalizedGraph<IndexType, ValueType>::create(graph)->getLocalN()), newDist->getLocalSize() );
+    EXPECT_FALSE( localized->isLocalizationOf(graph) );
+    EXPECT_ANY_THROW( (LocalizedGraph<IndexType, ValueType>::get(graph, localized)) );
+}
+//------------------------------------------------------------------------------
+
 } //namespace
@@ -5,9 +5,13 @@
  *      Author: tzovas
  */
 
+#include <limits>
+#include <numeric>
+
 #include "HilbertCurve.h"
+#include "GeometryCache.h"
+#include "Migration.h"
 
-#include <scai/dmemo/mpi/MPICommunicator.hpp>
 
 
 namespace ITI {
@@ -23,7 +27,7 @@ DenseVector<IndexType> HilbertCurve<IndexType, ValueType>::computePartition(cons
 //---------------------------------------------------------------------------------------
 
 template<typename IndexType, typename ValueType>
-DenseVector<IndexType> HilbertCurve<IndexType, ValueType>::computePartition(const std::vector<DenseVector<ValueType>> &coordinates, Settings settings) {
+DenseVector<IndexType> HilbertCurve<IndexType, ValueType>::computePartition(const std::vector<DenseVector<ValueType>> &coordinates, Settings settings, GeometryCache<IndexType, ValueType>* geometry) {
     SCAI_REGION( "HilbertCurve.computePartition" )
 
     std::chrono::time_point<std::chrono::steady_clock> start, afterSFC;
@@ -78,7 +82,7 @@ DenseVector<IndexType> HilbertCurve<IndexType, ValueType>::computePartition(cons
      */
 
     scai::lama::DenseVector<double> hilbertIndices(coordDist, 0);
-    std::vector<double> localHilberIndices = HilbertCurve<IndexType,ValueType>::getHilbertIndexVector(coordinates, recursionDepth, dimensions);
+    std::vector<double> localHilberIndices = HilbertCurve<IndexType,ValueType>::getHilbertIndexVector(coordinates, recursionDepth, dimensions, geometry);
     hilbertIndices.assign( scai::hmemo::HArray<double>( localHilberIndices.size(), localHilberIndices.data()), coordDist);
 
     //TODO: use the blockSizes vector
@@ -88,7 +92,7 @@ DenseVector<IndexType> HilbertCurve<IndexType, ValueType>::computePartition(cons
      * now sort the global indices by where they are on the space-filling curve.
      */
 
-    std::vector<sort_pair<ValueType>> localPairs= getSortedHilbertIndices( coordinates, settings );
+    std::vector<sort_pair<ValueType>> localPairs= getSortedHilbertIndices( coordinates, settings, geometry );
 
     //copy indices into array
     const IndexType newLocalN = localPairs.size();
@@ -309,7 +313,7 @@ double HilbertCurve<IndexType, ValueType>::getHilbertIndex3D(ValueType const* po
 //
 
 template<typename IndexType, typename ValueType>
-std::vector<double> HilbertCurve<IndexType, ValueType>::getHilbertIndexVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth, const IndexType dimensions) {
+std::vector<double> HilbertCurve<IndexType, ValueType>::getHilbertIndexVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth, const IndexType dimensions, GeometryCache<IndexType, ValueType>* geometry) {
 
     IndexType newRecursionDepth = recursionDepth;
 
@@ -322,11 +326,11 @@ std::vector<double> HilbertCurve<IndexType, ValueType>::getHilbertIndexVector (c
     }
 
     if(dimensions==2) {
-        return HilbertCurve<IndexType, ValueType>::getHilbertIndex2DVector( coordinates, newRecursionDepth);
+        return HilbertCurve<IndexType, ValueType>::getHilbertIndex2DVector( coordinates, newRecursionDepth, geometry);
     }
 
     if(dimensions==3) {
-        return HilbertCurve<IndexType, ValueType>::getHilbertIndex3DVector( coordinates, newRecursionDepth);
+        return HilbertCurve<IndexType, ValueType>::getHilbertIndex3DVector( coordinates, newRecursionDepth, geometry);
     }
 
     throw std::logic_error("Space filling curve currently only implemented for two or three dimensions");
@@ -335,7 +339,7 @@ std::vector<double> HilbertCurve<IndexType, ValueType>::getHilbertIndexVector (c
 //-------------------------------------------------------------------------------------------------
 
 template<typename IndexType, typename ValueType>
-std::vector<double> HilbertCurve<IndexType, ValueType>::getHilbertIndex2DVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth) {
+std::vector<double> HilbertCurve<IndexType, ValueType>::getHilbertIndex2DVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth, GeometryCache<IndexType, ValueType>* geometry) {
     SCAI_REGION("HilbertCurve.getHilbertIndex2DVector")
 
     const IndexType dimensions = coordinates.size();
@@ -354,9 +358,10 @@ std::vector<double> HilbertCurve<IndexType, ValueType>::getHilbertIndex2DVector
 
     {
         SCAI_REGION( "HilbertCurve.getHilbertIndex2DVector.minMax" )
+        const typename GeometryCache<IndexType,ValueType>::BoundingBox box = geometry != nullptr ? geometry->getGlobalBoundingBox() : GeometryCache<IndexType,ValueType>::computeGlobalBoundingBox(coordinates);
         for (IndexType dim = 0; dim < 2; dim++) {
-            minCoords[dim] = coordinates[dim].min();
-            maxCoords[dim] = coordinates[dim].max();
+            minCoords[dim] = box.first[dim];
+            maxCoords[dim] = box.second[dim];
             assert(std::isfinite(minCoords[dim]));
             assert(std::isfinite(maxCoords[dim]));
             SCAI_ASSERT_GE_ERROR(maxCoords[dim], minCoords[dim], "Wrong coordinates for dimension " << dim);
@@ -432,7 +437,7 @@ std::vector<double> HilbertCurve<IndexType, ValueType>::getHilbertIndex2DVector
 //-------------------------------------------------------------------------------------------------
 
 template<typename IndexType, typename ValueType>
-std::vector<double> HilbertCurve<IndexType, ValueType>::getHilbertIndex3DVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth) {
+std::vector<double> HilbertCurve<IndexType, ValueType>::getHilbertIndex3DVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth, GeometryCache<IndexType, ValueType>* geometry) {
     SCAI_REGION("HilbertCurve.getHilbertIndex3DVector")
 
     const IndexType dimensions = coordinates.size();
@@ -451,9 +456,10 @@ std::vector<double> HilbertCurve<IndexType, ValueType>::getHilbertIndex3DVector
 
     {
         SCAI_REGION( "HilbertCurve.getHilbertIndex3DVector.minMax" )
+        const typename GeometryCache<IndexType,ValueType>::BoundingBox box = geometry != nullptr ? geometry->getGlobalBoundingBox() : GeometryCache<IndexType,ValueType>::computeGlobalBoundingBox(coordinates);
         for (IndexType dim = 0; dim < 3; dim++) {
-            minCoords[dim] = coordinates[dim].min();
-            maxCoords[dim] = coordinates[dim].max();
+            minCoords[dim] = box.first[dim];
+            maxCoords[dim] = box.second[dim];
             assert(std::isfinite(minCoords[dim]));
             assert(std::isfinite(maxCoords[dim]));
             SCAI_ASSERT(maxCoords[dim] > minCoords[dim], "Wrong coordinates.");
@@ -701,7 +707,7 @@ std::vector<std::vector<ValueType>> HilbertCurve<IndexType, ValueType>::Hilbert3
 //-------------------------------------------------------------------------------------------------
 
 template<typename IndexType, typename ValueType>
-std::vector<sort_pair<ValueType>> HilbertCurve<IndexType, ValueType>::getSortedHilbertIndices( const std::vector<DenseVector<ValueType>> &coordinates, Settings settings) {
+std::vector<sort_pair<ValueType>> HilbertCurve<IndexType, ValueType>::getSortedHilbertIndices( const std::vector<DenseVector<ValueType>> &coordinates, Settings settings, GeometryCache<IndexType, ValueType>* geometry) {
 
     const scai::dmemo::DistributionPtr coordDist = coordinates[0].getDistributionPtr();
     const scai::dmemo::CommunicatorPtr comm = coordDist->getCommunicatorPtr();
@@ -716,49 +722,67 @@ std::vector<sort_pair<ValueType>> HilbertCurve<IndexType, ValueType>::getSortedH
     *	create space filling curve indices.
     */
 
-    std::vector<sort_pair<ValueType>> localPairs(localN);
-
+    std::vector<double> localHilbertInd;
     {
         SCAI_REGION("HilbertCurve.getSortedHilbertIndices.spaceFillingCurve");
 
         //get hilbert indices for all the points
-        std::vector<double> localHilbertInd = HilbertCurve<IndexType,ValueType>::getHilbertIndexVector(coordinates, recursionDepth, dimensions);
+        localHilbertInd = HilbertCurve<IndexType,ValueType>::getHilbertIndexVector(coordinates, recursionDepth, dimensions, geometry);
         SCAI_ASSERT_EQ_ERROR(localHilbertInd.size(), localN, "Size mismatch");
-
-        for (IndexType i = 0; i < localN; i++) {
-            localPairs[i].value = localHilbertInd[i];
-            localPairs[i].index = coordDist->local2Global(i);
-        }
     }
 
     /*
     * now sort the global indices by where they are on the space-filling curve.
     */
 
+    std::vector<sort_pair<ValueType>> localPairs;
+
     {
         SCAI_REGION( "HilbertCurve.getSortedHilbertIndices.sorting" );
 
-        int typesize;
-        MPI_Type_size(MPI_DOUBLE_INT, &typesize);
-        //MPI_Type_size(getMPITypePair<double,IndexType>(), &typesize);
-        //assert(typesize == sizeof(sort_pair)); does not have to be true anymore due to padding
+        const IndexType numPEs = comm->getSize();
+        const IndexType keyBits = getKeyBits(recursionDepth, dimensions);
 
-        //call distributed sort
-        //sfc index is hardcoded to double to allow better precision
-
-        //MPI_Comm mpi_comm, std::vector<value_type> &data, long long global_elements = -1, Compare comp = Compare()
-        MPI_Comm mpi_comm = MPI_COMM_WORLD;
+        //sort locally and find the splitters of the sorted keys
+        const std::vector<std::uint64_t> keys = getIntegerKeys(localHilbertInd, keyBits);
+        const std::vector<IndexType> permutation = radixSortPermutation(keys, keyBits);
+        std::vector<std::uint64_t> sortedKeys(localN);
+        for (IndexType i = 0; i < localN; i++) {
+            sortedKeys[i] = keys[permutation[i]];
+        }
+        const std::vector<std::uint64_t> splitters = getIntegerSplitters(sortedKeys, keyBits, comm);
 
-        // as MPI communicator might have been splitted, take the one used by comm
-        if ( comm->getType() == scai::dmemo::CommunicatorType::MPI ){
-            const auto& mpiComm = static_cast<const scai::dmemo::MPICommunicator&>( *comm );
-            mpi_comm = mpiComm.getMPIComm();
+        //the sorted points of every target PE are consecutive; the hilbert index and the global index are sent together
+        std::vector<IndexType> quantities(numPEs, 0);
+        std::vector<double> sendData(2*localN);
+        IndexType target = 0;
+        for (IndexType i = 0; i < localN; i++) {
+            while (sortedKeys[i] >= splitters[target+1]) {
+                target++;
+            }
+            quantities[target] += 2;
+            sendData[2*i] = localHilbertInd[permutation[i]];
+            sendData[2*i+1] = coordDist->local2Global(permutation[i]);
         }
 
-        //JanusSort::sort(mpi_comm, localPairs, MPI_DOUBLE_INT);
-        JanusSort::sort(mpi_comm, localPairs, getMPITypePair<ValueType,IndexType>());
+        scai::dmemo::CommunicationPlan sendPlan( quantities.data(), numPEs );
+        scai::dmemo::CommunicationPlan recvPlan = comm->transpose( sendPlan );
+        std::vector<double> recvData( recvPlan.totalQuantity() );
+        comm->exchangeByPlan( recvData.data(), recvPlan, sendData.data(), sendPlan );
+
+        //the received runs are sorted, they are merged by sorting once more
+        const IndexType newLocalN = recvData.size()/2;
+        std::vector<double> recvHilbertInd(newLocalN);
+        for (IndexType i = 0; i < newLocalN; i++) {
+            recvHilbertInd[i] = recvData[2*i];
+        }
+        const std::vector<IndexType> recvPermutation = radixSortPermutation(getIntegerKeys(recvHilbertInd, keyBits), keyBits);
 
-        //copy hilbert indices into array
+        localPairs.resize(newLocalN);
+        for (IndexType i = 0; i < newLocalN; i++) {
+            localPairs[i].value = recvHilbertInd[recvPermutation[i]];
+            localPairs[i].index = IndexType(recvData[2*recvPermutation[i]+1]);
+        }
 
         //check size and sanity
         SCAI_ASSERT_EQ_ERROR( comm->sum(localPairs.size()), globalN, "Global index mismatch.");
@@ -767,7 +791,6 @@ std::vector<sort_pair<ValueType>> HilbertCurve<IndexType, ValueType>::getSortedH
         if( settings.debugMode) {
             PRINT0("******** in debug mode");
             unsigned long indexSumAfter = 0;
-            unsigned int newLocalN = localPairs.size();
             for (IndexType i=0; i<newLocalN; i++) {
                 indexSumAfter += localPairs[i].index;
             }
@@ -785,14 +808,30 @@ std::vector<sort_pair<ValueType>> HilbertCurve<IndexType, ValueType>::getSortedH
 
 
 template<typename IndexType, typename ValueType>
-void HilbertCurve<IndexType, ValueType>::redistribute(std::vector<DenseVector<ValueType> >& coordinates, std::vector<DenseVector<ValueType>>& nodeWeights, Settings settings, Metrics<ValueType>& metrics) {
+void HilbertCurve<IndexType, ValueType>::redistribute(std::vector<DenseVector<ValueType> >& coordinates, std::vector<DenseVector<ValueType>>& nodeWeights, Settings settings, Metrics<ValueType>& metrics, GeometryCache<IndexType, ValueType>* geometry) {
+    // the data is read before the results are written, so input and output can be the same
+    redistribute(coordinates, nodeWeights, coordinates, nodeWeights, settings, metrics, geometry);
+    if (geometry != nullptr) {
+        geometry->invalidate();
+    }
+}
+//-------------------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+void HilbertCurve<IndexType, ValueType>::redistribute(const std::vector<DenseVector<ValueType> >& coordinates, const std::vector<DenseVector<ValueType>>& nodeWeights, std::vector<DenseVector<ValueType> >& newCoordinates, std::vector<DenseVector<ValueType>>& newNodeWeights, Settings settings, Metrics<ValueType>& metrics, GeometryCache<IndexType, ValueType>* geometry) {
     SCAI_REGION_START("HilbertCurve.redistribute.sfc")
     scai::dmemo::DistributionPtr inputDist = coordinates[0].getDistributionPtr();
     scai::dmemo::CommunicatorPtr comm = inputDist->getCommunicatorPtr();
     const IndexType localN = inputDist->getLocalSize();
-    const IndexType globalN = inputDist->getGlobalSize();
 
     if (comm->getSize() == 1) {
+        if (&newCoordinates != &coordinates) {
+            newCoordinates = coordinates;
+        }
+        if (&newNodeWeights != &nodeWeights) {
+            newNodeWeights = nodeWeights;
+        }
+        SCAI_REGION_END("HilbertCurve.redistribute.sfc")
         return;
     }
 
@@ -806,92 +845,71 @@ void HilbertCurve<IndexType, ValueType>::redistribute(std::vector<DenseVector<Va
 
     std::chrono::duration<double> migrationCalculation, migrationTime;
 
-    std::vector<double> hilbertIndices = HilbertCurve<IndexType, ValueType>::getHilbertIndexVector(coordinates, settings.sfcResolution, settings.dimensions);
+    std::vector<double> hilbertIndices = HilbertCurve<IndexType, ValueType>::getHilbertIndexVector(coordinates, settings.sfcResolution, settings.dimensions, geometry);
     SCAI_REGION_END("HilbertCurve.redistribute.sfc")
     SCAI_REGION_START("HilbertCurve.redistribute.sort")
-    /*
-     * fill sort pair
-     */
 
-    scai::hmemo::HArray<IndexType> myGlobalIndices(localN, IndexType(0) );
-    inputDist->getOwnedIndexes(myGlobalIndices);
-    std::vector<sort_pair<ValueType>> localPairs(localN);
+    // only the splitters are needed, the points are moved by the migration below
+    const IndexType keyBits = getKeyBits(settings.sfcResolution, settings.dimensions);
+    const std::vector<std::uint64_t> keys = getIntegerKeys(hilbertIndices, keyBits);
+    std::vector<std::uint64_t> splitters;
     {
-        scai::hmemo::ReadAccess<IndexType> rIndices(myGlobalIndices);
+        const std::vector<IndexType> permutation = radixSortPermutation(keys, keyBits);
+        std::vector<std::uint64_t> sortedKeys(localN);
         for (IndexType i = 0; i < localN; i++) {
-            localPairs[i].value = hilbertIndices[i];
-            localPairs[i].index = rIndices[i];
+            sortedKeys[i] = keys[permutation[i]];
         }
+        splitters = getIntegerSplitters(sortedKeys, keyBits, comm);
     }
 
-    MPI_Comm mpi_comm = MPI_COMM_WORLD; //TODO: cast the communicator ptr to a MPI communicator and get getMPIComm()?
-
-    // as MPI communicator might have been splitted, take the one used by comm
-    if ( comm->getType() == scai::dmemo::CommunicatorType::MPI ){
-        const auto& mpiComm = static_cast<const scai::dmemo::MPICommunicator&>( *comm );
-        mpi_comm = mpiComm.getMPIComm();
-    }
-
-    //JanusSort::sort(mpi_comm, localPairs, MPI_DOUBLE_INT);
-    JanusSort::sort(mpi_comm, localPairs, getMPITypePair<ValueType,IndexType>() );
-
     migrationCalculation = std::chrono::steady_clock::now() - beforeInitPart;
     metrics.MM["timeMigrationAlgo"] = migrationCalculation.count();
     std::chrono::time_point < std::chrono::steady_clock > beforeMigration = std::chrono::steady_clock::now();
-    assert(localPairs.size() > 0);
 
     SCAI_REGION_END("HilbertCurve.redistribute.sort")
 
-    sort_pair<ValueType> minLocalIndex = localPairs[0];
-    std::vector<double> sendThresholds(comm->getSize(), minLocalIndex.value);
-    std::vector<double> recvThresholds(comm->getSize());
-
-    comm->all2all(recvThresholds.data(), sendThresholds.data());//TODO: maybe speed up with hypercube
-    SCAI_ASSERT_LT_ERROR(recvThresholds[comm->getSize() - 1], 1, "invalid hilbert index");
-    SCAI_ASSERT_GE_ERROR(recvThresholds[comm->getSize() - 1], 0, "invalid hilbert index");
-    // merge to get quantities //Problem: nodes are not sorted according to their hilbert indices, so accesses are not aligned.
-    // Need to sort before and after communication
-    assert(std::is_sorted(recvThresholds.begin(), recvThresholds.end()));
-
-    std::vector<IndexType> permutation(localN);
-    std::iota(permutation.begin(), permutation.end(), 0);
-    std::sort(permutation.begin(), permutation.end(), [&](IndexType i, IndexType j) {
-        return hilbertIndices[i] < hilbertIndices[j];
-    });
-
-    //now sorting hilbert indices themselves
-    std::sort(hilbertIndices.begin(), hilbertIndices.end());
-    std::vector<IndexType> quantities(comm->getSize(), 0);
+    // the new owner of every local point is the PE whose splitter range contains its key
+    scai::hmemo::HArray<IndexType> newOwners(localN);
     {
-        IndexType p = 0;
+        scai::hmemo::WriteOnlyAccess<IndexType> wOwners(newOwners, localN);
+        #pragma omp parallel for
         for (IndexType i = 0; i < localN; i++) {
-            //increase target block counter if threshold is reached. Skip empty blocks if necessary.
-            while (p + 1 < comm->getSize()
-                    && recvThresholds[p + 1] <= hilbertIndices[i]) {
-                p++;
-            }
+            const IndexType p = std::upper_bound(splitters.begin()+1, splitters.end(), keys[i]) - splitters.begin() - 1;
             assert(p < comm->getSize());
-
-            quantities[p]++;
+            wOwners[i] = p;
         }
     }
 
-    SCAI_REGION_START("HilbertCurve.redistribute.communicationPlan")
-
-    // allocate sendPlan
-    scai::dmemo::CommunicationPlan sendPlan(quantities.data(), comm->getSize());
-    SCAI_ASSERT_EQ_ERROR(sendPlan.totalQuantity(), localN, "wrong size of send plan")
-
-    // allocate recvPlan - either with allocateTranspose, or directly
-    scai::dmemo::CommunicationPlan recvPlan = comm->transpose( sendPlan );
-    const IndexType newLocalN = recvPlan.totalQuantity();
+    // all coordinates and weights are moved together; constant weights are not sent but set again afterwards
+    newCoordinates.resize(settings.dimensions);
+    newNodeWeights.resize(numNodeWeights);
+    std::vector<const DenseVector<ValueType>*> sources;
+    std::vector<DenseVector<ValueType>*> targets;
+    for (IndexType d = 0; d < settings.dimensions; d++) {
+        sources.push_back(&coordinates[d]);
+        targets.push_back(&newCoordinates[d]);
+    }
+    std::vector<ValueType> constantWeights(numNodeWeights);
+    for (IndexType w = 0; w < numNodeWeights; w++) {
+        if (nodesUnweighted) {
+            constantWeights[w] = scai::hmemo::ReadAccess<ValueType>(nodeWeights[w].getLocalValues())[0];
+        } else {
+            sources.push_back(&nodeWeights[w]);
+            targets.push_back(&newNodeWeights[w]);
+        }
+    }
 
-    SCAI_REGION_END("HilbertCurve.redistribute.communicationPlan")
+    scai::dmemo::DistributionPtr newDist;
+    {
+        SCAI_REGION("HilbertCurve.redistribute.redistribute");
+        newDist = Migration<IndexType, ValueType>::migrateCopyByNewOwners(newOwners, sources, targets);
+    }
+    const IndexType newLocalN = newDist->getLocalSize();
 
     if (settings.verbose) {
         PRINT(comm->getRank()<<": " << localN << " old local values, " << newLocalN << " new ones.");
     }
-    
+
     //in some rare cases it can happen that some PE(s) do not get
     //any new local points; TODO: debug/investigate
 
@@ -899,88 +917,156 @@ void HilbertCurve<IndexType, ValueType>::redistribute(std::vector<DenseVector<Va
         throw std::runtime_error( "PE " + std::to_string(comm->getRank()) + " has no points after redistribution of Hilbert indices. It may be that the curve resolution is too small. Current value is " + std::to_string(settings.sfcResolution) + ". Retry using a higher value through the --sfcResolution argument. Setting the --verbose option may also provide additional information" );
      }
 
-    //transmit indices, allowing for resorting of the received values
-    std::vector<IndexType> sendIndices(localN);
-    {
-        SCAI_REGION("HilbertCurve.redistribute.permute");
-        scai::hmemo::ReadAccess<IndexType> rIndices(myGlobalIndices);
-        for (IndexType i = 0; i < localN; i++) {
-            assert(permutation[i] < localN);
-            assert(permutation[i] >= 0);
-            sendIndices[i] = rIndices[permutation[i]];
+    if (nodesUnweighted) {
+        for (IndexType w = 0; w < numNodeWeights; w++) {
+            newNodeWeights[w] = DenseVector<ValueType>(newDist, constantWeights[w]);
         }
     }
-    std::vector<IndexType> recvIndices(newLocalN);
-    comm->exchangeByPlan(recvIndices.data(), recvPlan, sendIndices.data(), sendPlan);
-    //get new distribution
-    scai::hmemo::HArray<IndexType> indexTransport(newLocalN, recvIndices.data());
-    
-    auto newDist = scai::dmemo::generalDistributionUnchecked(globalN, std::move(indexTransport), comm);
+    migrationTime = std::chrono::steady_clock::now() - beforeMigration;
+    metrics.MM["timeFirstDistribution"] = migrationTime.count();
+    assert( confirmHilbertDistribution(newCoordinates, newNodeWeights[0], settings) );
+}
+//-------------------------------------------------------------------------------------------------
+template<typename IndexType, typename ValueType>
+IndexType HilbertCurve<IndexType, ValueType>::getKeyBits(const IndexType recursionDepth, const IndexType dimensions) {
+    //getHilbertIndexVector reduces the recursion depth in the same way
+    const IndexType curveBits = dimensions * std::min(recursionDepth, IndexType(sizeof(double) * CHAR_BIT / dimensions));
+    return std::min(curveBits, IndexType(std::numeric_limits<double>::digits));
+}
+//-------------------------------------------------------------------------------------------------
 
-    SCAI_ASSERT_EQUAL(newDist->getLocalSize(), newLocalN,
-                      "wrong size of new distribution");
-    for (IndexType i = 0; i < newLocalN; i++) {
-        SCAI_ASSERT_VALID_INDEX_DEBUG(recvIndices[i], globalN, "invalid index");
+template<typename IndexType, typename ValueType>
+std::vector<std::uint64_t> HilbertCurve<IndexType, ValueType>::getIntegerKeys(const std::vector<double> &hilbertIndices, const IndexType keyBits) {
+    const double scale = std::ldexp(1.0, keyBits);
+    const std::uint64_t maxKey = (std::uint64_t(1) << keyBits) - 1;
+
+    std::vector<std::uint64_t> keys(hilbertIndices.size());
+    for (std::size_t i = 0; i < hilbertIndices.size(); i++) {
+        assert(hilbertIndices[i] >= 0);
+        keys[i] = std::min(std::uint64_t(hilbertIndices[i] * scale), maxKey);
     }
+    return keys;
+}
+//-------------------------------------------------------------------------------------------------
 
-    {
-        SCAI_REGION("HilbertCurve.redistribute.redistribute");
-        // for each dimension: define DenseVector with new distribution, get write access to local values, call exchangeByPlan
-        std::vector<ValueType> sendBuffer(localN);
-        std::vector<ValueType> recvBuffer(newLocalN);
-
-        for (IndexType d = 0; d < settings.dimensions; d++) {
-            {
-                SCAI_REGION("HilbertCurve.redistribute.redistribute.permute");
-                scai::hmemo::ReadAccess<ValueType> rCoords(coordinates[d].getLocalValues());
-                for (IndexType i = 0; i < localN; i++) { //TODO:maybe extract into lambda?
-                    sendBuffer[i] = rCoords[permutation[i]]; //TODO: how to make this more cache-friendly? (Probably by using pairs and sorting them.)
-                }
-            }
+template<typename IndexType, typename ValueType>
+std::vector<IndexType> HilbertCurve<IndexType, ValueType>::radixSortPermutation( const std::vector<std::uint64_t> &keys, const IndexType keyBits) {
+    SCAI_REGION("HilbertCurve.radixSortPermutation")
 
-            comm->exchangeByPlan(recvBuffer.data(), recvPlan, sendBuffer.data(), sendPlan);
-            coordinates[d] = DenseVector<ValueType>(newDist, 0);
-            {
-                SCAI_REGION("HilbertCurve.redistribute.redistribute.permute");
-                scai::hmemo::WriteAccess<ValueType> wCoords(coordinates[d].getLocalValues());
-                assert(wCoords.size() == newLocalN);
-                for (IndexType i = 0; i < newLocalN; i++) {
-                    wCoords[newDist->global2Local(recvIndices[i])] =
-                        recvBuffer[i];
-                }
+    const IndexType n = keys.size();
+    const IndexType numBuckets = IndexType(1) << radixBits;
+
+    std::vector<IndexType> permutation(n);
+    std::iota(permutation.begin(), permutation.end(), 0);
+    std::vector<IndexType> buffer(n);
+    std::vector<IndexType> offsets(numBuckets);
+
+    //least significant digit first, every pass is stable
+    for (IndexType shift = 0; shift < keyBits; shift += radixBits) {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (IndexType i = 0; i < n; i++) {
+            offsets[(keys[i] >> shift) & (numBuckets - 1)]++;
+        }
+        IndexType sum = 0;
+        for (IndexType b = 0; b < numBuckets; b++) {
+            const IndexType count = offsets[b];
+            offsets[b] = sum;
+            sum += count;
+        }
+        for (IndexType i = 0; i < n; i++) {
+            const IndexType v = permutation[i];
+            buffer[offsets[(keys[v] >> shift) & (numBuckets - 1)]++] = v;
+        }
+        std::swap(permutation, buffer);
+    }
+
+    return permutation;
+}
+//-------------------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+std::vector<std::uint64_t> HilbertCurve<IndexType, ValueType>::getIntegerSplitters( const std::vector<std::uint64_t> &sortedLocalKeys, const IndexType keyBits, const scai::dmemo::CommunicatorPtr comm) {
+    SCAI_REGION("HilbertCurve.getIntegerSplitters")
+
+    SCAI_ASSERT_LT_ERROR( keyBits, 64, "Too many bits for the keys" );
+    assert(std::is_sorted(sortedLocalKeys.begin(), sortedLocalKeys.end()));
+
+    const IndexType numPEs = comm->getSize();
+    const IndexType globalN = comm->sum( IndexType(sortedLocalKeys.size()) );
+
+    std::vector<std::uint64_t> splitters(numPEs + 1, 0);
+    splitters[numPEs] = std::uint64_t(1) << keyBits;
+
+    //for every inner splitter: the number of keys before it, the prefix of the bucket that contains the key at this
+    //position, the number of keys before this bucket and in it
+    std::vector<IndexType> target(numPEs, 0);
+    std::vector<std::uint64_t> prefix(numPEs, 0);
+    std::vector<IndexType> before(numPEs, 0);
+    std::vector<IndexType> bucketSize(numPEs, globalN);
+    std::vector<bool> done(numPEs, true);
+    for (IndexType i = 1; i < numPEs; i++) {
+        target[i] = IndexType( (long long)(i) * globalN / numPEs );
+        done[i] = (target[i] == 0);
+    }
+
+    IndexType prefixBits = 0;
+    while (prefixBits < keyBits and std::find(done.begin(), done.end(), false) != done.end()) {
+        const IndexType digitBits = std::min(histogramBits, keyBits - prefixBits);
+        const IndexType numDigits = IndexType(1) << digitBits;
+        const IndexType shift = keyBits - prefixBits - digitBits;
+
+        //the targets are increasing, so are the prefixes; they are the same on all PEs
+        std::vector<std::uint64_t> activePrefixes;
+        for (IndexType i = 1; i < numPEs; i++) {
+            if (!done[i]) activePrefixes.push_back(prefix[i]);
+        }
+        activePrefixes.erase(std::unique(activePrefixes.begin(), activePrefixes.end()), activePrefixes.end());
+
+        //the local histograms of the next digit in every active bucket
+        std::vector<IndexType> histogram(activePrefixes.size() * numDigits, 0);
+        for (std::size_t a = 0; a < activePrefixes.size(); a++) {
+            const std::uint64_t first = activePrefixes[a] << (keyBits - prefixBits);
+            const std::uint64_t last = (activePrefixes[a] + 1) << (keyBits - prefixBits);
+            const auto begin = std::lower_bound(sortedLocalKeys.begin(), sortedLocalKeys.end(), first);
+            const auto end = std::lower_bound(begin, sortedLocalKeys.end(), last);
+            for (auto it = begin; it != end; it++) {
+                histogram[a * numDigits + ((*it >> shift) & (numDigits - 1))]++;
             }
         }
-        // same for node weights
-        for (IndexType w = 0; w < numNodeWeights; w++) {
-            if (nodesUnweighted) {
-                nodeWeights[w] = DenseVector<ValueType>(newDist, nodeWeights[w].getLocalValues()[0]);
+        comm->sumImpl(histogram.data(), histogram.data(), histogram.size(), scai::common::TypeTraits<IndexType>::stype);
+
+        //descend into the sub-bucket that contains the target position
+        for (IndexType i = 1; i < numPEs; i++) {
+            if (done[i]) continue;
+            const IndexType a = std::lower_bound(activePrefixes.begin(), activePrefixes.end(), prefix[i]) - activePrefixes.begin();
+            IndexType digit = 0;
+            while (before[i] + histogram[a * numDigits + digit] <= target[i]) {
+                before[i] += histogram[a * numDigits + digit];
+                digit++;
+                SCAI_ASSERT_LT_DEBUG( digit, numDigits, "Target position not in bucket" );
             }
-            else
-            {
-                {
-                    SCAI_REGION("HilbertCurve.redistribute.redistribute.permute");
-                    scai::hmemo::ReadAccess<ValueType> rWeights(nodeWeights[w].getLocalValues());
-                    for (IndexType i = 0; i < localN; i++) {
-                        sendBuffer[i] = rWeights[permutation[i]]; //TODO: how to make this more cache-friendly? (Probably by using pairs and sorting them.)
-                    }
-                }
-                comm->exchangeByPlan(recvBuffer.data(), recvPlan, sendBuffer.data(), sendPlan);
-                nodeWeights[w] = DenseVector<ValueType>(newDist, 0);
-                {
-                    SCAI_REGION("HilbertCurve.redistribute.redistribute.permute");
-                    scai::hmemo::WriteAccess<ValueType> wWeights(nodeWeights[w].getLocalValues());
-                    for (IndexType i = 0; i < newLocalN; i++) {
-                        wWeights[newDist->global2Local(recvIndices[i])] = recvBuffer[i];
-                    }
-                }
+            prefix[i] = (prefix[i] << digitBits) | std::uint64_t(digit);
+            bucketSize[i] = histogram[a * numDigits + digit];
+            if (before[i] == target[i]) {
+                splitters[i] = prefix[i] << shift;
+                done[i] = true;
             }
         }
+        prefixBits += digitBits;
     }
-    migrationTime = std::chrono::steady_clock::now() - beforeMigration;
-    metrics.MM["timeFirstDistribution"] = migrationTime.count();
-    assert( confirmHilbertDistribution(coordinates, nodeWeights[0], settings) );
+
+    //the remaining buckets hold only equal keys, the splitter goes to the closer end
+    for (IndexType i = 1; i < numPEs; i++) {
+        if (!done[i]) {
+            splitters[i] = prefix[i] + (2 * (target[i] - before[i]) > bucketSize[i] ? 1 : 0);
+        }
+    }
+
+    assert(std::is_sorted(splitters.begin(), splitters.end()));
+    return splitters;
 }
 //-------------------------------------------------------------------------------------------------
+
 template<typename IndexType, typename ValueType>
 bool HilbertCurve<IndexType, ValueType>::confirmHilbertDistribution(
     //const scai::lama::CSRSparseMatrix<ValueType> &graph,
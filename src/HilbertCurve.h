@@ -10,6 +10,7 @@
 #include <assert.h>
 #include <cmath>
 #include <climits>
+#include <cstdint>
 #include <queue>
 #include <algorithm>
 
@@ -30,6 +31,7 @@
 
 #include "Settings.h"
 #include "Metrics.h"
+#include "GeometryCache.h"
 
 
 namespace ITI {
@@ -75,10 +77,11 @@ public:
      *
      * @param coordinates Coordinates of the input points
      * @param settings Settings struct
+     * @param geometry If given, the bounding box of the coordinates is taken from it
      *
      * @return partition DenseVector, redistributed according to the partition
      */
-    static scai::lama::DenseVector<IndexType> computePartition(const std::vector<DenseVector<ValueType>> &coordinates, Settings settings);
+    static scai::lama::DenseVector<IndexType> computePartition(const std::vector<DenseVector<ValueType>> &coordinates, Settings settings, GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
     /** \overload
     @param[in] nodeWeights Weights for the points
@@ -107,10 +110,11 @@ public:
      * @param[in] coordinates The coordinates of all the points
      * @param[in] recursionDepth The number of refinement levels the hilbert curve should have
      * @param[in] dimensions Number of dimensions of coordinates.
+     * @param[in] geometry If given, the bounding box of the coordinates is taken from it instead of computing it with a global reduction
      *
      * @return A vector with the hilbert indices for every local point. return.size()=coordinates[0].size()
      */
-    static std::vector<double> getHilbertIndexVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth, const IndexType dimensions);
+    static std::vector<double> getHilbertIndexVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth, const IndexType dimensions, GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
     //
     //reverse: from hilbert index to 2D/3D point
@@ -149,9 +153,32 @@ public:
      * So i and k=return[i].index are unrelated
      *
      * @param[in] coordinates The coordinates of all the points
+     * @param[in] geometry If given, the bounding box of the coordinates is taken from it
      * @return A sorted vector based on the hilbert index of each point.
      */
-    static std::vector<sort_pair<ValueType>> getSortedHilbertIndices( const std::vector<DenseVector<ValueType>> &coordinates, Settings settings);
+    static std::vector<sort_pair<ValueType>> getSortedHilbertIndices( const std::vector<DenseVector<ValueType>> &coordinates, Settings settings, GeometryCache<IndexType, ValueType>* geometry = nullptr);
+
+    /** @brief Stable radix sort of integer keys. Local operation.
+     *
+     * @param[in] keys The keys, all smaller than 2^keyBits.
+     * @param[in] keyBits The number of significant bits of the keys.
+     *
+     * @return The sorting permutation: keys[return[0]] <= keys[return[1]] <= ...
+     */
+    static std::vector<IndexType> radixSortPermutation( const std::vector<std::uint64_t> &keys, const IndexType keyBits);
+
+    /** @brief Splitters of distributed integer keys such that every PE gets about the same number of keys. Global operation.
+     *
+     * The keys are not sorted globally. Instead, the buckets that contain a splitter are refined by histogramBits bits in
+     * every round, with one sum reduction of their histograms, until the splitter is exact or its bucket holds only equal keys.
+     *
+     * @param[in] sortedLocalKeys The local keys, sorted, all smaller than 2^keyBits.
+     * @param[in] keyBits The number of significant bits of the keys.
+     * @param[in] comm The communicator.
+     *
+     * @return p+1 replicated splitters, PE i gets the keys in [return[i], return[i+1]). return[0]=0 and return[p]=2^keyBits.
+     */
+    static std::vector<std::uint64_t> getIntegerSplitters( const std::vector<std::uint64_t> &sortedLocalKeys, const IndexType keyBits, const scai::dmemo::CommunicatorPtr comm);
 
     /** Redistribute coordinates and weights according to an implicit hilberPartition.
      * Equivalent to (but faster):
@@ -165,8 +192,22 @@ public:
      *  @param[in,out] nodeWeights NodeWeights of input points, will be redistributed
      *  @param[in] settings Settings struct, effectively only needed for the hilbert curve resolution
      *  @param[out] metrics
+     *  @param[in,out] geometry If given, the bounding box of the coordinates is taken from it. Its local box is invalidated.
      */
-    static void redistribute(std::vector<DenseVector<ValueType> >& coordinates, std::vector<DenseVector<ValueType>>& nodeWeights, Settings settings, Metrics<ValueType>& metrics);
+    static void redistribute(std::vector<DenseVector<ValueType> >& coordinates, std::vector<DenseVector<ValueType>>& nodeWeights, Settings settings, Metrics<ValueType>& metrics, GeometryCache<IndexType, ValueType>* geometry = nullptr);
+
+    /** Same as redistribute() above, but the input is not changed and the redistributed data is stored in new vectors.
+     * The input is only read, so no copy of it is needed to keep the original.
+     *
+     *  @param[in] coordinates Coordinates of input points
+     *  @param[in] nodeWeights NodeWeights of input points
+     *  @param[out] newCoordinates The redistributed coordinates
+     *  @param[out] newNodeWeights The redistributed node weights
+     *  @param[in] settings Settings struct, effectively only needed for the hilbert curve resolution
+     *  @param[out] metrics
+     *  @param[in] geometry If given, the bounding box of the input coordinates is taken from it
+     */
+    static void redistribute(const std::vector<DenseVector<ValueType> >& coordinates, const std::vector<DenseVector<ValueType>>& nodeWeights, std::vector<DenseVector<ValueType> >& newCoordinates, std::vector<DenseVector<ValueType>>& newNodeWeights, Settings settings, Metrics<ValueType>& metrics, GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
     /** @brief Checks if all the input data are distributed to PEs according to the hilbert index curve of the coordinates
 
@@ -184,13 +225,25 @@ public:
 
 
 private:
+    /** @brief The number of bits of the integer keys of a curve, at most the precision of a double.
+     */
+    static IndexType getKeyBits(const IndexType recursionDepth, const IndexType dimensions);
+
+    /** @brief Converts hilbert indices in [0,1] to integer keys with keyBits bits in the same order.
+     */
+    static std::vector<std::uint64_t> getIntegerKeys(const std::vector<double> &hilbertIndices, const IndexType keyBits);
+
+    /** Bits per pass of radixSortPermutation and per refinement round of getIntegerSplitters. */
+    static constexpr IndexType radixBits = 11;
+    static constexpr IndexType histogramBits = 8;
+
     /** @brief Accepts a 2D point and returns is hilbert index.
      */
     static double getHilbertIndex2D(ValueType const * point, IndexType dimensions, IndexType recursionDepth, const std::vector<ValueType> &minCoords, const std::vector<ValueType> &maxCoords);
 
     /** @brief Gets a vector of coordinates in 2D as input and returns a vector with the hilbert indices for all coordinates.
      */
-    static std::vector<double> getHilbertIndex2DVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth);
+    static std::vector<double> getHilbertIndex2DVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth, GeometryCache<IndexType, ValueType>* geometry = nullptr);
     /**
     *@brief Accepts a point in 3 dimensions and calculates where along the hilbert curve it lies.
     *
@@ -208,7 +261,7 @@ private:
     /* Gets a vector of coordinates (either 2D or 3D) as input and returns a vector with the
      * hilbert indices for all coordinates.
      */
-    static std::vector<double> getHilbertIndex3DVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth);
+    static std::vector<double> getHilbertIndex3DVector (const std::vector<DenseVector<ValueType>> &coordinates, IndexType recursionDepth, GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
     //
     //reverse: from hilbert index to 2D/3D point
@@ -4,6 +4,7 @@
 #include <scai/lama/matutils/MatrixCreator.hpp>
 
 #include <scai/dmemo/BlockDistribution.hpp>
+#include <scai/dmemo/CyclicDistribution.hpp>
 
 #include <scai/hmemo/Context.hpp>
 #include <scai/hmemo/HArray.hpp>
@@ -16,10 +17,13 @@
 #include <iostream>
 #include <chrono>
 #include <type_traits>
+#include <random>
+#include <numeric>
 
 #include "GraphUtils.h"
 #include "gtest/gtest.h"
 #include "HilbertCurve.h"
+#include "GeometryCache.h"
 #include "FileIO.h"
 
 using namespace scai;
@@ -593,6 +597,130 @@ TYPED_TEST(HilbertCurveTest, testGetSortedHilbertIndices_Distributed) {
     }
 
 }
+//-------------------------------------------------------------------------------------------------
+
+TYPED_TEST(HilbertCurveTest, testIntegerKeySplitters) {
+    using ValueType = TypeParam;
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType numPEs = comm->getSize();
+    const IndexType keyBits = 30;
+    const IndexType localN = 1000 + 100*comm->getRank();
+
+    //distinct random keys with some duplicates of a few values
+    std::mt19937 generator(comm->getRank());
+    std::uniform_int_distribution<std::uint64_t> keyDist(0, (std::uint64_t(1) << keyBits) - 1);
+    std::vector<std::uint64_t> keys(localN);
+    for (IndexType i = 0; i < localN; i++) {
+        keys[i] = i % 10 == 0 ? 42 : keyDist(generator);
+    }
+
+    //the radix sort is a stable sort
+    const std::vector<IndexType> permutation = HilbertCurve<IndexType, ValueType>::radixSortPermutation(keys, keyBits);
+    ASSERT_EQ( permutation.size(), localN );
+    std::vector<IndexType> expected(localN);
+    std::iota(expected.begin(), expected.end(), 0);
+    std::stable_sort(expected.begin(), expected.end(), [&keys](IndexType a, IndexType b) {
+        return keys[a] < keys[b];
+    });
+    EXPECT_EQ( permutation, expected );
+
+    std::vector<std::uint64_t> sortedKeys(localN);
+    for (IndexType i = 0; i < localN; i++) {
+        sortedKeys[i] = keys[permutation[i]];
+    }
+    const std::vector<std::uint64_t> splitters = HilbertCurve<IndexType, ValueType>::getIntegerSplitters(sortedKeys, keyBits, comm);
+    ASSERT_EQ( splitters.size(), numPEs + 1 );
+    EXPECT_EQ( splitters[0], 0 );
+    EXPECT_EQ( splitters[numPEs], std::uint64_t(1) << keyBits );
+    EXPECT_TRUE( std::is_sorted(splitters.begin(), splitters.end()) );
+
+    //the number of keys before every splitter is within the duplicates of the optimum
+    const IndexType globalN = comm->sum(localN);
+    const IndexType numDuplicates = comm->sum( (localN + 9)/10 );
+    for (IndexType i = 1; i < numPEs; i++) {
+        const IndexType localBefore = std::lower_bound(sortedKeys.begin(), sortedKeys.end(), splitters[i]) - sortedKeys.begin();
+        const IndexType globalBefore = comm->sum(localBefore);
+        const IndexType optimum = IndexType( (long long)(i) * globalN / numPEs );
+        EXPECT_LE( std::abs(globalBefore - optimum), numDuplicates/2 + 1 ) << "splitter " << i;
+        if (splitters[i] != 42 and splitters[i] != 43) {
+            EXPECT_EQ( globalBefore, optimum ) << "splitter " << i;
+        }
+    }
+}
+//-------------------------------------------------------------------------------------------------
+
+TYPED_TEST(HilbertCurveTest, testGeometryCacheBoundingBoxes) {
+    using ValueType = TypeParam;
+
+    std::string fileName = "trace-00008.graph";
+    std::string file = HilbertCurveTest<ValueType>::graphPath + fileName;
+    const IndexType dimensions = 2;
+    const IndexType k = 5;
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    CSRSparseMatrix<ValueType> graph = FileIO<IndexType, ValueType>::readGraph( file, comm );
+    const IndexType N = graph.getNumRows();
+    std::vector<DenseVector<ValueType>> coordinates = FileIO<IndexType, ValueType>::readCoords( std::string(file + ".xyz"), N, dimensions);
+
+    typedef typename GeometryCache<IndexType, ValueType>::BoundingBox BoundingBox;
+    const BoundingBox box = GeometryCache<IndexType, ValueType>::computeGlobalBoundingBox( coordinates );
+    for (IndexType d = 0; d < dimensions; d++) {
+        EXPECT_EQ( coordinates[d].min(), box.first[d] );
+        EXPECT_EQ( coordinates[d].max(), box.second[d] );
+    }
+
+    // an object computes the box once and gives the same result
+    {
+        GeometryCache<IndexType, ValueType> geometry( coordinates );
+        EXPECT_EQ( box, geometry.getGlobalBoundingBox() );
+        EXPECT_EQ( box, geometry.getGlobalBoundingBox() );
+        const BoundingBox localBox = geometry.getLocalBoundingBox();
+        for (IndexType d = 0; d < dimensions; d++) {
+            EXPECT_LE( box.first[d], localBox.first[d] );
+            EXPECT_GE( box.second[d], localBox.second[d] );
+        }
+
+        // after a redistribution only the local box is recomputed, a redistributed copy takes the global box over
+        std::vector<DenseVector<ValueType>> copy( coordinates );
+        const scai::dmemo::DistributionPtr cyclicDist( new scai::dmemo::CyclicDistribution(N, 3, comm) );
+        for (IndexType d = 0; d < dimensions; d++) {
+            coordinates[d].redistribute( cyclicDist );
+        }
+        geometry.invalidate();
+        EXPECT_EQ( GeometryCache<IndexType, ValueType>::computeLocalBoundingBox( coordinates ), geometry.getLocalBoundingBox() );
+        EXPECT_EQ( box, geometry.getGlobalBoundingBox() );
+
+        GeometryCache<IndexType, ValueType> copyGeometry( copy, geometry );
+        EXPECT_EQ( box, copyGeometry.getGlobalBoundingBox() );
+        EXPECT_EQ( GeometryCache<IndexType, ValueType>::computeLocalBoundingBox( copy ), copyGeometry.getLocalBoundingBox() );
+    }
+
+    // there is no shared state, changed coordinates give the new box
+    coordinates[0] *= 2;
+    EXPECT_EQ( coordinates[0].max(), GeometryCache<IndexType, ValueType>::computeGlobalBoundingBox( coordinates ).second[0] );
+
+    // every point lies in the bounding box of its block
+    DenseVector<IndexType> partition( coordinates[0].getDistributionPtr(), 0 );
+    {
+        scai::hmemo::WriteAccess<IndexType> wPart( partition.getLocalValues() );
+        for (IndexType i = 0; i < wPart.size(); i++) {
+            wPart[i] = coordinates[0].getDistributionPtr()->local2Global(i) % k;
+        }
+    }
+    const std::vector<BoundingBox> blockBoxes = GeometryCache<IndexType, ValueType>::getBlockBoundingBoxes( coordinates, partition, k );
+    ASSERT_EQ( k, blockBoxes.size() );
+
+    scai::hmemo::ReadAccess<IndexType> rPart( partition.getLocalValues() );
+    for (IndexType d = 0; d < dimensions; d++) {
+        scai::hmemo::ReadAccess<ValueType> rCoords( coordinates[d].getLocalValues() );
+        for (IndexType i = 0; i < rCoords.size(); i++) {
+            EXPECT_LE( blockBoxes[rPart[i]].first[d], rCoords[i] );
+            EXPECT_GE( blockBoxes[rPart[i]].second[d], rCoords[i] );
+        }
+    }
+}
+//-------------------------------------------------------------------------------------------------
 
 //No way to combine typed and value test. See:
 // https://stackoverflow.com/questions/8507385/google-test-is-there-a-way-to-combine-a-test-which-is-both-type-parameterized-a
@@ -15,10 +15,12 @@
 
 #include "KMeans.h"
 #include "HilbertCurve.h"
+#include "GeometryCache.h"
 #include "MultiLevel.h"
 #include "quadtree/QuadNodeCartesianEuclid.h"
 // temporary, for debugging
 #include "FileIO.h"
+#include "Telemetry.h"
 
 namespace ITI {
 
@@ -33,7 +35,8 @@ std::vector<std::vector<point<ValueType>>> KMeans<IndexType,ValueType>::findInit
      const std::vector<ValueType> &maxCoords,
      const scai::lama::DenseVector<IndexType> &partition,
      const std::vector<cNode<IndexType,ValueType>> hierLevel,
-Settings settings) {
+Settings settings,
+GeometryCache<IndexType, ValueType>* geometry) {
 
     SCAI_REGION("KMeans.findInitialCentersSFC");
     const IndexType localN = coordinates[0].getLocalValues().size();
@@ -68,7 +71,7 @@ Settings settings) {
     std::vector<IndexType> sortedLocalIndices(localN);
     {
         // get local hilbert indices
-        std::vector<double> sfcIndices = HilbertCurve<IndexType, ValueType>::getHilbertIndexVector(coordinates, settings.sfcResolution, settings.dimensions);
+        std::vector<double> sfcIndices = HilbertCurve<IndexType, ValueType>::getHilbertIndexVector(coordinates, settings.sfcResolution, settings.dimensions, geometry);
         SCAI_ASSERT_EQ_ERROR(sfcIndices.size(), localN, "wrong local number of indices (?) ");
 
         // prepare indices for sorting
@@ -179,6 +182,12 @@ Settings settings) {
     IndexType sumOfRanges = 0;
     IndexType numOwnedCenters = 0;
 
+    // the within-block index of the next local point of every block and
+    // the first center of every block that this PE might own. The wanted
+    // indices of a block are sorted, so one sweep over the local points in
+    // SFC order finds all owned centers
+    std::vector<IndexType> withinBlockIndex(numOldBlocks);
+    std::vector<IndexType> nextCenter(numOldBlocks);
     for (IndexType b=0; b<numOldBlocks; b++) {
         IndexType fromInd = b*(numPEs+1)+thisPE;
         assert(fromInd+1<concatPrefixSumArray.size());
@@ -187,57 +196,35 @@ Settings settings) {
         IndexType rangeStart = concatPrefixSumArray[ fromInd ];
         IndexType rangeEnd = concatPrefixSumArray[ fromInd+1];
         sumOfRanges += rangeEnd-rangeStart;
-        // keep a counter that indicates the index of a point within
-        // a block in this PE.
-        IndexType counter = rangeStart;
 
-        // center indices for block b, pass by reference so not to copy
         const std::vector<IndexType>& centersForThisBlock = newCenterIndWithinBLock[b];
-
-        // TODO: optimize? Now, complexity is localN*number of owned centers
-        // can we do it with one linear scan? Well, newCenterIndWithinBLock[b] is expected
-        // to be kinf of small unless k>>p
-
-        // if some center indexes are local in this PE, store them.
-        // Later, we will scan the local points for their coordinates
-        for (unsigned int j=0; j<centersForThisBlock.size(); j++) {
-            IndexType centerInd = centersForThisBlock[j];
-            counter = rangeStart;// reset counter for next center
-            // if center index for block b is owned by thisPE
-            if (centerInd>=rangeStart and centerInd<=rangeEnd) {
-
-                // since we own a center, go over all local points
-                // and calculate their within-block index for the block
-                // they belong to
-                scai::hmemo::ReadAccess<IndexType> localPart = partition.getLocalValues();
-                for (unsigned int i=0; i<localN; i++) {
-                    // consider points based on their sorted sfc index
-                    IndexType sortedIndex = sortedLocalIndices[i];
-                    IndexType thisPointBlock = localPart[ sortedIndex ];
-                    // TODO: remove assertion?
-                    assert(thisPointBlock<numOldBlocks);
-                    if (thisPointBlock!=b) {
-                        continue;// not in desired block
-                    }
-
-                    IndexType withinBlockIndex = counter;
-                    // desired center found
-                    if (withinBlockIndex==centerInd) {
-                        // store center coords
-                        centersPerNewBlock[b][j] = convertedCoords[ sortedIndex ];
-                        numOwnedCenters++;
-                        // PRINT(*comm <<": adding center "<< centerInd << " with coordinates " << convertedCoords[sortedIndex][0] << ", " << convertedCoords[sortedIndex][1]);
-                        break;
-                    }
-                    counter++;
-                }// for i<localN
-                SCAI_ASSERT_LE_ERROR(counter, rangeEnd, "Within-block index out of bounds");
-            }// if center is local
-        }// for j<centersForThisBlock.size()
-    }// for b<numOldBlocks
+        SCAI_ASSERT_DEBUG(std::is_sorted(centersForThisBlock.begin(), centersForThisBlock.end()), "Center indices must be sorted");
+        withinBlockIndex[b] = rangeStart;
+        nextCenter[b] = std::lower_bound(centersForThisBlock.begin(), centersForThisBlock.end(), rangeStart) - centersForThisBlock.begin();
+    }
 
     SCAI_ASSERT_EQ_ERROR(sumOfRanges, localN, thisPE << ": Sum of owned number of points per block should be equal the total number of local points");
 
+    {
+        scai::hmemo::ReadAccess<IndexType> localPart = partition.getLocalValues();
+        for (IndexType i=0; i<localN; i++) {
+            // consider points based on their sorted sfc index
+            IndexType sortedIndex = sortedLocalIndices[i];
+            IndexType b = localPart[ sortedIndex ];
+            assert(b<numOldBlocks);
+
+            const std::vector<IndexType>& centersForThisBlock = newCenterIndWithinBLock[b];
+            // several centers can have the same index if the block has fewer points than centers
+            while (nextCenter[b]<centersForThisBlock.size() and centersForThisBlock[nextCenter[b]]==withinBlockIndex[b]) {
+                // store center coords
+                centersPerNewBlock[b][nextCenter[b]] = convertedCoords[ sortedIndex ];
+                numOwnedCenters++;
+                nextCenter[b]++;
+            }
+            withinBlockIndex[b]++;
+        }
+    }
+
     if (settings.debugMode) {
         PRINT(*comm << ": owns " << numOwnedCenters << " centers");
         unsigned int numNewTotalBlocks = std::accumulate(numNewBlocksPerOldBlock.begin(), numNewBlocksPerOldBlock.end(), 0);
@@ -245,33 +232,35 @@ Settings settings) {
     }
 
     //
-    // global sum operation. Doing it in a separate loop on purpose
-    // since different PEs own centers from different blocks and a lot of
-    // blocks own no centers at all
+    // global sum operation. The centers of all blocks are packed into one
+    // array, so one reduction assembles all of them; every center is owned
+    // by exactly one PE and zero on the others
     //
 
+    std::vector<IndexType> centerOffsets(numOldBlocks+1, 0);
     for (IndexType b=0; b<numOldBlocks; b++) {
-
         SCAI_ASSERT_EQ_ERROR(centersPerNewBlock[b][0].size(), dimensions, "Dimension mismatch for center");
-        IndexType numCenters = centersPerNewBlock[b].size();
-
-        // pack in a raw array
-        std::vector<ValueType> allCenters(numCenters*dimensions);
+        centerOffsets[b+1] = centerOffsets[b] + centersPerNewBlock[b].size();
+    }
+    const IndexType numAllCenters = centerOffsets[numOldBlocks];
 
-        for (unsigned int c=0; c<numCenters; c++) {
+    // pack in a raw array
+    std::vector<ValueType> allCenters(numAllCenters*dimensions);
+    for (IndexType b=0; b<numOldBlocks; b++) {
+        for (unsigned int c=0; c<centersPerNewBlock[b].size(); c++) {
             const point<ValueType>& thisCenter = centersPerNewBlock[b][c];
-            // copy this center
-            std::copy(thisCenter.begin(), thisCenter.end(), allCenters.begin() +c*dimensions);
+            std::copy(thisCenter.begin(), thisCenter.end(), allCenters.begin() + (centerOffsets[b]+c)*dimensions);
         }
+    }
 
-        // global sum
-        comm->sumImpl(allCenters.data(), allCenters.data(), numCenters*dimensions, scai::common::TypeTraits<ValueType>::stype);
+    comm->sumImpl(allCenters.data(), allCenters.data(), numAllCenters*dimensions, scai::common::TypeTraits<ValueType>::stype);
 
-        // unpack back to vector<point>
-        for (unsigned int c=0; c<numCenters; c++) {
+    // unpack back to vector<point>
+    for (IndexType b=0; b<numOldBlocks; b++) {
+        for (unsigned int c=0; c<centersPerNewBlock[b].size(); c++) {
             for (IndexType d=0; d<dimensions; d++) {
                 // center c, for block b
-                centersPerNewBlock[b][c][d] = allCenters[ c*dimensions+d ];
+                centersPerNewBlock[b][c][d] = allCenters[ (centerOffsets[b]+c)*dimensions+d ];
             }
         }
     }
@@ -289,7 +278,8 @@ std::vector<std::vector<ValueType>>  KMeans<IndexType,ValueType>::findInitialCen
      const std::vector<DenseVector<ValueType>>& coordinates,
      const std::vector<ValueType> &minCoords,
      const std::vector<ValueType> &maxCoords,
-Settings settings) {
+Settings settings,
+GeometryCache<IndexType, ValueType>* geometry) {
 
     // TODO: probably must also change the settings.numBlocks
 
@@ -307,7 +297,7 @@ Settings settings) {
     scai::lama::DenseVector<IndexType> partition(coordinates[0].getDistributionPtr(), 0);
 
     // return a vector of size 1 with
-    std::vector<std::vector<point<ValueType>>> initialCenters = findInitialCentersSFC(coordinates, minCoords, maxCoords, partition, leaves, settings);
+    std::vector<std::vector<point<ValueType>>> initialCenters = findInitialCentersSFC(coordinates, minCoords, maxCoords, partition, leaves, settings, geometry);
 
     SCAI_ASSERT_EQ_ERROR(initialCenters.size(), 1, "Wrong vector size");
     SCAI_ASSERT_EQ_ERROR(initialCenters[0].size(), settings.numBlocks, "Wrong vector size");
@@ -479,6 +469,53 @@ std::vector<point<ValueType>> KMeans<IndexType,ValueType>::findCenters(
 }
 
 
+template<typename IndexType, typename ValueType>
+template<typename Iterator, typename CoordType>
+std::vector<point<ValueType>> KMeans<IndexType,ValueType>::findCenters(
+    const std::vector<std::vector<CoordType>>& coordinates,
+    const DenseVector<IndexType>& partition,
+    const IndexType k,
+    const Iterator firstIndex,
+    const Iterator lastIndex,
+    const DenseVector<ValueType>& nodeWeights) {
+    SCAI_REGION("KMeans.findCenters");
+
+    const IndexType dim = coordinates.size();
+    const scai::dmemo::CommunicatorPtr comm = partition.getDistribution().getCommunicatorPtr();
+
+    scai::hmemo::ReadAccess<ValueType> rWeights(nodeWeights.getLocalValues());
+    scai::hmemo::ReadAccess<IndexType> rPartition(partition.getLocalValues());
+
+    // the coordinates may be stored in a lower precision, the sums are always accumulated in double
+    std::vector<double> weightSum(k, 0.0);
+    for (Iterator it = firstIndex; it != lastIndex; it++) {
+        weightSum[rPartition[*it]] += rWeights[*it];
+    }
+
+    std::vector<std::vector<double>> weightedSum(dim, std::vector<double>(k, 0.0));
+    for (IndexType d = 0; d < dim; d++) {
+        const std::vector<CoordType>& coords = coordinates[d];
+        for (Iterator it = firstIndex; it != lastIndex; it++) {
+            const IndexType i = *it;
+            weightedSum[d][rPartition[i]] += double(coords[i])*rWeights[i];
+        }
+    }
+
+    comm->sumImpl(weightSum.data(), weightSum.data(), k, scai::common::TypeTraits<double>::stype);
+
+    std::vector<std::vector<ValueType>> result(dim, std::vector<ValueType>(k));
+    for (IndexType d = 0; d < dim; d++) {
+        comm->sumImpl(weightedSum[d].data(), weightedSum[d].data(), k, scai::common::TypeTraits<double>::stype);
+        for (IndexType j = 0; j < k; j++) {
+            // make empty clusters explicit
+            result[d][j] = weightSum[j] == 0 ? NAN : ValueType(weightedSum[d][j] / weightSum[j]);
+        }
+    }
+
+    return result;
+}
+
+
 template<typename IndexType, typename ValueType>
 std::vector<point<ValueType>> KMeans<IndexType,ValueType>::vectorTranspose(const std::vector<std::vector<ValueType>>& points) {
     const IndexType dim = points.size();
@@ -499,9 +536,9 @@ std::vector<point<ValueType>> KMeans<IndexType,ValueType>::vectorTranspose(const
 }
 
 template<typename IndexType, typename ValueType>
-template<typename Iterator>
+template<typename Iterator, typename CoordType>
 DenseVector<IndexType> KMeans<IndexType,ValueType>::assignBlocks(
-    const std::vector<std::vector<ValueType>>& coordinates,
+    const std::vector<std::vector<CoordType>>& coordinates,
     const std::vector<point<ValueType>>& centers,
     const std::vector<IndexType>& blockSizesPrefixSum,
     const Iterator firstIndex,
@@ -519,6 +556,7 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::assignBlocks(
     Settings settings,
     Metrics<ValueType>& metrics) {
     SCAI_REGION("KMeans.assignBlocks");
+    Telemetry::ScopedTimer timer("KMeans.assignBlocks");
 
     const IndexType dim = coordinates.size();
     const scai::dmemo::DistributionPtr dist = previousAssignment.getDistributionPtr();
@@ -897,6 +935,8 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::assignBlocks(
         }
 
         iter++;
+        Telemetry::addCounter("KMeans.pointsVisited", currentLocalN);
+        Telemetry::addCounter("KMeans.pointsSkippedByBounds", skippedLoops);
 
         if (settings.verbose) {
             const IndexType takenLoops = currentLocalN - skippedLoops;
@@ -1020,7 +1060,8 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computeRepartition(
     const std::vector<DenseVector<ValueType>>& nodeWeights,
     const std::vector<std::vector<ValueType>>& blockSizes,
     const DenseVector<IndexType>& previous,
-    const Settings settings) {
+    const Settings settings,
+    GeometryCache<IndexType, ValueType>* geometry) {
 
     const IndexType localN = previous.getLocalValues().size();
     scai::dmemo::CommunicatorPtr comm = coordinates[0].getDistributionPtr()->getCommunicatorPtr();
@@ -1051,7 +1092,7 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computeRepartition(
 
     Metrics<ValueType> metrics(settings);
 
-    return computePartition(coordinates, nodeWeights, blockSizes, previous, groupOfCenters, tmpSettings, metrics);
+    return computePartition(coordinates, nodeWeights, blockSizes, previous, groupOfCenters, tmpSettings, metrics, geometry);
 }
 
 // WARNING: if settings.repartition=true then partition has a different meaning: is the partition to be rebalanced,
@@ -1067,9 +1108,11 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computePartition(
     const DenseVector<IndexType> &partition, // if repartition, this is the partition to be rebalanced
     std::vector<std::vector<point<ValueType>>> centers, \
     const Settings settings, \
-    Metrics<ValueType>& metrics) {
+    Metrics<ValueType>& metrics, \
+    GeometryCache<IndexType, ValueType>* geometry) {
 
     SCAI_REGION("KMeans.computePartition");
+    Telemetry::ScopedTimer timer("KMeans.computePartition");
     std::chrono::time_point<std::chrono::high_resolution_clock> KMeansStart = std::chrono::high_resolution_clock::now();
 
     // if repartition, by convention, numOldBlocks=1=center.size()
@@ -1178,23 +1221,40 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computePartition(
     std::vector<ValueType> minCoords(dim);
     std::vector<ValueType> maxCoords(dim);
 
-    std::vector<std::vector<ValueType> > convertedCoords(dim);
-    {
+    // with mixed precision, the coordinates are stored as float and only the distances are computed in ValueType
+    std::vector<std::vector<ValueType> > convertedCoords;
+    std::vector<std::vector<float> > floatCoords;
+    if (settings.mixedPrecision) {
+        floatCoords.resize(dim);
+        for (IndexType d = 0; d < dim; d++) {
+            scai::hmemo::ReadAccess<ValueType> rAccess(coordinates[d].getLocalValues());
+            floatCoords[d] = std::vector<float>(rAccess.get(), rAccess.get()+localN);
+        }
+    } else {
+        convertedCoords.resize(dim);
         for (IndexType d = 0; d < dim; d++) {
             scai::hmemo::ReadAccess<ValueType> rAccess(coordinates[d].getLocalValues());
             convertedCoords[d] = std::vector<ValueType>(rAccess.get(), rAccess.get()+localN);
-
-            minCoords[d] = *std::min_element(convertedCoords[d].begin(), convertedCoords[d].end());
-            maxCoords[d] = *std::max_element(convertedCoords[d].begin(), convertedCoords[d].end());
-
             assert(convertedCoords[d].size() == localN);
         }
     }
 
+    GeometryCache<IndexType,ValueType> ownGeometry(coordinates);
+    if (geometry == nullptr) {
+        geometry = &ownGeometry;
+    }
+    std::tie(minCoords, maxCoords) = geometry->getLocalBoundingBox();
+
+    // rounding can move a point out of the box, but the distance bounds need a box containing all stored points
+    for (IndexType d = 0; d < dim and settings.mixedPrecision and localN > 0; d++) {
+        const auto minMax = std::minmax_element(floatCoords[d].begin(), floatCoords[d].end());
+        minCoords[d] = std::min(minCoords[d], ValueType(*minMax.first));
+        maxCoords[d] = std::max(maxCoords[d], ValueType(*minMax.second));
+    }
+
     std::vector<ValueType> globalMinCoords(dim);
     std::vector<ValueType> globalMaxCoords(dim);
-    comm->minImpl(globalMinCoords.data(), minCoords.data(), dim, scai::common::TypeTraits<ValueType>::stype);
-    comm->maxImpl(globalMaxCoords.data(), maxCoords.data(), dim, scai::common::TypeTraits<ValueType>::stype);
+    std::tie(globalMinCoords, globalMaxCoords) = geometry->getGlobalBoundingBox();
 
     ValueType diagonalLength = 0;
     ValueType volume = 1;
@@ -1349,7 +1409,11 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computePartition(
 
         std::vector<ValueType> timePerPE(comm->getSize(), 0.0);
 
-        result = assignBlocks(convertedCoords, centers1DVector, blockSizesPrefixSum, firstIndex, lastIndex, convertedNodeWeights, normalizedNodeWeights, result, partition, adjustedBlockSizes, boundingBox, upperBoundOwnCenter, lowerBoundNextCenter, influence, imbalances, settings, metrics);
+        if (settings.mixedPrecision) {
+            result = assignBlocks(floatCoords, centers1DVector, blockSizesPrefixSum, firstIndex, lastIndex, convertedNodeWeights, normalizedNodeWeights, result, partition, adjustedBlockSizes, boundingBox, upperBoundOwnCenter, lowerBoundNextCenter, influence, imbalances, settings, metrics);
+        } else {
+            result = assignBlocks(convertedCoords, centers1DVector, blockSizesPrefixSum, firstIndex, lastIndex, convertedNodeWeights, normalizedNodeWeights, result, partition, adjustedBlockSizes, boundingBox, upperBoundOwnCenter, lowerBoundNextCenter, influence, imbalances, settings, metrics);
+        }
 
         scai::hmemo::ReadAccess<IndexType> rResult(result.getLocalValues());
 
@@ -1372,7 +1436,10 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computePartition(
         }
 
         // TODO: adapt for multiple weights
-        std::vector<std::vector<ValueType>> newCenters = findCenters(coordinates, result, totalNumNewBlocks, firstIndex, lastIndex, nodeWeights[0]);
+        // with mixed precision, the double coordinates are not read inside the iterations
+        std::vector<std::vector<ValueType>> newCenters = settings.mixedPrecision ?
+                findCenters(floatCoords, result, totalNumNewBlocks, firstIndex, lastIndex, nodeWeights[0]) :
+                findCenters(coordinates, result, totalNumNewBlocks, firstIndex, lastIndex, nodeWeights[0]);
 
         // newCenters have reversed order of the vectors
         // maybe turn centers to a 1D vector already in computePartition?
@@ -1555,13 +1622,20 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computePartition(
     const std::vector<DenseVector<ValueType>> &nodeWeights,
     const std::vector<std::vector<ValueType>> &blockSizes,
     const Settings settings,
-    Metrics<ValueType>& metrics) {
+    Metrics<ValueType>& metrics,
+    GeometryCache<IndexType, ValueType>* geometry) {
+
+    // the box is needed three times: for the min and max, the curve and the k-means bounds
+    GeometryCache<IndexType,ValueType> ownGeometry(coordinates);
+    if (geometry == nullptr) {
+        geometry = &ownGeometry;
+    }
 
     std::vector<ValueType> minCoords(settings.dimensions);
     std::vector<ValueType> maxCoords(settings.dimensions);
-    std::tie(minCoords, maxCoords) = getGlobalMinMaxCoords(coordinates);
+    std::tie(minCoords, maxCoords) = getGlobalMinMaxCoords(coordinates, geometry);
 
-    std::vector<point<ValueType>> centers = findInitialCentersSFC(coordinates, minCoords, maxCoords, settings);
+    std::vector<point<ValueType>> centers = findInitialCentersSFC(coordinates, minCoords, maxCoords, settings, geometry);
     SCAI_ASSERT_EQ_ERROR(centers.size(), settings.numBlocks, "Number of centers is not correct");
     SCAI_ASSERT_EQ_ERROR(centers[0].size(), settings.dimensions, "Dimension of centers is not correct");
 
@@ -1571,7 +1645,7 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computePartition(
     // every point belongs to one block in the beginning
     scai::lama::DenseVector<IndexType> partition(coordinates[0].getDistributionPtr(), 0);
 
-    return computePartition(coordinates, nodeWeights, blockSizes, partition, groupOfCenters, settings, metrics);
+    return computePartition(coordinates, nodeWeights, blockSizes, partition, groupOfCenters, settings, metrics, geometry);
 }
 
 
@@ -1582,7 +1656,8 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computeHierarchicalPartition
     std::vector<DenseVector<ValueType>> &nodeWeights,
     const CommTree<IndexType,ValueType> &commTree,
     Settings settings,
-    Metrics<ValueType>& metrics) {
+    Metrics<ValueType>& metrics,
+    GeometryCache<IndexType, ValueType>* geometry) {
 
     typedef cNode<IndexType,ValueType> cNode;
 
@@ -1606,7 +1681,12 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computeHierarchicalPartition
     // warning: this functions redistributes the coordinates and the node weights.
     // TODO: is this supposed to be here? it is also in ParcoRepart::partitionGraph
 
-    HilbertCurve<IndexType,ValueType>::redistribute(coordinates, nodeWeights, settings, metrics);
+    // the box is needed for the curve, the centers of every level and the k-means bounds
+    GeometryCache<IndexType,ValueType> ownGeometry(coordinates);
+    if (geometry == nullptr) {
+        geometry = &ownGeometry;
+    }
+    HilbertCurve<IndexType,ValueType>::redistribute(coordinates, nodeWeights, settings, metrics, geometry);
 
     if (settings.debugMode) {
         // added check to verify that the points are indeed distributed
@@ -1620,7 +1700,7 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computeHierarchicalPartition
 
     std::vector<ValueType> minCoords(settings.dimensions);
     std::vector<ValueType> maxCoords(settings.dimensions);
-    std::tie(minCoords, maxCoords) = getGlobalMinMaxCoords(coordinates);
+    std::tie(minCoords, maxCoords) = getGlobalMinMaxCoords(coordinates, geometry);
 
     // used later for debugging and calculating imbalance
     std::vector<ValueType> totalWeightSum(numNodeWeights);
@@ -1678,7 +1758,7 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computeHierarchicalPartition
         // Only the new level is passed and the previous level is
         // reconstructed internally
 
-        std::vector<std::vector<point<ValueType>>> groupOfCenters = findInitialCentersSFC(coordinates, minCoords, maxCoords, partition, thisLevel, settings);
+        std::vector<std::vector<point<ValueType>>> groupOfCenters = findInitialCentersSFC(coordinates, minCoords, maxCoords, partition, thisLevel, settings, geometry);
 
         SCAI_ASSERT_EQ_ERROR(groupOfCenters.size(), commTree.getHierLevel(h-1).size(), "Wrong number of blocks calculated");
         if (settings.debugMode) {
@@ -1716,7 +1796,7 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computeHierarchicalPartition
         // used. We infer the number of new blocks from the groupOfCenters
         // maybe, set also numBlocks for clarity??
 
-        partition = computePartition(coordinates, nodeWeights, targetBlockWeights, partition, groupOfCenters, settings, metrics);
+        partition = computePartition(coordinates, nodeWeights, targetBlockWeights, partition, groupOfCenters, settings, metrics, geometry);
 
         // TODO: not really needed assertions
         SCAI_ASSERT_EQ_ERROR(coordinates[0].getDistributionPtr()->getLocalSize(),\
@@ -1759,10 +1839,11 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computeHierPlusRepart(
     std::vector<DenseVector<ValueType>> &nodeWeights,
     const CommTree<IndexType,ValueType> &commTree,
     Settings settings,
-    Metrics<ValueType>& metrics) {
+    Metrics<ValueType>& metrics,
+    GeometryCache<IndexType, ValueType>* geometry) {
 
     // get a hierarchical partition
-    DenseVector<IndexType> result = computeHierarchicalPartition(coordinates, nodeWeights, commTree, settings, metrics);
+    DenseVector<IndexType> result = computeHierarchicalPartition(coordinates, nodeWeights, commTree, settings, metrics, geometry);
 
     std::vector<std::vector<ValueType>> blockSizes = commTree.getBalanceVectors(-1);
 
@@ -1772,24 +1853,22 @@ DenseVector<IndexType> KMeans<IndexType,ValueType>::computeHierPlusRepart(
     // refine using a repartition step
 
     std::chrono::time_point<std::chrono::high_resolution_clock> repartStart = std::chrono::high_resolution_clock::now();
-    DenseVector<IndexType> result2 = computeRepartition(coordinates, nodeWeights, blockSizes, result, settings);
+    DenseVector<IndexType> result2 = computeRepartition(coordinates, nodeWeights, blockSizes, result, settings, geometry);
     std::chrono::duration<ValueType,std::ratio<1>> repartTime = std::chrono::high_resolution_clock::now() - repartStart;
     metrics.MM["timeKmeans"] += repartTime.count();
 
     return result2;
 }// computeHierPlusRepart
 
-/* Get local minimum and maximum coordinates
- * TODO: This isn't used any more! Remove?
+/* Get global minimum and maximum coordinates
  */
 template<typename IndexType, typename ValueType>
-std::pair<std::vector<ValueType>,std::vector<ValueType>> KMeans<IndexType,ValueType>::getGlobalMinMaxCoords(const std::vector<DenseVector<ValueType>> &coordinates) {
+std::pair<std::vector<ValueType>,std::vector<ValueType>> KMeans<IndexType,ValueType>::getGlobalMinMaxCoords(const std::vector<DenseVector<ValueType>> &coordinates, GeometryCache<IndexType, ValueType>* geometry) {
     const int dim = coordinates.size();
     std::vector<ValueType> minCoords(dim);
     std::vector<ValueType> maxCoords(dim);
+    std::tie(minCoords, maxCoords) = geometry != nullptr ? geometry->getGlobalBoundingBox() : GeometryCache<IndexType,ValueType>::computeGlobalBoundingBox(coordinates);
     for (int d = 0; d < dim; d++) {
-        minCoords[d] = coordinates[d].min();
-        maxCoords[d] = coordinates[d].max();
         SCAI_ASSERT_NE_ERROR(minCoords[d], maxCoords[d], "min=max for dimension "<< d << ", this will cause problems to the hilbert index. local= " << coordinates[0].getLocalValues().size());
     }
     return {minCoords, maxCoords};
@@ -19,6 +19,7 @@
 #include "Metrics.h"
 #include "GraphUtils.h"
 #include "HilbertCurve.h"
+#include "GeometryCache.h"
 #include "AuxiliaryFunctions.h"
 #include "CommTree.h"
 #include "quadtree/SpatialCell.h"
@@ -51,6 +52,7 @@ public:
  * If settings.repartition=true then this has a different meaning: is the partition to be refined.
  * @param[in] centers initial k-means centers
  * @param[in] settings Settings struct
+ * @param[in] geometry If given, the bounding boxes of the coordinates are taken from it
  *
  * @return Distributed DenseVector of length n, partition[i] contains the block ID of node i
  */
@@ -64,7 +66,8 @@ static DenseVector<IndexType> computePartition(
     const DenseVector<IndexType>& prevPartition,\
     std::vector<std::vector< std::vector<ValueType> >> centers, \
     const Settings settings, \
-    Metrics<ValueType>& metrics);
+    Metrics<ValueType>& metrics, \
+    GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
 /** @brief Minimal wrapper with only the coordinates. Unit weights are assumed and uniform block sizes.
 */
@@ -85,6 +88,7 @@ static DenseVector<IndexType> computePartition(
  * @param[in] blockSizes Target, i.e., wanted, block sizes, not maximum sizes.
  * @param[in] settings Settings struct
  * @param[in] metrics Metrics struct
+ * @param[in] geometry If given, the bounding boxes of the coordinates are taken from it
  *
  * @return A partition of the points into \p settings.numBlocks number of blocks.
  */
@@ -96,7 +100,8 @@ static DenseVector<IndexType> computePartition(
     const std::vector<DenseVector<ValueType>> &nodeWeights,
     const std::vector<std::vector<ValueType>> &blockSizes,
     const Settings settings,
-    Metrics<ValueType>& metrics);
+    Metrics<ValueType>& metrics,
+    GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
 /**
  * Given a tree of the processors graph, computes a partition into a hierarchical fashion.
@@ -105,6 +110,7 @@ static DenseVector<IndexType> computePartition(
  * @param[in] nodeWeights The weights of the points. Each point can have multiple weights but all
  the same number of weights.
  * @param[in] commTree The tree describing the processor network. \sa CommTree
+ * @param[in,out] geometry If given, the bounding boxes of the coordinates are taken from it. The coordinates are redistributed, so its local box is invalidated.
  **/
 
 //template<typename IndexType, typename ValueType>
@@ -113,7 +119,8 @@ static DenseVector<IndexType> computeHierarchicalPartition(
     std::vector<DenseVector<ValueType>> &nodeWeights,
     const CommTree<IndexType,ValueType> &commTree,
     Settings settings,
-    Metrics<ValueType>& metrics);
+    Metrics<ValueType>& metrics,
+    GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
 /** Calls computeHierarchicalPartition() with an additional step of repartitioning in order to
 provide a better global cut.
@@ -126,7 +133,8 @@ static DenseVector<IndexType> computeHierPlusRepart(
     std::vector<DenseVector<ValueType>>& nodeWeights,
     const CommTree<IndexType,ValueType>& commTree,
     Settings settings,
-    Metrics<ValueType>& metrics);
+    Metrics<ValueType>& metrics,
+    GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
 /**
  * @brief Repartition a point set using balanced k-means.
@@ -137,6 +145,7 @@ static DenseVector<IndexType> computeHierPlusRepart(
  * @param[in] blockSizes target block sizes, not maximum sizes. blockSizes.size()== number of weights
  * @param[in] previous Previous partition
  * @param[in] settings Settings struct
+ * @param[in] geometry If given, the bounding boxes of the coordinates are taken from it
  *
  * @return partition
  */
@@ -146,7 +155,8 @@ static DenseVector<IndexType> computeRepartition(
     const std::vector<DenseVector<ValueType>>& nodeWeights,
     const std::vector<std::vector<ValueType>>& blockSizes,
     const DenseVector<IndexType> &previous,
-    const Settings settings);
+    const Settings settings,
+    GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
 //template<typename IndexType, typename ValueType>
 static DenseVector<IndexType> computeRepartition(
@@ -164,6 +174,7 @@ static DenseVector<IndexType> computeRepartition(
 	@param [in] hierLevel The previous hierarch level.
 	@param[in] partition The block id of every point in the previous hierarchy.
 	partition[i]=b means that point i was in block b in the previous hierarchy level.
+	@param[in] geometry If given, the bounding box for the space-filling curve is taken from it.
 	@return A vector of vectors of points.
 */
 //template<typename IndexType, typename ValueType>
@@ -173,7 +184,8 @@ static std::vector<std::vector< std::vector<ValueType> >> findInitialCentersSFC(
      const std::vector<ValueType> &maxCoords,
      const scai::lama::DenseVector<IndexType> &partition,
      const std::vector<cNode<IndexType,ValueType>> hierLevel,
-     Settings settings);
+     Settings settings,
+     GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
 /**
  * Find initial centers for k-means by sorting the local points along a space-filling curve.
@@ -184,6 +196,7 @@ static std::vector<std::vector< std::vector<ValueType> >> findInitialCentersSFC(
  * @param[in] minCoords Minimum coordinate in each dimension, lower left point of bounding box (if in 2D)
  * @param[in] maxCoords Maximum coordinate in each dimension, upper right point of bounding box (if in 2D)
  * @param[in] settings
+ * @param[in] geometry If given, the bounding box for the space-filling curve is taken from it.
  *
  * @return coordinates of centers
  */
@@ -192,7 +205,8 @@ static std::vector<std::vector<ValueType>>  findInitialCentersSFC(
      const std::vector<DenseVector<ValueType> >& coordinates,
      const std::vector<ValueType> &minCoords,
      const std::vector<ValueType> &maxCoords,
-     Settings settings);
+     Settings settings,
+     GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
 /**
  * @brief Compute initial centers from space-filling curve without considering point positions.
@@ -250,11 +264,33 @@ static std::vector< std::vector<ValueType> > findCenters(
     const Iterator lastIndex,
     const DenseVector<ValueType>& nodeWeights);
 
+/**
+ * Find centers of current partition from the local coordinates, which may be stored in a lower precision
+ * than ValueType. The weighted sums are accumulated in double.
+ *
+ * @param[in] coordinates local coordinates, one vector per dimension
+ * @param[in] partition an already know partition of the points
+ * @param[in] k number of blocks
+ * @param[in] firstIndex begin of local node indices
+ * @param[in] lastIndex end of local node indices
+ * @param[in] nodeWeights node weights
+ *
+ * @return coordinates of centers, NAN for empty blocks
+ */
+template<typename Iterator, typename CoordType>
+static std::vector< std::vector<ValueType> > findCenters(
+    const std::vector<std::vector<CoordType>>& coordinates,
+    const DenseVector<IndexType>& partition,
+    const IndexType k,
+    const Iterator firstIndex,
+    const Iterator lastIndex,
+    const DenseVector<ValueType>& nodeWeights);
 
-/** @brief Get minimum and maximum of the global coordinates.
+
+/** @brief Get minimum and maximum of the global coordinates. If \p geometry is given, the box is taken from it.
  */
 //template<typename ValueType>
-static std::pair<std::vector<ValueType>, std::vector<ValueType> > getGlobalMinMaxCoords(const std::vector<DenseVector<ValueType>> &coordinates);
+static std::pair<std::vector<ValueType>, std::vector<ValueType> > getGlobalMinMaxCoords(const std::vector<DenseVector<ValueType>> &coordinates, GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
 
 /**
@@ -287,7 +323,8 @@ static ValueType computeEffectiveDistance(
  *
  * The returned vector has always as many entries as local points, even if only some of them are non-zero.
  *
- * @param[in] coordinates input points
+ * @param[in] coordinates input points; they can be stored with less precision than ValueType, e.g., as float,
+ since the distances to the centers are always computed in ValueType
  * @param[in] centers block centers
  * @param[in] firstIndex begin of local node indices
  * @param[in] lastIndex end local node indices
@@ -311,9 +348,9 @@ static ValueType computeEffectiveDistance(
  * @return assignment of points to blocks
  */
 //template<typename IndexType, typename ValueType, typename Iterator>
-template< typename Iterator>
+template< typename Iterator, typename CoordType>
 static DenseVector<IndexType> assignBlocks(
-    const std::vector<std::vector<ValueType>> &coordinates,
+    const std::vector<std::vector<CoordType>> &coordinates,
     const std::vector< std::vector<ValueType> >& centers,
     const std::vector<IndexType>& blockSizesPrefixSum,
     const Iterator firstIndex,
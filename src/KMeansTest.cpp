@@ -124,6 +124,21 @@ TYPED_TEST(KMeansTest, testFindCenters) {
     EXPECT_EQ(dimensions, centers.size());
     EXPECT_EQ(k, centers[0].size());
 
+    //the centers from the float coordinates of the mixed precision mode are close to the exact ones
+    std::vector<std::vector<float>> floatCoords(dimensions);
+    for (IndexType d = 0; d < dimensions; d++) {
+        scai::hmemo::ReadAccess<ValueType> rCoords(coords[d].getLocalValues());
+        floatCoords[d] = std::vector<float>(rCoords.get(), rCoords.get()+rCoords.size());
+    }
+    std::vector<std::vector<ValueType> > floatCenters = KMeans<IndexType,ValueType>::findCenters(floatCoords, part, k, nodeIndices.begin(), nodeIndices.end(), uniformWeights);
+    ASSERT_EQ(dimensions, floatCenters.size());
+    for (IndexType d = 0; d < dimensions; d++) {
+        ASSERT_EQ(k, floatCenters[d].size());
+        for (IndexType j = 0; j < k; j++) {
+            EXPECT_NEAR(centers[d][j], floatCenters[d][j], 1e-4*(1+std::abs(centers[d][j])));
+        }
+    }
+
     //create invalid partition
     part = DenseVector<IndexType>(dist, 0);
 
@@ -405,6 +420,41 @@ TYPED_TEST(KMeansTest, testGetGlobalMinMax) {
         EXPECT_EQ(maxCoords[d], maxMax);
     }
 }
+//-----------------------------------------------
+
+TYPED_TEST(KMeansTest, testMixedPrecision) {
+    using ValueType = TypeParam;
+
+    std::string fileName = "bubbles-00010.graph";
+    std::string graphFile = KMeansTest<ValueType>::graphPath + fileName;
+    std::string coordFile = graphFile + ".xyz";
+
+    CSRSparseMatrix<ValueType> graph = FileIO<IndexType, ValueType>::readGraph(graphFile );
+    const scai::dmemo::DistributionPtr dist = graph.getRowDistributionPtr();
+    const scai::dmemo::CommunicatorPtr comm = dist->getCommunicatorPtr();
+    const IndexType globalN = graph.getNumRows();
+
+    struct Settings settings;
+    settings.dimensions = 2;
+    settings.numBlocks = 8;
+    const std::vector<DenseVector<ValueType>> coords = FileIO<IndexType, ValueType>::readCoords( std::string(coordFile), globalN, settings.dimensions);
+    const std::vector<DenseVector<ValueType>> nodeWeights = {DenseVector<ValueType>(dist, 1)};
+    const std::vector<std::vector<ValueType>> blockSizes = {std::vector<ValueType>(settings.numBlocks, std::ceil(ValueType(globalN)/settings.numBlocks))};
+
+    Metrics<ValueType> metrics(settings);
+    const DenseVector<IndexType> partition = KMeans<IndexType, ValueType>::computePartition( coords, nodeWeights, blockSizes, settings, metrics);
+
+    settings.mixedPrecision = true;
+    const DenseVector<IndexType> mixedPartition = KMeans<IndexType, ValueType>::computePartition( coords, nodeWeights, blockSizes, settings, metrics);
+
+    // rounding can change single assignments, but balance and quality must be kept
+    const ValueType imbalance = GraphUtils<IndexType, ValueType>::computeImbalance( mixedPartition, settings.numBlocks );
+    EXPECT_LE( imbalance, settings.epsilon );
+
+    const ValueType cut = GraphUtils<IndexType, ValueType>::computeCut( graph, partition );
+    const ValueType mixedCut = GraphUtils<IndexType, ValueType>::computeCut( graph, mixedPartition );
+    EXPECT_LE( mixedCut, 1.1*cut );
+}
 /*
 TYPED_TEST(KMeansTest, testPartitionWithNodeWeights) {
     using ValueType = TypeParam;
@@ -0,0 +1,239 @@
+/*
+ * LinearOctree.cpp
+ *
+ * A pointer-free octree whose leaves are stored in Morton order in contiguous arrays.
+ */
+
+#include <scai/lama/storage/CSRStorage.hpp>
+#include <scai/hmemo/WriteAccess.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include "LinearOctree.h"
+
+namespace ITI {
+
+template<typename IndexType, typename ValueType>
+LinearOctree<IndexType, ValueType>::LinearOctree(const std::vector<ValueType>& minCoords, const std::vector<ValueType>& maxCoords)
+    : dimension(minCoords.size()), minCoords(minCoords), gridWidth(minCoords.size()) {
+
+    SCAI_ASSERT_GT_ERROR(dimension, 0, "Need at least one dimension");
+    SCAI_ASSERT_EQ_ERROR(maxCoords.size(), dimension, "Dimensions of minimum and maximum do not agree");
+
+    //all keys and the span of the root must fit into 63 bits
+    maxLevel = std::min<IndexType>(63 / dimension, 31);
+
+    const ValueType gridSize = Key(1) << maxLevel;
+    for (IndexType d = 0; d < dimension; d++) {
+        SCAI_ASSERT_GT_ERROR(maxCoords[d], minCoords[d], "Empty box in dimension " << d);
+        gridWidth[d] = (maxCoords[d] - minCoords[d]) / gridSize;
+    }
+
+    leafKeys = {0};
+    leafLevels = {0};
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+typename LinearOctree<IndexType, ValueType>::Key LinearOctree<IndexType, ValueType>::getKey(const ValueType* point) const {
+    const Key maxAnchor = (Key(1) << maxLevel) - 1;
+
+    std::vector<Key> anchor(dimension);
+    for (IndexType d = 0; d < dimension; d++) {
+        const ValueType scaled = std::floor((point[d] - minCoords[d]) / gridWidth[d]);
+        anchor[d] = scaled < 0 ? 0 : std::min(Key(scaled), maxAnchor);
+    }
+    return encode(anchor);
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+void LinearOctree<IndexType, ValueType>::build(std::vector<Key>& pointKeys, const IndexType capacity) {
+    SCAI_REGION("LinearOctree.build")
+
+    SCAI_ASSERT_GT_ERROR(capacity, 0, "Capacity must be positive");
+
+    std::sort(pointKeys.begin(), pointKeys.end());
+
+    leafKeys.clear();
+    leafLevels.clear();
+    buildSubtree(pointKeys.data(), pointKeys.data() + pointKeys.size(), 0, 0, capacity);
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+void LinearOctree<IndexType, ValueType>::buildSubtree(const Key* begin, const Key* end, const Key key, const IndexType level, const IndexType capacity) {
+    if (end - begin <= capacity or level == maxLevel) {
+        leafKeys.push_back(key);
+        leafLevels.push_back(level);
+        return;
+    }
+
+    //the keys of every child are a contiguous range of the sorted keys
+    const IndexType numChildren = IndexType(1) << dimension;
+    const Key childSpan = span(level+1);
+    const Key* childBegin = begin;
+    for (IndexType c = 0; c < numChildren; c++) {
+        const Key child = childKey(key, level, c);
+        const Key* childEnd = std::lower_bound(childBegin, end, child + childSpan);
+        buildSubtree(childBegin, childEnd, child, level+1, capacity);
+        childBegin = childEnd;
+    }
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+IndexType LinearOctree<IndexType, ValueType>::findLeaf(const Key key) const {
+    //the leaves cover the whole box, so the last leaf starting at or before key contains it
+    return std::upper_bound(leafKeys.begin(), leafKeys.end(), key) - leafKeys.begin() - 1;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+void LinearOctree<IndexType, ValueType>::getLeafBox(const IndexType leaf, std::vector<ValueType>& minCorner, std::vector<ValueType>& maxCorner) const {
+    std::vector<Key> anchor(dimension);
+    decode(leafKeys[leaf], anchor);
+    const ValueType sideLength = Key(1) << (maxLevel - leafLevels[leaf]);
+
+    minCorner.resize(dimension);
+    maxCorner.resize(dimension);
+    for (IndexType d = 0; d < dimension; d++) {
+        minCorner[d] = minCoords[d] + anchor[d]*gridWidth[d];
+        maxCorner[d] = minCorner[d] + sideLength*gridWidth[d];
+    }
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+std::vector<std::vector<ValueType>> LinearOctree<IndexType, ValueType>::getLeafCenters() const {
+    SCAI_REGION("LinearOctree.getLeafCenters")
+
+    const IndexType n = numLeaves();
+    std::vector<std::vector<ValueType>> centers(dimension, std::vector<ValueType>(n));
+
+    #pragma omp parallel for
+    for (IndexType i = 0; i < n; i++) {
+        std::vector<ValueType> minCorner, maxCorner;
+        getLeafBox(i, minCorner, maxCorner);
+        for (IndexType d = 0; d < dimension; d++) {
+            centers[d][i] = (minCorner[d] + maxCorner[d]) / 2;
+        }
+    }
+    return centers;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+IndexType LinearOctree<IndexType, ValueType>::getNeighbors(const IndexType leaf, IndexType* neighbors) const {
+    const Key sideLength = Key(1) << (maxLevel - leafLevels[leaf]);
+    const Key gridSize = Key(1) << maxLevel;
+
+    std::vector<Key> anchor(dimension);
+    std::vector<Key> other(dimension);
+    decode(leafKeys[leaf], anchor);
+
+    IndexType numNeighbors = 0;
+    for (IndexType d = 0; d < dimension; d++) {
+        for (int direction = -1; direction <= 1; direction += 2) {
+            if ((direction < 0 and anchor[d] == 0) or (direction > 0 and anchor[d] + sideLength == gridSize)) {
+                continue;
+            }
+
+            //the cell of the same size on the other side of the face
+            std::vector<Key> opposite = anchor;
+            opposite[d] = direction < 0 ? anchor[d] - sideLength : anchor[d] + sideLength;
+            const Key oppositeKey = encode(opposite);
+            const IndexType first = findLeaf(oppositeKey);
+
+            if (leafLevels[first] <= leafLevels[leaf]) {
+                if (neighbors != nullptr) {
+                    neighbors[numNeighbors] = first;
+                }
+                numNeighbors++;
+                continue;
+            }
+
+            //the cell is refined further, its leaves are contiguous and only those touching the face are neighbors
+            const Key oppositeEnd = oppositeKey + span(leafLevels[leaf]);
+            for (IndexType j = first; j < numLeaves() and leafKeys[j] < oppositeEnd; j++) {
+                decode(leafKeys[j], other);
+                const Key otherSideLength = Key(1) << (maxLevel - leafLevels[j]);
+                const bool touches = direction < 0 ? other[d] + otherSideLength == anchor[d] : other[d] == anchor[d] + sideLength;
+                if (touches) {
+                    if (neighbors != nullptr) {
+                        neighbors[numNeighbors] = j;
+                    }
+                    numNeighbors++;
+                }
+            }
+        }
+    }
+    return numNeighbors;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+CSRSparseMatrix<ValueType> LinearOctree<IndexType, ValueType>::getLeafGraph() const {
+    SCAI_REGION("LinearOctree.getLeafGraph")
+
+    const IndexType n = numLeaves();
+
+    //first count the neighbors, then write them into their rows
+    scai::hmemo::HArray<IndexType> csrIA;
+    scai::hmemo::HArray<IndexType> csrJA;
+    scai::hmemo::HArray<ValueType> csrValues;
+    {
+        scai::hmemo::WriteOnlyAccess<IndexType> ia(csrIA, n+1);
+        ia[0] = 0;
+        #pragma omp parallel for
+        for (IndexType i = 0; i < n; i++) {
+            ia[i+1] = getNeighbors(i, nullptr);
+        }
+        for (IndexType i = 0; i < n; i++) {
+            ia[i+1] += ia[i];
+        }
+        const IndexType nnz = ia[n];
+
+        scai::hmemo::WriteOnlyAccess<IndexType> ja(csrJA, nnz);
+        scai::hmemo::WriteOnlyAccess<ValueType> values(csrValues, nnz);
+        #pragma omp parallel for
+        for (IndexType i = 0; i < n; i++) {
+            getNeighbors(i, ja.get() + ia[i]);
+            std::sort(ja.get() + ia[i], ja.get() + ia[i+1]);
+            std::fill(values.get() + ia[i], values.get() + ia[i+1], 1);
+        }
+    }
+
+    scai::lama::CSRStorage<ValueType> localMatrix(n, n, std::move(csrIA), std::move(csrJA), std::move(csrValues));
+    return CSRSparseMatrix<ValueType>(std::move(localMatrix));
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+typename LinearOctree<IndexType, ValueType>::Key LinearOctree<IndexType, ValueType>::encode(const std::vector<Key>& anchor) const {
+    Key key = 0;
+    for (IndexType bit = 0; bit < maxLevel; bit++) {
+        for (IndexType d = 0; d < dimension; d++) {
+            key |= ((anchor[d] >> bit) & 1) << (bit*dimension + d);
+        }
+    }
+    return key;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+void LinearOctree<IndexType, ValueType>::decode(Key key, std::vector<Key>& anchor) const {
+    std::fill(anchor.begin(), anchor.end(), 0);
+    for (IndexType bit = 0; bit < maxLevel; bit++) {
+        for (IndexType d = 0; d < dimension; d++) {
+            anchor[d] |= ((key >> (bit*dimension + d)) & 1) << bit;
+        }
+    }
+}
+//---------------------------------------------------------------------------------------
+
+template class LinearOctree<IndexType, double>;
+template class LinearOctree<IndexType, float>;
+
+} // namespace ITI
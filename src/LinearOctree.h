@@ -0,0 +1,137 @@
+/*
+ * LinearOctree.h
+ *
+ * A pointer-free octree whose leaves are stored in Morton order in contiguous arrays.
+ */
+
+#pragma once
+
+#include <scai/lama/matrix/CSRSparseMatrix.hpp>
+#include <scai/tracing.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "Settings.h"
+
+namespace ITI {
+
+using scai::lama::CSRSparseMatrix;
+
+/** @brief A linear octree (quadtree in 2D) over a box, for any dimension.
+
+The box is divided into a grid of 2^maxLevel cells per dimension. Every cell of the tree is identified by the Morton key of
+its lowest grid cell, i.e., the interleaved bits of its integer anchor coordinates, together with its level; the root has level 0.
+Only the leaves are stored, sorted by their keys, in two contiguous arrays. Thus, there are no pointers and no per-cell allocations:
+the parent and the children of a cell are found by masking or setting the bits of its key, the leaf containing a point
+with a binary search, and all leaves inside a cell form a contiguous range of the leaf arrays.
+
+A leaf is split as in QuadNodeCartesianEuclid with theoretical splits, i.e., at the middle of every dimension, if it contains more than capacity points.
+*/
+
+template <typename IndexType, typename ValueType>
+class LinearOctree {
+public:
+    typedef uint64_t Key;
+
+    /** @brief Creates an octree with a single leaf covering the given box.
+
+    @param[in] minCoords The minimum of every dimension, minCoords.size() is the dimension.
+    @param[in] maxCoords The maximum of every dimension (excluded).
+    */
+    LinearOctree(const std::vector<ValueType>& minCoords, const std::vector<ValueType>& maxCoords);
+
+    /** @brief The Morton key of the grid cell containing the point; points outside the box are moved to its border.
+
+    @param[in] point The dimension coordinates of the point.
+    */
+    Key getKey(const ValueType* point) const;
+
+    /** @brief Builds the leaves such that no leaf contains more than capacity points, unless it is a cell of the finest grid.
+    Previous leaves are discarded.
+
+    @param[in] pointKeys The keys of all points, see getKey(). They are sorted in place.
+    @param[in] capacity The maximum number of points per leaf.
+    */
+    void build(std::vector<Key>& pointKeys, const IndexType capacity);
+
+    /** @return The number of leaves. */
+    IndexType numLeaves() const {
+        return leafKeys.size();
+    }
+
+    /** @return The key of the given leaf. */
+    Key getLeafKey(const IndexType leaf) const {
+        return leafKeys[leaf];
+    }
+
+    /** @return The level of the given leaf; the root has level 0. */
+    IndexType getLeafLevel(const IndexType leaf) const {
+        return leafLevels[leaf];
+    }
+
+    /** @brief The leaf containing the given key, e.g., the key of a point. O(log numLeaves). */
+    IndexType findLeaf(const Key key) const;
+
+    /** @brief The key of the parent of a cell at the given level > 0. */
+    Key parentKey(const Key key, const IndexType level) const {
+        return key & ~(span(level-1) - 1);
+    }
+
+    /** @brief The key of the child c, 0 <= c < 2^dimension, of a cell at the given level < maxLevel. */
+    Key childKey(const Key key, const IndexType level, const IndexType c) const {
+        return key | (Key(c) << ((maxLevel-level-1)*dimension));
+    }
+
+    /** @brief The number of grid cells in a cell of the given level; the keys of a cell are in [key, key+span(level)). */
+    Key span(const IndexType level) const {
+        return Key(1) << ((maxLevel-level)*dimension);
+    }
+
+    /** @brief The bounding box of a leaf.
+
+    @param[in] leaf The leaf.
+    @param[out] minCorner The minimum of the leaf in every dimension.
+    @param[out] maxCorner The maximum of the leaf in every dimension.
+    */
+    void getLeafBox(const IndexType leaf, std::vector<ValueType>& minCorner, std::vector<ValueType>& maxCorner) const;
+
+    /** @brief The centers of all leaves.
+
+    @return The coordinates of the centers, one vector of size numLeaves() per dimension.
+    */
+    std::vector<std::vector<ValueType>> getLeafCenters() const;
+
+    /** @brief The graph of the leaves: two leaves are adjacent if they share a face, i.e., not only an edge or a corner.
+
+    The neighbors of a leaf are found in bulk by looking up, for each of its 2*dimension faces, the cell of the same size on the
+    other side. If that cell is covered by one leaf, it is the only neighbor across this face; otherwise, the neighbors are the leaves
+    of the contiguous range of that cell that touch the face. The rows are computed in parallel.
+
+    @return The replicated adjacency matrix with unit weights, the vertices are the leaves in Morton order.
+    */
+    CSRSparseMatrix<ValueType> getLeafGraph() const;
+
+private:
+    /** The key of the given anchor, i.e., the integer coordinates of a grid cell. */
+    Key encode(const std::vector<Key>& anchor) const;
+
+    /** The anchor of the given key. */
+    void decode(Key key, std::vector<Key>& anchor) const;
+
+    /** Adds the leaves for the sorted keys in [begin, end), which are all in the cell key at the given level. */
+    void buildSubtree(const Key* begin, const Key* end, const Key key, const IndexType level, const IndexType capacity);
+
+    /** Writes the neighbors of the leaf to neighbors, if it is not null, and returns their number. */
+    IndexType getNeighbors(const IndexType leaf, IndexType* neighbors) const;
+
+    IndexType dimension;
+    IndexType maxLevel;
+    std::vector<ValueType> minCoords;
+    std::vector<ValueType> gridWidth;
+
+    std::vector<Key> leafKeys;
+    std::vector<uint8_t> leafLevels;
+};
+
+} // namespace ITI
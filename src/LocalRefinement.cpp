@@ -1,11 +1,21 @@
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
 #include <unordered_set>
 
+#include <omp.h>
+
 #include "LocalRefinement.h"
 #include "GraphUtils.h"
 #include "HaloPlanFns.h"
+#include "LocalizedGraph.h"
+#include "Telemetry.h"
 
 #include <scai/utilskernel/TransferUtils.hpp>
+#include <scai/common/TypeTraits.hpp>
 
 using scai::hmemo::HArray;
 
@@ -21,11 +31,40 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFM
     std::vector<ValueType> &distances,
     DenseVector<IndexType> &origin,
     const std::vector<DenseVector<IndexType>>& communicationScheme,
-    Settings settings) {
+    Settings settings,
+    std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>* localization) {
+
+    std::vector<DenseVector<ValueType>> allNodeWeights;
+    allNodeWeights.push_back(std::move(nodeWeights));
+    std::vector<ValueType> gainPerRound = distributedFMStep(input, part, nodesWithNonLocalNeighbors, allNodeWeights, coordinates, distances, origin, communicationScheme, settings, localization);
+    nodeWeights = std::move(allNodeWeights[0]);
+    return gainPerRound;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFMStep(
+    CSRSparseMatrix<ValueType>& input,
+    DenseVector<IndexType>& part,
+    std::vector<IndexType>& nodesWithNonLocalNeighbors,
+    std::vector<DenseVector<ValueType>> &nodeWeights,
+    std::vector<DenseVector<ValueType>> &coordinates,
+    std::vector<ValueType> &distances,
+    DenseVector<IndexType> &origin,
+    const std::vector<DenseVector<IndexType>>& communicationScheme,
+    Settings settings,
+    std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>* localization) {
 
     std::chrono::time_point<std::chrono::steady_clock> startTime =  std::chrono::steady_clock::now();
 
     SCAI_REGION( "LocalRefinement.distributedFMStep" )
+    Telemetry::ScopedTimer timer( "LocalRefinement.distributedFMStep" );
+
+    //the localization of the graph is built when first needed and dropped when the graph is redistributed
+    std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> ownLocalization;
+    if (localization == nullptr) {
+        localization = &ownLocalization;
+    }
     const IndexType globalN = input.getRowDistributionPtr()->getGlobalSize();
     scai::dmemo::CommunicatorPtr comm = input.getRowDistributionPtr()->getCommunicatorPtr();
 
@@ -54,18 +93,22 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFM
         throw std::runtime_error("Called with " + std::to_string(comm->getSize()) + " processors, but " + std::to_string(settings.numBlocks) + " blocks.");
     }
 
-    //TODO: opt size
-    //const IndexType optSize_old = ceil(double(globalN) / settings.numBlocks);
-    const IndexType optSize =  nodeWeights.sum() / settings.numBlocks;
-    const IndexType maxAllowableBlockSize = optSize*(1+settings.epsilon);
-
     //for now, we are assuming equal numbers of blocks and processes
     const IndexType localBlockID = comm->getRank();
 
-    const bool nodesWeighted = nodeWeights.getDistributionPtr()->getGlobalSize() > 0;
-    if (nodesWeighted && nodeWeights.getDistributionPtr()->getLocalSize() != input.getRowDistributionPtr()->getLocalSize()) {
-        throw std::runtime_error("Node weights have " + std::to_string(nodeWeights.getDistributionPtr()->getLocalSize()) + " local values, should be "
-                                 + std::to_string(input.getRowDistributionPtr()->getLocalSize()));
+    //an empty weight vector stands for unit weights
+    const IndexType numWeights = std::max<IndexType>(nodeWeights.size(), 1);
+    nodeWeights.resize(numWeights);
+    std::vector<bool> nodesWeighted(numWeights);
+    std::vector<ValueType> maxAllowableBlockSizes(numWeights);
+    for (IndexType w = 0; w < numWeights; w++) {
+        nodesWeighted[w] = nodeWeights[w].getDistributionPtr()->getGlobalSize() > 0;
+        if (nodesWeighted[w] && nodeWeights[w].getDistributionPtr()->getLocalSize() != input.getRowDistributionPtr()->getLocalSize()) {
+            throw std::runtime_error("Node weights " + std::to_string(w) + " have " + std::to_string(nodeWeights[w].getDistributionPtr()->getLocalSize()) + " local values, should be "
+                                     + std::to_string(input.getRowDistributionPtr()->getLocalSize()));
+        }
+        const ValueType optSize = (nodesWeighted[w] ? nodeWeights[w].sum() : ValueType(globalN)) / settings.numBlocks;
+        maxAllowableBlockSizes[w] = optSize*(1+settings.epsilon);
     }
 
     ValueType gainSum = 0;
@@ -139,9 +182,16 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFM
 
         ValueType gainThisRound = 0;
 
+        //collective, so it is computed by all processes, also by the inactive ones
+        IndexType blockVolume = 0;
+        if (settings.refineCommVolume and settings.minMaxCommVolume) {
+            *localization = LocalizedGraph<IndexType, ValueType>::get(input, *localization);
+            blockVolume = GraphUtils<IndexType, ValueType>::computeCommVolume(input, part, settings, *localization)[localBlockID];
+        }
+
         scai::dmemo::HaloExchangePlan graphHalo;
         CSRStorage<ValueType> haloMatrix;
-        HArray<ValueType> nodeWeightHaloData;
+        std::vector<HArray<ValueType>> nodeWeightHaloData(numWeights);
 
         if (partner != comm->getRank()) {
             //processor is active this round
@@ -151,7 +201,8 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFM
              */
             std::vector<IndexType> interfaceNodes;
             std::vector<IndexType> roundMarkers;
-            std::tie(interfaceNodes, roundMarkers)= getInterfaceNodes(input, part, nodesWithNonLocalNeighbors, partner, settings.minBorderNodes);
+            *localization = LocalizedGraph<IndexType, ValueType>::get(input, *localization);
+            std::tie(interfaceNodes, roundMarkers)= getInterfaceNodes(input, part, nodesWithNonLocalNeighbors, partner, settings.minBorderNodes, *localization);
 
             const IndexType lastRoundMarker = roundMarkers[roundMarkers.size()-1];
             const IndexType secondRoundMarker = roundMarkers[1];
@@ -165,22 +216,26 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFM
             //swap size of border region and total block size.
             IndexType blockSize = part.getDistributionPtr()->getLocalSize();
 
-            const ValueType blockWeightSum = scai::utilskernel::HArrayUtils::sum(nodeWeights.getLocalValues());
+            std::vector<ValueType> blockWeightSums(numWeights);
+            for (IndexType w = 0; w < numWeights; w++) {
+                blockWeightSums[w] = nodesWeighted[w] ? scai::utilskernel::HArrayUtils::sum(nodeWeights[w].getLocalValues()) : ValueType(blockSize);
+            }
 
-            ValueType swapField[5];
+            std::vector<ValueType> swapField(5 + numWeights);
             swapField[0] = interfaceNodes.size();
             swapField[1] = secondRoundMarker;
             swapField[2] = lastRoundMarker;
             swapField[3] = blockSize;
-            swapField[4] = blockWeightSum;
-            comm->swap(swapField, 5, partner);
+            swapField[4] = blockVolume;
+            std::copy(blockWeightSums.begin(), blockWeightSums.end(), swapField.begin() + 5);
+            comm->swap(swapField.data(), 5 + numWeights, partner);
             //want to isolate raw array accesses as much as possible, define named variables and only use these from now
             const IndexType otherSize = swapField[0];
             const IndexType otherSecondRoundMarker = swapField[1];
             const IndexType otherLastRoundMarker = swapField[2];
             //const IndexType otherBlockSize = swapField[3];
-//WARNING/TODO: this assumes that node weights (and thus block weights) are integers
-            const IndexType otherBlockWeightSum = swapField[4];
+            const IndexType otherBlockVolume = swapField[4];
+            const std::vector<ValueType> otherBlockWeightSums(swapField.begin() + 5, swapField.begin() + 5 + numWeights);
 
             if (interfaceNodes.size() == 0) {
                 if (otherSize != 0) {
@@ -258,25 +313,30 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFM
             const IndexType borderRegionSize = borderRegionIDs.size();
 
             /*
-             * If nodes are weighted, exchange Halo for node weights
+             * If nodes are weighted, exchange Halo for node weights. Unit weights are filled in for the unweighted ones.
              */
-            std::vector<ValueType> borderNodeWeights = {};
-            if (nodesWeighted) {
-                const HArray<ValueType>& localWeights = nodeWeights.getLocalValues();
-                assert(localWeights.size() == localN);
-                graphHalo.updateHalo( nodeWeightHaloData, localWeights, *comm );
-                borderNodeWeights.resize(borderRegionSize,-1);
-                for (IndexType i = 0; i < borderRegionSize; i++) {
-                    const IndexType globalI = borderRegionIDs[i];
-                    const IndexType localI = inputDist->global2Local(globalI);
-                    if (localI != scai::invalidIndex) {
-                        borderNodeWeights[i] = localWeights[localI];
-                    } else {
-                        const IndexType localI = graphHalo.global2Halo(globalI);
-                        assert(localI != scai::invalidIndex);
-                        borderNodeWeights[i] = nodeWeightHaloData[localI];
+            std::vector<std::vector<ValueType>> borderNodeWeights = {};
+            if (std::find(nodesWeighted.begin(), nodesWeighted.end(), true) != nodesWeighted.end()) {
+                borderNodeWeights.resize(numWeights, std::vector<ValueType>(borderRegionSize, 1));
+                for (IndexType w = 0; w < numWeights; w++) {
+                    if (!nodesWeighted[w]) {
+                        continue;
+                    }
+                    const HArray<ValueType>& localWeights = nodeWeights[w].getLocalValues();
+                    assert(localWeights.size() == localN);
+                    graphHalo.updateHalo( nodeWeightHaloData[w], localWeights, *comm );
+                    for (IndexType i = 0; i < borderRegionSize; i++) {
+                        const IndexType globalI = borderRegionIDs[i];
+                        const IndexType localI = inputDist->global2Local(globalI);
+                        if (localI != scai::invalidIndex) {
+                            borderNodeWeights[w][i] = localWeights[localI];
+                        } else {
+                            const IndexType localI = graphHalo.global2Halo(globalI);
+                            assert(localI != scai::invalidIndex);
+                            borderNodeWeights[w][i] = nodeWeightHaloData[w][localI];
+                        }
+                        assert(borderNodeWeights[w][i] >= 0);
                     }
-                    assert(borderNodeWeights[i] >= 0);
                 }
             }
 
@@ -284,10 +344,15 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFM
             scai::hmemo::HArray<IndexType> originData;
             graphHalo.updateHalo(originData, origin.getLocalValues(), *comm);
 
-//WARNING/TODO: this assumes that node weights (and thus block weights) are integers?
-            //block sizes and capacities
-            std::pair<IndexType, IndexType> blockSizes = {blockWeightSum, otherBlockWeightSum};
-            std::pair<IndexType, IndexType> maxBlockSizes = {maxAllowableBlockSize, maxAllowableBlockSize};
+            //block sizes and capacities, one pair per weight
+            std::vector<std::pair<ValueType, ValueType>> blockSizes(numWeights);
+            std::vector<std::pair<ValueType, ValueType>> maxBlockSizes(numWeights);
+            for (IndexType w = 0; w < numWeights; w++) {
+                blockSizes[w] = {blockWeightSums[w], otherBlockWeightSums[w]};
+                maxBlockSizes[w] = {maxAllowableBlockSizes[w], maxAllowableBlockSizes[w]};
+            }
+
+            const std::pair<IndexType, IndexType> blockVolumes = {blockVolume, otherBlockVolume};
 
             //second round markers
             std::pair<IndexType, IndexType> secondRoundMarkers = {secondRoundMarker, otherSecondRoundMarker};
@@ -323,26 +388,44 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFM
             of PEs involved is low so it makes sense to precompute the distances.
             Maybe distances can be computed here and given as an input
             */
-            ValueType gain = twoWayLocalFM(input, haloMatrix, graphHalo, borderRegionIDs, borderNodeWeights, assignedToSecondBlock, maxBlockSizes, blockSizes, tieBreakingKeys, settings);
+            ValueType gain;
+            if (settings.fmTrials > 1) {
+                //the configured tie breaking first, then diffusion if it is not the configured one, then random start orders
+                std::vector<std::vector<ValueType>> trialKeys = {tieBreakingKeys};
+                if (!settings.useDiffusionTieBreaking) {
+                    std::vector<ValueType> load = twoWayLocalDiffusion(input, haloMatrix, graphHalo, borderRegionIDs, secondRoundMarkers, assignedToSecondBlock, settings);
+                    for (ValueType& l : load) {
+                        l = std::abs(l);
+                    }
+                    trialKeys.push_back(load);
+                }
+                //the seed differs between the processes and rounds, so partners and rounds try different orders
+                std::mt19937 generator( comm->getRank()*communicationScheme.size() + color );
+                std::uniform_real_distribution<ValueType> distribution(0, 1);
+                while (IndexType(trialKeys.size()) < settings.fmTrials) {
+                    std::vector<ValueType> randomKeys(borderRegionSize);
+                    for (ValueType& key : randomKeys) {
+                        key = distribution(generator);
+                    }
+                    trialKeys.push_back(randomKeys);
+                }
+                trialKeys.resize(settings.fmTrials);
+                gain = multiTryLocalFM(input, haloMatrix, graphHalo, borderRegionIDs, borderNodeWeights, assignedToSecondBlock, maxBlockSizes, blockSizes, trialKeys, settings, blockVolumes);
+            } else {
+                gain = twoWayLocalFM(input, haloMatrix, graphHalo, borderRegionIDs, borderNodeWeights, assignedToSecondBlock, maxBlockSizes, blockSizes, tieBreakingKeys, settings, blockVolumes);
+            }
 
             {
                 SCAI_REGION( "LocalRefinement.distributedFMStep.loop.swapFMResults" )
                 /*
                  * Communicate achieved gain.
-                 * Since only two values are swapped, the tracing results measure the latency and synchronization overhead,
+                 * Since only one value is swapped, the tracing results measure the latency and synchronization overhead,
                  * the difference in running times between the two local FM implementations.
                  */
                 swapField[0] = gain;
-                swapField[1] = otherBlockWeightSum;
-                comm->swap(swapField, 2, partner);
+                comm->swap(swapField.data(), 1, partner);
             }
             const ValueType otherGain = swapField[0];
-            const ValueType otherSecondBlockWeightSum = swapField[1];
-
-            if (otherSecondBlockWeightSum > maxBlockSizes.first) {
-                //If a block is too large after the refinement, it is only because it was too large to begin with.
-                assert(otherSecondBlockWeightSum <= blockWeightSum);
-            }
 
             if (otherGain <= 0 && gain <= 0  /* && false */ ) {
                 //Oh well. None of the processors managed an improvement. No need to update data structures.
@@ -430,9 +513,12 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFM
                     SCAI_REGION( "LocalRefinement.distributedFMStep.loop.redistribute.updateDataStructures" )
 
                     redistributeFromHalo(input, newDistribution, graphHalo, haloMatrix);
+                    localization->reset();
                     part = scai::lama::fill<DenseVector<IndexType>>(newDistribution, localBlockID);
-                    if (nodesWeighted) {
-                        redistributeFromHalo<ValueType>(nodeWeights, newDistribution, graphHalo, nodeWeightHaloData);
+                    for (IndexType w = 0; w < numWeights; w++) {
+                        if (nodesWeighted[w]) {
+                            redistributeFromHalo<ValueType>(nodeWeights[w], newDistribution, graphHalo, nodeWeightHaloData[w]);
+                        }
                     }
                     redistributeFromHalo(origin, newDistribution, graphHalo, originData);
                 }
@@ -475,6 +561,7 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFM
 
     scai::dmemo::DistributionPtr sameDist = scai::dmemo::generalDistributionUnchecked(globalN, input.getRowDistributionPtr()->ownedGlobalIndexes(), comm);
     input = CSRSparseMatrix<ValueType>(sameDist, input.getLocalStorage());
+    localization->reset();
     part.swap(part.getLocalValues(), sameDist);
     origin.swap(origin.getLocalValues(), sameDist);
 
@@ -484,8 +571,10 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distributedFM
         }
     }
 
-    if (nodesWeighted) {
-        nodeWeights.swap(nodeWeights.getLocalValues(), sameDist);
+    for (IndexType w = 0; w < numWeights; w++) {
+        if (nodesWeighted[w]) {
+            nodeWeights[w].swap(nodeWeights[w].getLocalValues(), sameDist);
+        }
     }
 
     for (IndexType color = 0; color < gainPerRound.size(); color++) {
@@ -502,14 +591,16 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
     const CSRStorage<ValueType> &haloStorage,
     const scai::dmemo::HaloExchangePlan &matrixHalo,
     const std::vector<IndexType>& borderRegionIDs,
-    const std::vector<ValueType>& nodeWeights,
+    const std::vector<std::vector<ValueType>>& nodeWeights,
     std::vector<bool>& assignedToSecondBlock,
-    const std::pair<IndexType, IndexType> blockCapacities,
-    std::pair<IndexType, IndexType>& blockSizes,
+    const std::vector<std::pair<ValueType, ValueType>>& blockCapacities,
+    std::vector<std::pair<ValueType, ValueType>>& blockSizes,
     const std::vector<ValueType>& tieBreakingKeys,
-    Settings settings) {
+    Settings settings,
+    const std::pair<IndexType, IndexType> blockVolumes) {
 
     SCAI_REGION( "LocalRefinement.twoWayLocalFM" )
+    Telemetry::ScopedTimer timer( "LocalRefinement.twoWayLocalFM" );
 
     IndexType magicStoppingAfterNoGainRounds;
     if (settings.stopAfterNoGainRounds > 0) {
@@ -518,7 +609,11 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
         magicStoppingAfterNoGainRounds = borderRegionIDs.size();
     }
 
-    assert(blockCapacities.first == blockCapacities.second);
+    const IndexType numWeights = blockCapacities.size();
+    assert(blockSizes.size() == numWeights);
+    for ([[maybe_unused]] const std::pair<ValueType, ValueType>& capacities : blockCapacities) {
+        assert(capacities.first == capacities.second);
+    }
     const bool nodesWeighted = (nodeWeights.size() != 0);
     //const bool edgesWeighted = nodesWeighted;//TODO: adapt this, change interface
     const bool edgesWeighted = ( scai::utilskernel::HArrayUtils::max(input.getLocalStorage().getValues()) !=1 );
@@ -532,7 +627,32 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
 
     const bool gainOverBalance = settings.gainOverBalance;
 
-    if (blockSizes.first >= blockCapacities.first && blockSizes.second >= blockCapacities.second) {
+    /*
+     * With several node weights, every weight has its own capacity. The load of a block is the largest ratio of
+     * its size and capacity over all weights, a block is full if its load is at least 1.
+     */
+    auto getLoads = [&]() {
+        std::pair<ValueType, ValueType> loads(0, 0);
+        for (IndexType w = 0; w < numWeights; w++) {
+            if (blockCapacities[w].first > 0) {
+                loads.first = std::max(loads.first, blockSizes[w].first / blockCapacities[w].first);
+                loads.second = std::max(loads.second, blockSizes[w].second / blockCapacities[w].second);
+            }
+        }
+        return loads;
+    };
+
+    //moves the weights of a node between the sizes of the two blocks
+    auto moveWeights = [&](IndexType veryLocalID, bool toSecondBlock) {
+        for (IndexType w = 0; w < numWeights; w++) {
+            const ValueType nodeWeight = nodesWeighted ? nodeWeights[w][veryLocalID] : 1;
+            blockSizes[w].first += toSecondBlock ? -nodeWeight : nodeWeight;
+            blockSizes[w].second += toSecondBlock ? nodeWeight : -nodeWeight;
+        }
+    };
+
+    std::pair<ValueType, ValueType> loads = getLoads();
+    if (loads.first >= 1 && loads.second >= 1) {
         //cannot move any nodes, all blocks are overloaded already.
         return 0;
     }
@@ -544,7 +664,10 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
     const IndexType veryLocalN = borderRegionIDs.size();
     assert(tieBreakingKeys.size() == veryLocalN);
     if (nodesWeighted) {
-        assert(nodeWeights.size() == veryLocalN);
+        assert(nodeWeights.size() == numWeights);
+        for ([[maybe_unused]] const std::vector<ValueType>& weights : nodeWeights) {
+            assert(weights.size() == veryLocalN);
+        }
     }
 
     //TODO: not used variable
@@ -565,6 +688,109 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
         return globalToVeryLocal.count(globalID) > 0;
     };
 
+    /*
+     * For the communication volume, the gain of a vertex depends on the neighbors of its neighbors.
+     * All vertices of the first block are local and all vertices of the second block that are adjacent to the first block
+     * or to the border region are in the halo, so the counts below are exact for every neighbor of the border region.
+     */
+    const bool volumeGains = settings.refineCommVolume;
+    const CSRStorage<ValueType>& localStorage = input.getLocalStorage();
+    const scai::hmemo::ReadAccess<IndexType> rLocalIA(localStorage.getIA());
+    const scai::hmemo::ReadAccess<IndexType> rLocalJA(localStorage.getJA());
+    const scai::hmemo::ReadAccess<IndexType> rHaloIA(haloStorage.getIA());
+    const scai::hmemo::ReadAccess<IndexType> rHaloJA(haloStorage.getJA());
+
+    //0 for the first block, 1 for the second, -1 for other blocks
+    auto currentBlock = [&](IndexType globalID) -> IndexType {
+        const auto it = globalToVeryLocal.find(globalID);
+        if (it != globalToVeryLocal.end()) {
+            return assignedToSecondBlock[it->second];
+        } else if (inputDist->isLocal(globalID)) {
+            return 0;
+        } else if (matrixHalo.global2Halo(globalID) != scai::invalidIndex) {
+            return 1;
+        }
+        return -1;
+    };
+
+    auto forEachNeighbor = [&](IndexType globalID, auto&& function) {
+        const bool isLocal = inputDist->isLocal(globalID);
+        const IndexType localID = isLocal ? inputDist->global2Local(globalID) : matrixHalo.global2Halo(globalID);
+        assert(localID != scai::invalidIndex);
+        const scai::hmemo::ReadAccess<IndexType>& ia = isLocal ? rLocalIA : rHaloIA;
+        const scai::hmemo::ReadAccess<IndexType>& ja = isLocal ? rLocalJA : rHaloJA;
+        for (IndexType j = ia[localID]; j < ia[localID+1]; j++) {
+            if (ja[j] != globalID) {
+                function(ja[j]);
+            }
+        }
+    };
+
+    //the number of neighbors in the first and in the second block, computed on first use and updated after every move
+    std::map<IndexType, std::pair<IndexType, IndexType>> blockNeighbors;
+    auto getBlockNeighbors = [&](IndexType globalID) -> std::pair<IndexType, IndexType>& {
+        auto it = blockNeighbors.find(globalID);
+        if (it == blockNeighbors.end()) {
+            std::pair<IndexType, IndexType> counts(0, 0);
+            forEachNeighbor(globalID, [&](IndexType neighbor) {
+                const IndexType block = currentBlock(neighbor);
+                if (block == 0) {
+                    counts.first++;
+                } else if (block == 1) {
+                    counts.second++;
+                }
+            });
+            it = blockNeighbors.emplace(globalID, counts).first;
+        }
+        return it->second;
+    };
+    auto countIn = [](const std::pair<IndexType, IndexType>& counts, IndexType block) {
+        return block == 0 ? counts.first : counts.second;
+    };
+
+    //the change of the volume of the first and the second block if the vertex moves to the other block
+    auto volumeChange = [&](IndexType veryLocalID) {
+        const IndexType globalID = borderRegionIDs[veryLocalID];
+        const IndexType ownBlock = assignedToSecondBlock[veryLocalID];
+        const IndexType otherBlock = 1 - ownBlock;
+        const std::pair<IndexType, IndexType> counts = getBlockNeighbors(globalID);
+
+        //the vertex leaves the boundary of its block and may join the boundary of the other one
+        IndexType ownChange = -IndexType(countIn(counts, otherBlock) > 0);
+        IndexType otherChange = IndexType(countIn(counts, ownBlock) > 0);
+        forEachNeighbor(globalID, [&](IndexType neighbor) {
+            const IndexType block = currentBlock(neighbor);
+            if (block == ownBlock and countIn(getBlockNeighbors(neighbor), otherBlock) == 0) {
+                //the neighbor gets its first neighbor in the other block
+                ownChange++;
+            } else if (block == otherBlock and countIn(getBlockNeighbors(neighbor), ownBlock) == 1) {
+                //the vertex was the only neighbor of the neighbor in its block
+                otherChange--;
+            }
+        });
+        return ownBlock == 0 ? std::make_pair(ownChange, otherChange) : std::make_pair(otherChange, ownChange);
+    };
+
+    auto volumeGain = [&](IndexType veryLocalID) {
+        const std::pair<IndexType, IndexType> change = volumeChange(veryLocalID);
+        return ValueType(-change.first - change.second);
+    };
+
+    //with the min-max objective, the volume of the blocks to other blocks is assumed to stay the same
+    const bool minMaxVolume = volumeGains and settings.minMaxCommVolume;
+    std::pair<IndexType, IndexType> pairVolumes(0, 0);
+    if (minMaxVolume) {
+        for (IndexType i = 0; i < veryLocalN; i++) {
+            const std::pair<IndexType, IndexType>& counts = getBlockNeighbors(borderRegionIDs[i]);
+            if (assignedToSecondBlock[i]) {
+                pairVolumes.second += counts.first > 0;
+            } else {
+                pairVolumes.first += counts.second > 0;
+            }
+        }
+    }
+    const std::pair<IndexType, IndexType> restVolumes(blockVolumes.first - pairVolumes.first, blockVolumes.second - pairVolumes.second);
+
     /*
      * This lambda computes the initial gain of each node.
      * Inlining to reduce the overhead of read access locks didn't give any performance benefit.
@@ -623,7 +849,7 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
     std::vector<ValueType> gain(veryLocalN);
 
     for (IndexType i = 0; i < veryLocalN; i++) {
-        gain[i] = computeInitialGain(i);
+        gain[i] = volumeGains ? volumeGain(i) : computeInitialGain(i);
         const ValueType tieBreakingKey = tieBreakingKeys[i];
         if (assignedToSecondBlock[i]) {
             //the queues only support extractMin, since we want the maximum gain each round, we multiply it with -1
@@ -643,8 +869,63 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
     std::vector<ValueType> gainSumList, sizeList;
     gainSumList.reserve(veryLocalN);
     sizeList.reserve(veryLocalN);
+    //the larger volume of the two blocks after each move, only with the min-max objective
+    std::vector<IndexType> volumeList;
 
     IndexType iter = 0;
+
+    //the last iteration in which the volume gain of a vertex was updated
+    std::vector<IndexType> updatedInIter(volumeGains ? veryLocalN : 0, -1);
+
+    /*
+     * After a move, the block of the moved vertex and the neighbor counts of its neighbors change.
+     * The volume gain of a vertex depends on both for all its neighbors, so the gains within distance two are computed again.
+     */
+    auto updateVolumeGains = [&](IndexType movedVertex, IndexType fromBlock) {
+        SCAI_REGION( "LocalRefinement.twoWayLocalFM.queueloop.volumeGainUpdate" )
+        std::vector<IndexType> changedNeighbors;
+        forEachNeighbor(movedVertex, [&](IndexType neighbor) {
+            const auto it = blockNeighbors.find(neighbor);
+            if (it != blockNeighbors.end()) {
+                (fromBlock == 0 ? it->second.first : it->second.second)--;
+                (fromBlock == 0 ? it->second.second : it->second.first)++;
+            }
+            if (currentBlock(neighbor) >= 0) {
+                changedNeighbors.push_back(neighbor);
+            }
+        });
+
+        auto updateGain = [&](IndexType globalID) {
+            const auto it = globalToVeryLocal.find(globalID);
+            if (it == globalToVeryLocal.end() or moved[it->second] or updatedInIter[it->second] == iter) {
+                return;
+            }
+            const IndexType veryLocalNeighborID = it->second;
+            updatedInIter[veryLocalNeighborID] = iter;
+
+            const ValueType oldGain = gain[veryLocalNeighborID];
+            gain[veryLocalNeighborID] = volumeGain(veryLocalNeighborID);
+            if (gain[veryLocalNeighborID] == oldGain) {
+                return;
+            }
+
+            const ValueType tieBreakingKey = tieBreakingKeys[veryLocalNeighborID];
+            const std::pair<IndexType, ValueType> oldKey = std::make_pair(-oldGain, tieBreakingKey);
+            const std::pair<IndexType, ValueType> newKey = std::make_pair(-gain[veryLocalNeighborID], tieBreakingKey);
+
+            if (assignedToSecondBlock[veryLocalNeighborID]) {
+                secondQueue.updateKey(oldKey, newKey, veryLocalNeighborID);
+            } else {
+                firstQueue.updateKey(oldKey, newKey, veryLocalNeighborID);
+            }
+        };
+
+        for (IndexType neighbor : changedNeighbors) {
+            updateGain(neighbor);
+            forEachNeighbor(neighbor, updateGain);
+        }
+    };
+
     IndexType iterWithoutGain = 0;
     while (firstQueue.size() + secondQueue.size() > 0 && iterWithoutGain < magicStoppingAfterNoGainRounds) {
         SCAI_REGION( "LocalRefinement.twoWayLocalFM.queueloop" )
@@ -654,8 +935,8 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
         /*
          * first check break situations
          */
-        if ((firstQueue.size() == 0 && blockSizes.first >= blockCapacities.first)
-                ||	(secondQueue.size() == 0 && blockSizes.second >= blockCapacities.second)) {
+        if ((firstQueue.size() == 0 && loads.first >= 1)
+                ||	(secondQueue.size() == 0 && loads.second >= 1)) {
             //cannot move any nodes
             break;
         }
@@ -664,14 +945,14 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
          * now check situations where we have no choice, for example because one queue is empty or one block is already full
          */
         if (firstQueue.size() == 0) {
-            assert(blockSizes.first < blockCapacities.first);
+            assert(loads.first < 1);
             bestQueueIndex = 1;
         } else if (secondQueue.size() == 0) {
-            assert(blockSizes.second < blockCapacities.second);
+            assert(loads.second < 1);
             bestQueueIndex = 0;
-        } else if (blockSizes.first >= blockCapacities.first) {
+        } else if (loads.first >= 1) {
             bestQueueIndex = 1;
-        } else if (blockSizes.second >= blockCapacities.second) {
+        } else if (loads.second >= 1) {
             bestQueueIndex = 0;
         }
         else {
@@ -679,15 +960,15 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
              * now the rest
              */
             SCAI_REGION( "LocalRefinement.twoWayLocalFM.queueloop.queueselection" )
-            std::pair<IndexType, IndexType> firstComparisonPair;
-            std::pair<IndexType, IndexType> secondComparisonPair;
+            std::pair<ValueType, ValueType> firstComparisonPair;
+            std::pair<ValueType, ValueType> secondComparisonPair;
 
             if (gainOverBalance) {
-                firstComparisonPair = {-firstQueue.inspectMin().first.first, blockSizes.first};
-                firstComparisonPair = {-secondQueue.inspectMin().first.first, blockSizes.second};
+                firstComparisonPair = {-firstQueue.inspectMin().first.first, loads.first};
+                secondComparisonPair = {-secondQueue.inspectMin().first.first, loads.second};
             } else {
-                firstComparisonPair = {blockSizes.first, -firstQueue.inspectMin().first.first};
-                secondComparisonPair = {blockSizes.second, -secondQueue.inspectMin().first.first};
+                firstComparisonPair = {loads.first, -firstQueue.inspectMin().first.first};
+                secondComparisonPair = {loads.second, -secondQueue.inspectMin().first.first};
             }
 
             if (firstComparisonPair > secondComparisonPair) {
@@ -715,6 +996,13 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
         if (topGain > 0) iterWithoutGain = 0;
         else iterWithoutGain++;
 
+        if (minMaxVolume) {
+            const std::pair<IndexType, IndexType> change = volumeChange(veryLocalID);
+            pairVolumes.first += change.first;
+            pairVolumes.second += change.second;
+            volumeList.push_back(std::max(restVolumes.first + pairVolumes.first, restVolumes.second + pairVolumes.second));
+        }
+
         //move node
         transfers.push_back(veryLocalID);
         assignedToSecondBlock[veryLocalID] = !bestQueueIndex;
@@ -725,10 +1013,15 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
         gainSumList.push_back(gainSum);
 
         //update sizes
-        const ValueType nodeWeight = nodesWeighted ? nodeWeights[veryLocalID] : 1;
-        blockSizes.first += bestQueueIndex == 0 ? -nodeWeight : nodeWeight;
-        blockSizes.second += bestQueueIndex == 0 ? nodeWeight : -nodeWeight;
-        sizeList.push_back(std::max(blockSizes.first, blockSizes.second));
+        moveWeights(veryLocalID, bestQueueIndex == 0);
+        loads = getLoads();
+        sizeList.push_back(std::max(loads.first, loads.second));
+
+        if (volumeGains) {
+            updateVolumeGains(topVertex, bestQueueIndex);
+            iter++;
+            continue;
+        }
 
         /*
          * update gains of neighbors
@@ -780,19 +1073,34 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
     */
     ValueType maxGain = 0;
     const IndexType testedNodes = gainSumList.size();
+    Telemetry::addCounter( "LocalRefinement.fmMovesTried", testedNodes );
     if (testedNodes == 0) return 0;
 
     SCAI_REGION_START( "LocalRefinement.twoWayLocalFM.recoverBestCut" )
     IndexType maxIndex = -1;
 
-    for (IndexType i = 0; i < testedNodes; i++) {
-        if (gainSumList[i] > maxGain && sizeList[i] <= blockCapacities.first) {
-            maxIndex = i;
-            maxGain = gainSumList[i];
+    if (minMaxVolume) {
+        //the gain is the reduction of the larger volume of the two blocks
+        const IndexType initialMaxVolume = std::max(blockVolumes.first, blockVolumes.second);
+        IndexType minMaxVolumeSeen = initialMaxVolume;
+        for (IndexType i = 0; i < testedNodes; i++) {
+            if (volumeList[i] < minMaxVolumeSeen && sizeList[i] <= 1) {
+                maxIndex = i;
+                minMaxVolumeSeen = volumeList[i];
+            }
+        }
+        maxGain = initialMaxVolume - minMaxVolumeSeen;
+    } else {
+        for (IndexType i = 0; i < testedNodes; i++) {
+            if (gainSumList[i] > maxGain && sizeList[i] <= 1) {
+                maxIndex = i;
+                maxGain = gainSumList[i];
+            }
         }
     }
     assert(testedNodes >= maxIndex);
     assert(testedNodes-1 < transfers.size());
+    Telemetry::addCounter( "LocalRefinement.fmMovesKept", maxIndex+1 );
 
     /*
      * apply partition modifications in reverse until best is recovered
@@ -806,9 +1114,7 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
 
         //apply movement in reverse
         assignedToSecondBlock[veryLocalID] = previousBlock;
-        const ValueType nodeWeight = nodesWeighted ? nodeWeights[veryLocalID] : 1;
-        blockSizes.first += previousBlock == 0 ? nodeWeight : -nodeWeight;
-        blockSizes.second += previousBlock == 0 ? -nodeWeight : nodeWeight;
+        moveWeights(veryLocalID, previousBlock);
 
     }
     SCAI_REGION_END( "LocalRefinement.twoWayLocalFM.recoverBestCut" )
@@ -817,6 +1123,42 @@ ValueType ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalFM(
 }
 //---------------------------------------------------------------------------------------
 
+template<typename IndexType, typename ValueType>
+ValueType ITI::LocalRefinement<IndexType, ValueType>::multiTryLocalFM(
+    const CSRSparseMatrix<ValueType> &input,
+    const CSRStorage<ValueType> &haloStorage,
+    const scai::dmemo::HaloExchangePlan &matrixHalo,
+    const std::vector<IndexType>& borderRegionIDs,
+    const std::vector<std::vector<ValueType>>& nodeWeights,
+    std::vector<bool>& assignedToSecondBlock,
+    const std::vector<std::pair<ValueType, ValueType>>& blockCapacities,
+    std::vector<std::pair<ValueType, ValueType>>& blockSizes,
+    const std::vector<std::vector<ValueType>>& tieBreakingKeys,
+    Settings settings,
+    const std::pair<IndexType, IndexType> blockVolumes) {
+
+    SCAI_REGION( "LocalRefinement.multiTryLocalFM" )
+
+    const IndexType numTrials = tieBreakingKeys.size();
+    std::vector<std::vector<bool>> trialAssignments(numTrials, assignedToSecondBlock);
+    std::vector<std::vector<std::pair<ValueType, ValueType>>> trialBlockSizes(numTrials, blockSizes);
+    std::vector<ValueType> trialGains(numTrials);
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(std::max(1, std::min(int(numTrials), omp_get_max_threads())))
+    for (IndexType t = 0; t < numTrials; t++) {
+        trialGains[t] = twoWayLocalFM(input, haloStorage, matrixHalo, borderRegionIDs, nodeWeights, trialAssignments[t], blockCapacities, trialBlockSizes[t], tieBreakingKeys[t], settings, blockVolumes);
+    }
+
+    const IndexType best = std::max_element(trialGains.begin(), trialGains.end()) - trialGains.begin();
+    Telemetry::addCounter( "LocalRefinement.fmTrials", numTrials );
+    Telemetry::addCounter( "LocalRefinement.fmTrialsBetterThanFirst", IndexType(trialGains[best] > trialGains[0]) );
+
+    assignedToSecondBlock.swap(trialAssignments[best]);
+    blockSizes = trialBlockSizes[best];
+    return trialGains[best];
+}
+//---------------------------------------------------------------------------------------
+
 template<typename IndexType, typename ValueType>
 std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::twoWayLocalDiffusion(
     const CSRSparseMatrix<ValueType> &input,
@@ -1130,7 +1472,7 @@ void ITI::LocalRefinement<IndexType, ValueType>::redistributeFromHalo(
 //---------------------------------------------------------------------------------------
 
 template<typename IndexType, typename ValueType>
-std::pair<std::vector<IndexType>, std::vector<IndexType>> ITI::LocalRefinement<IndexType, ValueType>::getInterfaceNodes(const CSRSparseMatrix<ValueType> &input, const DenseVector<IndexType> &part, const std::vector<IndexType>& nodesWithNonLocalNeighbors, IndexType otherBlock, IndexType minBorderNodes) {
+std::pair<std::vector<IndexType>, std::vector<IndexType>> ITI::LocalRefinement<IndexType, ValueType>::getInterfaceNodes(const CSRSparseMatrix<ValueType> &input, const DenseVector<IndexType> &part, const std::vector<IndexType>& nodesWithNonLocalNeighbors, IndexType otherBlock, IndexType minBorderNodes, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
 
     SCAI_REGION( "LocalRefinement.getInterfaceNodes" )
     const scai::dmemo::DistributionPtr inputDist = input.getRowDistributionPtr();
@@ -1159,9 +1501,12 @@ std::pair<std::vector<IndexType>, std::vector<IndexType>> ITI::LocalRefinement<I
 
     scai::hmemo::HArray<IndexType> localData = part.getLocalValues();
 
+    // the columns are localized, local neighbors have columns below localN
     const CSRStorage<ValueType>& localStorage = input.getLocalStorage();
+    const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::get(input, localization);
+    const std::vector<IndexType>& haloGlobalIndices = localized->getHaloGlobalIndices();
     const scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
-    const scai::hmemo::ReadAccess<IndexType> ja(localStorage.getJA());
+    const scai::hmemo::ReadAccess<IndexType> ja(localized->getJA());
 
     /*
      * send nodes with non-local neighbors to partner process.
@@ -1204,7 +1549,7 @@ std::pair<std::vector<IndexType>, std::vector<IndexType>> ITI::LocalRefinement<I
         assert(localI != scai::invalidIndex);
 
         for (IndexType j = ia[localI]; j < ia[localI+1]; j++) {
-            if (foreignNodes.count(ja[j])> 0) {
+            if (ja[j] >= localN and foreignNodes.count(haloGlobalIndices[ja[j]-localN]) > 0) {
                 interfaceNodes.push_back(node);
                 break;
             }
@@ -1223,11 +1568,12 @@ std::pair<std::vector<IndexType>, std::vector<IndexType>> ITI::LocalRefinement<I
         SCAI_REGION( "LocalRefinement.getInterfaceNodes.breadthFirstSearch" )
         std::vector<bool> touched(localN, false);
 
+        //the queues contain local indices
         std::queue<IndexType> bfsQueue;
         for (IndexType node : interfaceNodes) {
-            bfsQueue.push(node);
             const IndexType localID = inputDist->global2Local(node);
             assert(localID != scai::invalidIndex);
+            bfsQueue.push(localID);
             touched[localID] = true;
         }
         assert(bfsQueue.size() == interfaceNodes.size());
@@ -1239,21 +1585,18 @@ std::pair<std::vector<IndexType>, std::vector<IndexType>> ITI::LocalRefinement<I
             roundMarkers.push_back(interfaceNodes.size());
             std::queue<IndexType> nextQueue;
             while (!bfsQueue.empty()) {
-                IndexType nextNode = bfsQueue.front();
+                const IndexType localI = bfsQueue.front();
                 bfsQueue.pop();
-                const IndexType localI = inputDist->global2Local(nextNode);
-                assert(localI != scai::invalidIndex);
                 assert(touched[localI]);
                 const IndexType beginCols = ia[localI];
                 const IndexType endCols = ia[localI+1];
 
                 for (IndexType j = beginCols; j < endCols; j++) {
-                    IndexType neighbor = ja[j];
-                    IndexType localNeighbor = inputDist->global2Local(neighbor);
+                    const IndexType localNeighbor = ja[j];
                     //assume k=p
-                    if (localNeighbor != scai::invalidIndex && !touched[localNeighbor]) {
-                        nextQueue.push(neighbor);
-                        interfaceNodes.push_back(neighbor);
+                    if (localNeighbor < localN && !touched[localNeighbor]) {
+                        nextQueue.push(localNeighbor);
+                        interfaceNodes.push_back(inputDist->local2Global(localNeighbor));
                         touched[localNeighbor] = true;
                     }
                 }
@@ -1330,6 +1673,217 @@ std::vector<ValueType> ITI::LocalRefinement<IndexType, ValueType>::distancesFrom
 
 //---------------------------------------------------------------------------------------
 
+template<typename IndexType, typename ValueType>
+std::vector<ValueType> LocalRefinement<IndexType, ValueType>::labelPropagation(
+    const CSRSparseMatrix<ValueType> &input,
+    DenseVector<IndexType> &part,
+    const DenseVector<ValueType> &nodeWeights,
+    Settings settings,
+    const CommTree<IndexType, ValueType>* commTree,
+    const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
+
+    SCAI_REGION( "LocalRefinement.labelPropagation" )
+    Telemetry::ScopedTimer timer( "LocalRefinement.labelPropagation" );
+
+    const scai::dmemo::DistributionPtr dist = input.getRowDistributionPtr();
+    const scai::dmemo::CommunicatorPtr comm = dist->getCommunicatorPtr();
+    const IndexType k = settings.numBlocks;
+    const IndexType localN = dist->getLocalSize();
+    const IndexType numPEs = comm->getSize();
+
+    SCAI_ASSERT_ERROR( part.getDistributionPtr()->isEqual(*dist), "Graph and partition distributions must agree" );
+    if (settings.epsilon < 0) {
+        throw std::runtime_error("Epsilon must be >= 0, not " + std::to_string(settings.epsilon));
+    }
+
+    const bool nodesWeighted = nodeWeights.getDistributionPtr()->getGlobalSize() > 0;
+    if (nodesWeighted) {
+        SCAI_ASSERT_EQ_ERROR( nodeWeights.getDistributionPtr()->getLocalSize(), localN, "Node weights do not match the graph" );
+    }
+
+    const CSRStorage<ValueType>& localStorage = input.getLocalStorage();
+    const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::get(input, localization);
+    scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
+    scai::hmemo::ReadAccess<IndexType> ja(localized->getJA());
+    scai::hmemo::ReadAccess<ValueType> values(localStorage.getValues());
+    scai::hmemo::ReadAccess<ValueType> rWeights(nodeWeights.getLocalValues());
+
+    auto weight = [&](const IndexType i) {
+        return nodesWeighted ? rWeights[i] : ValueType(1);
+    };
+
+    //without a tree every cut edge costs its weight, i.e., the distance of two different blocks is 1
+    std::vector<typename CommTree<IndexType, ValueType>::commNode> leaves;
+    if (commTree != nullptr) {
+        leaves = commTree->getLeaves();
+        SCAI_ASSERT_EQ_ERROR( IndexType(leaves.size()), k, "The number of leaves and blocks should agree" );
+    }
+    const bool topologyAware = not leaves.empty();
+
+    auto blockDistance = [&](const IndexType a, const IndexType b) {
+        return topologyAware ? CommTree<IndexType, ValueType>::distance(leaves[a], leaves[b]) : ValueType(a != b);
+    };
+
+    //the reduction of the cost of the cut edges of a vertex with the given connections if it moves from block from to block to
+    auto moveGain = [&](const IndexType from, const IndexType to, const std::vector<ValueType>& connection, const std::vector<IndexType>& adjacentBlocks) {
+        ValueType gain = 0;
+        for (const IndexType block : adjacentBlocks) {
+            gain += connection[block] * (blockDistance(from, block) - blockDistance(to, block));
+        }
+        return gain;
+    };
+
+    std::vector<ValueType> blockWeights(k, 0);
+    {
+        scai::hmemo::ReadAccess<IndexType> rPart(part.getLocalValues());
+        for (IndexType i = 0; i < localN; i++) {
+            SCAI_ASSERT_VALID_INDEX_DEBUG( rPart[i], k, "Invalid block ID" );
+            blockWeights[rPart[i]] += weight(i);
+        }
+    }
+    comm->sumImpl( blockWeights.data(), blockWeights.data(), k, scai::common::TypeTraits<ValueType>::stype );
+
+    const ValueType totalWeight = std::accumulate(blockWeights.begin(), blockWeights.end(), ValueType(0));
+    const ValueType maxBlockWeight = totalWeight / k * (1 + settings.epsilon);
+
+    std::vector<ValueType> gainPerRound;
+    IndexType roundsWithoutGain = 0;
+
+    //one round in each direction without gain ends the refinement
+    for (IndexType round = 0; round < settings.labelPropagationRounds and roundsWithoutGain < 2; round++) {
+        const bool upwards = round % 2 == 0;
+
+        scai::hmemo::HArray<IndexType>& localPart = part.getLocalValues();
+        const scai::hmemo::HArray<IndexType> haloPart = localized->updateHalo(localPart);
+
+        //the share of this PE of the room left in every block and of the overload of every block
+        std::vector<ValueType> quota(k), overload(k);
+        for (IndexType b = 0; b < k; b++) {
+            quota[b] = std::max(ValueType(0), maxBlockWeight - blockWeights[b]) / numPEs;
+            overload[b] = std::max(ValueType(0), blockWeights[b] - maxBlockWeight) / numPEs;
+        }
+
+        //the block with the largest gain in the direction of this round, -1 if the vertex stays
+        std::vector<IndexType> targets(localN, -1);
+        {
+            SCAI_REGION( "LocalRefinement.labelPropagation.scan" )
+            scai::hmemo::ReadAccess<IndexType> rPart(localPart);
+            scai::hmemo::ReadAccess<IndexType> rHaloPart(haloPart);
+
+            #pragma omp parallel
+            {
+                std::vector<ValueType> connection(k, 0);
+                std::vector<IndexType> lastSeen(k, -1);
+                std::vector<IndexType> adjacentBlocks;
+
+                #pragma omp for schedule(guided)
+                for (IndexType i = 0; i < localN; i++) {
+                    const IndexType ownBlock = rPart[i];
+                    adjacentBlocks.clear();
+                    for (IndexType j = ia[i]; j < ia[i+1]; j++) {
+                        const IndexType neighbor = ja[j];
+                        const IndexType block = neighbor < localN ? rPart[neighbor] : rHaloPart[neighbor-localN];
+                        if (lastSeen[block] != i) {
+                            lastSeen[block] = i;
+                            connection[block] = 0;
+                            adjacentBlocks.push_back(block);
+                        }
+                        connection[block] += values[j];
+                    }
+
+                    IndexType bestBlock = -1;
+                    ValueType bestGain = overload[ownBlock] > 0 ? std::numeric_limits<ValueType>::lowest() : 0;
+                    for (const IndexType block : adjacentBlocks) {
+                        const bool allowed = upwards ? block > ownBlock : block < ownBlock;
+                        if (not allowed or quota[block] <= 0) {
+                            continue;
+                        }
+                        const ValueType blockGain = moveGain(ownBlock, block, connection, adjacentBlocks);
+                        if (blockGain > bestGain) {
+                            bestBlock = block;
+                            bestGain = blockGain;
+                        }
+                    }
+                    targets[i] = bestBlock;
+                }
+            }
+        }
+
+        //apply the moves; earlier moves of this round may have changed the blocks of local neighbors, so the gain is computed again
+        ValueType gain = 0;
+        IndexType numMoved = 0;
+        {
+            SCAI_REGION( "LocalRefinement.labelPropagation.move" )
+            scai::hmemo::WriteAccess<IndexType> wPart(localPart);
+            scai::hmemo::ReadAccess<IndexType> rHaloPart(haloPart);
+            std::vector<ValueType> weightChange(k, 0);
+            std::vector<ValueType> connection(k, 0);
+            std::vector<IndexType> lastSeen(k, -1);
+            std::vector<IndexType> adjacentBlocks;
+
+            for (IndexType i = 0; i < localN; i++) {
+                const IndexType target = targets[i];
+                if (target < 0 or quota[target] < weight(i)) {
+                    continue;
+                }
+                const IndexType ownBlock = wPart[i];
+
+                adjacentBlocks.clear();
+                for (IndexType j = ia[i]; j < ia[i+1]; j++) {
+                    const IndexType neighbor = ja[j];
+                    const IndexType block = neighbor < localN ? wPart[neighbor] : rHaloPart[neighbor-localN];
+                    if (lastSeen[block] != i) {
+                        lastSeen[block] = i;
+                        connection[block] = 0;
+                        adjacentBlocks.push_back(block);
+                    }
+                    connection[block] += values[j];
+                }
+
+                const ValueType vertexGain = moveGain(ownBlock, target, connection, adjacentBlocks);
+                const bool improves = vertexGain > 0;
+                const bool rebalances = overload[ownBlock] > 0 and lastSeen[target] == i;
+                if (not improves and not rebalances) {
+                    continue;
+                }
+
+                wPart[i] = target;
+                quota[target] -= weight(i);
+                //the room freed by this PE can be filled by this PE, but not the part of the weight that removes its share of the overload
+                quota[ownBlock] += std::max(ValueType(0), weight(i) - std::max(overload[ownBlock], ValueType(0)));
+                overload[ownBlock] -= weight(i);
+                weightChange[ownBlock] -= weight(i);
+                weightChange[target] += weight(i);
+                gain += vertexGain;
+                numMoved++;
+            }
+
+            comm->sumImpl( weightChange.data(), weightChange.data(), k, scai::common::TypeTraits<ValueType>::stype );
+            for (IndexType b = 0; b < k; b++) {
+                blockWeights[b] += weightChange[b];
+            }
+        }
+        Telemetry::addCounter( "LocalRefinement.lpMoves", numMoved );
+
+        gain = comm->sum(gain);
+        gainPerRound.push_back(gain);
+        //moves that remove an overload do not reduce the cut, so these rounds do not end the refinement
+        const bool overloaded = *std::max_element(blockWeights.begin(), blockWeights.end()) > maxBlockWeight;
+        if (gain < settings.minGainForNextRound and not overloaded) {
+            roundsWithoutGain++;
+        } else {
+            roundsWithoutGain = 0;
+        }
+
+        if (settings.verbose) {
+            PRINT0("label propagation round " << round << ": gain " << gain << ", moved " << comm->sum(numMoved) << " vertices");
+        }
+    }
+
+    return gainPerRound;
+}
+//---------------------------------------------------------------------------------------
+
 
 template class LocalRefinement<IndexType, double>;
 template class LocalRefinement<IndexType, float>;
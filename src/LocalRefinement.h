@@ -15,6 +15,8 @@
 
 #include "Settings.h"
 #include "PrioQueue.h"
+#include "CommTree.h"
+#include "LocalizedGraph.h"
 
 namespace ITI {
 
@@ -54,12 +56,14 @@ public:
      * @param[in,out] input Adjacency matrix of the input graph
      * @param[in,out] part Partition
      * @param[in,out] nodesWithNonLocalNeighbors Nodes that are local to this process, but have neighbors that are not.
-     * @param[in,out] nodeWeights
+     * @param[in,out] nodeWeights Node weights, may be fractional. A vector without values stands for unit weights.
      * @param[in,out] coordinates Coordinates of input points, only used for geometric tie-breaking
      * @param[in,out] distances For each node, distance to block center. Only used for geometric tie-breaking
      * @param[in,out] origin Indicating for each element, where it originally came from. Is redistributed during refinement, allowing to trace movements.
      * @param[in] communicationScheme As many elements as rounds, each element is a DenseVector of length p. Indicates the communication partner in each round.
      * @param[in] settings Settings struct
+     * @param[in,out] localization If not nullptr, points to the localization of the input graph or to nullptr. The localization is
+     * built when it is first needed and replaced after every redistribution, so the next call can reuse it.
      *
      */
     static std::vector<ValueType> distributedFMStep(
@@ -71,7 +75,29 @@ public:
         std::vector<ValueType> &distances,
         DenseVector<IndexType> &origin,
         const std::vector<DenseVector<IndexType>>& communicationScheme,
-        Settings settings
+        Settings settings,
+        std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>* localization = nullptr
+    );
+
+    /**
+     * Multi-constraint version of distributedFMStep: the balance constraint holds for each of the node weights, every block
+     * may have at most (1+epsilon) times the average weight for each of them. Weights may be fractional.
+     *
+     * @param[in,out] nodeWeights One vector per weight. A vector without values stands for unit weights.
+     *
+     * The other parameters are the ones of the single-weight version.
+     */
+    static std::vector<ValueType> distributedFMStep(
+        CSRSparseMatrix<ValueType> &input,
+        DenseVector<IndexType> &part,
+        std::vector<IndexType>& nodesWithNonLocalNeighbors,
+        std::vector<DenseVector<ValueType>> &nodeWeights,
+        std::vector<DenseVector<ValueType>> &coordinates,
+        std::vector<ValueType> &distances,
+        DenseVector<IndexType> &origin,
+        const std::vector<DenseVector<IndexType>>& communicationScheme,
+        Settings settings,
+        std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>* localization = nullptr
     );
 
     /**
@@ -87,6 +113,7 @@ public:
      * @param[in] nodesWithNonLocalNeighbors Nodes directly adjacent to other blocks
      * @param[in] otherBlock block to which the border region should be adjacent
      * @param[in] minNodes Minimum number nodes in the border region.
+     * @param[in] localization The localization of the input graph with its current distribution, built here if nullptr.
      *
      * @return pair of interfaceNodes, roundMarkers
      */
@@ -95,7 +122,8 @@ public:
                 const DenseVector<IndexType> &part,
                 const std::vector<IndexType>& nodesWithNonLocalNeighbors,
                 IndexType otherBlock,
-                IndexType minNodes
+                IndexType minNodes,
+                const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr
             );
 
     /**
@@ -129,26 +157,68 @@ public:
     */
     static std::vector<ValueType> distancesFromBlockCenter(const std::vector<DenseVector<ValueType>> &coordinates);
 
+    /**
+     * Size-constrained label propagation: every local vertex moves to the adjacent block it has the heaviest connection to,
+     * if this reduces the cut and the block has room left. Works for any number of blocks and any distribution of the graph;
+     * the partition is changed, the graph is not redistributed.
+     *
+     * The neighbors of all local vertices are scanned in parallel by the OpenMP threads, the moves are then checked again
+     * against the current blocks of the local neighbors and applied. The blocks of non-local neighbors are exchanged once per
+     * round. In even rounds vertices only move to blocks with a larger ID, in odd rounds to blocks with a smaller ID, so two
+     * neighbors on different PEs never swap their blocks. The room left in every block, (1+epsilon) times the average block
+     * weight minus its weight, is split equally among the PEs, so the balance constraint holds after every round. Vertices
+     * of an overloaded block also move if this does not reduce the cut, until their PE has removed its share of the overload;
+     * only the weight moved beyond that share can be refilled in the same round, and the refinement does not stop while a
+     * block is overloaded.
+     *
+     * If a communication tree is given, block b is assigned to leaf b of the tree and every cut edge costs its weight times
+     * the distance of the leaves of its blocks (CommTree::distance), so the vertices move to reduce the hop-bytes instead of
+     * the cut: a vertex leaves its block for a block on a nearby PE before one that it has a slightly heavier connection to,
+     * but that is on another island of the network.
+     *
+     * @param[in] input Adjacency matrix of the graph
+     * @param[in,out] part Partition, same distribution as the graph
+     * @param[in] nodeWeights Node weights, can be empty for unit weights
+     * @param[in] settings Settings struct, uses numBlocks, epsilon, labelPropagationRounds and minGainForNextRound
+     * @param[in] commTree The physical network, with one leaf per block, or nullptr to minimize the cut
+     * @param[in] localization The localization of the graph with its current distribution, built here if nullptr
+     *
+     * @return The gain of every round, i.e., the reduction of the cut (or of the hop-bytes) as seen by the moved vertices.
+     */
+    static std::vector<ValueType> labelPropagation(const CSRSparseMatrix<ValueType> &input, DenseVector<IndexType> &part, const DenseVector<ValueType> &nodeWeights, Settings settings, const CommTree<IndexType, ValueType>* commTree = nullptr, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr);
+
 private:
 
     /**
      * Performs local refinement between the border region of two blocks, one of them being the local block associated with this process.
      * The non-local graph information must be given in the haloStorage.
      *
-     * The vectors borderRegionIDs, nodeWeights, assignedToSecondBlock and tieBreakingKeys have the same size.
+     * The vectors borderRegionIDs, assignedToSecondBlock, tieBreakingKeys and each vector in nodeWeights have the same size.
+     *
+     * The weights may be fractional and there may be several of them. The load of a block is the maximum over all weights of
+     * its size divided by its capacity; a partition is balanced if both loads are at most 1. Moves are taken from the more
+     * loaded block, and the kept prefix of moves is the best one after which both loads are at most 1.
      *
      * The improved partition can be read from the assignedToSecondBlock input/output parameter.
      *
+     * With settings.refineCommVolume, the gain of a move is the reduction of the communication volume between the two blocks,
+     * i.e., of the number of vertices of one block with a neighbor in the other block, summed over both blocks. Moving a vertex
+     * changes the volume contributed by its neighbors, so the gains of all border region vertices within distance two are
+     * updated. Edge weights are ignored and the volume to third blocks is not considered. With settings.minMaxCommVolume, the
+     * kept prefix of moves is the one with the smallest maximum of the total volumes of the two blocks, estimated from
+     * blockVolumes, and the gain is the reduction of this maximum.
+     *
      * @param[in] input Adjacency matrix of local subgraph
      * @param[in] haloStorage Adjacency matrix of non-local border region
      * @param[in] halo Halo object to translate global IDs to elements in haloStorage
      * @param[in] borderRegionIDs global IDs of nodes in local and non-local border regions
-     * @param[in] nodeWeights node weights of nodes in border region
+     * @param[in] nodeWeights node weights of nodes in border region, one vector per weight; no vector means unit weights
      * @param[in,out] assignedToSecondBlock boolean array, false if node is in first (local) block, true if in second (non-local) block
-     * @param[in] blockCapacities Total capacity of both blocks
-     * @param[in] blockSizes Total size of both blocks, also including nodes not in the border region
+     * @param[in] blockCapacities Total capacity of both blocks, one pair per weight
+     * @param[in] blockSizes Total size of both blocks, one pair per weight, also including nodes not in the border region
      * @param[in] tieBreakingKeys When two moves would have the same gain, the node with the lower entry in tieBreakingKeys is moved
      * @param[in] settings Settings struct
+     * @param[in] blockVolumes Total communication volume of both blocks, only used with settings.minMaxCommVolume
      *
      * @return gain
      */
@@ -157,12 +227,37 @@ private:
         const CSRStorage<ValueType> &haloStorage,
         const scai::dmemo::HaloExchangePlan &Halo,
         const std::vector<IndexType>& borderRegionIDs,
-        const std::vector<ValueType>& nodeWeights,
+        const std::vector<std::vector<ValueType>>& nodeWeights,
         std::vector<bool>& assignedToSecondBlock,
-        const std::pair<IndexType, IndexType> blockCapacities,
-        std::pair<IndexType, IndexType>& blockSizes,
+        const std::vector<std::pair<ValueType, ValueType>>& blockCapacities,
+        std::vector<std::pair<ValueType, ValueType>>& blockSizes,
         const std::vector<ValueType>& tieBreakingKeys,
-        Settings settings
+        Settings settings,
+        const std::pair<IndexType, IndexType> blockVolumes = {0, 0}
+    );
+
+    /**
+     * Runs twoWayLocalFM once for every vector of tie breaking keys, in parallel on the OpenMP threads of this process,
+     * and keeps the result with the highest gain; on equal gains, the earlier trial is kept. Every trial works on its own
+     * copy of the block assignment and block sizes.
+     *
+     * The parameters are the ones of twoWayLocalFM, except:
+     * @param[in] tieBreakingKeys One vector of keys per trial, each of the size of borderRegionIDs
+     *
+     * @return gain of the best trial
+     */
+    static ValueType multiTryLocalFM(
+        const CSRSparseMatrix<ValueType> &input,
+        const CSRStorage<ValueType> &haloStorage,
+        const scai::dmemo::HaloExchangePlan &Halo,
+        const std::vector<IndexType>& borderRegionIDs,
+        const std::vector<std::vector<ValueType>>& nodeWeights,
+        std::vector<bool>& assignedToSecondBlock,
+        const std::vector<std::pair<ValueType, ValueType>>& blockCapacities,
+        std::vector<std::pair<ValueType, ValueType>>& blockSizes,
+        const std::vector<std::vector<ValueType>>& tieBreakingKeys,
+        Settings settings,
+        const std::pair<IndexType, IndexType> blockVolumes = {0, 0}
     );
 
     /**
@@ -409,6 +409,368 @@ TYPED_TEST(LocalRefinementTest, testDistancesFromBlockCenter) {
 }
 //---------------------------------------------------------------------------------------
 
+TYPED_TEST(LocalRefinementTest, testMultiTryFM) {
+    using ValueType = TypeParam;
+
+    const IndexType nroot = 16;
+    const IndexType n = nroot * nroot * nroot;
+    const IndexType dimensions = 3;
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType k = comm->getSize();
+
+    scai::dmemo::DistributionPtr dist ( scai::dmemo::Distribution::getDistributionPtr( "BLOCK", comm, n) );
+    scai::dmemo::DistributionPtr noDistPointer(new scai::dmemo::NoDistribution(n));
+
+    auto graph = scai::lama::zero<scai::lama::CSRSparseMatrix<ValueType>>(dist, noDistPointer);
+    std::vector<ValueType> maxCoord(dimensions, nroot);
+    std::vector<IndexType> numPoints(dimensions, nroot);
+
+    std::vector<DenseVector<ValueType>> coordinates(dimensions);
+    for(IndexType i=0; i<dimensions; i++) {
+        coordinates[i].allocate(dist);
+        coordinates[i] = static_cast<ValueType>( 0 );
+    }
+    MeshGenerator<IndexType, ValueType>::createRandomStructured3DMesh_dist(graph, coordinates, maxCoord, numPoints);
+
+    //the block distribution is the partition
+    DenseVector<IndexType> part(dist, comm->getRank());
+
+    Settings settings;
+    settings.numBlocks = k;
+    settings.epsilon = 0.05;
+    settings.fmTrials = 4;
+
+    scai::lama::CSRSparseMatrix<ValueType> blockGraph = GraphUtils<IndexType,ValueType>::getBlockGraph( graph, part, settings.numBlocks);
+    std::vector<DenseVector<IndexType>> communicationScheme = ParcoRepart<IndexType,ValueType>::getCommunicationPairs_local(blockGraph, settings);
+
+    DenseVector<ValueType> weights(graph.getRowDistributionPtr(), 1);
+    std::vector<IndexType> localBorder = GraphUtils<IndexType,ValueType>::getNodesWithNonLocalNeighbors(graph);
+    std::vector<ValueType> distances;
+    DenseVector<IndexType> origin(graph.getRowDistributionPtr(), comm->getRank());
+
+    ValueType cut = GraphUtils<IndexType,ValueType>::computeCut(graph, part, true);
+
+    for (IndexType i = 0; i < 3; i++) {
+        std::vector<ValueType> gainPerRound = LocalRefinement<IndexType, ValueType>::distributedFMStep(graph, part, localBorder, weights, coordinates, distances, origin, communicationScheme, settings);
+        const ValueType gain = std::accumulate(gainPerRound.begin(), gainPerRound.end(), ValueType(0));
+
+        //the gain of the best trial is the gain of the partition that is kept
+        const ValueType newCut = GraphUtils<IndexType,ValueType>::computeCut(graph, part, true);
+        EXPECT_EQ(cut - gain, newCut);
+        EXPECT_LE(newCut, cut);
+        cut = newCut;
+    }
+
+    EXPECT_LE( GraphUtils<IndexType,ValueType>::computeImbalance(part, k, weights), settings.epsilon );
+}
+//---------------------------------------------------------------------------------------
+
+TYPED_TEST(LocalRefinementTest, testCommVolumeFM) {
+    using ValueType = TypeParam;
+
+    const IndexType nroot = 16;
+    const IndexType n = nroot * nroot * nroot;
+    const IndexType dimensions = 3;
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType k = comm->getSize();
+
+    scai::dmemo::DistributionPtr dist ( scai::dmemo::Distribution::getDistributionPtr( "BLOCK", comm, n) );
+    scai::dmemo::DistributionPtr noDistPointer(new scai::dmemo::NoDistribution(n));
+
+    auto graph = scai::lama::zero<scai::lama::CSRSparseMatrix<ValueType>>(dist, noDistPointer);
+    std::vector<ValueType> maxCoord(dimensions, nroot);
+    std::vector<IndexType> numPoints(dimensions, nroot);
+
+    std::vector<DenseVector<ValueType>> coordinates(dimensions);
+    for(IndexType i=0; i<dimensions; i++) {
+        coordinates[i].allocate(dist);
+        coordinates[i] = static_cast<ValueType>( 0 );
+    }
+    MeshGenerator<IndexType, ValueType>::createStructuredMesh_dist(graph, coordinates, maxCoord, numPoints, dimensions);
+
+    //the block distribution is the partition
+    DenseVector<IndexType> part(dist, comm->getRank());
+
+    Settings settings;
+    settings.numBlocks = k;
+    settings.epsilon = 0.05;
+    settings.refineCommVolume = true;
+
+    scai::lama::CSRSparseMatrix<ValueType> blockGraph = GraphUtils<IndexType,ValueType>::getBlockGraph( graph, part, settings.numBlocks);
+    std::vector<DenseVector<IndexType>> communicationScheme = ParcoRepart<IndexType,ValueType>::getCommunicationPairs_local(blockGraph, settings);
+
+    DenseVector<ValueType> weights(graph.getRowDistributionPtr(), 1);
+    std::vector<IndexType> localBorder = GraphUtils<IndexType,ValueType>::getNodesWithNonLocalNeighbors(graph);
+    std::vector<ValueType> distances;
+    DenseVector<IndexType> origin(graph.getRowDistributionPtr(), comm->getRank());
+
+    std::vector<IndexType> volumes = GraphUtils<IndexType,ValueType>::computeCommVolume(graph, part, settings);
+    const IndexType initialTotalVolume = std::accumulate(volumes.begin(), volumes.end(), IndexType(0));
+
+    //first the total volume, then the maximum volume
+    LocalRefinement<IndexType, ValueType>::distributedFMStep(graph, part, localBorder, weights, coordinates, distances, origin, communicationScheme, settings);
+    volumes = GraphUtils<IndexType,ValueType>::computeCommVolume(graph, part, settings);
+    const IndexType totalVolume = std::accumulate(volumes.begin(), volumes.end(), IndexType(0));
+    const IndexType maxVolume = *std::max_element(volumes.begin(), volumes.end());
+    EXPECT_LE( totalVolume, initialTotalVolume );
+
+    settings.minMaxCommVolume = true;
+    LocalRefinement<IndexType, ValueType>::distributedFMStep(graph, part, localBorder, weights, coordinates, distances, origin, communicationScheme, settings);
+    volumes = GraphUtils<IndexType,ValueType>::computeCommVolume(graph, part, settings);
+    EXPECT_LE( *std::max_element(volumes.begin(), volumes.end()), maxVolume );
+
+    EXPECT_LE( GraphUtils<IndexType,ValueType>::computeImbalance(part, k, weights), settings.epsilon );
+    PRINT0("communication volume FM: total volume " << initialTotalVolume << " -> " << totalVolume << ", max volume " << maxVolume << " -> " << *std::max_element(volumes.begin(), volumes.end()));
+}
+//---------------------------------------------------------------------------------------
+
+TYPED_TEST(LocalRefinementTest, testMultiConstraintFM) {
+    using ValueType = TypeParam;
+
+    const IndexType nroot = 16;
+    const IndexType n = nroot * nroot * nroot;
+    const IndexType dimensions = 3;
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType k = comm->getSize();
+
+    scai::dmemo::DistributionPtr dist ( scai::dmemo::Distribution::getDistributionPtr( "BLOCK", comm, n) );
+    scai::dmemo::DistributionPtr noDistPointer(new scai::dmemo::NoDistribution(n));
+
+    auto graph = scai::lama::zero<scai::lama::CSRSparseMatrix<ValueType>>(dist, noDistPointer);
+    std::vector<ValueType> maxCoord(dimensions, nroot);
+    std::vector<IndexType> numPoints(dimensions, nroot);
+
+    std::vector<DenseVector<ValueType>> coordinates(dimensions);
+    for(IndexType i=0; i<dimensions; i++) {
+        coordinates[i].allocate(dist);
+        coordinates[i] = static_cast<ValueType>( 0 );
+    }
+    MeshGenerator<IndexType, ValueType>::createStructuredMesh_dist(graph, coordinates, maxCoord, numPoints, dimensions);
+
+    //the block distribution is the partition
+    DenseVector<IndexType> part(dist, comm->getRank());
+
+    //one unit weight and one fractional weight that varies between the vertices
+    std::vector<DenseVector<ValueType>> weights(2);
+    weights[0] = DenseVector<ValueType>(dist, 1);
+    weights[1] = DenseVector<ValueType>(dist, 0);
+    {
+        scai::hmemo::WriteAccess<ValueType> wWeights(weights[1].getLocalValues());
+        for (IndexType i = 0; i < dist->getLocalSize(); i++) {
+            wWeights[i] = 0.25 + 1.5*ValueType((dist->local2Global(i)*7919) % 101)/101;
+        }
+    }
+
+    Settings settings;
+    settings.numBlocks = k;
+    settings.epsilon = 0.05;
+
+    scai::lama::CSRSparseMatrix<ValueType> blockGraph = GraphUtils<IndexType,ValueType>::getBlockGraph( graph, part, settings.numBlocks);
+    std::vector<DenseVector<IndexType>> communicationScheme = ParcoRepart<IndexType,ValueType>::getCommunicationPairs_local(blockGraph, settings);
+
+    std::vector<IndexType> localBorder = GraphUtils<IndexType,ValueType>::getNodesWithNonLocalNeighbors(graph);
+    std::vector<ValueType> distances;
+    DenseVector<IndexType> origin(graph.getRowDistributionPtr(), comm->getRank());
+
+    const ValueType initialCut = GraphUtils<IndexType,ValueType>::computeCut(graph, part, true);
+    ValueType initialImbalance = 0;
+    for (const DenseVector<ValueType>& w : weights) {
+        initialImbalance = std::max(initialImbalance, GraphUtils<IndexType,ValueType>::computeImbalance(part, k, w));
+    }
+
+    LocalRefinement<IndexType, ValueType>::distributedFMStep(graph, part, localBorder, weights, coordinates, distances, origin, communicationScheme, settings);
+
+    ASSERT_TRUE( weights[1].getDistributionPtr()->isEqual(graph.getRowDistribution()) );
+    EXPECT_LE( GraphUtils<IndexType,ValueType>::computeCut(graph, part, true), initialCut );
+    for (const DenseVector<ValueType>& w : weights) {
+        EXPECT_LE( GraphUtils<IndexType,ValueType>::computeImbalance(part, k, w), std::max<ValueType>(settings.epsilon, initialImbalance) + 1e-5 );
+    }
+}
+//---------------------------------------------------------------------------------------
+
+TYPED_TEST(LocalRefinementTest, testLabelPropagation) {
+    using ValueType = TypeParam;
+
+    const IndexType nroot = 16;
+    const IndexType n = nroot * nroot * nroot;
+    const IndexType dimensions = 3;
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    //label propagation does not need one block per process
+    const IndexType k = 2*comm->getSize() + 1;
+
+    scai::dmemo::DistributionPtr dist ( scai::dmemo::Distribution::getDistributionPtr( "BLOCK", comm, n) );
+    scai::dmemo::DistributionPtr noDistPointer(new scai::dmemo::NoDistribution(n));
+
+    auto graph = scai::lama::zero<scai::lama::CSRSparseMatrix<ValueType>>(dist, noDistPointer);
+    std::vector<ValueType> maxCoord(dimensions, nroot);
+    std::vector<IndexType> numPoints(dimensions, nroot);
+
+    std::vector<DenseVector<ValueType>> coordinates(dimensions);
+    for(IndexType i=0; i<dimensions; i++) {
+        coordinates[i].allocate(dist);
+        coordinates[i] = static_cast<ValueType>( 0 );
+    }
+
+    MeshGenerator<IndexType, ValueType>::createStructuredMesh_dist(graph, coordinates, maxCoord, numPoints, dimensions);
+
+    //a balanced partition with a large cut: slabs of 16 vertices are assigned to the blocks in turn
+    const IndexType localN = dist->getLocalSize();
+    DenseVector<IndexType> part(dist, 0);
+    {
+        scai::hmemo::WriteAccess<IndexType> wPart(part.getLocalValues());
+        for (IndexType i = 0; i < localN; i++) {
+            wPart[i] = (dist->local2Global(i) / nroot) % k;
+        }
+    }
+
+    Settings settings;
+    settings.numBlocks = k;
+    settings.epsilon = 0.05;
+    settings.dimensions = dimensions;
+
+    const DenseVector<ValueType> uniformWeights(dist, 1);
+    const ValueType initialCut = GraphUtils<IndexType, ValueType>::computeCut(graph, part);
+    const ValueType initialImbalance = GraphUtils<IndexType, ValueType>::computeImbalance(part, k, uniformWeights);
+
+    std::vector<ValueType> gainPerRound = LocalRefinement<IndexType, ValueType>::labelPropagation(graph, part, uniformWeights, settings);
+    EXPECT_GT( gainPerRound.size(), 0 );
+    EXPECT_LE( IndexType(gainPerRound.size()), settings.labelPropagationRounds );
+
+    //the graph keeps its distribution
+    EXPECT_TRUE( part.getDistributionPtr()->isEqual(*dist) );
+
+    const ValueType cut = GraphUtils<IndexType, ValueType>::computeCut(graph, part);
+    const ValueType imbalance = GraphUtils<IndexType, ValueType>::computeImbalance(part, k, uniformWeights);
+    EXPECT_LT( cut, initialCut );
+    EXPECT_LE( imbalance, std::max<ValueType>(settings.epsilon, initialImbalance) + 1e-5 );
+    PRINT0("label propagation: cut " << initialCut << " -> " << cut << ", imbalance " << initialImbalance << " -> " << imbalance);
+}
+//---------------------------------------------------------------------------------------
+
+TYPED_TEST(LocalRefinementTest, testLabelPropagationOverloadedBlock) {
+    using ValueType = TypeParam;
+
+    const IndexType nroot = 16;
+    const IndexType n = nroot * nroot * nroot;
+    const IndexType dimensions = 3;
+    const IndexType k = 3;
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    scai::dmemo::DistributionPtr dist ( scai::dmemo::Distribution::getDistributionPtr( "BLOCK", comm, n) );
+    scai::dmemo::DistributionPtr noDistPointer(new scai::dmemo::NoDistribution(n));
+
+    auto graph = scai::lama::zero<scai::lama::CSRSparseMatrix<ValueType>>(dist, noDistPointer);
+    std::vector<ValueType> maxCoord(dimensions, nroot);
+    std::vector<IndexType> numPoints(dimensions, nroot);
+    std::vector<DenseVector<ValueType>> coordinates(dimensions);
+    for(IndexType i=0; i<dimensions; i++) {
+        coordinates[i].allocate(dist);
+        coordinates[i] = static_cast<ValueType>( 0 );
+    }
+    MeshGenerator<IndexType, ValueType>::createStructuredMesh_dist(graph, coordinates, maxCoord, numPoints, dimensions);
+
+    //layers of the last coordinate: block 1 in the middle has 9 of 16 layers, the border between
+    //blocks 0 and 1 is ragged, so there are moves into block 1 that reduce the cut
+    const IndexType localN = dist->getLocalSize();
+    DenseVector<IndexType> part(dist, 0);
+    {
+        scai::hmemo::WriteAccess<IndexType> wPart(part.getLocalValues());
+        for (IndexType i = 0; i < localN; i++) {
+            const IndexType globalI = dist->local2Global(i);
+            const IndexType layer = globalI % nroot;
+            if (layer == 2 or layer == 3) {
+                wPart[i] = (globalI / nroot) % 3 == 0 ? 3 - layer : layer - 2;
+            } else {
+                wPart[i] = layer < 3 ? 0 : (layer < 12 ? 1 : 2);
+            }
+        }
+    }
+
+    Settings settings;
+    settings.numBlocks = k;
+    settings.epsilon = 0.05;
+    settings.dimensions = dimensions;
+
+    const DenseVector<ValueType> uniformWeights(dist, 1);
+    const ValueType initialImbalance = GraphUtils<IndexType, ValueType>::computeImbalance(part, k, uniformWeights);
+    ASSERT_GT( initialImbalance, 0.5 );
+
+    LocalRefinement<IndexType, ValueType>::labelPropagation(graph, part, uniformWeights, settings);
+
+    //the overloaded block ends under the cap, no other block exceeds it
+    const ValueType imbalance = GraphUtils<IndexType, ValueType>::computeImbalance(part, k, uniformWeights);
+    EXPECT_LE( imbalance, settings.epsilon + 1e-5 );
+    PRINT0("label propagation of an overloaded block: imbalance " << initialImbalance << " -> " << imbalance);
+}
+//---------------------------------------------------------------------------------------
+
+TYPED_TEST(LocalRefinementTest, testTopologyAwareLabelPropagation) {
+    using ValueType = TypeParam;
+
+    const IndexType nroot = 16;
+    const IndexType n = nroot * nroot * nroot;
+    const IndexType dimensions = 3;
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+
+    //two islands of four blocks each; blocks on different islands have distance 2, on the same island 1
+    CommTree<IndexType, ValueType> commTree;
+    commTree.createFromLevels( {2, 4}, 1 );
+    const IndexType k = commTree.getNumLeaves();
+
+    scai::dmemo::DistributionPtr dist ( scai::dmemo::Distribution::getDistributionPtr( "BLOCK", comm, n) );
+    scai::dmemo::DistributionPtr noDistPointer(new scai::dmemo::NoDistribution(n));
+
+    auto graph = scai::lama::zero<scai::lama::CSRSparseMatrix<ValueType>>(dist, noDistPointer);
+    std::vector<ValueType> maxCoord(dimensions, nroot);
+    std::vector<IndexType> numPoints(dimensions, nroot);
+
+    std::vector<DenseVector<ValueType>> coordinates(dimensions);
+    for(IndexType i=0; i<dimensions; i++) {
+        coordinates[i].allocate(dist);
+        coordinates[i] = static_cast<ValueType>( 0 );
+    }
+
+    MeshGenerator<IndexType, ValueType>::createStructuredMesh_dist(graph, coordinates, maxCoord, numPoints, dimensions);
+
+    //slabs of 16 vertices are assigned to the blocks in turn, so most cut edges are between islands
+    const IndexType localN = dist->getLocalSize();
+    DenseVector<IndexType> part(dist, 0);
+    {
+        scai::hmemo::WriteAccess<IndexType> wPart(part.getLocalValues());
+        for (IndexType i = 0; i < localN; i++) {
+            wPart[i] = (dist->local2Global(i) / nroot) % k;
+        }
+    }
+
+    Settings settings;
+    settings.numBlocks = k;
+    settings.epsilon = 0.05;
+    settings.dimensions = dimensions;
+
+    const DenseVector<ValueType> uniformWeights(dist, 1);
+    const ValueType initialImbalance = GraphUtils<IndexType, ValueType>::computeImbalance(part, k, uniformWeights);
+    const scai::lama::CSRSparseMatrix<ValueType> PEGraph = commTree.exportAsGraph_local();
+
+    Metrics<ValueType> initialMetrics(settings);
+    initialMetrics.getMappingMetrics(graph, part, PEGraph);
+
+    std::vector<ValueType> gainPerRound = LocalRefinement<IndexType, ValueType>::labelPropagation(graph, part, uniformWeights, settings, &commTree);
+    EXPECT_GT( gainPerRound.size(), 0 );
+
+    Metrics<ValueType> metrics(settings);
+    metrics.getMappingMetrics(graph, part, PEGraph);
+
+    const ValueType imbalance = GraphUtils<IndexType, ValueType>::computeImbalance(part, k, uniformWeights);
+    EXPECT_LT( metrics.MM["sumDilation"], initialMetrics.MM["sumDilation"] );
+    EXPECT_LE( imbalance, std::max<ValueType>(settings.epsilon, initialImbalance) + 1e-5 );
+    PRINT0("topology-aware label propagation: hop-bytes " << initialMetrics.MM["sumDilation"] << " -> " << metrics.MM["sumDilation"] << ", imbalance " << initialImbalance << " -> " << imbalance);
+}
+//---------------------------------------------------------------------------------------
 
 
 }// namespace ITI
@@ -0,0 +1,133 @@
+/*
+ * LocalizedGraph.cpp
+ *
+ * The local rows of a distributed graph with column indices renumbered to local and halo indices.
+ */
+
+#include <scai/lama/storage/CSRStorage.hpp>
+#include <scai/hmemo/ReadAccess.hpp>
+#include <scai/hmemo/WriteAccess.hpp>
+
+#include <algorithm>
+
+#include "LocalizedGraph.h"
+#include "Telemetry.h"
+
+namespace ITI {
+
+template<typename IndexType, typename ValueType>
+std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> LocalizedGraph<IndexType, ValueType>::create(const CSRSparseMatrix<ValueType>& graph) {
+    return std::shared_ptr<const LocalizedGraph>(new LocalizedGraph(graph));
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> LocalizedGraph<IndexType, ValueType>::get(const CSRSparseMatrix<ValueType>& graph, const std::shared_ptr<const LocalizedGraph>& localization) {
+    if (localization == nullptr) {
+        return create(graph);
+    }
+    SCAI_ASSERT_ERROR( localization->isLocalizationOf(graph), "Localization does not belong to the graph, was the graph redistributed?" );
+    return localization;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+bool LocalizedGraph<IndexType, ValueType>::isLocalizationOf(const CSRSparseMatrix<ValueType>& graph) const {
+    // a redistribution always creates a new distribution object
+    return graph.getRowDistributionPtr() == distribution and graph.getLocalStorage().getJA().size() == localJA.size();
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+LocalizedGraph<IndexType, ValueType>::LocalizedGraph(const CSRSparseMatrix<ValueType>& graph)
+    : distribution(graph.getRowDistributionPtr()), localN(graph.getRowDistributionPtr()->getLocalSize()) {
+
+    SCAI_REGION( "LocalizedGraph.localize" )
+
+    SCAI_ASSERT_ERROR( graph.getColDistributionPtr()->isReplicated(), "Columns of the graph must be global indices" );
+
+    const scai::hmemo::HArray<IndexType>& ja = graph.getLocalStorage().getJA();
+    const IndexType numValues = ja.size();
+
+    // the local index of every column, or invalidIndex; this is the only lookup per edge
+    scai::hmemo::HArray<IndexType> localIndices;
+    distribution->global2LocalV(localIndices, ja);
+
+    scai::hmemo::ReadAccess<IndexType> rJA(ja);
+    scai::hmemo::ReadAccess<IndexType> rLocal(localIndices);
+
+    for (IndexType j = 0; j < numValues; j++) {
+        if (rLocal[j] == scai::invalidIndex) {
+            haloGlobalIndices.push_back(rJA[j]);
+        }
+    }
+    std::sort(haloGlobalIndices.begin(), haloGlobalIndices.end());
+    haloGlobalIndices.erase(std::unique(haloGlobalIndices.begin(), haloGlobalIndices.end()), haloGlobalIndices.end());
+
+    scai::hmemo::WriteOnlyAccess<IndexType> wJA(localJA, numValues);
+    #pragma omp parallel for
+    for (IndexType j = 0; j < numValues; j++) {
+        if (rLocal[j] != scai::invalidIndex) {
+            wJA[j] = rLocal[j];
+        } else {
+            const IndexType h = std::lower_bound(haloGlobalIndices.begin(), haloGlobalIndices.end(), rJA[j]) - haloGlobalIndices.begin();
+            wJA[j] = localN + h;
+        }
+    }
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+scai::hmemo::HArray<IndexType> LocalizedGraph<IndexType, ValueType>::updateHalo(const scai::hmemo::HArray<IndexType>& localValues) const {
+    return updateHaloT(localValues);
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+scai::hmemo::HArray<ValueType> LocalizedGraph<IndexType, ValueType>::updateHalo(const scai::hmemo::HArray<ValueType>& localValues) const {
+    return updateHaloT(localValues);
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+template<typename T>
+scai::hmemo::HArray<T> LocalizedGraph<IndexType, ValueType>::updateHaloT(const scai::hmemo::HArray<T>& localValues) const {
+    SCAI_REGION( "LocalizedGraph.updateHalo" )
+
+    const scai::dmemo::Communicator& comm = distribution->getCommunicator();
+    SCAI_ASSERT_EQ_ERROR( localValues.size(), localN, "Values do not match the graph" );
+
+    // building the plan is collective, so it is built again on all PEs if one PE does not have it
+    const IndexType allHavePlan = comm.min( IndexType(haloPlan != nullptr) );
+    if (not allHavePlan) {
+        const IndexType haloN = haloGlobalIndices.size();
+        scai::hmemo::HArray<IndexType> requiredIndexes( haloN, haloGlobalIndices.data() );
+        haloPlan = std::make_shared<scai::dmemo::HaloExchangePlan>( scai::dmemo::haloExchangePlan(*distribution, requiredIndexes) );
+
+        haloPermutation.resize(haloN);
+        for (IndexType h = 0; h < haloN; h++) {
+            haloPermutation[h] = haloPlan->global2Halo(haloGlobalIndices[h]);
+            SCAI_ASSERT_NE_ERROR( haloPermutation[h], scai::invalidIndex, "Index " << haloGlobalIndices[h] << " not in halo" );
+        }
+    }
+
+    scai::hmemo::HArray<T> planHalo = haloPlan->updateHaloF(localValues, comm);
+    Telemetry::addCounter( "LocalizedGraph.haloExchanges", 1 );
+
+    const IndexType haloN = haloPermutation.size();
+    scai::hmemo::HArray<T> result;
+    {
+        scai::hmemo::ReadAccess<T> rPlanHalo(planHalo);
+        scai::hmemo::WriteOnlyAccess<T> wResult(result, haloN);
+        for (IndexType h = 0; h < haloN; h++) {
+            wResult[h] = rPlanHalo[haloPermutation[h]];
+        }
+    }
+    return result;
+}
+//---------------------------------------------------------------------------------------
+
+template class LocalizedGraph<IndexType, double>;
+template class LocalizedGraph<IndexType, float>;
+
+} //namespace ITI
@@ -0,0 +1,111 @@
+/*
+ * LocalizedGraph.h
+ *
+ * The local rows of a distributed graph with column indices renumbered to local and halo indices.
+ */
+
+#pragma once
+
+#include <scai/lama/matrix/CSRSparseMatrix.hpp>
+#include <scai/dmemo/Distribution.hpp>
+#include <scai/dmemo/HaloExchangePlan.hpp>
+#include <scai/hmemo/HArray.hpp>
+#include <scai/tracing.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "Settings.h"
+
+namespace ITI {
+
+using scai::lama::CSRSparseMatrix;
+
+/** @brief The adjacency of the local vertices of a distributed graph with columns that can be used as array indices.
+
+The column of an owned neighbor is its local index in [0, localN), the column of a non-local neighbor is localN+h
+with h in [0, haloN), where the halo vertices are numbered in the order of their global indices. The row offsets are the
+ones of the graph. Thus, kernels that look at the neighbors of every local vertex, e.g., to find the block of a neighbor,
+read per-vertex data with one array access per edge instead of calling global2Local or global2Halo for every edge:
+
+    value = col < localN ? localValues[col] : haloValues[col-localN]
+
+where haloValues is the result of updateHalo().
+
+The localized columns are computed locally, without communication, with one global2Local lookup per edge. There is no
+shared cache: an object belongs to the caller, who creates it for a graph and distribution and keeps it as long as both do
+not change; after a redistribution, a new object must be created. The kernels of GraphUtils, LocalRefinement and MultiLevel
+that use it take an optional localization, so the multilevel refinement localizes the graph once per distribution instead
+of once per kernel call. The halo exchange plan is built on the first call of updateHalo() and all PEs agree on whether it
+must be built, so all PEs always take the same path.
+*/
+
+template <typename IndexType, typename ValueType>
+class LocalizedGraph {
+public:
+    /** @brief The localized adjacency of the graph. Local operation.
+
+    @param[in] graph The graph; its columns must be global indices, i.e., not distributed.
+    @return The localized adjacency; it does not refer to the graph and stays valid, but is outdated after the graph is
+    changed or redistributed.
+    */
+    static std::shared_ptr<const LocalizedGraph> create(const CSRSparseMatrix<ValueType>& graph);
+
+    /** @brief The given localization of the graph or, if there is none, a new one. Local operation.
+
+    @param[in] graph The graph.
+    @param[in] localization A localization of the graph with its current distribution, or nullptr.
+    @return localization if it is not nullptr, create(graph) otherwise.
+    */
+    static std::shared_ptr<const LocalizedGraph> get(const CSRSparseMatrix<ValueType>& graph, const std::shared_ptr<const LocalizedGraph>& localization);
+
+    /** @return True if this object was created for the graph with its current distribution. Local operation. */
+    bool isLocalizationOf(const CSRSparseMatrix<ValueType>& graph) const;
+
+    /** @return The number of local vertices. */
+    IndexType getLocalN() const {
+        return localN;
+    }
+
+    /** @return The number of non-local neighbors. */
+    IndexType getHaloN() const {
+        return haloGlobalIndices.size();
+    }
+
+    /** @return The localized columns, with the same row offsets as the graph. */
+    const scai::hmemo::HArray<IndexType>& getJA() const {
+        return localJA;
+    }
+
+    /** @return The global index of every halo vertex, halo vertex h is column localN+h. Sorted. */
+    const std::vector<IndexType>& getHaloGlobalIndices() const {
+        return haloGlobalIndices;
+    }
+
+    /** @brief The values of the halo vertices, value h belongs to column localN+h. Global operation.
+
+    @param[in] localValues Values of the local vertices, same distribution as the graph.
+    @return The values of the halo vertices.
+    */
+    scai::hmemo::HArray<IndexType> updateHalo(const scai::hmemo::HArray<IndexType>& localValues) const;
+
+    /** @copydoc updateHalo */
+    scai::hmemo::HArray<ValueType> updateHalo(const scai::hmemo::HArray<ValueType>& localValues) const;
+
+private:
+    LocalizedGraph(const CSRSparseMatrix<ValueType>& graph);
+
+    template<typename T>
+    scai::hmemo::HArray<T> updateHaloT(const scai::hmemo::HArray<T>& localValues) const;
+
+    scai::dmemo::DistributionPtr distribution;
+    IndexType localN;
+    scai::hmemo::HArray<IndexType> localJA;
+    std::vector<IndexType> haloGlobalIndices;
+
+    // built on first use; halo vertex h is found at haloPermutation[h] in the halo of the plan
+    mutable std::shared_ptr<scai::dmemo::HaloExchangePlan> haloPlan;
+    mutable std::vector<IndexType> haloPermutation;
+};
+
+} //namespace ITI
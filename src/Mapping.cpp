@@ -5,8 +5,13 @@
  *      Author: tzovas
  */
 
+#include <algorithm>
+#include <numeric>
+#include <queue>
+
 #include "Mapping.h"
 #include "KMeans.h" //needed for findCenters in sfcMapping
+#include "HilbertCurve.h"
 
 
 namespace ITI {
@@ -484,6 +489,147 @@ std::vector<IndexType> Mapping<IndexType, ValueType>::applySfcRenumber(
     return reverseR;
 }//applySfcRenumber
 
+template <typename IndexType, typename ValueType>
+std::vector<IndexType> Mapping<IndexType, ValueType>::getLocalVertexOrder(
+    const scai::lama::CSRSparseMatrix<ValueType>& graph,
+    const std::vector<scai::lama::DenseVector<ValueType>>& coordinates,
+    const Settings settings) {
+    SCAI_REGION("Mapping.getLocalVertexOrder")
+
+    const scai::dmemo::DistributionPtr dist = graph.getRowDistributionPtr();
+    const IndexType localN = dist->getLocalSize();
+
+    SCAI_ASSERT( settings.localVertexOrder=="sfc" or settings.localVertexOrder=="rcm", "Unknown local vertex order " << settings.localVertexOrder );
+    SCAI_ASSERT( graph.getColDistributionPtr()->isReplicated(), "The columns of the graph must not be distributed" );
+
+    //the local neighbors of every vertex; a vertex with a non-local neighbor is an interface vertex
+    std::vector<IndexType> localIA(localN+1, 0);
+    std::vector<IndexType> localJA;
+    std::vector<bool> isInterface(localN, false);
+    {
+        const scai::lama::CSRStorage<ValueType>& localStorage = graph.getLocalStorage();
+        scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
+        scai::hmemo::ReadAccess<IndexType> ja(localStorage.getJA());
+        localJA.reserve(ia[localN]);
+
+        for (IndexType i = 0; i < localN; i++) {
+            for (IndexType j = ia[i]; j < ia[i+1]; j++) {
+                const IndexType localNeighbor = dist->global2Local(ja[j]);
+                if (localNeighbor == scai::invalidIndex) {
+                    isInterface[i] = true;
+                } else if (localNeighbor != i) {
+                    localJA.push_back(localNeighbor);
+                }
+            }
+            localIA[i+1] = localJA.size();
+        }
+    }
+
+    std::vector<IndexType> order(localN);
+    std::iota(order.begin(), order.end(), 0);
+
+    if (settings.localVertexOrder=="sfc") {
+        SCAI_ASSERT_EQ_ERROR( coordinates.size(), settings.dimensions, "The sfc order needs the coordinates" );
+        SCAI_ASSERT( coordinates[0].getDistribution().isEqual(*dist), "Graph and coordinates must have the same distribution" );
+
+        const std::vector<double> hilbertIndices = HilbertCurve<IndexType, ValueType>::getHilbertIndexVector(coordinates, settings.sfcResolution, settings.dimensions);
+        std::sort(order.begin(), order.end(), [&hilbertIndices](IndexType a, IndexType b) {
+            return hilbertIndices[a] < hilbertIndices[b];
+        });
+    } else {
+        //Cuthill-McKee: breadth-first search from a vertex of minimum degree in every connected component,
+        //visiting the neighbors by increasing degree; the order is reversed at the end
+        auto degree = [&localIA](IndexType v) {
+            return localIA[v+1] - localIA[v];
+        };
+
+        std::vector<IndexType> byDegree(order);
+        std::stable_sort(byDegree.begin(), byDegree.end(), [&degree](IndexType a, IndexType b) {
+            return degree(a) < degree(b);
+        });
+
+        std::vector<bool> visited(localN, false);
+        std::vector<IndexType> neighbors;
+        IndexType position = 0;
+        for (const IndexType root : byDegree) {
+            if (visited[root]) continue;
+
+            std::queue<IndexType> queue;
+            queue.push(root);
+            visited[root] = true;
+            while (!queue.empty()) {
+                const IndexType v = queue.front();
+                queue.pop();
+                order[position++] = v;
+
+                neighbors.clear();
+                for (IndexType j = localIA[v]; j < localIA[v+1]; j++) {
+                    if (!visited[localJA[j]]) {
+                        visited[localJA[j]] = true;
+                        neighbors.push_back(localJA[j]);
+                    }
+                }
+                std::stable_sort(neighbors.begin(), neighbors.end(), [&degree](IndexType a, IndexType b) {
+                    return degree(a) < degree(b);
+                });
+                for (const IndexType u : neighbors) {
+                    queue.push(u);
+                }
+            }
+        }
+        SCAI_ASSERT_EQ_ERROR( position, localN, "Not all vertices were ordered" );
+        std::reverse(order.begin(), order.end());
+    }
+
+    //the interface vertices go last, keeping the order within both groups
+    std::stable_partition(order.begin(), order.end(), [&isInterface](IndexType v) {
+        return !isInterface[v];
+    });
+
+    return order;
+}//getLocalVertexOrder
+//------------------------------------------------------------------------------------
+
+template <typename IndexType, typename ValueType>
+scai::dmemo::DistributionPtr Mapping<IndexType, ValueType>::applyLocalVertexOrder(
+    scai::lama::CSRSparseMatrix<ValueType>& graph,
+    std::vector<scai::lama::DenseVector<ValueType>>& coordinates,
+    std::vector<scai::lama::DenseVector<ValueType>>& nodeWeights,
+    const Settings settings) {
+    SCAI_REGION("Mapping.applyLocalVertexOrder")
+
+    const scai::dmemo::DistributionPtr dist = graph.getRowDistributionPtr();
+    const scai::dmemo::CommunicatorPtr comm = dist->getCommunicatorPtr();
+    const IndexType globalN = dist->getGlobalSize();
+    const IndexType localN = dist->getLocalSize();
+
+    const std::vector<IndexType> order = getLocalVertexOrder(graph, coordinates, settings);
+
+    //the owned indices in the new order; the local index of a vertex is its position in this array
+    scai::hmemo::HArray<IndexType> newOwned;
+    {
+        scai::hmemo::HArray<IndexType> ownedIndices;
+        dist->getOwnedIndexes(ownedIndices);
+        scai::hmemo::ReadAccess<IndexType> rOwned(ownedIndices);
+        scai::hmemo::WriteOnlyAccess<IndexType> wNewOwned(newOwned, localN);
+        for (IndexType i = 0; i < localN; i++) {
+            wNewOwned[i] = rOwned[order[i]];
+        }
+    }
+    const scai::dmemo::DistributionPtr newDist = scai::dmemo::generalDistributionUnchecked(globalN, newOwned, comm);
+
+    graph.redistribute(newDist, graph.getColDistributionPtr());
+    for (IndexType d = 0; d < IndexType(coordinates.size()); d++) {
+        coordinates[d].redistribute(newDist);
+    }
+    for (IndexType w = 0; w < IndexType(nodeWeights.size()); w++) {
+        nodeWeights[w].redistribute(newDist);
+    }
+
+    return newDist;
+}//applyLocalVertexOrder
+//------------------------------------------------------------------------------------
+
 //to force instantiation
 template class Mapping<IndexType, double>;
 template class Mapping<IndexType, float>;
@@ -110,6 +110,41 @@ public:
         scai::lama::DenseVector<IndexType>& partition,
         const Settings settings);
 
+    /** Provide an order of the local vertices for better cache locality when the local rows are
+    *   multiplied, e.g., in the SpMV of a solver. The graph must be distributed according to the
+    *   partition, i.e., every PE owns the vertices of one block. The vertices without non-local
+    *   neighbors come first, then the interface vertices, so the rows that need the halo are
+    *   consecutive. Both groups are ordered by settings.localVertexOrder: "sfc" sorts them by
+    *   the hilbert index of their coordinates, "rcm" uses reverse Cuthill-McKee on the local edges.
+    *
+    *	@param[in] graph The distributed graph, the local rows are one block. The columns must not be distributed.
+    *	@param[in] coordinates The coordinates of the points, distributed like the graph rows. Only
+    *	used for the sfc order and can be empty for rcm.
+    *	@param[in] settings Settings struct
+    * 	@return A vector of size localN. The local vertex R[i] should be placed at position i.
+    */
+    static std::vector<IndexType> getLocalVertexOrder(
+        const scai::lama::CSRSparseMatrix<ValueType>& graph,
+        const std::vector<scai::lama::DenseVector<ValueType>>& coordinates,
+        const Settings settings);
+
+    /** Calculates the local vertex order using getLocalVertexOrder and redistributes the graph,
+    *	the coordinates and the node weights so that the local rows follow it. The owner of every
+    *	vertex does not change.
+    *
+    *	@param[in,out] graph The distributed graph, the local rows are one block. The columns must not
+    *	be distributed; to reorder them as well, redistribute them with the returned distribution.
+    *	@param[in,out] coordinates The coordinates of the points, distributed like the graph rows.
+    *	@param[in,out] nodeWeights The weights of the points, distributed like the graph rows.
+    *	@param[in] settings Settings struct
+    * 	@return The new distribution, its local indices are the owned global indices in the new order.
+    */
+    static scai::dmemo::DistributionPtr applyLocalVertexOrder(
+        scai::lama::CSRSparseMatrix<ValueType>& graph,
+        std::vector<scai::lama::DenseVector<ValueType>>& coordinates,
+        std::vector<scai::lama::DenseVector<ValueType>>& nodeWeights,
+        const Settings settings);
+
 private:
     class max_compare_func {
     public:
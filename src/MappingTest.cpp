@@ -161,5 +161,76 @@ TYPED_TEST(MappingTest, testSfcMapping) {
 
 }
 
+//---------------------------------------------------------------------
+
+TYPED_TEST(MappingTest, testLocalVertexOrder) {
+    using ValueType = TypeParam;
+
+    std::string fileName = "Grid32x32";
+    std::string file = MappingTest<ValueType>::graphPath + fileName;
+
+    Settings settings;
+    settings.dimensions = 2;
+
+    const scai::lama::CSRSparseMatrix<ValueType> graph = FileIO<IndexType, ValueType>::readGraph( file );
+    const IndexType N = graph.getNumRows();
+    const std::vector<DenseVector<ValueType>> coords = FileIO<IndexType, ValueType>::readCoords( std::string(file + ".xyz"), N, settings.dimensions);
+
+    //the block distribution of the input is the partition, every PE owns one block
+    const scai::dmemo::DistributionPtr dist = graph.getRowDistributionPtr();
+    const IndexType localN = dist->getLocalSize();
+    ASSERT_TRUE( graph.getColDistributionPtr()->isReplicated() );
+
+    for( const std::string localOrder : {"sfc", "rcm"} ) {
+        settings.localVertexOrder = localOrder;
+
+        const std::vector<IndexType> order = Mapping<IndexType,ValueType>::getLocalVertexOrder( graph, coords, settings );
+        ASSERT_EQ( order.size(), localN );
+
+        std::vector<IndexType> sortedOrder( order );
+        std::sort( sortedOrder.begin(), sortedOrder.end() );
+        for( IndexType i=0; i<localN; i++) {
+            EXPECT_EQ( sortedOrder[i], i ) << "order is not a permutation";
+        }
+
+        //once the first interface vertex is reached, all following vertices are interface vertices
+        {
+            const scai::lama::CSRStorage<ValueType>& localStorage = graph.getLocalStorage();
+            scai::hmemo::ReadAccess<IndexType> ia( localStorage.getIA() );
+            scai::hmemo::ReadAccess<IndexType> ja( localStorage.getJA() );
+            bool interfaceReached = false;
+            for( IndexType i=0; i<localN; i++) {
+                const IndexType v = order[i];
+                bool isInterface = false;
+                for( IndexType j=ia[v]; j<ia[v+1]; j++) {
+                    isInterface = isInterface or not dist->isLocal(ja[j]);
+                }
+                EXPECT_TRUE( isInterface or not interfaceReached ) << "inner vertex after an interface vertex for " << localOrder;
+                interfaceReached = interfaceReached or isInterface;
+            }
+        }
+
+        //applying the order keeps the owners and moves the rows and coordinates to their new positions
+        scai::lama::CSRSparseMatrix<ValueType> orderedGraph( graph );
+        std::vector<DenseVector<ValueType>> orderedCoords( coords );
+        std::vector<DenseVector<ValueType>> nodeWeights( 1, DenseVector<ValueType>(dist, 1) );
+        const scai::dmemo::DistributionPtr newDist = Mapping<IndexType,ValueType>::applyLocalVertexOrder( orderedGraph, orderedCoords, nodeWeights, settings );
+
+        ASSERT_EQ( newDist->getLocalSize(), localN );
+        EXPECT_TRUE( orderedGraph.getRowDistributionPtr()->isEqual(*newDist) );
+        EXPECT_TRUE( nodeWeights[0].getDistributionPtr()->isEqual(*newDist) );
+        EXPECT_EQ( orderedGraph.getNumValues(), graph.getNumValues() );
+
+        scai::hmemo::ReadAccess<IndexType> oldIA( graph.getLocalStorage().getIA() );
+        scai::hmemo::ReadAccess<IndexType> newIA( orderedGraph.getLocalStorage().getIA() );
+        scai::hmemo::ReadAccess<ValueType> oldCoords( coords[0].getLocalValues() );
+        scai::hmemo::ReadAccess<ValueType> newCoords( orderedCoords[0].getLocalValues() );
+        for( IndexType i=0; i<localN; i++) {
+            EXPECT_EQ( newDist->local2Global(i), dist->local2Global(order[i]) );
+            EXPECT_EQ( newIA[i+1]-newIA[i], oldIA[order[i]+1]-oldIA[order[i]] );
+            EXPECT_EQ( newCoords[i], oldCoords[order[i]] );
+        }
+    }
+}
 
 }//namespace ITI
@@ -7,6 +7,7 @@
 
 #include "MeshGenerator.h"
 #include <chrono>
+#include <algorithm>
 
 #include <scai/common/macros/assert.hpp>
 
@@ -420,11 +421,155 @@ void MeshGenerator<IndexType, ValueType>::createStructuredMesh_dist(CSRSparseMat
     }
 }
 
+//-------------------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+void MeshGenerator<IndexType, ValueType>::createMesh_dist(CSRSparseMatrix<ValueType> &adjM, std::vector<DenseVector<ValueType>> &coords, const std::vector<ValueType> maxCoord, const std::vector<IndexType> numPoints, const MeshType meshType, const scai::dmemo::CommunicatorPtr comm, const ValueType meshParameter, const IndexType seed) {
+    SCAI_REGION( "MeshGenerator.createMesh_dist" )
+
+    const IndexType dimensions = numPoints.size();
+    if( !(dimensions==2 or dimensions==3) ) {
+        throw std::runtime_error("Function createMesh_dist only supports 2 or 3 dimension grids but dimension given is "+ std::to_string(dimensions)\
+                                 + ".\nAborting...");
+    }
+    SCAI_ASSERT_EQ_ERROR( maxCoord.size(), dimensions, "Wrong size for maxCoord" );
+    if( meshType==MeshType::perturbed ) {
+        SCAI_ASSERT_ERROR( meshParameter>=0 and meshParameter<1, "The perturbation must be in [0,1) but it is " << meshParameter );
+    } else if( meshType==MeshType::graded ) {
+        SCAI_ASSERT_GT_ERROR( meshParameter, 0, "The grading exponent must be positive" );
+    }
+
+    //internally, a 2D mesh is a 3D mesh with a single layer in the last dimension
+    const IndexType n[3] = { numPoints[0], numPoints[1], (dimensions==3 ? numPoints[2] : 1) };
+    const IndexType stride[3] = { n[1]*n[2], n[2], 1 };
+    for( IndexType d=0; d<3; d++) {
+        SCAI_ASSERT_GT_ERROR( n[d], 0, "Number of points must be positive in every dimension" );
+    }
+    const IndexType globalN = n[0]*n[1]*n[2];
+
+    const scai::dmemo::DistributionPtr dist( new scai::dmemo::BlockDistribution(globalN, comm) );
+    const IndexType localN = dist->getLocalSize();
+
+    IndexType beginLocalRange, endLocalRange;
+    scai::dmemo::BlockDistribution::getLocalRange(beginLocalRange, endLocalRange, globalN, comm->getRank(), comm->getSize());
+    SCAI_ASSERT_EQ_ERROR( localN, endLocalRange-beginLocalRange, "Local ranges do not agree");
+
+    //all random choices are hashes of global indices, thus they do not depend on the number of PEs
+    const unsigned long long diagonalSeed = mixHash( seed );
+    const unsigned long long coordSeed = mixHash( diagonalSeed );
+
+    //
+    // set the coordinates
+    //
+    {
+        SCAI_REGION( "MeshGenerator.createMesh_dist.setCoordinates" )
+
+        std::vector<std::vector<ValueType>> localCoords( dimensions, std::vector<ValueType>(localN) );
+
+        for( IndexType d=0; d<dimensions; d++) {
+            const ValueType offset = maxCoord[d]/n[d];
+
+            for( IndexType i=0; i<localN; i++) {
+                const IndexType globalI = beginLocalRange+i;
+                const IndexType ind = (globalI/stride[d])%n[d];
+                ValueType pos = ind*offset;
+
+                if( meshType==MeshType::perturbed ) {
+                    const unsigned long long h = mixHash( (((unsigned long long) globalI)*3 + d) ^ coordSeed );
+                    const double r = (h >> 11) * (1.0/9007199254740992.0); //uniform in [0,1)
+                    pos += (r-0.5)*meshParameter*offset;
+                } else if( meshType==MeshType::graded ) {
+                    pos = maxCoord[d]*std::pow( ValueType(ind)/n[d], meshParameter );
+                }
+                localCoords[d][i] = pos;
+            }
+        }
+
+        coords.resize( dimensions );
+        for( IndexType d=0; d<dimensions; d++) {
+            coords[d] = DenseVector<ValueType>(dist, HArray<ValueType>(localN, localCoords[d].data()) );
+        }
+    }
+
+    //
+    // set the adjacency lists
+    //
+
+    std::vector<IndexType> ia(localN+1, 0);
+    std::vector<IndexType> ja;
+    ja.reserve( localN*( meshType==MeshType::perturbed ? 6*dimensions-6 : 2*dimensions) );
+    {
+        SCAI_REGION( "MeshGenerator.createMesh_dist.setAdjacency" )
+
+        //the planes spanned by two dimensions, used for the diagonals
+        const IndexType planes[3][2] = { {0,1}, {0,2}, {1,2} };
+        std::vector<IndexType> neighbors;
+
+        for( IndexType i=0; i<localN; i++) {
+            const IndexType v = beginLocalRange+i;
+            const IndexType x[3] = { v/stride[0], (v/stride[1])%n[1], v%n[2] };
+            neighbors.clear();
+
+            for( IndexType d=0; d<3; d++) {
+                if( x[d]>0 ) {
+                    neighbors.push_back( v-stride[d] );
+                }
+                if( x[d]<n[d]-1 ) {
+                    neighbors.push_back( v+stride[d] );
+                }
+            }
+
+            if( meshType==MeshType::perturbed ) {
+                for( IndexType p=0; p<3; p++) {
+                    const IndexType a = planes[p][0];
+                    const IndexType b = planes[p][1];
+                    if( n[a]<2 or n[b]<2 ) {
+                        continue;
+                    }
+                    // v is a corner of up to four squares in this plane, (oa,ob) is its position within the square.
+                    // Every square gets one diagonal and both endpoints derive the same choice from the square's lower corner.
+                    for( IndexType oa=0; oa<2; oa++) {
+                        for( IndexType ob=0; ob<2; ob++) {
+                            const IndexType cornerA = x[a]-oa;
+                            const IndexType cornerB = x[b]-ob;
+                            if( cornerA<0 or cornerA>n[a]-2 or cornerB<0 or cornerB>n[b]-2 ) {
+                                continue;
+                            }
+                            const IndexType corner = v - oa*stride[a] - ob*stride[b];
+                            const unsigned long long squareId = ((unsigned long long) corner)*3 + p;
+                            const bool antiDiagonal = mixHash( squareId ^ diagonalSeed ) & 1;
+                            if( antiDiagonal == (oa!=ob) ) {
+                                neighbors.push_back( v + (1-2*oa)*stride[a] + (1-2*ob)*stride[b] );
+                            }
+                        }
+                    }
+                }
+            }
+
+            std::sort( neighbors.begin(), neighbors.end() );
+            ja.insert( ja.end(), neighbors.begin(), neighbors.end() );
+            ia[i+1] = ja.size();
+        }
+    }
+
+    {
+        SCAI_REGION( "MeshGenerator.createMesh_dist.setCSRSparseMatrix" )
+        std::vector<ValueType> values( ja.size(), 1.0 );
+
+        scai::lama::CSRStorage<ValueType> myStorage( localN, globalN,
+                HArray<IndexType>(ia.size(), ia.data()),
+                HArray<IndexType>(ja.size(), ja.data()),
+                HArray<ValueType>(values.size(), values.data()) );
+
+        adjM = CSRSparseMatrix<ValueType>( dist, std::move(myStorage) );
+    }
+}
+
 //-------------------------------------------------------------------------------------------------
 // coords.size()= 3 , coords[i].size()= N
 // here, N= numPoints[0]*numPoints[1]*numPoints[2]
 
-//TODO: not used, deprecate?
+//TODO: not used, deprecate? createMesh_dist with MeshType::perturbed replaces it
 //TODO: similarities with an rgg generator?
 
 template<typename IndexType, typename ValueType>
@@ -833,19 +978,15 @@ template<typename IndexType, typename ValueType>
 void MeshGenerator<IndexType, ValueType>::createQuadMesh( CSRSparseMatrix<ValueType> &adjM, std::vector<DenseVector<ValueType>> &coords, const int dimension, const IndexType numberOfAreas, const IndexType pointsPerArea, const ValueType maxVal, const IndexType seed) {
     SCAI_REGION("MeshGenerator.createQuadMesh")
 
-    //Point<ValueType> minCoord(dimension, 0); //something like that does not work, look at quad/Point.h
-
-    Point<ValueType> minCoord(dimension);
-    Point<ValueType> maxCoord(dimension);
-    for(int i=0; i< dimension; i++) {
-        minCoord[i]= 0;
-        maxCoord[i]= maxVal;
-    }
+    std::vector<ValueType> minCoord(dimension, 0);
+    std::vector<ValueType> maxCoord(dimension, maxVal);
 
     IndexType capacity = 1;
 
-    // the quad tree
-    QuadTreeCartesianEuclid<ValueType> quad(minCoord, maxCoord, true, capacity);
+    // the points are only needed as keys of the linear octree
+    LinearOctree<IndexType, ValueType> octree(minCoord, maxCoord);
+    std::vector<typename LinearOctree<IndexType, ValueType>::Key> pointKeys;
+    pointKeys.reserve( numberOfAreas*pointsPerArea + pointsPerArea*2 );
 
     // create points and add them in the tree
     std::random_device rd;
@@ -855,7 +996,7 @@ void MeshGenerator<IndexType, ValueType>::createQuadMesh( CSRSparseMatrix<ValueT
     std::cout<< "Creating graph for " << numberOfAreas << " areas and " << pointsPerArea << " points per area." <<std::endl;
 
     for(IndexType n=0; n<numberOfAreas; n++) {
-        SCAI_REGION("MeshGenerator.createQuadMesh.addPointsInQuadtree")
+        SCAI_REGION("MeshGenerator.createQuadMesh.addPointsInOctree")
         Point<ValueType> randPoint(dimension);
 
         for(int d=0; d<dimension; d++) {
@@ -879,7 +1020,7 @@ void MeshGenerator<IndexType, ValueType>::createQuadMesh( CSRSparseMatrix<ValueT
                 assert(thisCoord < maxCoord[d]);
                 pInRange[d] = thisCoord;
             }
-            quad.addContent(0,pInRange);
+            pointKeys.push_back( octree.getKey(&pInRange[0]) );
         }
     }
 
@@ -892,11 +1033,11 @@ void MeshGenerator<IndexType, ValueType>::createQuadMesh( CSRSparseMatrix<ValueT
             p[d] = dist(generator);
             //p[d]= ((ValueType) rand()/RAND_MAX) * maxCoord[d];
         }
-        quad.addContent(0, p);
+        pointKeys.push_back( octree.getKey(&p[0]) );
     }
 
-    quad.indexSubtree(0);
-    graphFromQuadtree(adjM, coords, quad);
+    octree.build(pointKeys, capacity);
+    graphFromOctree(adjM, coords, octree);
 }
 //----------------------------------------------------------------------------------------------
 
@@ -923,6 +1064,26 @@ void MeshGenerator<IndexType, ValueType>::graphFromQuadtree(CSRSparseMatrix<Valu
     }
 }
 
+//----------------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+void MeshGenerator<IndexType, ValueType>::graphFromOctree(CSRSparseMatrix<ValueType> &adjM, std::vector<DenseVector<ValueType>> &coords, const LinearOctree<IndexType, ValueType> &octree) {
+    SCAI_REGION("MeshGenerator.graphFromOctree")
+
+    adjM = octree.getLeafGraph();
+    const IndexType n = adjM.getNumRows();
+
+    std::vector<std::vector<ValueType>> coordsV = octree.getLeafCenters();
+    const IndexType dimension = coordsV.size();
+    coords.resize(dimension);
+
+    for(int d=0; d<dimension; d++) {
+        assert(coordsV[d].size() == n);
+        HArray<ValueType> localValues(n, coordsV[d].data());
+        coords[d] = DenseVector<ValueType>(localValues);
+    }
+}
+
 //----------------------------------------------------------------------------------------------
 /* Creates random points in the cube [0,maxCoord] in the given dimensions.
  */
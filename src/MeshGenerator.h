@@ -29,6 +29,7 @@
 #include <random>
 
 #include "quadtree/QuadTreeCartesianEuclid.h"
+#include "LinearOctree.h"
 #include "AuxiliaryFunctions.h"
 #include "Settings.h"
 
@@ -75,9 +76,36 @@ public:
     static void createStructuredMesh_dist(CSRSparseMatrix<ValueType> &adjM, std::vector<DenseVector<ValueType>> &coords, const std::vector<ValueType> maxCoord, const std::vector<IndexType> numPoints, const IndexType dimensions);
 
 
+    /** Creates a 2D or 3D grid mesh in a distributed way. Every PE computes its own block of consecutive vertices, their coordinates and
+    	adjacency lists arithmetically from the global vertex indices; no communication is needed besides creating the distribution.
+    	This scales to very large meshes (for more than 2^31 vertices, IndexType must be 64 bit).
+
+    	Vertices are numbered as in createStructuredMesh_dist, i.e., index = x*numPoints[1]*numPoints[2] + y*numPoints[2] + z.
+    	Depending on meshType:
+    	- structured: every vertex is adjacent to its axis-aligned neighbors.
+    	- perturbed: every point is moved randomly by up to meshParameter/2 times the grid spacing in every dimension and every
+    	 square of the grid gets one of its two diagonals as an additional edge. The choice only depends on the square and the seed,
+    	 so the graph is symmetric and the result does not depend on the number of PEs.
+    	- graded: as structured, but the coordinate of grid index i in dimension d is maxCoord[d]*(i/numPoints[d])^meshParameter.
+
+     @param[out] adjM The adjacency matrix of the output graph, block distributed over comm.
+     @param[out] coords The coordinates of every vertex, coords.size()=numPoints.size().
+     @param[in] maxCoord The maximum coordinate in every dimension.
+     @param[in] numPoints The number of points in every dimension; numPoints.size() must be 2 or 3.
+     @param[in] meshType The kind of mesh, \sa MeshType.
+     @param[in] comm The communicator to distribute the mesh over.
+     @param[in] meshParameter For perturbed meshes the perturbation as a fraction of the grid spacing, must be in [0,1).
+     	For graded meshes the grading exponent, must be positive. Ignored for structured meshes.
+     @param[in] seed The random seed for perturbed meshes.
+    */
+    static void createMesh_dist(CSRSparseMatrix<ValueType> &adjM, std::vector<DenseVector<ValueType>> &coords, const std::vector<ValueType> maxCoord, const std::vector<IndexType> numPoints, const MeshType meshType, const scai::dmemo::CommunicatorPtr comm, const ValueType meshParameter=0.5, const IndexType seed=0);
+
+    /** Creates a randomly connected 3D grid.
+     @deprecated Slow for large meshes since it communicates non-local edges in a ring; use createMesh_dist with MeshType::perturbed instead.
+    */
     static void createRandomStructured3DMesh_dist(CSRSparseMatrix<ValueType> &adjM, std::vector<DenseVector<ValueType>> &coords, const std::vector<ValueType> maxCoord, const std::vector<IndexType> numPoints);
 
-    /** First, it creates points in a cube of side maxCoord around some areas and adds them in a quad tree. After constructing the quad tree
+    /** First, it creates points in a cube of side maxCoord around some areas and adds them in a linear octree, see LinearOctree. After constructing the tree
     	it converts it to a graph. The graph has as many vertices as the cells of the quad tree. Two vertices are adjacent in the graph if the
     	corresponding cells are adjacent in the quad tree.
 
@@ -125,6 +153,11 @@ private:
     */
     static void graphFromQuadtree(CSRSparseMatrix<ValueType> &adjM, std::vector<DenseVector<ValueType>> &coords, const QuadTreeCartesianEuclid<ValueType> &quad);
 
+    /** Create a graph and coordinates from the leaves of a linear octree. The vertices are the leaves in Morton order,
+    	two vertices are adjacent if their leaves share a face and the coordinates are the centers of the leaves.
+    */
+    static void graphFromOctree(CSRSparseMatrix<ValueType> &adjM, std::vector<DenseVector<ValueType>> &coords, const LinearOctree<IndexType, ValueType> &octree);
+
     /** Creates random points in the cube for the given dimension, points in [0,maxCoord]^dim.
      */
     static std::vector<DenseVector<ValueType>> randomPoints(IndexType numberOfPoints, int dimensions, ValueType maxCoord);
@@ -133,6 +166,15 @@ private:
       */
     static ValueType dist3DSquared(std::tuple<IndexType, IndexType, IndexType> p1, std::tuple<IndexType, IndexType, IndexType> p2);
 
+    /** A stateless hash (the splitmix64 finalizer) used to derive reproducible random choices from global indices.
+      */
+    static inline unsigned long long mixHash(unsigned long long x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
 };//class MeshGenerator
 
 }//namespace ITI
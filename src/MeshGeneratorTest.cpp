@@ -17,11 +17,14 @@
 #include <fstream>
 #include <iostream>
 #include <chrono>
+#include <random>
+#include <set>
 
 #include "ParcoRepart.h"
 #include "gtest/gtest.h"
 #include "HilbertCurve.h"
 #include "MeshGenerator.h"
+#include "LinearOctree.h"
 #include "Settings.h"
 #include "FileIO.h"
 
@@ -340,6 +343,57 @@ TYPED_TEST(MeshGeneratorTest, testCreateRandomStructuredMesh_Distributed_3D) {
 }
 
 //-----------------------------------------------------------------
+TYPED_TEST(MeshGeneratorTest, testCreateMesh_Distributed) {
+    using ValueType = TypeParam;
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+
+    for( std::vector<IndexType> numPoints : { std::vector<IndexType>{40, 27, 19}, std::vector<IndexType>{93, 61} } ) {
+        const IndexType dimensions = numPoints.size();
+        const IndexType A = numPoints[0];
+        const IndexType B = numPoints[1];
+        const IndexType C = dimensions==3 ? numPoints[2] : 1;
+        const IndexType N = A*B*C;
+        std::vector<ValueType> maxCoord( dimensions, 100 );
+
+        for( MeshType meshType : {MeshType::structured, MeshType::perturbed, MeshType::graded} ) {
+            PRINT0("Building " << meshType << " mesh with N=" << N << " in " << dimensions << " dimensions" );
+
+            scai::lama::CSRSparseMatrix<ValueType> adjM;
+            std::vector<DenseVector<ValueType>> coords;
+            const ValueType meshParameter = meshType==MeshType::graded ? 2.0 : 0.5;
+            MeshGenerator<IndexType, ValueType>::createMesh_dist( adjM, coords, maxCoord, numPoints, meshType, comm, meshParameter, 7 );
+
+            ASSERT_EQ( coords.size(), dimensions );
+            EXPECT_EQ( adjM.getNumRows(), N );
+            EXPECT_TRUE( adjM.getRowDistribution().isEqual(coords[0].getDistribution()) );
+
+            //axis-aligned edges, plus one diagonal per square for perturbed meshes
+            IndexType numEdges = (A-1)*B*C + A*(B-1)*C + A*B*(C-1);
+            if( meshType==MeshType::perturbed ) {
+                numEdges += (A-1)*(B-1)*C + (A-1)*B*(C-1) + A*(B-1)*(C-1);
+            }
+            EXPECT_EQ( adjM.getNumValues(), 2*numEdges );
+
+            //coordinates stay close to the grid
+            for( IndexType d=0; d<dimensions; d++) {
+                const ValueType offset = maxCoord[d]/numPoints[d];
+                EXPECT_GE( coords[d].min(), -offset/2 );
+                EXPECT_LE( coords[d].max(), maxCoord[d] );
+            }
+
+            EXPECT_TRUE( adjM.isConsistent() );
+
+            // gather/replicate locally and test whole matrix
+            scai::dmemo::DistributionPtr noDistPointer(new scai::dmemo::NoDistribution( N ));
+            adjM.redistribute(noDistPointer, noDistPointer);
+            aux<IndexType, ValueType>::checkLocalDegreeSymmetry( adjM );
+        }
+    }
+}
+
+//-----------------------------------------------------------------
+
 TYPED_TEST(MeshGeneratorTest, testWriteMetis_Dist_3D) {
     using ValueType = TypeParam;
 
@@ -486,6 +540,79 @@ TYPED_TEST(MeshGeneratorTest, testSimpleMeshFromQuadTree_2D) {
 }
 //-----------------------------------------------------------------
 
+TYPED_TEST(MeshGeneratorTest, testLinearOctreeGraph) {
+    using ValueType = TypeParam;
+
+    const IndexType dimension = 3;
+    const IndexType numPoints = 300;
+    const std::vector<ValueType> minCoords(dimension, 0);
+    const std::vector<ValueType> maxCoords(dimension, 64);
+
+    LinearOctree<IndexType, ValueType> octree(minCoords, maxCoords);
+
+    //points clustered in one corner, so the leaves have many different levels
+    std::default_random_engine generator(42);
+    std::exponential_distribution<ValueType> dist(0.2);
+    std::vector<typename LinearOctree<IndexType, ValueType>::Key> keys(numPoints);
+    for (IndexType i = 0; i < numPoints; i++) {
+        std::vector<ValueType> point(dimension);
+        for (IndexType d = 0; d < dimension; d++) {
+            point[d] = std::min(dist(generator), ValueType(63));
+        }
+        keys[i] = octree.getKey(point.data());
+    }
+    octree.build(keys, 2);
+
+    const IndexType n = octree.numLeaves();
+    ASSERT_GT(n, 1);
+
+    std::vector<std::vector<ValueType>> minCorners(n), maxCorners(n);
+    ValueType volume = 0;
+    for (IndexType i = 0; i < n; i++) {
+        octree.getLeafBox(i, minCorners[i], maxCorners[i]);
+        volume += std::pow(maxCorners[i][0] - minCorners[i][0], dimension);
+
+        //parent and child arithmetic
+        const IndexType level = octree.getLeafLevel(i);
+        if (level > 0) {
+            const auto parent = octree.parentKey(octree.getLeafKey(i), level);
+            EXPECT_LE(octree.findLeaf(parent), i);
+            EXPECT_GT(octree.span(level-1), octree.getLeafKey(i) - parent);
+        }
+        EXPECT_EQ(octree.findLeaf(octree.getLeafKey(i)), i);
+    }
+    //the leaves cover the box exactly
+    EXPECT_NEAR(volume, std::pow(64, dimension), 1e-3);
+
+    //compare with the adjacency of the boxes: sharing a face, but not only an edge or a corner
+    const scai::lama::CSRSparseMatrix<ValueType> graph = octree.getLeafGraph();
+    ASSERT_EQ(graph.getNumRows(), n);
+    const scai::lama::CSRStorage<ValueType>& localStorage = graph.getLocalStorage();
+    const scai::hmemo::ReadAccess<IndexType> ia(localStorage.getIA());
+    const scai::hmemo::ReadAccess<IndexType> ja(localStorage.getJA());
+
+    for (IndexType i = 0; i < n; i++) {
+        std::set<IndexType> neighbors(ja.get() + ia[i], ja.get() + ia[i+1]);
+        EXPECT_EQ(IndexType(neighbors.size()), ia[i+1] - ia[i]);
+
+        for (IndexType j = 0; j < n; j++) {
+            if (i == j) continue;
+            bool overlap = true;
+            IndexType touching = 0;
+            for (IndexType d = 0; d < dimension; d++) {
+                if (maxCorners[i][d] < minCorners[j][d] or minCorners[i][d] > maxCorners[j][d]) {
+                    overlap = false;
+                }
+                if (maxCorners[i][d] == minCorners[j][d] or minCorners[i][d] == maxCorners[j][d]) {
+                    touching++;
+                }
+            }
+            EXPECT_EQ(overlap and touching == 1, neighbors.count(j) > 0) << "leaves " << i << " and " << j;
+        }
+    }
+}
+//-----------------------------------------------------------------
+
 TYPED_TEST(MeshGeneratorTest, testDistSquared) {
     using ValueType = TypeParam;
 
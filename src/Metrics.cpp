@@ -3,6 +3,7 @@
 
 #include "Metrics.h"
 #include "FileIO.h"
+#include "Mapping.h"
 
 using namespace ITI;
 
@@ -122,7 +123,10 @@ void Metrics<ValueType>::getRedistMetrics( const scai::lama::CSRSparseMatrix<Val
 template<typename ValueType>
 void Metrics<ValueType>::getEasyMetrics( const scai::lama::CSRSparseMatrix<ValueType> graph, const scai::lama::DenseVector<IndexType> partition, const std::vector<scai::lama::DenseVector<ValueType>> nodeWeights, struct Settings settings ) {
 
-    MM["finalCut"] = ITI::GraphUtils<IndexType, ValueType>::computeCut(graph, partition, true);
+    //the cut and the communication volume share one localization of the graph
+    const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::create(graph);
+
+    MM["finalCut"] = ITI::GraphUtils<IndexType, ValueType>::computeCut(graph, partition, true, localized);
 
     for( unsigned int w=0; w<nodeWeights.size(); w++ ) {
         imbalances.push_back(  ITI::GraphUtils<IndexType, ValueType>::computeImbalance( partition, settings.numBlocks, nodeWeights[w]) );
@@ -143,7 +147,7 @@ void Metrics<ValueType>::getEasyMetrics( const scai::lama::CSRSparseMatrix<Value
     // TODO: can re returned in an auto, check if it is faster
     // it is a bit uglier but saves time
     std::tie( commVolume, numBorderNodesPerBlock, numInnerNodesPerBlock ) = \
-            ITI::GraphUtils<IndexType, ValueType>::computeCommBndInner( graph, partition, settings );
+            ITI::GraphUtils<IndexType, ValueType>::computeCommBndInner( graph, partition, settings, localized );
 
     MM["maxCommVolume"] = *std::max_element( commVolume.begin(), commVolume.end() );
     MM["totalCommVolume"] = std::accumulate( commVolume.begin(), commVolume.end(), 0 );
@@ -301,6 +305,12 @@ void Metrics<ValueType>::getRedistRequiredMetrics( const scai::lama::CSRSparseMa
     // redistribute for SpMV, linear solver and commTime
     //
 
+    //order the rows inside the blocks as the solver would get them; the sfc order needs coordinates, which are not given here
+    if( settings.localVertexOrder=="rcm" ) {
+        std::vector<scai::lama::DenseVector<ValueType>> noCoordinates, noWeights;
+        distFromPartition = Mapping<IndexType,ValueType>::applyLocalVertexOrder( copyGraph, noCoordinates, noWeights, settings );
+    }
+
     copyGraph.redistribute( distFromPartition, distFromPartition );
 
     MM["SpMVtime"] = getSPMVtime(copyGraph, repeatTimes);
@@ -483,6 +493,7 @@ void Metrics<ValueType>::getMappingMetrics(
     MM["maxCongestion"] = maxCongestion;
     MM["maxDilation"] = maxDilation;
     MM["avgDilation"] = avgDilation;
+    MM["sumDilation"] = sumDilation; //the hop-bytes of the partition for the weights of the PE graph
 
 }//getMappingMetrics
 //---------------------------------------------------------------------------------------
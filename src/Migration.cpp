@@ -0,0 +1,360 @@
+/*
+ * Migration.cpp
+ *
+ * Moves the graph and all per-vertex data to a new distribution with one communication plan.
+ */
+
+#include <scai/dmemo/CommunicationPlan.hpp>
+#include <scai/dmemo/GeneralDistribution.hpp>
+#include <scai/dmemo/NoDistribution.hpp>
+#include <scai/hmemo/ReadAccess.hpp>
+#include <scai/hmemo/WriteAccess.hpp>
+
+#include <numeric>
+#include <memory>
+
+#include "Migration.h"
+#include "Telemetry.h"
+
+namespace ITI {
+
+template<typename IndexType, typename ValueType>
+scai::dmemo::DistributionPtr Migration<IndexType, ValueType>::migrateByNewOwners(
+    const scai::hmemo::HArray<IndexType>& newOwners,
+    CSRSparseMatrix<ValueType>* graph,
+    const std::vector<DenseVector<ValueType>*>& valueVectors,
+    const std::vector<DenseVector<IndexType>*>& indexVectors) {
+
+    return migrate( newOwners, scai::dmemo::DistributionPtr(), graph, asConst(valueVectors), valueVectors, indexVectors );
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+scai::dmemo::DistributionPtr Migration<IndexType, ValueType>::migrateCopyByNewOwners(
+    const scai::hmemo::HArray<IndexType>& newOwners,
+    const std::vector<const DenseVector<ValueType>*>& sources,
+    const std::vector<DenseVector<ValueType>*>& targets) {
+
+    SCAI_ASSERT_EQ_ERROR( sources.size(), targets.size(), "One target per source vector needed" );
+    return migrate( newOwners, scai::dmemo::DistributionPtr(), nullptr, sources, targets, {} );
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+void Migration<IndexType, ValueType>::migrateToDistribution(
+    const scai::dmemo::DistributionPtr targetDistribution,
+    CSRSparseMatrix<ValueType>* graph,
+    const std::vector<DenseVector<ValueType>*>& valueVectors,
+    const std::vector<DenseVector<IndexType>*>& indexVectors) {
+
+    SCAI_REGION( "Migration.migrateToDistribution" )
+
+    const scai::dmemo::DistributionPtr sourceDist = getSourceDistribution( graph, asConst(valueVectors), indexVectors );
+    if( sourceDist->isEqual(*targetDistribution) ) {
+        if( graph != nullptr and not graph->getColDistributionPtr()->isReplicated() ) {
+            graph->redistribute( sourceDist, scai::dmemo::DistributionPtr(new scai::dmemo::NoDistribution(sourceDist->getGlobalSize())) );
+        }
+        return;
+    }
+
+    scai::hmemo::HArray<IndexType> myGlobalIndexes;
+    sourceDist->getOwnedIndexes( myGlobalIndexes );
+    scai::hmemo::HArray<IndexType> newOwners;
+    targetDistribution->computeOwners( newOwners, myGlobalIndexes );
+
+    migrate( newOwners, targetDistribution, graph, asConst(valueVectors), valueVectors, indexVectors );
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+scai::dmemo::DistributionPtr Migration<IndexType, ValueType>::migrate(
+    const scai::hmemo::HArray<IndexType>& newOwners,
+    scai::dmemo::DistributionPtr targetDistribution,
+    CSRSparseMatrix<ValueType>* graph,
+    const std::vector<const DenseVector<ValueType>*>& valueSources,
+    const std::vector<DenseVector<ValueType>*>& valueTargets,
+    const std::vector<DenseVector<IndexType>*>& indexVectors) {
+
+    SCAI_REGION( "Migration.migrate" )
+    Telemetry::ScopedTimer timer( "Migration.migrate" );
+
+    const scai::dmemo::DistributionPtr sourceDist = getSourceDistribution( graph, valueSources, indexVectors );
+    const scai::dmemo::CommunicatorPtr comm = sourceDist->getCommunicatorPtr();
+    const IndexType numPEs = comm->getSize();
+    const IndexType globalN = sourceDist->getGlobalSize();
+    const IndexType localN = sourceDist->getLocalSize();
+    SCAI_ASSERT_EQ_ERROR( newOwners.size(), localN, "One new owner per local vertex is needed" );
+
+    const IndexType numValueVectors = valueSources.size();
+    const IndexType numIndexVectors = indexVectors.size();
+
+    // a record of one vertex: [global id, degree, index vectors..., neighbors...] and [value vectors..., edge weights...]
+    const IndexType indexHeader = 2 + numIndexVectors;
+    const IndexType valueHeader = numValueVectors;
+
+    if( graph != nullptr and not graph->getColDistributionPtr()->isReplicated() ) {
+        // the local storage must contain all columns with their global indices
+        graph->redistribute( sourceDist, scai::dmemo::DistributionPtr(new scai::dmemo::NoDistribution(globalN)) );
+    }
+
+    //
+    // sort the local vertices by their new owner and compute the size of every record
+    //
+
+    std::vector<IndexType> order( localN );
+    std::vector<IndexType> indexOffset( localN+1, 0 );
+    std::vector<IndexType> valueOffset( localN+1, 0 );
+    std::vector<IndexType> indexQuantities( numPEs, 0 );
+    std::vector<IndexType> valueQuantities( numPEs, 0 );
+    {
+        SCAI_REGION( "Migration.migrate.plan" )
+        scai::hmemo::ReadAccess<IndexType> rOwners( newOwners );
+
+        std::vector<IndexType> firstOfPE( numPEs+1, 0 );
+        for (IndexType i = 0; i < localN; i++) {
+            SCAI_ASSERT_VALID_INDEX_DEBUG( rOwners[i], numPEs, "Invalid new owner" );
+            firstOfPE[ rOwners[i]+1 ]++;
+        }
+        std::partial_sum( firstOfPE.begin(), firstOfPE.end(), firstOfPE.begin() );
+        for (IndexType i = 0; i < localN; i++) {
+            order[ firstOfPE[rOwners[i]]++ ] = i;
+        }
+
+        std::unique_ptr<scai::hmemo::ReadAccess<IndexType>> rIA;
+        if( graph != nullptr ) {
+            rIA.reset( new scai::hmemo::ReadAccess<IndexType>( graph->getLocalStorage().getIA() ) );
+        }
+
+        for (IndexType j = 0; j < localN; j++) {
+            const IndexType i = order[j];
+            const IndexType degree = rIA ? (*rIA)[i+1] - (*rIA)[i] : 0;
+            indexOffset[j+1] = indexOffset[j] + indexHeader + degree;
+            valueOffset[j+1] = valueOffset[j] + valueHeader + degree;
+            indexQuantities[ rOwners[i] ] += indexHeader + degree;
+            valueQuantities[ rOwners[i] ] += valueHeader + degree;
+        }
+    }
+
+    //
+    // pack the records in the order of their new owners
+    //
+
+    std::vector<IndexType> sendIndices( indexOffset[localN] );
+    std::vector<ValueType> sendValues( valueOffset[localN] );
+    {
+        SCAI_REGION( "Migration.migrate.pack" )
+        scai::hmemo::HArray<IndexType> myGlobalIndexes;
+        sourceDist->getOwnedIndexes( myGlobalIndexes );
+        scai::hmemo::ReadAccess<IndexType> rGlobal( myGlobalIndexes );
+
+        for (IndexType v = 0; v < numIndexVectors; v++) {
+            scai::hmemo::ReadAccess<IndexType> rVector( indexVectors[v]->getLocalValues() );
+            #pragma omp parallel for
+            for (IndexType j = 0; j < localN; j++) {
+                sendIndices[ indexOffset[j] + 2 + v ] = rVector[ order[j] ];
+            }
+        }
+        for (IndexType v = 0; v < numValueVectors; v++) {
+            scai::hmemo::ReadAccess<ValueType> rVector( valueSources[v]->getLocalValues() );
+            #pragma omp parallel for
+            for (IndexType j = 0; j < localN; j++) {
+                sendValues[ valueOffset[j] + v ] = rVector[ order[j] ];
+            }
+        }
+
+        if( graph != nullptr ) {
+            const scai::lama::CSRStorage<ValueType>& storage = graph->getLocalStorage();
+            scai::hmemo::ReadAccess<IndexType> rIA( storage.getIA() );
+            scai::hmemo::ReadAccess<IndexType> rJA( storage.getJA() );
+            scai::hmemo::ReadAccess<ValueType> rEdgeValues( storage.getValues() );
+
+            #pragma omp parallel for
+            for (IndexType j = 0; j < localN; j++) {
+                const IndexType i = order[j];
+                const IndexType degree = rIA[i+1] - rIA[i];
+                sendIndices[ indexOffset[j] ] = rGlobal[i];
+                sendIndices[ indexOffset[j] + 1 ] = degree;
+                std::copy( rJA.get() + rIA[i], rJA.get() + rIA[i+1], sendIndices.begin() + indexOffset[j] + indexHeader );
+                std::copy( rEdgeValues.get() + rIA[i], rEdgeValues.get() + rIA[i+1], sendValues.begin() + valueOffset[j] + valueHeader );
+            }
+        } else {
+            #pragma omp parallel for
+            for (IndexType j = 0; j < localN; j++) {
+                sendIndices[ indexOffset[j] ] = rGlobal[ order[j] ];
+                sendIndices[ indexOffset[j] + 1 ] = 0;
+            }
+        }
+    }
+    order.clear();
+    indexOffset.clear();
+    valueOffset.clear();
+
+    //
+    // exchange the integer stream, then derive the plan of the value stream from the received degrees
+    //
+
+    // the records a PE keeps are not sent
+    const IndexType myRank = comm->getRank();
+    const IndexType sentIndices = std::accumulate( indexQuantities.begin(), indexQuantities.end(), IndexType(0) ) - indexQuantities[myRank];
+    const IndexType sentValues = std::accumulate( valueQuantities.begin(), valueQuantities.end(), IndexType(0) ) - valueQuantities[myRank];
+    Telemetry::addCounter( "Migration.bytesSent", double(sentIndices)*sizeof(IndexType) + double(sentValues)*sizeof(ValueType) );
+    Telemetry::addCounter( "Migration.collectives", 3 ); // one transpose and two exchanges
+
+    scai::dmemo::CommunicationPlan indexSendPlan( indexQuantities.data(), numPEs );
+    scai::dmemo::CommunicationPlan indexRecvPlan = comm->transpose( indexSendPlan );
+
+    std::vector<IndexType> recvIndices( indexRecvPlan.totalQuantity() );
+    {
+        SCAI_REGION( "Migration.migrate.exchangeIndices" )
+        comm->exchangeByPlan( recvIndices.data(), indexRecvPlan, sendIndices.data(), indexSendPlan );
+    }
+    sendIndices.clear();
+
+    // the start of every received record in both streams
+    std::vector<IndexType> recvIndexOffset;
+    std::vector<IndexType> recvValueOffset;
+    std::vector<IndexType> recvValueQuantities( numPEs, 0 );
+    {
+        IndexType valuePos = 0;
+        for (IndexType e = 0; e < indexRecvPlan.size(); e++) {
+            const scai::dmemo::CommunicationPlan::Entry entry = indexRecvPlan[e];
+            IndexType pos = entry.offset;
+            while( pos < entry.offset + entry.quantity ) {
+                const IndexType degree = recvIndices[pos+1];
+                recvIndexOffset.push_back( pos );
+                recvValueOffset.push_back( valuePos );
+                recvValueQuantities[ entry.partitionId ] += valueHeader + degree;
+                pos += indexHeader + degree;
+                valuePos += valueHeader + degree;
+            }
+            SCAI_ASSERT_EQ_ERROR( pos, entry.offset + entry.quantity, "Corrupted records received from PE " << entry.partitionId );
+        }
+    }
+    const IndexType newLocalN = recvIndexOffset.size();
+
+    scai::dmemo::CommunicationPlan valueSendPlan( valueQuantities.data(), numPEs );
+    scai::dmemo::CommunicationPlan valueRecvPlan( recvValueQuantities.data(), numPEs );
+
+    std::vector<ValueType> recvValues( valueRecvPlan.totalQuantity() );
+    {
+        SCAI_REGION( "Migration.migrate.exchangeValues" )
+        comm->exchangeByPlan( recvValues.data(), valueRecvPlan, sendValues.data(), valueSendPlan );
+    }
+    sendValues.clear();
+
+    //
+    // create the new distribution and unpack
+    //
+
+    std::vector<IndexType> recvGlobal( newLocalN );
+    for (IndexType r = 0; r < newLocalN; r++) {
+        recvGlobal[r] = recvIndices[ recvIndexOffset[r] ];
+    }
+
+    if( targetDistribution ) {
+        SCAI_ASSERT_EQ_ERROR( targetDistribution->getLocalSize(), newLocalN, "Received data does not fit the target distribution" );
+    } else {
+        scai::hmemo::HArray<IndexType> indexTransport( newLocalN, recvGlobal.data() );
+        targetDistribution = scai::dmemo::generalDistributionUnchecked( globalN, std::move(indexTransport), comm );
+    }
+
+    // the local index of every received record
+    std::vector<IndexType> localPos( newLocalN );
+    #pragma omp parallel for
+    for (IndexType r = 0; r < newLocalN; r++) {
+        localPos[r] = targetDistribution->global2Local( recvGlobal[r] );
+        SCAI_ASSERT_NE_DEBUG( localPos[r], scai::invalidIndex, "Received vertex " << recvGlobal[r] << " is not local" );
+    }
+
+    SCAI_REGION_START( "Migration.migrate.unpack" )
+    for (IndexType v = 0; v < numIndexVectors; v++) {
+        scai::hmemo::HArray<IndexType> newValues( newLocalN );
+        {
+            scai::hmemo::WriteOnlyAccess<IndexType> wValues( newValues, newLocalN );
+            #pragma omp parallel for
+            for (IndexType r = 0; r < newLocalN; r++) {
+                wValues[ localPos[r] ] = recvIndices[ recvIndexOffset[r] + 2 + v ];
+            }
+        }
+        *indexVectors[v] = DenseVector<IndexType>( targetDistribution, std::move(newValues) );
+    }
+    for (IndexType v = 0; v < numValueVectors; v++) {
+        scai::hmemo::HArray<ValueType> newValues( newLocalN );
+        {
+            scai::hmemo::WriteOnlyAccess<ValueType> wValues( newValues, newLocalN );
+            #pragma omp parallel for
+            for (IndexType r = 0; r < newLocalN; r++) {
+                wValues[ localPos[r] ] = recvValues[ recvValueOffset[r] + v ];
+            }
+        }
+        *valueTargets[v] = DenseVector<ValueType>( targetDistribution, std::move(newValues) );
+    }
+
+    if( graph != nullptr ) {
+        std::vector<IndexType> ia( newLocalN+1, 0 );
+        for (IndexType r = 0; r < newLocalN; r++) {
+            ia[ localPos[r]+1 ] = recvIndices[ recvIndexOffset[r] + 1 ];
+        }
+        std::partial_sum( ia.begin(), ia.end(), ia.begin() );
+
+        std::vector<IndexType> ja( ia[newLocalN] );
+        std::vector<ValueType> edgeValues( ia[newLocalN] );
+        #pragma omp parallel for
+        for (IndexType r = 0; r < newLocalN; r++) {
+            const IndexType row = localPos[r];
+            const IndexType degree = ia[row+1] - ia[row];
+            const IndexType indexStart = recvIndexOffset[r] + indexHeader;
+            const IndexType valueStart = recvValueOffset[r] + valueHeader;
+            std::copy( recvIndices.begin() + indexStart, recvIndices.begin() + indexStart + degree, ja.begin() + ia[row] );
+            std::copy( recvValues.begin() + valueStart, recvValues.begin() + valueStart + degree, edgeValues.begin() + ia[row] );
+        }
+
+        scai::lama::CSRStorage<ValueType> myStorage( newLocalN, globalN,
+                scai::hmemo::HArray<IndexType>(ia.size(), ia.data()),
+                scai::hmemo::HArray<IndexType>(ja.size(), ja.data()),
+                scai::hmemo::HArray<ValueType>(edgeValues.size(), edgeValues.data()));
+
+        *graph = CSRSparseMatrix<ValueType>( targetDistribution, std::move(myStorage) );
+    }
+    SCAI_REGION_END( "Migration.migrate.unpack" )
+
+    return targetDistribution;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+scai::dmemo::DistributionPtr Migration<IndexType, ValueType>::getSourceDistribution(
+    const CSRSparseMatrix<ValueType>* graph,
+    const std::vector<const DenseVector<ValueType>*>& valueVectors,
+    const std::vector<DenseVector<IndexType>*>& indexVectors) {
+
+    scai::dmemo::DistributionPtr dist;
+    if( graph != nullptr ) {
+        dist = graph->getRowDistributionPtr();
+    } else if( not valueVectors.empty() ) {
+        dist = valueVectors[0]->getDistributionPtr();
+    } else {
+        SCAI_ASSERT_ERROR( not indexVectors.empty(), "Nothing to migrate" );
+        dist = indexVectors[0]->getDistributionPtr();
+    }
+
+    for (const DenseVector<ValueType>* vector : valueVectors) {
+        SCAI_ASSERT_ERROR( vector->getDistribution().isEqual(*dist), "Distribution mismatch" );
+    }
+    for (const DenseVector<IndexType>* vector : indexVectors) {
+        SCAI_ASSERT_ERROR( vector->getDistribution().isEqual(*dist), "Distribution mismatch" );
+    }
+    return dist;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+std::vector<const DenseVector<ValueType>*> Migration<IndexType, ValueType>::asConst(const std::vector<DenseVector<ValueType>*>& vectors) {
+    return std::vector<const DenseVector<ValueType>*>( vectors.begin(), vectors.end() );
+}
+//---------------------------------------------------------------------------------------
+
+template class Migration<IndexType, double>;
+template class Migration<IndexType, float>;
+
+} //namespace ITI
@@ -0,0 +1,99 @@
+/*
+ * Migration.h
+ *
+ * Moves the graph and all per-vertex data to a new distribution with one communication plan.
+ */
+
+#pragma once
+
+#include <scai/lama.hpp>
+#include <scai/lama/matrix/CSRSparseMatrix.hpp>
+#include <scai/lama/DenseVector.hpp>
+#include <scai/dmemo/Distribution.hpp>
+#include <scai/hmemo/HArray.hpp>
+#include <scai/tracing.hpp>
+
+#include <vector>
+
+#include "Settings.h"
+
+namespace ITI {
+
+using scai::lama::CSRSparseMatrix;
+using scai::lama::DenseVector;
+
+/** @brief Redistributes a graph together with its coordinates, weights and other per-vertex data.
+
+Instead of one LAMA redistribute call (with its own plan setup and all-to-all exchange) per vector, one communication
+plan is built per migration and every vertex is sent as one record: all integer data of a vertex (its global id,
+its degree, all IndexType vectors and its CSR column indices) is packed into one stream and all floating point data
+(all ValueType vectors and the edge weights) into another. The two streams are exchanged with one exchangeByPlan each;
+the receive plan of the second stream is derived locally from the first, so only one plan is transposed.
+
+Afterwards, the columns of the graph are not distributed, i.e., the column indices are global indices.
+*/
+
+template <typename IndexType, typename ValueType>
+class Migration {
+public:
+    /** @brief Moves every local vertex to the PE given in newOwners. Global operation.
+
+    @param[in] newOwners For every local vertex, the PE it is moved to; same size as the local part of the distribution.
+    @param[in,out] graph The graph to move; can be nullptr if only vectors are moved.
+    @param[in,out] valueVectors Vectors that are moved, e.g., the coordinates and the node weights.
+    @param[in,out] indexVectors Vectors that are moved, e.g., a partition.
+    @return The new distribution, i.e., the distribution of all moved data.
+    */
+    static scai::dmemo::DistributionPtr migrateByNewOwners(
+        const scai::hmemo::HArray<IndexType>& newOwners,
+        CSRSparseMatrix<ValueType>* graph,
+        const std::vector<DenseVector<ValueType>*>& valueVectors,
+        const std::vector<DenseVector<IndexType>*>& indexVectors);
+
+    /** @brief Moves the given vectors to the PEs given in newOwners without changing them; the result is stored in targets. Global operation.
+    Since the data is only read from the sources, no copy of them is needed to keep the original distribution.
+
+    @param[in] newOwners For every local vertex, the PE it is moved to.
+    @param[in] sources The vectors to move, all with the same distribution.
+    @param[out] targets The moved vectors, targets[i] gets the values of sources[i].
+    @return The new distribution, i.e., the distribution of the targets.
+    */
+    static scai::dmemo::DistributionPtr migrateCopyByNewOwners(
+        const scai::hmemo::HArray<IndexType>& newOwners,
+        const std::vector<const DenseVector<ValueType>*>& sources,
+        const std::vector<DenseVector<ValueType>*>& targets);
+
+    /** @brief Moves all data to the given distribution. Global operation.
+
+    @param[in] targetDistribution The new distribution; afterwards, all data has exactly this distribution.
+    @param[in,out] graph The graph to move; can be nullptr if only vectors are moved.
+    @param[in,out] valueVectors Vectors that are moved, e.g., the coordinates and the node weights.
+    @param[in,out] indexVectors Vectors that are moved, e.g., a partition.
+    */
+    static void migrateToDistribution(
+        const scai::dmemo::DistributionPtr targetDistribution,
+        CSRSparseMatrix<ValueType>* graph,
+        const std::vector<DenseVector<ValueType>*>& valueVectors,
+        const std::vector<DenseVector<IndexType>*>& indexVectors);
+
+private:
+    /** Moves the data, the values of valueSources[i] are stored in valueTargets[i], which can be the same vector.
+    If targetDistribution is null, it is created from the received global indices. */
+    static scai::dmemo::DistributionPtr migrate(
+        const scai::hmemo::HArray<IndexType>& newOwners,
+        scai::dmemo::DistributionPtr targetDistribution,
+        CSRSparseMatrix<ValueType>* graph,
+        const std::vector<const DenseVector<ValueType>*>& valueSources,
+        const std::vector<DenseVector<ValueType>*>& valueTargets,
+        const std::vector<DenseVector<IndexType>*>& indexVectors);
+
+    /** The distribution of the data, checks that all given data agrees on it. */
+    static scai::dmemo::DistributionPtr getSourceDistribution(
+        const CSRSparseMatrix<ValueType>* graph,
+        const std::vector<const DenseVector<ValueType>*>& valueVectors,
+        const std::vector<DenseVector<IndexType>*>& indexVectors);
+
+    static std::vector<const DenseVector<ValueType>*> asConst(const std::vector<DenseVector<ValueType>*>& vectors);
+};
+
+} //namespace ITI
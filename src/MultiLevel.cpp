@@ -1,8 +1,13 @@
 #include <scai/dmemo/GenBlockDistribution.hpp>
+#include <cmath>
+#include <numeric>
 
 #include "MultiLevel.h"
 #include "GraphUtils.h"
 #include "HaloPlanFns.h"
+#include "GeometryCache.h"
+#include "Migration.h"
+#include "LocalizedGraph.h"
 #include "ParcoRepart.h"
 
 //TODO: needed monstly(only?) for debugging, to store the PE graph
@@ -13,7 +18,17 @@ using scai::hmemo::HArray;
 namespace ITI {
 
 template<typename IndexType, typename ValueType>
-DenseVector<IndexType> ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(CSRSparseMatrix<ValueType> &input, DenseVector<IndexType> &part, DenseVector<ValueType> &nodeWeights, std::vector<DenseVector<ValueType>> &coordinates, const HaloExchangePlan& halo, Settings settings, Metrics<ValueType>& metrics) {
+DenseVector<IndexType> ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(CSRSparseMatrix<ValueType> &input, DenseVector<IndexType> &part, DenseVector<ValueType> &nodeWeights, std::vector<DenseVector<ValueType>> &coordinates, const HaloExchangePlan& halo, Settings settings, Metrics<ValueType>& metrics, const CommTree<IndexType, ValueType>* commTree, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
+    std::vector<DenseVector<ValueType>> allNodeWeights;
+    allNodeWeights.push_back(std::move(nodeWeights));
+    DenseVector<IndexType> origin = multiLevelStep(input, part, allNodeWeights, coordinates, halo, settings, metrics, commTree, localization);
+    nodeWeights = std::move(allNodeWeights[0]);
+    return origin;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+DenseVector<IndexType> ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(CSRSparseMatrix<ValueType> &input, DenseVector<IndexType> &part, std::vector<DenseVector<ValueType>> &nodeWeights, std::vector<DenseVector<ValueType>> &coordinates, const HaloExchangePlan& halo, Settings settings, Metrics<ValueType>& metrics, const CommTree<IndexType, ValueType>* commTree, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
 
     SCAI_REGION( "MultiLevel.multiLevelStep" );
     scai::dmemo::CommunicatorPtr comm = input.getRowDistributionPtr()->getCommunicatorPtr();
@@ -27,7 +42,9 @@ DenseVector<IndexType> ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(CSR
         //check whether distributions agree
         const scai::dmemo::Distribution &inputDist = input.getRowDistribution();
         SCAI_ASSERT(  part.getDistributionPtr()->isEqual(inputDist), "distribution mismatch" );
-        SCAI_ASSERT(  nodeWeights.getDistributionPtr()->isEqual(inputDist), "distribution mismatch" );
+        for (const DenseVector<ValueType>& weights : nodeWeights) {
+            SCAI_ASSERT(  weights.getDistributionPtr()->isEqual(inputDist), "distribution mismatch" );
+        }
         if (settings.useGeometricTieBreaking) {
             for (IndexType dim = 0; dim < settings.dimensions; dim++) {
                 SCAI_ASSERT(  coordinates[dim].getDistributionPtr()->isEqual(inputDist), "distribution mismatch in dimension " << dim );
@@ -46,6 +63,9 @@ DenseVector<IndexType> ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(CSR
 
     auto origin = scai::lama::fill<DenseVector<IndexType>>(input.getRowDistributionPtr(), comm->getRank());//to track node movements through the hierarchies
 
+    //one localization of the graph for the coarsening and the refinement, it is only rebuilt when the graph is redistributed
+    std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::get(input, localization);
+
     if (settings.multiLevelRounds > 0) {
         SCAI_REGION_START( "MultiLevel.multiLevelStep.prepareRecursiveCall" )
         CSRSparseMatrix<ValueType> coarseGraph;
@@ -55,7 +75,7 @@ DenseVector<IndexType> ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(CSR
         if (comm->getRank() == 0) {
             std::cout << "Beginning coarsening, still " << settings.multiLevelRounds << " levels to go." << std::endl;
         }
-        MultiLevel<IndexType, ValueType>::coarsen(input, nodeWeights, halo, coordinates, coarseGraph, fineToCoarseMap, settings,  settings.coarseningStepsBetweenRefinement);
+        MultiLevel<IndexType, ValueType>::coarsen(input, nodeWeights[0], halo, coordinates, coarseGraph, fineToCoarseMap, settings,  settings.coarseningStepsBetweenRefinement, localized);
 
         scai::dmemo::DistributionPtr oldCoarseDist = input.getRowDistributionPtr();
         if (comm->getRank() == 0) {
@@ -72,14 +92,19 @@ DenseVector<IndexType> ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(CSR
 
         DenseVector<IndexType> coarsePart =  scai::lama::fill<DenseVector<IndexType>>(coarseGraph.getRowDistributionPtr(), comm->getRank());
 
-        DenseVector<ValueType> coarseWeights = sumToCoarse(nodeWeights, fineToCoarseMap);
+        std::vector<DenseVector<ValueType>> coarseWeights(nodeWeights.size());
+        for (IndexType w = 0; w < IndexType(nodeWeights.size()); w++) {
+            coarseWeights[w] = sumToCoarse(nodeWeights[w], fineToCoarseMap);
+        }
 
         scai::hmemo::HArray<IndexType> haloData;
         halo.updateHalo(haloData, fineToCoarseMap.getLocalValues(), *comm);
 
         HaloExchangePlan coarseHalo = coarsenHalo(coarseGraph.getRowDistribution(), halo, fineToCoarseMap.getLocalValues(), haloData);
 
-        assert(coarseWeights.sum() == nodeWeights.sum());
+        for ([[maybe_unused]] IndexType w = 0; w < IndexType(nodeWeights.size()); w++) {
+            assert(std::abs(coarseWeights[w].sum() - nodeWeights[w].sum()) <= 1e-6*std::abs(nodeWeights[w].sum()));
+        }
 
         std::chrono::duration<double> coarseningTime =  std::chrono::steady_clock::now() - beforeCoarse;
         ValueType timeForCoarse = ValueType ( comm->max(coarseningTime.count() ));
@@ -90,7 +115,7 @@ DenseVector<IndexType> ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(CSR
         settingscopy.multiLevelRounds -= settings.coarseningStepsBetweenRefinement;
         SCAI_REGION_END( "MultiLevel.multiLevelStep.prepareRecursiveCall" )
         // recursive call
-        DenseVector<IndexType> coarseOrigin = multiLevelStep(coarseGraph, coarsePart, coarseWeights, coarseCoords, coarseHalo, settingscopy, metrics);
+        DenseVector<IndexType> coarseOrigin = multiLevelStep(coarseGraph, coarsePart, coarseWeights, coarseCoords, coarseHalo, settingscopy, metrics, commTree);
         SCAI_ASSERT_DEBUG(coarseOrigin.getDistribution().isEqual(coarseGraph.getRowDistribution()), "Distributions inconsistent.");
         //SCAI_ASSERT_DEBUG(scai::dmemo::Redistributor(coarseOrigin.getLocalValues(), coarseOrigin.getDistributionPtr()).getTargetDistributionPtr()->isEqual(*oldCoarseDist), "coarseOrigin invalid");
 
@@ -99,24 +124,22 @@ DenseVector<IndexType> ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(CSR
             // uncoarsening/refinement
             std::chrono::time_point<std::chrono::steady_clock> beforeUnCoarse =  std::chrono::steady_clock::now();
             DenseVector<IndexType> fineTargets = getFineTargets(coarseOrigin, fineToCoarseMap);
-            auto redistributor = scai::dmemo::redistributePlanByNewOwners( fineTargets.getLocalValues(), fineTargets.getDistributionPtr());
-            scai::dmemo::DistributionPtr projectedFineDist = redistributor.getTargetDistributionPtr();
-
-            assert(projectedFineDist->getGlobalSize() == globalN);
-
-            part.setSameValue(projectedFineDist, comm->getRank());
-
+            // move the graph, weights, origin and, if needed, coordinates in one migration
+            std::vector<DenseVector<ValueType>*> valueVectors;
+            for (DenseVector<ValueType>& weights : nodeWeights) {
+                valueVectors.push_back(&weights);
+            }
             if (settings.useGeometricTieBreaking) {
                 for (IndexType dim = 0; dim < settings.dimensions; dim++) {
-                    coordinates[dim].redistribute(redistributor);
+                    valueVectors.push_back(&coordinates[dim]);
                 }
             }
+            scai::dmemo::DistributionPtr projectedFineDist = Migration<IndexType, ValueType>::migrateByNewOwners( fineTargets.getLocalValues(), &input, valueVectors, { &origin } );
+            localized = LocalizedGraph<IndexType, ValueType>::create(input);
 
-            input.redistribute(redistributor, input.getColDistributionPtr());
-
-            nodeWeights.redistribute(redistributor);
+            assert(projectedFineDist->getGlobalSize() == globalN);
 
-            origin.redistribute(redistributor);
+            part.setSameValue(projectedFineDist, comm->getRank());
 
             std::chrono::duration<double> uncoarseningTime =  std::chrono::steady_clock::now() - beforeUnCoarse;
             ValueType time = ValueType ( comm->max(uncoarseningTime.count() ));
@@ -125,7 +148,29 @@ DenseVector<IndexType> ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(CSR
     }
 
     // do local refinement
-    {
+    if (settings.localRefAlgo == Tool::geoLabelProp) {
+        SCAI_REGION( "MultiLevel.multiLevelStep.labelPropagation" )
+        std::chrono::time_point<std::chrono::steady_clock> before =  std::chrono::steady_clock::now();
+
+        SCAI_ASSERT_EQ_ERROR( nodeWeights.size(), 1, "Label propagation supports only one node weight" );
+        std::vector<ValueType> gainPerRound = LocalRefinement<IndexType, ValueType>::labelPropagation(input, part, nodeWeights[0], settings, commTree, localized);
+
+        //the partition must agree with the distribution again, so every vertex is moved to the PE of its new block
+        std::vector<DenseVector<ValueType>*> valueVectors{ &nodeWeights[0] };
+        for (IndexType dim = 0; dim < settings.dimensions; dim++) {
+            if (coordinates[dim].getDistributionPtr()->isEqual(input.getRowDistribution())) {
+                valueVectors.push_back(&coordinates[dim]);
+            }
+        }
+        scai::dmemo::DistributionPtr newDist = Migration<IndexType, ValueType>::migrateByNewOwners( part.getLocalValues(), &input, valueVectors, { &origin } );
+        part.setSameValue(newDist, comm->getRank());
+
+        std::chrono::duration<double> elapTime = std::chrono::steady_clock::now() - before;
+        ValueType refineTime = comm->max( elapTime.count() );
+        if (comm->getRank() == 0) {
+            std::cout << "Multilevel round "<< settings.multiLevelRounds <<": label propagation with " << gainPerRound.size() << " rounds, gain was " << std::accumulate(gainPerRound.begin(), gainPerRound.end(), ValueType(0)) << " in time " << refineTime << std::endl;
+        }
+    } else {
         SCAI_REGION( "MultiLevel.multiLevelStep.localRefinement" )
         scai::lama::CSRSparseMatrix<ValueType> processGraph = GraphUtils<IndexType, ValueType>::getPEGraph(input);
 
@@ -166,7 +211,7 @@ DenseVector<IndexType> ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(CSR
             }
             */
 
-            std::vector<ValueType> gainPerRound = LocalRefinement<IndexType, ValueType>::distributedFMStep(input, part, nodesWithNonLocalNeighbors, nodeWeights, coordinates, distances, origin, communicationScheme, settings);
+            std::vector<ValueType> gainPerRound = LocalRefinement<IndexType, ValueType>::distributedFMStep(input, part, nodesWithNonLocalNeighbors, nodeWeights, coordinates, distances, origin, communicationScheme, settings, &localized);
             gain = 0;
             for (ValueType roundGain : gainPerRound) gain += roundGain;
 
@@ -261,7 +306,7 @@ DenseVector<IndexType> MultiLevel<IndexType, ValueType>::getFineTargets(const De
 }
 
 template<typename IndexType, typename ValueType>
-void MultiLevel<IndexType, ValueType>::coarsen(const CSRSparseMatrix<ValueType>& adjM, const DenseVector<ValueType> &nodeWeights,  const HaloExchangePlan& halo, const std::vector<DenseVector<ValueType>>& coordinates, CSRSparseMatrix<ValueType>& coarseGraph, DenseVector<IndexType>& fineToCoarse, Settings settings, IndexType iterations) {
+void MultiLevel<IndexType, ValueType>::coarsen(const CSRSparseMatrix<ValueType>& adjM, const DenseVector<ValueType> &nodeWeights,  const HaloExchangePlan& halo, const std::vector<DenseVector<ValueType>>& coordinates, CSRSparseMatrix<ValueType>& coarseGraph, DenseVector<IndexType>& fineToCoarse, Settings settings, IndexType iterations, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
     SCAI_REGION("MultiLevel.coarsen");
     scai::dmemo::CommunicatorPtr comm = adjM.getRowDistributionPtr()->getCommunicatorPtr();
     const scai::dmemo::DistributionPtr distPtr = adjM.getRowDistributionPtr();
@@ -297,7 +342,8 @@ void MultiLevel<IndexType, ValueType>::coarsen(const CSRSparseMatrix<ValueType>&
         assert(ia.size()-1 == localN );
 
         //get a matching, the returned indices are from 0 to localN
-        std::vector<std::pair<IndexType,IndexType>> matching = MultiLevel<IndexType, ValueType>::maxLocalMatching( graph, localWeightCopy, coordinates, settings.nnCoarsening );
+        //the copy has the distribution of adjM, but only the first iteration has its edges
+        std::vector<std::pair<IndexType,IndexType>> matching = MultiLevel<IndexType, ValueType>::maxLocalMatching( graph, localWeightCopy, coordinates, settings.nnCoarsening, i == 0 ? localization : nullptr );
 
         std::vector<IndexType> localMatchingPartner(localN, -1);
 
@@ -660,16 +706,18 @@ DenseVector<ValueType> MultiLevel<IndexType, ValueType>::sumToCoarse(const Dense
 //---------------------------------------------------------------------------------------
 
 template<typename IndexType, typename ValueType>
-std::vector<std::pair<IndexType,IndexType>> MultiLevel<IndexType, ValueType>::maxLocalMatching(const scai::lama::CSRSparseMatrix<ValueType>& adjM, const DenseVector<ValueType>& nodeWeights, const std::vector<DenseVector<ValueType>>& coordinates, bool nnCoarsening) {
+std::vector<std::pair<IndexType,IndexType>> MultiLevel<IndexType, ValueType>::maxLocalMatching(const scai::lama::CSRSparseMatrix<ValueType>& adjM, const DenseVector<ValueType>& nodeWeights, const std::vector<DenseVector<ValueType>>& coordinates, bool nnCoarsening, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization) {
     SCAI_REGION("MultiLevel.maxLocalMatching");
 
     const scai::dmemo::DistributionPtr distPtr = adjM.getRowDistributionPtr();
     const scai::dmemo::CommunicatorPtr comm = distPtr->getCommunicatorPtr();
 
-    // get local data of the adjacency matrix
+    // get local data of the adjacency matrix; the columns are localized, so the partner functions need no global2Local.
+    // The graph changes in every coarsening round, so only the first round gets the localization of the caller.
     const CSRStorage<ValueType>& localStorage = adjM.getLocalStorage();
+    const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>> localized = LocalizedGraph<IndexType, ValueType>::get(adjM, localization);
     scai::hmemo::ReadAccess<IndexType> ia( localStorage.getIA() );
-    scai::hmemo::ReadAccess<IndexType> ja( localStorage.getJA() );
+    scai::hmemo::ReadAccess<IndexType> ja( localized->getJA() );
     scai::hmemo::ReadAccess<ValueType> values( localStorage.getValues() );
     
     // get local part of node weights
@@ -708,13 +756,10 @@ std::vector<std::pair<IndexType,IndexType>> MultiLevel<IndexType, ValueType>::ma
         IndexType bestTarget = getPartner( localNode, ia, values, ja, rLocalNodeWeights, coordinates, distPtr, matched);
 
         if (bestTarget > 0) {
-            IndexType globalNgbr = ja[bestTarget];
-
-            // at this point -globalNgbr- is the local node with the heaviest edge
+            // at this point -localNgbr- is the local node with the heaviest edge
             // and should be matched with -localNode-.
-            // So, actually, globalNgbr is also local....
-            IndexType localNgbr = distPtr->global2Local(globalNgbr);
-            assert(localNgbr != scai::invalidIndex);
+            IndexType localNgbr = ja[bestTarget];
+            assert(localNgbr < localN);
             //TODO: search neighbors for the heaviest edge
             matching.push_back( std::pair<IndexType,IndexType> (localNode, localNgbr) );
 
@@ -734,14 +779,16 @@ template<typename IndexType, typename ValueType>
 IndexType MultiLevel<IndexType, ValueType>::edgeRatingPartner(  const IndexType localNode, const scai::hmemo::ReadAccess<IndexType>& ia, const scai::hmemo::ReadAccess<ValueType>& values, const scai::hmemo::ReadAccess<IndexType>& ja, const scai::hmemo::ReadAccess<ValueType>& localNodeWeights, const std::vector<DenseVector<ValueType>>& coordinates, const scai::dmemo::DistributionPtr distPtr, const std::vector<bool>& matched){
     SCAI_REGION("MultiLevel.edgeRatingPartner");
 
+    const IndexType localN = distPtr->getLocalSize();
+
     IndexType bestTarget = -1;
     ValueType maxEdgeRating = -1;
 
     const IndexType endCols = ia[localNode+1];
     for (IndexType j = ia[localNode]; j < endCols; j++) {
-        IndexType localNeighbor = distPtr->global2Local(ja[j]);
-    
-        if (localNeighbor != scai::invalidIndex && localNeighbor != localNode && !matched[localNeighbor]) {
+        const IndexType localNeighbor = ja[j];
+
+        if (localNeighbor < localN && localNeighbor != localNode && !matched[localNeighbor]) {
             //neighbor is local and unmatched, possible partner
             ValueType thisEdgeRating = values[j]*values[j]/(localNodeWeights[localNode]*localNodeWeights[localNeighbor]);
 
@@ -761,6 +808,7 @@ IndexType MultiLevel<IndexType, ValueType>::nnPartner(  const IndexType localNod
     SCAI_REGION("MultiLevel.nnPartner");
 
     const IndexType dim = coordinates.size();
+    const IndexType localN = distPtr->getLocalSize();
 
     IndexType nn = -1;
     ValueType nnDist = -1;
@@ -773,9 +821,9 @@ IndexType MultiLevel<IndexType, ValueType>::nnPartner(  const IndexType localNod
 
     const IndexType endCols = ia[localNode+1];
     for (IndexType j = ia[localNode]; j < endCols; j++) {
-        IndexType localNeighbor = distPtr->global2Local(ja[j]);
+        const IndexType localNeighbor = ja[j];
 
-        if (localNeighbor != scai::invalidIndex && localNeighbor != localNode && !matched[localNeighbor]) {
+        if (localNeighbor < localN && localNeighbor != localNode && !matched[localNeighbor]) {
             //neighbor is local and unmatched, possible partner
             
             std::vector<ValueType> ngbrPoint(dim);
@@ -802,7 +850,8 @@ scai::lama::CSRSparseMatrix<ValueType> MultiLevel<IndexType, ValueType>::pixeled
     const scai::lama::CSRSparseMatrix<ValueType>& adjM,
     const std::vector<DenseVector<ValueType>> &coordinates,
     DenseVector<ValueType> &nodeWeights,
-    Settings settings) {
+    Settings settings,
+    GeometryCache<IndexType, ValueType>* geometry) {
     SCAI_REGION( "MultiLevel.pixeledCoarsen" )
 
     const scai::dmemo::DistributionPtr coordDist = coordinates[0].getDistributionPtr();
@@ -814,32 +863,11 @@ scai::lama::CSRSparseMatrix<ValueType> MultiLevel<IndexType, ValueType>::pixeled
     const IndexType localN = inputDist->getLocalSize();
     const IndexType globalN = inputDist->getGlobalSize();
 
-    std::vector<ValueType> maxCoords(dimensions, std::numeric_limits<ValueType>::lowest());
-    std::vector<ValueType> minCoords(dimensions, std::numeric_limits<ValueType>::max());
+    std::vector<ValueType> maxCoords(dimensions);
+    std::vector<ValueType> minCoords(dimensions);
     DenseVector<IndexType> result(inputDist, 0);
 
-    //TODO: if we know maximum from the input we could save that although is not too costly
-
-    /**
-     * get maximum of local coordinates
-     */
-    for (IndexType dim = 0; dim < dimensions; dim++) {
-        //get local parts of coordinates
-        const HArray<ValueType>& localPartOfCoords = coordinates[dim].getLocalValues();
-        for (IndexType i = 0; i < localN; i++) {
-            ValueType coord = localPartOfCoords[i];
-            if(coord > maxCoords[dim]) maxCoords[dim] = coord;
-            if(coord < minCoords[dim]) minCoords[dim] = coord;
-        }
-    }
-
-    /**
-     * communicate to get global  max
-     */
-    for (IndexType dim = 0; dim < dimensions; dim++) {
-        maxCoords[dim] = comm->max(maxCoords[dim]);
-        minCoords[dim] = comm->min(minCoords[dim]);
-    }
+    std::tie(minCoords, maxCoords) = geometry != nullptr ? geometry->getGlobalBoundingBox() : GeometryCache<IndexType,ValueType>::computeGlobalBoundingBox(coordinates);
 
     // measure density with rounding
     // have to handle 2D and 3D cases seperately
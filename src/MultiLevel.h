@@ -20,6 +20,7 @@
 #include "AuxiliaryFunctions.h"
 #include "LocalRefinement.h"
 #include "Settings.h"
+#include "GeometryCache.h"
 #include "Metrics.h" //needed for profiling, remove is not used
 
 namespace ITI {
@@ -46,10 +47,19 @@ public:
      * @param[in,out] coordinates of input points
      * @param[in] halo for non-local neighbors
      * @param[in] settings
+     * @param[in] commTree The physical network for topology-aware label propagation, or nullptr
+     * @param[in] localization The localization of the input graph with its current distribution, built here if nullptr.
+     * It is used by the coarsening and the refinement and rebuilt only after the graph is redistributed.
      *
      * @return origin DenseVector that specifies for each element the original process before the multiLevelStep. Only needed when used to speed up redistribution.
      */
-    static DenseVector<IndexType> multiLevelStep(scai::lama::CSRSparseMatrix<ValueType> &input, DenseVector<IndexType> &part, DenseVector<ValueType> &nodeWeights, std::vector<DenseVector<ValueType>> &coordinates, const HaloExchangePlan& halo, Settings settings, Metrics<ValueType>& metrics);
+    static DenseVector<IndexType> multiLevelStep(scai::lama::CSRSparseMatrix<ValueType> &input, DenseVector<IndexType> &part, DenseVector<ValueType> &nodeWeights, std::vector<DenseVector<ValueType>> &coordinates, const HaloExchangePlan& halo, Settings settings, Metrics<ValueType>& metrics, const CommTree<IndexType, ValueType>* commTree = nullptr, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr);
+
+    /**
+     * Multi-constraint version of multiLevelStep with one vector per node weight. The refinement keeps every block within
+     * (1+epsilon) times the average for each weight, the coarsening uses the first weight. Label propagation supports only one weight.
+     */
+    static DenseVector<IndexType> multiLevelStep(scai::lama::CSRSparseMatrix<ValueType> &input, DenseVector<IndexType> &part, std::vector<DenseVector<ValueType>> &nodeWeights, std::vector<DenseVector<ValueType>> &coordinates, const HaloExchangePlan& halo, Settings settings, Metrics<ValueType>& metrics, const CommTree<IndexType, ValueType>* commTree = nullptr, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr);
 
     /**
      * Given the origin array resulting from a multi-level step on a coarsened graph, compute where local elements on the current level have to be sent to recreate the coarse distribution on the current level.
@@ -73,18 +83,20 @@ public:
      * @param[out] coarseGraph Adjacency matrix of coarsened graph
      * @param[out] fineToCoarse DenseVector with as many entries as uncoarsened nodes. For each uncoarsened node, contains the corresponding coarsened node.
      * @param[in] iterations Number of contraction iterations
+     * @param[in] localization The localization of inputGraph, used for the first contraction and built there if nullptr
      */
-    static void coarsen(const CSRSparseMatrix<ValueType>& inputGraph, const DenseVector<ValueType> &nodeWeights, const HaloExchangePlan& halo, const std::vector<DenseVector<ValueType>>& coordinates, CSRSparseMatrix<ValueType>& coarseGraph, DenseVector<IndexType>& fineToCoarse, Settings settings, IndexType iterations = 1);
+    static void coarsen(const CSRSparseMatrix<ValueType>& inputGraph, const DenseVector<ValueType> &nodeWeights, const HaloExchangePlan& halo, const std::vector<DenseVector<ValueType>>& coordinates, CSRSparseMatrix<ValueType>& coarseGraph, DenseVector<IndexType>& fineToCoarse, Settings settings, IndexType iterations = 1, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr);
 
     /**
      * @brief Perform a local maximum matching
      *
      * @param[in] graph Adjacency matrix of input graph
      * @param[in] nodeWeights
+     * @param[in] localization The localization of the graph with its current distribution, built here if nullptr
      *
      * @return vector of edges in maximum matching. ret[i].first is a vertex that is matched to ret[i].second
      */
-    static std::vector<std::pair<IndexType,IndexType>> maxLocalMatching(const scai::lama::CSRSparseMatrix<ValueType>& graph, const DenseVector<ValueType> &nodeWeights, const std::vector<DenseVector<ValueType>>& coordinates, bool nnCoarsening=false );
+    static std::vector<std::pair<IndexType,IndexType>> maxLocalMatching(const scai::lama::CSRSparseMatrix<ValueType>& graph, const DenseVector<ValueType> &nodeWeights, const std::vector<DenseVector<ValueType>>& coordinates, bool nnCoarsening=false, const std::shared_ptr<const LocalizedGraph<IndexType, ValueType>>& localization = nullptr );
 
     /**
      * @brief Project a fine DenseVector to a coarse DenseVector. Values are interpolated linearly.
@@ -136,12 +148,14 @@ public:
      * @param[in] coordinates The coordinates of the input points.
      * @param[out] nodeWeights The weights for the coarse nodes/pixels of the returned graph.
      * @param[in] settings Describe different setting for the coarsening. Here we need settings.pixeledDetailLevel.
+     * @param[in] geometry If given, the bounding box of the coordinates is taken from it.
      * @return The adjacency matrix of the coarsened/pixeled graph. This has side length 2^detailLevel and the whole size is dimension^sideLength.
      */
-    static scai::lama::CSRSparseMatrix<ValueType> pixeledCoarsen (const CSRSparseMatrix<ValueType>& adjM, const std::vector<DenseVector<ValueType>> &coordinates, DenseVector<ValueType> &nodeWeights, Settings settings);
+    static scai::lama::CSRSparseMatrix<ValueType> pixeledCoarsen (const CSRSparseMatrix<ValueType>& adjM, const std::vector<DenseVector<ValueType>> &coordinates, DenseVector<ValueType> &nodeWeights, Settings settings, GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
 private:
 
+    /* The partner functions get the localized columns of LocalizedGraph, i.e., local neighbors have columns below the local size. */
     static IndexType edgeRatingPartner( const IndexType localNode, const scai::hmemo::ReadAccess<IndexType>& ia, const scai::hmemo::ReadAccess<ValueType>& values, const scai::hmemo::ReadAccess<IndexType>& ja, const scai::hmemo::ReadAccess<ValueType>& localNodeWeights, const std::vector<DenseVector<ValueType>>& coordinates, const scai::dmemo::DistributionPtr distPtr, const std::vector<bool>& matched);
 
     static IndexType nnPartner( const IndexType localNode, const scai::hmemo::ReadAccess<IndexType>& ia, const scai::hmemo::ReadAccess<ValueType>& values, const scai::hmemo::ReadAccess<IndexType>& ja, const scai::hmemo::ReadAccess<ValueType>& localNodeWeights, const std::vector<DenseVector<ValueType>>& coordinates, const scai::dmemo::DistributionPtr distPtr, const std::vector<bool>& matched);    
@@ -7,6 +7,7 @@
 #include "MultiSection.h"
 #include "GraphUtils.h"
 #include "AuxiliaryFunctions.h"
+#include "GeometryCache.h"
 
 #include <numeric>
 
@@ -22,7 +23,8 @@ scai::lama::DenseVector<IndexType> MultiSection<IndexType, ValueType>::computePa
     const scai::lama::CSRSparseMatrix<ValueType> &input,
     const std::vector<scai::lama::DenseVector<ValueType>> &coordinates,
     const scai::lama::DenseVector<ValueType>& nodeWeights,
-    struct Settings settings ) {
+    struct Settings settings,
+    GeometryCache<IndexType, ValueType>* geometry ) {
 
     const scai::dmemo::DistributionPtr inputDistPtr = input.getRowDistributionPtr();
     const scai::dmemo::CommunicatorPtr comm = inputDistPtr->getCommunicatorPtr();
@@ -67,10 +69,7 @@ scai::lama::DenseVector<IndexType> MultiSection<IndexType, ValueType>::computePa
     //get global min and max
     std::vector<ValueType> minCoords(dim);
     std::vector<ValueType> maxCoords(dim);
-    for (int d=0; d<dim; d++) {
-        minCoords[d] = coordinates[d].min();
-        maxCoords[d] = coordinates[d].max();
-    }
+    std::tie(minCoords, maxCoords) = geometry != nullptr ? geometry->getGlobalBoundingBox() : GeometryCache<IndexType,ValueType>::computeGlobalBoundingBox( coordinates );
 
     if( settings.useIter ) { //in this case, do not scale coords
         std::vector<point> localPoints( localN, point(dim,0.0) );
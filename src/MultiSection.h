@@ -8,6 +8,7 @@
 #include <fstream>
 
 #include "Settings.h"
+#include "GeometryCache.h"
 
 namespace ITI {
 
@@ -416,6 +417,7 @@ public:
      * @param[in] coordinates Coordinates of input points
      * @param[in] nodeWeights Optional node weights.
      * @param[in] settings Settings struct
+     * @param[in] geometry If given, the bounding box of the coordinates is taken from it
      *
      * @return Distributed DenseVector of length n, partition[i] contains the block ID of node i
      */
@@ -423,7 +425,8 @@ public:
         const scai::lama::CSRSparseMatrix<ValueType> &input,
         const std::vector<scai::lama::DenseVector<ValueType>> &coordinates,
         const scai::lama::DenseVector<ValueType>& nodeWeights,
-        struct Settings settings );
+        struct Settings settings,
+        GeometryCache<IndexType, ValueType>* geometry = nullptr );
 
     template<typename T>
     static scai::lama::DenseVector<IndexType> computePartition(
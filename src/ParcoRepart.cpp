@@ -21,6 +21,7 @@
 #include <set>
 #include <iostream>
 #include <iomanip>
+#include <memory>
 
 #include <scai/tracing.hpp>
 
@@ -30,9 +31,11 @@
 #include "SpectralPartition.h"
 #include "KMeans.h"
 #include "AuxiliaryFunctions.h"
+#include "GeometryCache.h"
 #include "MultiSection.h"
 #include "GraphUtils.h"
 #include "Mapping.h"
+#include "Telemetry.h"
 
 #if PARMETIS_FOUND
 #include "Wrappers.h"
@@ -238,12 +241,19 @@ std::vector<IndexType> ParcoRepart<IndexType, ValueType>::partitionGraph(
     //
     // node weights
     //
-    std::vector<scai::lama::DenseVector<ValueType>> nodeWeights(1, scai::lama::DenseVector<ValueType>(genBlockDistPtr, scai::hmemo::HArray<ValueType>(localN, *vwgt)));
+    scai::hmemo::HArray<ValueType> localWeights(localN);
+    {
+        scai::hmemo::WriteOnlyAccess<ValueType> wWeights(localWeights, localN);
+        for( int i=0; i<localN; i++) {
+            wWeights[i] = vwgt[i];
+        }
+    }
+    std::vector<scai::lama::DenseVector<ValueType>> nodeWeights(1, scai::lama::DenseVector<ValueType>(genBlockDistPtr, std::move(localWeights)));
 
     scai::lama::DenseVector<IndexType> localPartitionDV = partitionGraph( graph, coordinates, nodeWeights, comm, settings, metrics);
 
-    //WARNING: must check that is correct
-    localPartitionDV.redistribute( graph.getRowDistributionPtr() );
+    //the graph may have been redistributed, return the partition in the distribution of the input
+    localPartitionDV.redistribute( genBlockDistPtr );
 
     //copy the local values to a std::vector and return
     scai::hmemo::ReadAccess<IndexType> localPartRead ( localPartitionDV.getLocalValues() );
@@ -291,10 +301,17 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::partitionGraph(
     std::chrono::duration<double> partitionTime= std::chrono::duration<double>(0.0);
 	std::chrono::time_point<std::chrono::steady_clock> beforeInitPart =  std::chrono::steady_clock::now();
     
+	//the bounding box of the coordinates is computed at most once, it is invalidated when the coordinates are redistributed
+	GeometryCache<IndexType,ValueType> geometry(coordinates);
+
 	/*
 	* get an initial partition
 	*/
-	DenseVector<IndexType> result = initialPartition( input, coordinates, nodeWeights, previous, commTree, comm, settings, metrics);
+	DenseVector<IndexType> result;
+	{
+		Telemetry::ScopedTimer timer( "ParcoRepart.initialPartition" );
+		result = initialPartition( input, coordinates, nodeWeights, previous, commTree, comm, settings, metrics, geometry);
+	}
 
     partitionTime =  std::chrono::steady_clock::now() - beforeInitPart;
     metrics.MM["timePreliminary"] = partitionTime.count();
@@ -304,6 +321,15 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::partitionGraph(
     // At this point we have the initial, geometric partition.
     //
 
+    //the tree is only used by the label propagation; the hop-bytes before and after the refinement are reported as the sum of the dilations
+    const CommTree<IndexType,ValueType>* refinementTree = settings.topologyAwareRefinement ? &commTree : nullptr;
+    const bool reportHopBytes = settings.topologyAwareRefinement and settings.localRefAlgo == Tool::geoLabelProp and !settings.noRefinement and settings.metricsDetail.compare("no")!=0;
+    auto getHopBytes = [&](){
+        Metrics<ValueType> tmpMetrics(settings);
+        tmpMetrics.getMappingMetrics( input, result, commTree.exportAsGraph_local() );
+        return tmpMetrics.MM["sumDilation"];
+    };
+
     if (comm->getSize() == k) {
         //WARNING: the result  is not redistributed. must redistribute afterwards
         if( !settings.noRefinement ) {
@@ -320,9 +346,43 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::partitionGraph(
                 metrics.MM["preliminaryCut"] = tmpMetrics.MM["finalCut"];
                 metrics.MM["preliminaryImbalance"] = tmpMetrics.MM["finalImbalance"];
             }
+            if (reportHopBytes) {
+                metrics.MM["preliminarySumDilation"] = getHopBytes();
+            }
+
+			{
+				Telemetry::ScopedTimer timer( "ParcoRepart.localRefinement" );
+				doLocalRefinement( result,  input, coordinates, nodeWeights, comm, settings, metrics, geometry, refinementTree );
+			}
+
+            if (reportHopBytes) {
+                metrics.MM["sumDilation"] = getHopBytes();
+            }
 
-			doLocalRefinement( result,  input, coordinates, nodeWeights, comm, settings, metrics );
+        }
+    } else if (settings.localRefAlgo == Tool::geoLabelProp and !settings.noRefinement) {
+        //label propagation does not need one block per process, the graph keeps its distribution
+        if (nodeWeights.size() > 1) {
+            throw std::logic_error("Label propagation not yet implemented for multiple weights.");
+        }
+        if (not result.getDistributionPtr()->isEqual(*inputDist)) {
+            result.redistribute(inputDist);
+        }
+
+        if (reportHopBytes) {
+            metrics.MM["preliminarySumDilation"] = getHopBytes();
+        }
+
+        {
+            std::chrono::time_point<std::chrono::steady_clock> beforeLR = std::chrono::steady_clock::now();
+            Telemetry::ScopedTimer timer( "ParcoRepart.localRefinement" );
+            LocalRefinement<IndexType, ValueType>::labelPropagation(input, result, nodeWeights[0], settings, refinementTree);
+            std::chrono::duration<double> LRtime = std::chrono::steady_clock::now() - beforeLR;
+            metrics.MM["timeLocalRef"] = comm->max( LRtime.count() );
+        }
 
+        if (reportHopBytes) {
+            metrics.MM["sumDilation"] = getHopBytes();
         }
     } else {
         //result.redistribute(inputDist);
@@ -349,6 +409,7 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::partitionGraph(
             for( int d=0; d<dimensions; d++) {
                 coordinates[d].redistribute( result.getDistributionPtr() );
             }
+            geometry.invalidate();
         }
         Mapping<IndexType,ValueType>::applySfcRenumber( coordinates, nodeWeights, result, settings );
 
@@ -371,7 +432,8 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::initialPartition(
     CommTree<IndexType,ValueType> commTree,
     scai::dmemo::CommunicatorPtr comm,
     Settings settings,
-    Metrics<ValueType>& metrics){
+    Metrics<ValueType>& metrics,
+    GeometryCache<IndexType,ValueType>& geometry){
     
 	SCAI_REGION( "ParcoRepart.initialPartition" )
 
@@ -383,7 +445,7 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::initialPartition(
 
     if( settings.initialPartition==ITI::Tool::geoSFC) {
         PRINT0("Initial partition with SFCs");
-        result= HilbertCurve<IndexType, ValueType>::computePartition(coordinates, settings);
+        result= HilbertCurve<IndexType, ValueType>::computePartition(coordinates, settings, &geometry);
         std::chrono::duration<double> sfcTime = std::chrono::steady_clock::now() - beforeInitPart;
         if ( settings.verbose ) {
             ValueType totSFCTime = ValueType(comm->max(sfcTime.count()) );
@@ -397,16 +459,19 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::initialPartition(
             std::cout << "Initial partition with K-Means" << std::endl;
         }
 
-        //prepare coordinates for k-means
-        std::vector<DenseVector<ValueType>> coordinateCopy = coordinates;
-        std::vector<DenseVector<ValueType>> nodeWeightCopy = nodeWeights;
+        //prepare coordinates for k-means: the input is not copied, if it is migrated, the migrated data is stored in
+        //ownCoordinates and ownNodeWeights. Only the partition is sent back at the end.
+        std::vector<DenseVector<ValueType>> ownCoordinates;
+        std::vector<DenseVector<ValueType>> ownNodeWeights;
+        bool ownData = false;
         if (comm->getSize() > 1 && (settings.dimensions == 2 || settings.dimensions == 3)) {
             SCAI_REGION("ParcoRepart.partitionGraph.initialPartition.prepareForKMeans")
 
             if (!settings.repartition || comm->getSize() != settings.numBlocks) {
 
                 if (settings.initialMigration == ITI::Tool::geoSFC) {
-                    HilbertCurve<IndexType,ValueType>::redistribute(coordinateCopy, nodeWeightCopy, settings, metrics);
+                    HilbertCurve<IndexType,ValueType>::redistribute(coordinates, nodeWeights, ownCoordinates, ownNodeWeights, settings, metrics, &geometry);
+                    ownData = true;
                 }else if(settings.initialMigration == ITI::Tool::none) {
                     //do nothing
                 }else{
@@ -415,6 +480,23 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::initialPartition(
             }
         }
 
+        //the hierarchical versions redistribute their input, so they need their own data in any case
+        const bool hierarchical = settings.initialPartition == ITI::Tool::geoHierKM or settings.initialPartition == ITI::Tool::geoHierRepart;
+        if (hierarchical and not settings.repartition and not ownData) {
+            ownCoordinates = coordinates;
+            ownNodeWeights = nodeWeights;
+            ownData = true;
+        }
+        const std::vector<DenseVector<ValueType>>& coordinateView = ownData ? ownCoordinates : coordinates;
+        const std::vector<DenseVector<ValueType>>& nodeWeightView = ownData ? ownNodeWeights : nodeWeights;
+
+        //the own coordinates have the same global box, only their local box is computed again
+        std::unique_ptr<GeometryCache<IndexType,ValueType>> ownGeometry;
+        if (ownData) {
+            ownGeometry.reset( new GeometryCache<IndexType,ValueType>(ownCoordinates, geometry) );
+        }
+        GeometryCache<IndexType,ValueType>* geometryView = ownData ? ownGeometry.get() : &geometry;
+
         std::vector<ValueType> weightSum(nodeWeights.size());
         for (int i = 0; i < nodeWeights.size(); i++) {
             weightSum[i] = nodeWeights[i].sum();
@@ -434,21 +516,21 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::initialPartition(
         std::chrono::time_point<std::chrono::steady_clock> beforeKMeans =  std::chrono::steady_clock::now();
 
         if (settings.repartition) {
-            result = ITI::KMeans<IndexType,ValueType>::computeRepartition(coordinateCopy, nodeWeightCopy, blockSizes, previous, settings);
+            result = ITI::KMeans<IndexType,ValueType>::computeRepartition(coordinateView, nodeWeightView, blockSizes, previous, settings, geometryView);
         } else if (settings.initialPartition == ITI::Tool::geoKmeans) {
-            result = ITI::KMeans<IndexType,ValueType>::computePartition(coordinateCopy, nodeWeightCopy, blockSizes, settings, metrics);
+            result = ITI::KMeans<IndexType,ValueType>::computePartition(coordinateView, nodeWeightView, blockSizes, settings, metrics, geometryView);
         } else if (settings.initialPartition == ITI::Tool::geoHierKM or settings.initialPartition == ITI::Tool::geoHierRepart) {
 
             SCAI_ASSERT_ERROR( commTree.areWeightsAdapted(), "The weight of the tree are not adapted; should call tree.adaptWeights()" );
             SCAI_ASSERT_EQ_ERROR( commTree.getNumLeaves(), settings.numBlocks, "The number of leaves and blocks should agree" );            
             if (settings.initialPartition == ITI::Tool::geoHierKM) {
-                result = ITI::KMeans<IndexType,ValueType>::computeHierarchicalPartition( coordinateCopy, nodeWeightCopy, commTree, settings, metrics);
+                result = ITI::KMeans<IndexType,ValueType>::computeHierarchicalPartition( ownCoordinates, ownNodeWeights, commTree, settings, metrics, geometryView);
             }
             if (settings.initialPartition == ITI::Tool::geoHierRepart) {
                 //settings.debugMode = true;
-                result = ITI::KMeans<IndexType,ValueType>::computeHierPlusRepart( coordinateCopy, nodeWeightCopy, commTree, settings, metrics);
+                result = ITI::KMeans<IndexType,ValueType>::computeHierPlusRepart( ownCoordinates, ownNodeWeights, commTree, settings, metrics, geometryView);
             }
-            SCAI_ASSERT_EQ_ERROR( nodeWeightCopy[0].getDistributionPtr()->getLocalSize(), \
+            SCAI_ASSERT_EQ_ERROR( ownNodeWeights[0].getDistributionPtr()->getLocalSize(), \
                 result.getDistributionPtr()->getLocalSize(), "Partition distribution mismatch(?)");
         }
 
@@ -468,7 +550,9 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::initialPartition(
         SCAI_ASSERT_EQ_ERROR( result.max(), settings.numBlocks -1, "Wrong index in partition" );
         //assert(result.max() == settings.numBlocks -1);
         assert(result.min() == 0);
-        SCAI_ASSERT_ERROR( result.getDistributionPtr()->isEqual(coordinateCopy[0].getDistribution()), "Distribution mismatch");
+        SCAI_ASSERT_ERROR( result.getDistributionPtr()->isEqual(coordinateView[0].getDistribution()), "Distribution mismatch");
+        ownCoordinates.clear();
+        ownNodeWeights.clear();
 
     } else if (settings.initialPartition == ITI::Tool::geoMS) {// multisection
         PRINT0("Initial partition with multisection");
@@ -482,7 +566,7 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::initialPartition(
         }
 
         DenseVector<ValueType> convertedWeights(nodeWeights[0]);
-        result = ITI::MultiSection<IndexType, ValueType>::computePartition(input, coordinates, convertedWeights, settings);
+        result = ITI::MultiSection<IndexType, ValueType>::computePartition(input, coordinates, convertedWeights, settings, &geometry);
         std::chrono::duration<double> msTime = std::chrono::steady_clock::now() - beforeInitPart;
 
         if ( settings.verbose ) {
@@ -490,6 +574,16 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::initialPartition(
             if(comm->getRank() == 0)
                 std::cout << "MS Time:" << totMsTime << std::endl;
         }
+    } else if (settings.initialPartition == ITI::Tool::geoSpectral) {
+        PRINT0("Initial partition with recursive spectral bisection");
+        result = SpectralPartition<IndexType, ValueType>::getPartition(input, nodeWeights[0], settings);
+        std::chrono::duration<double> spectralTime = std::chrono::steady_clock::now() - beforeInitPart;
+
+        if ( settings.verbose ) {
+            ValueType totSpectralTime = ValueType ( comm->max(spectralTime.count()) );
+            if(comm->getRank() == 0)
+                std::cout << "Spectral Time:" << totSpectralTime << std::endl;
+        }
     } else if (settings.initialPartition == ITI::Tool::none) {
         //no need to explicitly check for repartitioning mode or not.
         assert(comm->getSize() == settings.numBlocks);
@@ -523,7 +617,9 @@ void ParcoRepart<IndexType, ValueType>::doLocalRefinement(
     std::vector<DenseVector<ValueType>> &nodeWeights,
 	scai::dmemo::CommunicatorPtr comm,
     Settings settings,
-	Metrics<ValueType>& metrics){
+	Metrics<ValueType>& metrics,
+	GeometryCache<IndexType,ValueType>& geometry,
+	const CommTree<IndexType,ValueType>* commTree){
 
 	SCAI_REGION("ParcoRepart.doLocalRefinement");		
 	
@@ -531,8 +627,8 @@ void ParcoRepart<IndexType, ValueType>::doLocalRefinement(
 	//std::string filename = "geomPart.mtx";
 	//result.writeToFile( filename );
 	
-	if (nodeWeights.size() > 1) {
-		throw std::logic_error("Local refinement not yet implemented for multiple weights.");
+	if (nodeWeights.size() > 1 and settings.localRefAlgo == Tool::geoLabelProp) {
+		throw std::logic_error("Label propagation not yet implemented for multiple weights.");
 	}
 
     std::chrono::time_point<std::chrono::steady_clock> start =  std::chrono::steady_clock::now();	
@@ -542,6 +638,7 @@ void ParcoRepart<IndexType, ValueType>::doLocalRefinement(
 	 */
 	bool useRedistributor = true;
 	aux<IndexType, ValueType>::redistributeFromPartition( result, input, coordinates, nodeWeights, settings, useRedistributor);
+	geometry.invalidate();
 	
 	std::chrono::duration<double> redistTime =  std::chrono::steady_clock::now() - start;
 	//now, every PE store its own times. These will be maxed afterwards, before printing in Metrics
@@ -564,7 +661,10 @@ void ParcoRepart<IndexType, ValueType>::doLocalRefinement(
 //TODO: get rid of constexpr
         if constexpr ( std::is_same<ValueType,real_t>() ){
 
-            [[maybe_unused]] bool didRedistribution = aux<IndexType,ValueType>::alignDistributions( input, coordinates, nodeWeights, result, settings );
+            const bool didRedistribution = aux<IndexType,ValueType>::alignDistributions( input, coordinates, nodeWeights, result, settings );
+            if (didRedistribution) {
+                geometry.invalidate();
+            }
 
             //result =  Wrappers<IndexType,ValueType>::refine( input, coordinates, nodeWeights, result, settings, metrics );
 
@@ -600,7 +700,7 @@ void ParcoRepart<IndexType, ValueType>::doLocalRefinement(
 #else
         throw std::runtime_error("*** ERROR: requested local refinement using parmetis (settings.localRefAlgo) but parmetis was not installed. Either install parmetis or pick another local refinement method.\nAborting...");
 #endif
-    } else if( settings.localRefAlgo==Tool::geographer){
+    } else if( settings.localRefAlgo==Tool::geographer or settings.localRefAlgo==Tool::geoLabelProp){
     	SCAI_REGION("ParcoRepart.doLocalRefinement.multiLevelStep")
         std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
 
@@ -619,19 +719,19 @@ void ParcoRepart<IndexType, ValueType>::doLocalRefinement(
             }
         }
 
-    	ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(input, result, nodeWeights[0], coordinates, halo, settings, metrics);
+    	ITI::MultiLevel<IndexType, ValueType>::multiLevelStep(input, result, nodeWeights, coordinates, halo, settings, metrics, commTree);
 
         std::chrono::duration<double> LRtime = std::chrono::steady_clock::now() - start;
         metrics.MM["timeLocalRef"] = comm->max( LRtime.count() );
     }else{
-        throw std::runtime_error("Provided algorithm for local refinement is "+ to_string(settings.localRefAlgo) + " but is not currently supported. Pick geographer or parMetisRefine. \nAborting...");
+        throw std::runtime_error("Provided algorithm for local refinement is "+ to_string(settings.localRefAlgo) + " but is not currently supported. Pick geographer, geoLabelProp or parMetisRefine. \nAborting...");
     }
 			
 }//doLocalRefinement
 //---------------------------------------------------------------------------------------
 
 template<typename IndexType, typename ValueType>
-DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::pixelPartition(const std::vector<DenseVector<ValueType>> &coordinates, Settings settings) {
+DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::pixelPartition(const std::vector<DenseVector<ValueType>> &coordinates, Settings settings, GeometryCache<IndexType, ValueType>* geometry) {
     SCAI_REGION( "ParcoRepart.pixelPartition" )
 
     SCAI_REGION_START("ParcoRepart.pixelPartition.initialise")
@@ -650,33 +750,12 @@ DenseVector<IndexType> ParcoRepart<IndexType, ValueType>::pixelPartition(const s
         throw std::logic_error("Pixel partition only implemented for same number of blocks and processes.");
     }
 
-    std::vector<ValueType> minCoords(dimensions, std::numeric_limits<ValueType>::max());
-    std::vector<ValueType> maxCoords(dimensions, std::numeric_limits<ValueType>::lowest());
+    std::vector<ValueType> minCoords(dimensions);
+    std::vector<ValueType> maxCoords(dimensions);
     DenseVector<IndexType> result(coordDist, 0);
 
     //TODO: probably minimum is not needed
-    //TODO: if we know maximum from the input we could save that although is not too costly
-
-    /*
-     * get minimum / maximum of local coordinates
-     */
-    for (IndexType dim = 0; dim < dimensions; dim++) {
-        //get local parts of coordinates
-        scai::hmemo::ReadAccess<ValueType> localPartOfCoords( coordinates[dim].getLocalValues() );
-        for (IndexType i = 0; i < localN; i++) {
-            ValueType coord = localPartOfCoords[i];
-            if (coord < minCoords[dim]) minCoords[dim] = coord;
-            if (coord > maxCoords[dim]) maxCoords[dim] = coord;
-        }
-    }
-
-    /*
-     * communicate to get global min / max
-     */
-    for (IndexType dim = 0; dim < dimensions; dim++) {
-        minCoords[dim] = comm->min(minCoords[dim]);
-        maxCoords[dim] = comm->max(maxCoords[dim]);
-    }
+    std::tie(minCoords, maxCoords) = geometry != nullptr ? geometry->getGlobalBoundingBox() : GeometryCache<IndexType,ValueType>::computeGlobalBoundingBox(coordinates);
 
     // measure density with rounding
     // have to handle 2D and 3D cases seperately
@@ -17,6 +17,7 @@
 #include "Settings.h"
 #include "Metrics.h"
 #include "CommTree.h"
+#include "GeometryCache.h"
 
 /** @brief Global namespace that includes all classes.
 */
@@ -160,7 +161,8 @@ public:
     		in xyz[ndims*i], xyz[ndims*i+1], ... , xyz[ndims*i+ndims]
     * ndims is the dimensions of the coordinates are given via settings.dimensions
 
-    \warning One a single node weight is supported. Edge weights not supported.
+    \warning One a single node weight is supported. Edge weights not supported. See CInterface.h for a C interface
+    with edge weights and multiple node weights.
 
     \sa <a href="glaros.dtc.umn.edu/gkhome/fetch/sw/metis/manual.pdf">metis manual</a>.
 
@@ -174,8 +176,9 @@ public:
 
     /**
      * Get an initial partition using the morton curve and measuring density per square.
+     * If \p geometry is given, the bounding box of the coordinates is taken from it.
      */
-    static DenseVector<IndexType> pixelPartition(const std::vector<DenseVector<ValueType>> &coordinates, Settings settings);
+    static DenseVector<IndexType> pixelPartition(const std::vector<DenseVector<ValueType>> &coordinates, Settings settings, GeometryCache<IndexType, ValueType>* geometry = nullptr);
 
     /** Given the block graph, creates an edge coloring of the graph and returns a communication
      *  scheme based on the coloring
@@ -207,7 +210,7 @@ private:
 
     Attention, for metis, and methods using the multilevel approach, the term 'initial partition' usually refers to the first
     partition in the coarsest level of the multilevel cycle. Here, we obtain an initial partition without coarsening, by
-    using the coordinates of the graph.
+    using the coordinates of the graph. The geometric methods take the bounding box of the coordinates from \p geometry.
     */
     static DenseVector<IndexType> initialPartition(
         const CSRSparseMatrix<ValueType> &input,
@@ -217,9 +220,13 @@ private:
         CommTree<IndexType,ValueType> commTree,
         scai::dmemo::CommunicatorPtr comm,
         Settings settings,
-        Metrics<ValueType>& metrics); 
+        Metrics<ValueType>& metrics,
+        GeometryCache<IndexType, ValueType>& geometry); 
 	
 	/** Wrapper function to do local refinement on a partitioned graph. 
+	 If a communication tree is given, the label propagation (localRefAlgo geoLabelProp) weights every cut edge with the
+	 distance of its blocks in the tree; the FM refinement always minimizes the cut.
+	 The coordinates are redistributed, so the local box of \p geometry is invalidated.
 	 */
 	static void doLocalRefinement(
 		DenseVector<IndexType> &result,
@@ -228,7 +235,9 @@ private:
 		std::vector<DenseVector<ValueType>> &nodeWeights,
 		scai::dmemo::CommunicatorPtr comm,
 		Settings settings,
-		Metrics<ValueType>& metrics);
+		Metrics<ValueType>& metrics,
+		GeometryCache<IndexType, ValueType>& geometry,
+		const CommTree<IndexType,ValueType>* commTree = nullptr);
 	
 };
 } //namespace ITI
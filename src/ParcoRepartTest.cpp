@@ -12,8 +12,10 @@
 
 #include <algorithm>
 #include <memory>
+#include <cstdio>
 #include <cstdlib>
 #include <numeric>
+#include <limits>
 
 #include "GraphUtils.h"
 #include "MeshGenerator.h"
@@ -1156,6 +1158,62 @@ TYPED_TEST(ParcoRepartTest, testRedistributeFromPartition) {
 //------------------------------------------------------------------------------
 
 
+TYPED_TEST(ParcoRepartTest, testAutoSettings) {
+    using ValueType = TypeParam;
+
+    std::string fileName = "bigtrace-00000.graph";
+    std::string file = ParcoRepartTest<ValueType>::graphPath + fileName;
+    const IndexType dimensions = 2;
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const CSRSparseMatrix<ValueType> graph = FileIO<IndexType, ValueType>::readGraph( file, comm );
+    const IndexType N = graph.getNumRows();
+    const std::vector<DenseVector<ValueType>> coords = FileIO<IndexType, ValueType>::readCoords( std::string(file + ".xyz"), N, dimensions);
+
+    struct Settings settings;
+    settings.numBlocks = comm->getSize();
+    settings.dimensions = dimensions;
+    settings.epsilon = 0.03;
+
+    const Settings tuned = settings.setDefault( graph, coords );
+    EXPECT_GE( tuned.sfcResolution, std::ceil(std::log2(N)/dimensions) );
+    EXPECT_LE( tuned.sfcResolution, std::numeric_limits<double>::digits/dimensions );
+    EXPECT_GE( tuned.minSamplingNodes, 100 );
+    EXPECT_GE( tuned.multiLevelRounds, 0 );
+    EXPECT_GE( tuned.coarseningStepsBetweenRefinement, 1 );
+    EXPECT_EQ( tuned.balanceIterations, settings.balanceIterations ) << "no profile, the default is kept";
+
+    //a previous run that hit the cap of balance iterations without reaching the balance
+    Settings previous = tuned;
+    previous.autoSettingsProfile = "autoSettingsTest.profile";
+    Metrics<ValueType> metrics( previous );
+    metrics.numBalanceIter.assign( 5, previous.balanceIterations );
+    metrics.MM["finalImbalance"] = 0.1;
+    previous.storeAutoSettingsProfile( metrics, N, comm );
+    comm->synchronize();
+
+    const std::map<std::string, double> profile = Settings::readAutoSettingsProfile( previous.autoSettingsProfile, comm );
+    EXPECT_EQ( profile.at("numPoints"), N );
+    EXPECT_EQ( profile.at("balanceIterations"), previous.balanceIterations );
+    EXPECT_EQ( profile.at("initialPartition"), int(previous.initialPartition) );
+
+    settings.autoSettingsProfile = previous.autoSettingsProfile;
+    const Settings retuned = settings.setDefault( graph, coords );
+    EXPECT_GT( retuned.balanceIterations, previous.balanceIterations );
+    EXPECT_EQ( retuned.sfcResolution, tuned.sfcResolution );
+
+    //the profile of a k-means run does not apply to another tool
+    settings.initialPartition = Tool::geoSFC;
+    const Settings otherTool = settings.setDefault( graph, coords );
+    EXPECT_EQ( otherTool.balanceIterations, settings.balanceIterations );
+
+    comm->synchronize();
+    if( comm->getRank()==0 ){
+        std::remove( previous.autoSettingsProfile.c_str() );
+    }
+}
+//---------------------------------------------------------------------------------------
+
 /**
 * TODO: test for correct error handling in case of inconsistent distributions
 */
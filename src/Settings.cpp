@@ -1,8 +1,17 @@
 #include <unistd.h>
 
 #include <scai/lama/matrix/all.hpp>
+#include <scai/hmemo/ReadAccess.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <sstream>
 
 #include "Settings.h"
+#include "Metrics.h"
 
 
 std::ostream& ITI::operator<<( std::ostream& out, const ITI::Tool tool) {
@@ -28,6 +37,12 @@ std::ostream& ITI::operator<<( std::ostream& out, const ITI::Tool tool) {
     case Tool::geoMS:
         token = "geoMS";
         break;
+    case Tool::geoSpectral:
+        token = "geoSpectral";
+        break;
+    case Tool::geoLabelProp:
+        token = "geoLabelProp";
+        break;
     case Tool::parMetisGraph:
         token = "parMetisGraph";
         break;
@@ -107,6 +122,10 @@ std::istream& ITI::operator>>(std::istream& in, ITI::Tool& tool) {
         tool = ITI::Tool::geoHierRepart;
     else if( token=="geoMS" or tokenLower=="geoms")
         tool = ITI::Tool::geoMS;
+    else if( token=="geoSpectral" or tokenLower=="geospectral")
+        tool = ITI::Tool::geoSpectral;
+    else if( token=="geoLabelProp" or tokenLower=="geolabelprop")
+        tool = ITI::Tool::geoLabelProp;
     else if( token=="parMetisGraph" or tokenLower=="parmetisgraph")
         tool = ITI::Tool::parMetisGraph;
     else if( token=="parMetisGeom" or tokenLower=="parmetisgeom" )
@@ -198,6 +217,227 @@ ITI::Settings ITI::Settings::setDefault( const scai::lama::CSRSparseMatrix<Value
     return retSet;
 }
 
+template <typename ValueType>
+ITI::Settings ITI::Settings::setDefault( const scai::lama::CSRSparseMatrix<ValueType>& graph, const std::vector<scai::lama::DenseVector<ValueType>>& coordinates ){
+    Settings retSet = setDefault( graph );
+
+    const scai::dmemo::DistributionPtr dist = graph.getRowDistributionPtr();
+    const scai::dmemo::CommunicatorPtr comm = dist->getCommunicatorPtr();
+    const IndexType globalN = dist->getGlobalSize();
+    const IndexType localN = dist->getLocalSize();
+    const IndexType k = numBlocks;
+    const IndexType dims = coordinates.size();
+    SCAI_ASSERT_GT_ERROR( dims, 0, "The coordinates are needed for the automatic settings" );
+
+    //
+    // cheap global statistics: degrees and the spread of the point density
+    //
+
+    const ValueType avgDegree = ValueType( graph.getNumValues() )/globalN;
+    IndexType maxDegree = 0;
+    {
+        scai::hmemo::ReadAccess<IndexType> ia( graph.getLocalStorage().getIA() );
+        for( IndexType i=0; i<localN; i++){
+            maxDegree = std::max( maxDegree, ia[i+1]-ia[i] );
+        }
+    }
+    maxDegree = comm->max( maxDegree );
+
+    //the densest local bounding box compared to the global one; for an input distribution without
+    //locality, the local boxes are close to the global box and the spread is underestimated
+    ValueType densitySpread = 1;
+    {
+        ValueType localVolumeRatio = 1;
+        for( IndexType d=0; d<dims; d++){
+            scai::hmemo::ReadAccess<ValueType> rCoords( coordinates[d].getLocalValues() );
+            ValueType localMin = std::numeric_limits<ValueType>::max();
+            ValueType localMax = std::numeric_limits<ValueType>::lowest();
+            for( IndexType i=0; i<localN; i++){
+                localMin = std::min( localMin, rCoords[i] );
+                localMax = std::max( localMax, rCoords[i] );
+            }
+            const ValueType globalExtent = comm->max( localMax ) - comm->min( localMin );
+            if( localN>0 and localMax>localMin ){
+                localVolumeRatio *= globalExtent/(localMax-localMin);
+            }
+        }
+        densitySpread = std::max( ValueType(1), comm->max( localVolumeRatio*localN/globalN ) );
+    }
+
+    //
+    // the curve needs enough cells to separate the points, also in the densest regions
+    //
+
+    const IndexType densityBits = std::ceil( std::log2(densitySpread)/dims );
+    const IndexType maxResolution = std::numeric_limits<double>::digits/dims;
+    retSet.sfcResolution = std::min( IndexType(std::ceil(std::log2(globalN)/dims)) + 1 + densityBits, maxResolution );
+
+    //
+    // k-means starts with a sample that reaches all local points after samplingRounds doublings
+    //
+
+    const IndexType samplingRounds = 6;
+    const IndexType defaultMinSamplingNodes = 100;
+    retSet.minSamplingNodes = std::max( IndexType(globalN/(k*std::pow(2, samplingRounds-1))), defaultMinSamplingNodes );
+
+    //
+    // coarsen until about 5000 vertices per block remain, less for irregular degrees where the matching coarsens badly;
+    // refine on about three levels
+    //
+
+    const ValueType pointsPerBlock = ValueType(globalN)/k;
+    IndexType multiLevelRounds = std::floor( std::log2(pointsPerBlock/5000) ) + 1;
+    if( maxDegree > 10*avgDegree ){
+        multiLevelRounds--;
+    }
+    retSet.multiLevelRounds = std::min( std::max( multiLevelRounds, IndexType(0) ), IndexType(9) );
+
+    //
+    // adjust by the previous run
+    //
+
+    //only a previous k-means run with the same tool is comparable; the profile is read by PE 0 and broadcast
+    const bool kmeansTool = initialPartition==Tool::geoKmeans or initialPartition==Tool::geoHierKM or initialPartition==Tool::geoHierRepart;
+    std::map<std::string, double> profile = readAutoSettingsProfile( autoSettingsProfile, comm );
+    const bool sameTool = profile.count("initialPartition") and int(profile.at("initialPartition"))==int(initialPartition);
+    if( not kmeansTool or not sameTool ){
+        profile.clear();
+    }
+    auto hasKeys = [&profile]( std::initializer_list<std::string> keys ){
+        for( const std::string& key : keys ){
+            if( not profile.count(key) ){
+                return false;
+            }
+        }
+        return true;
+    };
+
+    //balance iterations: more if the cap was hit without reaching the balance, less if they were not needed
+    if( hasKeys({"balanceIterations", "avgBalanceIter", "finalImbalance"}) ){
+        const IndexType prevBalanceIterations = profile.at("balanceIterations");
+        const double avgBalanceIter = profile.at("avgBalanceIter");
+        if( avgBalanceIter >= 0.9*prevBalanceIterations and profile.at("finalImbalance") > epsilon ){
+            retSet.balanceIterations = std::ceil( 1.5*prevBalanceIterations );
+        }else if( avgBalanceIter < 0.5*prevBalanceIterations ){
+            retSet.balanceIterations = std::max( IndexType(std::ceil(2*avgBalanceIter)), IndexType(5) );
+        }else{
+            retSet.balanceIterations = prevBalanceIterations;
+        }
+    }
+
+    //sampling: the iterations after the sampling rounds are the expensive ones; if many were needed, one more
+    //round on a sample is cheaper, if (almost) none were needed the sampling starts with more points
+    if( hasKeys({"numPoints", "minSamplingNodes", "kmeansIterations"}) and profile.at("numPoints")>0 and profile.at("minSamplingNodes")>0 ){
+        const double prevN = profile.at("numPoints");
+        const double prevMinSamplingNodes = profile.at("minSamplingNodes");
+        const double prevSamplingRounds = std::max( std::ceil(std::log2(prevN/(prevMinSamplingNodes*k)))+1, 0.0 );
+        const double fullIterations = profile.at("kmeansIterations") - prevSamplingRounds;
+        double minSamplingNodes = prevMinSamplingNodes*globalN/prevN;
+        if( fullIterations > 10 ){
+            minSamplingNodes /= 2;
+        }else if( fullIterations <= 2 ){
+            minSamplingNodes *= 2;
+        }
+        retSet.minSamplingNodes = std::min( std::max( IndexType(minSamplingNodes), defaultMinSamplingNodes ), IndexType(std::max(pointsPerBlock, ValueType(defaultMinSamplingNodes))) );
+    }
+
+    //multilevel: fewer levels if the refinement dominated the time, more if it was cheap
+    if( hasKeys({"timeLocalRef", "timeKmeans", "multiLevelRounds"}) and profile.at("timeLocalRef")>=0 and profile.at("timeKmeans")>0 ){
+        const double timeLocalRef = profile.at("timeLocalRef");
+        const double timeKmeans = profile.at("timeKmeans");
+        const IndexType prevMultiLevelRounds = profile.at("multiLevelRounds");
+        if( timeLocalRef > 2*timeKmeans ){
+            retSet.multiLevelRounds = std::max( prevMultiLevelRounds-1, IndexType(0) );
+        }else if( timeLocalRef < 0.5*timeKmeans ){
+            retSet.multiLevelRounds = std::min( prevMultiLevelRounds+1, IndexType(9) );
+        }else{
+            retSet.multiLevelRounds = prevMultiLevelRounds;
+        }
+    }
+
+    retSet.coarseningStepsBetweenRefinement = std::max( IndexType(std::ceil(retSet.multiLevelRounds/3.0)), IndexType(1) );
+
+    if(comm->getRank() == 0 ){
+        std::cout << "\tinput statistics: n= " << globalN << ", average degree= " << avgDegree << ", max degree= " << maxDegree << ", density spread= " << densitySpread;
+        std::cout << (profile.empty() ? "" : ", previous run from " + autoSettingsProfile) << std::endl;
+        std::cout << "\tsetting sfcResolution to " << retSet.sfcResolution << ", minSamplingNodes to " << retSet.minSamplingNodes << ", balanceIterations to " << retSet.balanceIterations << std::endl;
+        std::cout << "\tsetting multiLevelRounds to " << retSet.multiLevelRounds << ", coarseningStepsBetweenRefinement to " << retSet.coarseningStepsBetweenRefinement << std::endl;
+    }
+
+    return retSet;
+}
+
+template <typename ValueType>
+void ITI::Settings::storeAutoSettingsProfile( const Metrics<ValueType>& metrics, const IndexType globalN, const scai::dmemo::CommunicatorPtr comm ) const {
+    if( autoSettingsProfile=="-" or comm->getRank()!=0 ){
+        return;
+    }
+
+    std::ofstream outF( autoSettingsProfile, std::ios::out );
+    if( outF.fail() ){
+        throw std::runtime_error("Could not write to file " + autoSettingsProfile);
+    }
+
+    const double avgBalanceIter = metrics.numBalanceIter.empty() ? 0 : std::accumulate( metrics.numBalanceIter.begin(), metrics.numBalanceIter.end(), 0.0 )/metrics.numBalanceIter.size();
+
+    outF << "% parameters and measurements of the last run, read with --autoSettings" << std::endl;
+    outF << "initialPartition " << int(initialPartition) << std::endl;
+    outF << "numPoints " << globalN << std::endl;
+    outF << "sfcResolution " << sfcResolution << std::endl;
+    outF << "minSamplingNodes " << minSamplingNodes << std::endl;
+    outF << "balanceIterations " << balanceIterations << std::endl;
+    outF << "multiLevelRounds " << multiLevelRounds << std::endl;
+    outF << "coarseningStepsBetweenRefinement " << coarseningStepsBetweenRefinement << std::endl;
+    outF << "kmeansIterations " << metrics.kmeansProfiling.size() << std::endl;
+    outF << "avgBalanceIter " << avgBalanceIter << std::endl;
+    outF << "timeKmeans " << metrics.MM.at("timeKmeans") << std::endl;
+    outF << "timeLocalRef " << metrics.MM.at("timeLocalRef") << std::endl;
+    outF << "finalImbalance " << metrics.MM.at("finalImbalance") << std::endl;
+}
+
+std::map<std::string, double> ITI::Settings::readAutoSettingsProfile( const std::string filename, const scai::dmemo::CommunicatorPtr comm ){
+    std::map<std::string, double> profile;
+    if( filename=="-" ){
+        return profile;
+    }
+
+    //the keys written by storeAutoSettingsProfile, a missing value is sent as NaN
+    const std::vector<std::string> keys = {"initialPartition", "numPoints", "sfcResolution", "minSamplingNodes", "balanceIterations", "multiLevelRounds",
+        "coarseningStepsBetweenRefinement", "kmeansIterations", "avgBalanceIter", "timeKmeans", "timeLocalRef", "finalImbalance"};
+    std::vector<double> values( keys.size(), std::numeric_limits<double>::quiet_NaN() );
+
+    if( comm->getRank()==0 ){
+        std::ifstream file( filename );
+        std::string line;
+        while( std::getline(file, line) ){
+            if( line.empty() or line[0]=='%' ){
+                continue;
+            }
+            std::istringstream ss( line );
+            std::string key;
+            double value;
+            if( ss >> key >> value ){
+                const auto it = std::find( keys.begin(), keys.end(), key );
+                if( it!=keys.end() ){
+                    values[it-keys.begin()] = value;
+                }
+            }
+        }
+    }
+    comm->bcast( values.data(), values.size(), 0 );
+
+    for( std::size_t i=0; i<keys.size(); i++ ){
+        if( not std::isnan(values[i]) ){
+            profile[keys[i]] = values[i];
+        }
+    }
+    return profile;
+}
+
 //instantiation
 template ITI::Settings ITI::Settings::setDefault<double>( const scai::lama::CSRSparseMatrix<double>& graph );
-template ITI::Settings ITI::Settings::setDefault( const scai::lama::CSRSparseMatrix<float>& graph );
\ No newline at end of file
+template ITI::Settings ITI::Settings::setDefault( const scai::lama::CSRSparseMatrix<float>& graph );
+template ITI::Settings ITI::Settings::setDefault<double>( const scai::lama::CSRSparseMatrix<double>& graph, const std::vector<scai::lama::DenseVector<double>>& coordinates );
+template ITI::Settings ITI::Settings::setDefault( const scai::lama::CSRSparseMatrix<float>& graph, const std::vector<scai::lama::DenseVector<float>>& coordinates );
+template void ITI::Settings::storeAutoSettingsProfile( const ITI::Metrics<double>& metrics, const IndexType globalN, const scai::dmemo::CommunicatorPtr comm ) const;
+template void ITI::Settings::storeAutoSettingsProfile( const ITI::Metrics<float>& metrics, const IndexType globalN, const scai::dmemo::CommunicatorPtr comm ) const;
\ No newline at end of file
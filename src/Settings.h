@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <map>
 #include <scai/lama.hpp>
 #include <assert.h>
 
@@ -109,6 +110,47 @@ inline std::ostream& operator<<(std::ostream& out, Format method) {
 
 //-----------------------------------------------------------------------------------
 
+/** The kind of mesh created by MeshGenerator::createMesh_dist().
+
+- structured: A uniform grid; every vertex is connected to its axis-aligned neighbors.
+- perturbed: The grid points are randomly moved inside their cell and every square (face) of the grid gets one of its two diagonals at random.
+- graded: A structured grid whose points get denser towards the origin (the spacing follows a power law).
+*/
+enum class MeshType {structured, perturbed, graded};
+
+/** @brief Operator to convert a stream to an enum MeshType.
+*/
+inline std::istream& operator>>(std::istream& in, MeshType& meshType) {
+    std::string token;
+    in >> token;
+    if (token == "structured")
+        meshType = ITI::MeshType::structured;
+    else if (token == "perturbed")
+        meshType = ITI::MeshType::perturbed;
+    else if (token == "graded")
+        meshType = ITI::MeshType::graded;
+    else
+        in.setstate(std::ios_base::failbit);
+    return in;
+}
+
+/** @brief Operator to convert an enum MeshType to a stream.
+*/
+inline std::ostream& operator<<(std::ostream& out, MeshType meshType) {
+    std::string token;
+
+    if (meshType == ITI::MeshType::structured)
+        token = "structured";
+    else if (meshType == ITI::MeshType::perturbed)
+        token = "perturbed";
+    else if (meshType == ITI::MeshType::graded)
+        token = "graded";
+    out << token;
+    return out;
+}
+
+//-----------------------------------------------------------------------------------
+
 /** Different tools, i.e., algorithmic approaches, that can be used to partition a input graph, point set or a mesh, i.e., a graph with coordinates.
 	For geographer, typically these are predetermined combinations of the input settings.
 
@@ -119,6 +161,7 @@ inline std::ostream& operator<<(std::ostream& out, Format method) {
 - geoHierRepart First step is same as using geoHierKM but we also do a post-processing repartition step to improve the cut more.
 - geoSFC Partition a point set (no graph is needed) using the hilbert space filling curve.
 - geoMS Partition a point set (no graph is needed) using the MultiSection algorithm.
+- geoSpectral Partition a graph (no coordinates are needed) using recursive spectral bisection.
 ### The tools below require the external libraries parmetis and zoltan2.
 - parMetisGraph Partition a graph using parmetis
 - parMetisGeom Partition a mesh using a version of parmetis that also uses coordinates for an initial partition.
@@ -128,7 +171,7 @@ inline std::ostream& operator<<(std::ostream& out, Format method) {
 - zoltanMJ Partition a point set (no graph is needed) using the Multijagged algorithm of zoltan2.
 - zoltanMJ Partition a point set (no graph is needed) using the space filling curves algorithm of zoltan2.
 */
-enum class Tool { geographer, geoKmeans, geoHierKM, geoHierRepart, geoSFC, geoMS, parMetisGraph, parMetisGeom, parMetisSFC, parMetisRefine, zoltanRIB, zoltanRCB, zoltanMJ, zoltanSFC, parhipFastMesh, parhipUltraFastMesh, parhipEcoMesh, myAlgo, none, unknown};
+enum class Tool { geographer, geoKmeans, geoHierKM, geoHierRepart, geoSFC, geoMS, geoSpectral, geoLabelProp, parMetisGraph, parMetisGeom, parMetisSFC, parMetisRefine, zoltanRIB, zoltanRCB, zoltanMJ, zoltanSFC, parhipFastMesh, parhipUltraFastMesh, parhipEcoMesh, myAlgo, none, unknown};
 
 
 std::istream& operator>>(std::istream& in, ITI::Tool& tool);
@@ -143,6 +186,9 @@ ITI::Tool to_tool(const std::string& s);
 
 std::string getCallingCommand( const int argc, char** argv );
 
+template <typename ValueType>
+class Metrics;
+
 /** @brief A structure that holds several options for partitioning, input, output, metrics e.t.c.
 */
 struct Settings {
@@ -167,6 +213,7 @@ struct Settings {
     IndexType dimensions= 2;	///< the dimension of the point set
     std::string fileName = "-";	///< the name of the input file to read the graph from
     std::string outFile = "-";	///< name of the file to store metrics (if desired)
+    std::string telemetryFile = "-";	///< name of the file to store the per-phase timers and counters as JSON (if desired), \sa Telemetry
     std::string outDir = "-"; 	//this is used by the competitors main
     std::string PEGraphFile = "-"; //TODO: this should not be in settings
     std::string blockSizesFile = "-"; //TODO: this should not be in settings
@@ -178,6 +225,8 @@ struct Settings {
     std::string machine;                ///< name of the machine that the executable is running
     double seed;                        ///< random seed used for some routines
     std::string callingCommand;         ///< the complete calling command used
+    bool streamCoordinates = false;     ///< partition the points of a binary coordinate file in memory-mapped slices, without a graph, \sa StreamingPartition
+    IndexType streamingSampleSize = 1000000; ///< number of sampled points from which the streaming partition is computed
     //@}
 
     /** @name Mesh generation settings
@@ -187,6 +236,9 @@ struct Settings {
     IndexType numX = 32;
     IndexType numY = 32;
     IndexType numZ = 1;
+    ITI::MeshType meshType = ITI::MeshType::structured; ///< the kind of mesh to generate, \sa MeshType
+    double meshPerturbation = 0.5;          ///< for perturbed meshes, how far a point can move as a fraction of the grid spacing (<1)
+    double meshGrading = 2.0;               ///< for graded meshes, the exponent of the spacing; 1 gives a uniform grid
     //@}
 
     /** @name Tuning parameters for local refinement
@@ -201,6 +253,9 @@ struct Settings {
     bool useGeometricTieBreaking = false;	///< if distance from center should be used for tie braking
     bool gainOverBalance = false;
     bool skipNoGainColors = false;			///< if we should skip some rounds if there is no gain
+    IndexType fmTrials = 1;					///< number of independent FM trials per process with different tie breaking, run on different threads; the best is kept
+    bool refineCommVolume = false;			///< FM gains are the reduction of the communication volume between the two blocks instead of the cut
+    bool minMaxCommVolume = false;			///< with refineCommVolume, FM minimizes the larger total communication volume of the two blocks
     ITI::Tool localRefAlgo = ITI::Tool::geographer; ///< with which algorithm to do local refinement
     //@}
 
@@ -225,6 +280,7 @@ struct Settings {
     bool tightenBounds = false;
     bool freezeBalancedInfluence = false;
     bool erodeInfluence = false;
+    bool mixedPrecision = false;			///< k-means stores its copy of the coordinates as float; distances, centers and influence stay in ValueType
     //bool manhattanDistance = false;
     std::vector<IndexType> hierLevels; 		///< for hierarchial kMeans, the number of blocks per level
     //@}
@@ -246,6 +302,8 @@ struct Settings {
     IndexType multiLevelRounds = 0;			///< number of multilevel rounds
     IndexType coarseningStepsBetweenRefinement = 3; ///< number of rounds every which we do coarsening
     bool nnCoarsening = false;              ///< when matching vertices, use the nearest neighbor to match (and contract with)
+    IndexType labelPropagationRounds = 20;  ///< maximum number of rounds of the label propagation refinement, see LocalRefinement::labelPropagation
+    bool topologyAwareRefinement = false;   ///< label propagation minimizes the cut edges weighted by the distance of their blocks in the communication tree
     //@}
 
     /** @name Debug and profiling parameters
@@ -274,12 +332,17 @@ struct Settings {
 
     /// use some default settings; will overwrite other arguments given in the command line
     bool setAutoSettings;
+    /// with setAutoSettings, file with the tuned parameters and measurements of the previous run; read before and written after partitioning
+    std::string autoSettingsProfile = "-";
     ///this is used by the competitors main to set the tools we are gonna use
     std::vector<std::string> tools;
 
     /// for mapping by renumbering the block centers according to their SFC index
     bool mappingRenumbering = false;
 
+    /// order of the vertices inside every block after partitioning: none, sfc (Hilbert order) or rcm (reverse Cuthill-McKee); interface vertices are placed last
+    std::string localVertexOrder = "none";
+
     /// variable to check if the settings given are valid or not
     bool isValid = true;
     //@}
@@ -369,6 +432,36 @@ struct Settings {
     template <typename ValueType>
     Settings setDefault( const scai::lama::CSRSparseMatrix<ValueType>& graph );
 
+    /** @brief Tunes the geometric and refinement parameters from global statistics of the input. Global operation.
+
+    Besides minBorderNodes and stopAfterNoGainRounds, sets sfcResolution from the number of points and the spread of
+    the point density, minSamplingNodes so that k-means has a fixed number of sampling rounds, and multiLevelRounds and
+    coarseningStepsBetweenRefinement from the points per block and the degree distribution. If autoSettingsProfile
+    exists and stores a previous k-means run with the same initialPartition, balanceIterations, minSamplingNodes and
+    multiLevelRounds are adjusted by the measurements of that run.
+
+    @param[in] graph The input graph.
+    @param[in] coordinates The coordinates of the points, distributed like the graph rows.
+    @return A copy of these settings with the tuned parameters.
+    */
+    template <typename ValueType>
+    Settings setDefault( const scai::lama::CSRSparseMatrix<ValueType>& graph, const std::vector<scai::lama::DenseVector<ValueType>>& coordinates );
+
+    /** @brief Writes the tuned parameters and the measurements of a run to autoSettingsProfile, for setDefault in the next run.
+    Only PE 0 writes.
+
+    @param[in] metrics The metrics of the run.
+    @param[in] globalN The number of points of the run.
+    @param[in] comm The communicator.
+    */
+    template <typename ValueType>
+    void storeAutoSettingsProfile( const Metrics<ValueType>& metrics, const IndexType globalN, const scai::dmemo::CommunicatorPtr comm ) const;
+
+    /** @brief Reads a file written by storeAutoSettingsProfile. Global operation, PE 0 reads the file and broadcasts the values.
+    @return The stored values by name, only the keys found in the file; empty if the file does not exist.
+    */
+    static std::map<std::string, double> readAutoSettingsProfile( const std::string filename, const scai::dmemo::CommunicatorPtr comm );
+
 }; //struct Settings
 
 
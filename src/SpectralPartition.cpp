@@ -5,312 +5,472 @@
  *      Author: tzovas
  */
 
+#include <scai/hmemo/HArray.hpp>
+#include <scai/hmemo/ReadAccess.hpp>
+#include <scai/common/TypeTraits.hpp>
+
+#include <algorithm>
 
 #include "SpectralPartition.h"
 #include "GraphUtils.h"
 
 namespace ITI {
 
-
 template<typename IndexType, typename ValueType>
-scai::lama::DenseVector<IndexType> SpectralPartition<IndexType, ValueType>::getPartition(const CSRSparseMatrix<ValueType> &adjM, const std::vector<DenseVector<ValueType>> &coordinates, Settings settings) {
+DenseVector<IndexType> SpectralPartition<IndexType, ValueType>::getPartition(const CSRSparseMatrix<ValueType> &adjM, const DenseVector<ValueType> &nodeWeights, Settings settings) {
     SCAI_REGION( "SpectralPartition.getPartition" )
 
-    std::chrono::time_point<std::chrono::steady_clock> start, round;
-    start = std::chrono::steady_clock::now();
-
-    //const scai::dmemo::DistributionPtr coordDist = coordinates[0].getDistributionPtr();
     const scai::dmemo::DistributionPtr inputDist = adjM.getRowDistributionPtr();
     const scai::dmemo::CommunicatorPtr comm = inputDist->getCommunicatorPtr();
-
-    IndexType k = settings.numBlocks;
-    const IndexType dimensions = coordinates.size();
+    const IndexType k = settings.numBlocks;
     const IndexType localN = inputDist->getLocalSize();
-    const IndexType globalN = inputDist->getGlobalSize();
-
-    if (k != comm->getSize() && comm->getRank() == 0) {
-        throw std::logic_error("Spectral partition only implemented for same number of blocks and processes.");
-    }
-
-    // get a pixeled-coarsen graph , this is replicated in every PE
-    scai::lama::DenseVector<ValueType> pixelWeights;
-    scai::lama::CSRSparseMatrix<ValueType> pixelGraph = MultiLevel<IndexType, ValueType>::pixeledCoarsen(adjM, coordinates, pixelWeights, settings);
-    SCAI_ASSERT( pixelGraph.getRowDistributionPtr()->isReplicated() == 1, "Pixel graph should (?) be replicated.");
-
-    IndexType numPixels = pixelGraph.getNumRows();
-    SCAI_ASSERT( numPixels == pixelGraph.getNumColumns(), "Wrong pixeled graph.");
-    SCAI_ASSERT( pixelGraph.isConsistent() == 1, "Pixeled graph not consistent.");
-
-    // get the laplacian of the pixeled graph , since the pixeled graph is replicated so should be the laplacian
-    scai::lama::CSRSparseMatrix<ValueType> laplacian = GraphUtils<IndexType, ValueType>::constructLaplacian(pixelGraph);
-    SCAI_ASSERT( laplacian.isConsistent() == 1, "Laplacian graph not consistent.");
-    SCAI_ASSERT( laplacian.getNumRows() == numPixels, "Wrong size of the laplacian.");
-
-    if( !laplacian.getRowDistributionPtr()->isReplicated() ) {
-        // replicate the laplacian
-        scai::dmemo::DistributionPtr pixelNoDistPointer(new scai::dmemo::NoDistribution( numPixels ));
-        laplacian.redistribute( pixelNoDistPointer, pixelNoDistPointer);
-    } else {
-        PRINT0("Laplacian already replicated, no need to redistribute.");
-    }
-
-    // the fiedler vector corresponding to second smallest eigenvalue
-    scai::lama::DenseVector<ValueType> fiedler;
-    ValueType fiedlerEigenvalue;
 
-    scai::lama::DenseVector<IndexType> permutation;
+    SCAI_ASSERT_GT_ERROR( k, 0, "Number of blocks must be positive" );
+    SCAI_ASSERT_ERROR( nodeWeights.getDistributionPtr()->isEqual(*inputDist), "Distributions of graph and node weights do not agree" );
 
+    std::vector<ValueType> localWeights( localN );
     {
-        SCAI_REGION( "SpectralPartition.getPartition.getFiedlerVectorAndSort" )
-        fiedler= SpectralPartition<IndexType, ValueType>::getFiedlerVector( pixelGraph, fiedlerEigenvalue );
-        SCAI_ASSERT( fiedler.size() == numPixels, "Sizes do not agree.");
-        fiedler.sort(permutation, true);
+        scai::hmemo::ReadAccess<ValueType> rWeights( nodeWeights.getLocalValues() );
+        std::copy( rWeights.get(), rWeights.get()+localN, localWeights.begin() );
     }
 
-    //TODO(?): a distributed version
-    // since pixelGraph is replicated so is the permutation
-    SCAI_ASSERT( true, permutation.getDistributionPtr()->isReplicated() );
-
-    // TODO: change to localPixelPartition( numPixels, k-1); so that the last part get the remaining pixels (if any)
-    // get local partition of the pixeled graph
-    auto localPixelPartition = scai::lama::fill<DenseVector<IndexType>>( numPixels, -1);
-    IndexType averageBlockSize = globalN/k +1;
-    IndexType serialPixelInd =0;
-
-    for(IndexType block=0; block<k; block++) {
-        IndexType thisBlockSize = 0;
-        // these two vectors should be replicated
-        SCAI_ASSERT( localPixelPartition.getDistributionPtr()->isReplicated() == 1, "Should be (?) replicated.");
-        SCAI_ASSERT( pixelWeights.getDistributionPtr()->isReplicated() == 1, "Should be (?) replicated.");
-
-        scai::hmemo::WriteOnlyAccess<IndexType> wPixelPart( localPixelPartition.getLocalValues() );
-        scai::hmemo::ReadAccess<ValueType> rPixelWeights( pixelWeights.getLocalValues() );
-
-        while( thisBlockSize < averageBlockSize) {
-            SCAI_ASSERT( serialPixelInd<permutation.getLocalValues().size(), "Pixel index " << serialPixelInd << " too big.");
-            IndexType pixel= permutation.getLocalValues()[ serialPixelInd ];
-            SCAI_ASSERT( pixel<numPixels, "Wrong pixel value "<< pixel);
-            wPixelPart[ pixel ] = block;
-            thisBlockSize += rPixelWeights[ pixel ];
-            ++serialPixelInd;
-
-            if(serialPixelInd >= numPixels) {
-                if(block != k-1) {
-                    PRINT("Pixels finished but still have blocks that will be empty: current block is "<< block << " and k= "<< k << std::endl << "This should not happen. Exiting...");
-                    return scai::lama::fill<DenseVector<IndexType>>(inputDist, -1);
-                }
-                break;
-            }
+    // every block is identified by the first final block it contains and blockSize[b] is the
+    // number of final blocks it will be split into; initially, there is one block containing all k
+    std::vector<IndexType> localBlock( localN, 0 );
+    std::vector<IndexType> blockSize( k, 0 );
+    blockSize[0] = k;
+
+    IndexType round = 0;
+    while( true ) {
+        std::vector<bool> active( k );
+        bool anyActive = false;
+        for( IndexType b=0; b<k; b++) {
+            active[b] = blockSize[b]>1;
+            anyActive = anyActive or active[b];
         }
-        // every block can have size > averageBlockSize but hopefully not much more...
-    }
-
-    {
-        // TODO: for debugging, should remove
-        for(int i=0; i<numPixels; i++) {
-            scai::hmemo::ReadAccess<IndexType> rPixelPart( localPixelPartition.getLocalValues() );
-            int b = rPixelPart[i];
-            SCAI_ASSERT( b>=0, "Wrong pixel partitioning " << b <<" for pixel "<< i);
-            SCAI_ASSERT( b<k, "Wrong pixel partitioning " << b <<" for pixel "<< i);
+        if( !anyActive ) {
+            break;
         }
-    }
-    //
-    // here, every pixel must belong to a part
-    //
 
-    const unsigned long sideLen = settings.pixeledSideLen;
+        std::vector<ValueType> eigenvalues;
+        const std::vector<double> fiedler = getBlockFiedlerVectors( adjM, localBlock, active, eigenvalues );
 
-    //TODO: finding the max is also done in pixeledCoarsen, maybe we can pass max as input parameter there
-    std::vector<ValueType> maxCoords(dimensions, std::numeric_limits<ValueType>::lowest());
+        // the left part of block b gets leftSize[b] final blocks and the corresponding fraction of its weight
+        std::vector<IndexType> leftSize( k, 0 );
+        std::vector<double> blockWeight( k, 0.0 );
+        for( IndexType i=0; i<localN; i++) {
+            blockWeight[localBlock[i]] += localWeights[i];
+        }
+        comm->sumImpl( blockWeight.data(), blockWeight.data(), k, scai::common::TypeTraits<double>::stype );
 
-    // get local max
-    for (IndexType dim = 0; dim < dimensions; dim++) {
-        //get local parts of coordinates
-        const scai::hmemo::HArray<ValueType>& localPartOfCoords = coordinates[dim].getLocalValues();
-        for (IndexType i = 0; i < localN; i++) {
-            ValueType coord = localPartOfCoords[i];
-            if (coord > maxCoords[dim]) maxCoords[dim] = coord;
+        std::vector<double> targetWeight( k, 0.0 );
+        for( IndexType b=0; b<k; b++) {
+            if( active[b] ) {
+                leftSize[b] = blockSize[b]/2;
+                targetWeight[b] = blockWeight[b]*leftSize[b]/blockSize[b];
+            }
         }
-    }
-    // communicate to get global  max
-    for (IndexType dim = 0; dim < dimensions; dim++) {
-        maxCoords[dim] = comm->max(maxCoords[dim]);
-    }
 
-    // set your local part of the partition/result
-    DenseVector<IndexType>  result(inputDist, 0);
+        // the Fiedler vector of every block has norm 1, thus all values are in [-1,1].
+        // Find by bisection the smallest threshold per block so that the weight of the vertices below it reaches the target.
+        std::vector<double> lower( k, -1.0-1e-9 );
+        std::vector<double> upper( k, 1.0 );
+        {
+            SCAI_REGION( "SpectralPartition.getPartition.findThresholds" )
+            std::vector<double> weightBelow( k );
+
+            for( IndexType iter=0; iter<60; iter++) {
+                std::fill( weightBelow.begin(), weightBelow.end(), 0.0 );
+                for( IndexType i=0; i<localN; i++) {
+                    const IndexType b = localBlock[i];
+                    if( active[b] and fiedler[i] <= (lower[b]+upper[b])/2 ) {
+                        weightBelow[b] += localWeights[i];
+                    }
+                }
+                comm->sumImpl( weightBelow.data(), weightBelow.data(), k, scai::common::TypeTraits<double>::stype );
+
+                for( IndexType b=0; b<k; b++) {
+                    const double mid = (lower[b]+upper[b])/2;
+                    if( weightBelow[b] >= targetWeight[b] ) {
+                        upper[b] = mid;
+                    } else {
+                        lower[b] = mid;
+                    }
+                }
+            }
+        }
 
-    {
-        scai::hmemo::WriteOnlyAccess<IndexType> wLocalPart ( result.getLocalValues() );
-        scai::hmemo::ReadAccess<IndexType> rPixelPart( localPixelPartition.getLocalValues() );
-
-        scai::hmemo::ReadAccess<ValueType> coordAccess0( coordinates[0].getLocalValues() );
-        scai::hmemo::ReadAccess<ValueType> coordAccess1( coordinates[1].getLocalValues() );
-        // this is faulty, if dimensions=2 coordAccess2 is equal to coordAccess1
-        scai::hmemo::ReadAccess<ValueType> coordAccess2( coordinates[dimensions-1].getLocalValues() );
-
-        for(IndexType i=0; i<localN; i++) {
-            IndexType scaledX = sideLen*coordAccess0[i]/(maxCoords[0]+1);
-            IndexType scaledY = sideLen*coordAccess1[i]/(maxCoords[1]+1);
-            IndexType thisPixel;    // the pixel this node belongs to
-            if(dimensions==3) {
-                IndexType scaledZ = sideLen*coordAccess2[i]/(maxCoords[2]+1);
-                thisPixel = scaledX*sideLen*sideLen + scaledY*sideLen + scaledZ;
-            } else {
-                thisPixel = scaledX*sideLen + scaledY;
+        for( IndexType i=0; i<localN; i++) {
+            const IndexType b = localBlock[i];
+            if( active[b] and fiedler[i] > upper[b] ) {
+                localBlock[i] = b + leftSize[b];
+            }
+        }
+        for( IndexType b=0; b<k; b++) {
+            if( active[b] ) {
+                blockSize[b+leftSize[b]] = blockSize[b]-leftSize[b];
+                blockSize[b] = leftSize[b];
             }
-            SCAI_ASSERT( thisPixel < numPixels, "Index too big: "<< thisPixel );
+        }
 
-            // set the block for this node
-            wLocalPart[i] = rPixelPart[ thisPixel ];
+        if( settings.verbose ) {
+            PRINT0("Spectral bisection, finished round " << round );
         }
+        round++;
     }
 
-    return result;
+    return DenseVector<IndexType>( inputDist, scai::hmemo::HArray<IndexType>(localN, localBlock.data()) );
 }
 //---------------------------------------------------------------------------------------
 
-
 template<typename IndexType, typename ValueType>
-scai::lama::DenseVector<ValueType> SpectralPartition<IndexType, ValueType>::getFiedlerVector(const scai::lama::CSRSparseMatrix<ValueType>& adjM, ValueType& eigenvalue ) {
+DenseVector<ValueType> SpectralPartition<IndexType, ValueType>::getFiedlerVector(const CSRSparseMatrix<ValueType>& adjM, ValueType& eigenvalue ) {
     SCAI_REGION("SpectralPartition.getFiedlerVector");
 
-    IndexType globalN= adjM.getNumRows();
+    const IndexType globalN = adjM.getNumRows();
     SCAI_ASSERT_EQ_ERROR( globalN, adjM.getNumColumns(), "Matrix not square, numRows != numColumns");
 
-    scai::lama::CSRSparseMatrix<ValueType> laplacian = GraphUtils<IndexType, ValueType>::constructLaplacian( adjM );
+    const scai::dmemo::DistributionPtr dist = adjM.getRowDistributionPtr();
+    const IndexType localN = dist->getLocalSize();
 
-    // set u=[ 1+sqrt(n), 1, 1, 1, ... ]
-    ValueType n12 = scai::common::Math::sqrt( ValueType( globalN ));
+    std::vector<ValueType> eigenvalues;
+    const std::vector<double> fiedler = getBlockFiedlerVectors( adjM, std::vector<IndexType>(localN, 0), std::vector<bool>(1, true), eigenvalues );
+    eigenvalue = eigenvalues[0];
 
-    auto u = scai::lama::fill<scai::lama::DenseVector<ValueType>>( laplacian.getRowDistributionPtr(), 1);
-    u[0] = n12 + 1;
+    std::vector<ValueType> converted( fiedler.begin(), fiedler.end() );
+    return DenseVector<ValueType>( dist, scai::hmemo::HArray<ValueType>(localN, converted.data()) );
+}
+//---------------------------------------------------------------------------------------
 
-    ValueType alpha= globalN + n12;
+template<typename IndexType, typename ValueType>
+std::vector<double> SpectralPartition<IndexType, ValueType>::getBlockFiedlerVectors(
+    const CSRSparseMatrix<ValueType>& adjM,
+    const std::vector<IndexType>& localBlock,
+    const std::vector<bool>& active,
+    std::vector<ValueType>& eigenvalues,
+    const IndexType maxIterations,
+    const double tolerance) {
+    SCAI_REGION("SpectralPartition.getBlockFiedlerVectors");
+
+    const scai::dmemo::DistributionPtr dist = adjM.getRowDistributionPtr();
+    const scai::dmemo::CommunicatorPtr comm = dist->getCommunicatorPtr();
+    const IndexType localN = dist->getLocalSize();
+    const IndexType numBlocks = active.size();
+    SCAI_ASSERT_EQ_ERROR( localBlock.size(), localN, "Wrong size of block vector" );
+
+    //
+    // keep only the local edges inside blocks; a neighbor is stored as its local index or as localN + its halo index
+    //
 
-    // set h= L*u/alpha
-    auto h = scai::lama::eval<scai::lama::DenseVector<ValueType>>( laplacian*u );
-    h /= alpha;
+    const scai::dmemo::HaloExchangePlan halo = GraphUtils<IndexType, ValueType>::buildNeighborHalo( adjM );
+    std::vector<IndexType> blockIA( localN+1, 0 );
+    std::vector<IndexType> blockJA;
+    std::vector<double> blockValues;
+    std::vector<double> degree( localN, 0.0 );
+    {
+        SCAI_REGION("SpectralPartition.getBlockFiedlerVectors.filterEdges");
+        scai::hmemo::HArray<IndexType> haloBlock;
+        halo.updateHalo( haloBlock, scai::hmemo::HArray<IndexType>(localN, localBlock.data()), *comm );
+        scai::hmemo::ReadAccess<IndexType> rHaloBlock( haloBlock );
+
+        const scai::lama::CSRStorage<ValueType>& localStorage = adjM.getLocalStorage();
+        scai::hmemo::ReadAccess<IndexType> ia( localStorage.getIA() );
+        scai::hmemo::ReadAccess<IndexType> ja( localStorage.getJA() );
+        scai::hmemo::ReadAccess<ValueType> values( localStorage.getValues() );
+
+        for( IndexType i=0; i<localN; i++) {
+            const IndexType globalI = dist->local2Global(i);
+            for( IndexType j=ia[i]; j<ia[i+1]; j++) {
+                const IndexType neighbor = ja[j];
+                if( neighbor==globalI ) {
+                    continue;
+                }
+                IndexType index, neighborBlock;
+                if( dist->isLocal(neighbor) ) {
+                    index = dist->global2Local(neighbor);
+                    neighborBlock = localBlock[index];
+                } else {
+                    const IndexType haloIndex = halo.global2Halo(neighbor);
+                    index = localN + haloIndex;
+                    neighborBlock = rHaloBlock[haloIndex];
+                }
+                if( neighborBlock==localBlock[i] ) {
+                    blockJA.push_back( index );
+                    blockValues.push_back( values[j] );
+                    degree[i] += values[j];
+                }
+            }
+            blockIA[i+1] = blockJA.size();
+        }
+    }
 
-    // set v= h - gamma*u/2
-    ValueType gamma= u.dotProduct(h)/ alpha * 0.5;
-    auto v = scai::lama::eval<scai::lama::DenseVector<ValueType>>(h - gamma*u);
+    // y = L*x, where L is the Laplacian of the graph without the edges between blocks
+    scai::hmemo::HArray<double> haloX;
+    auto applyLaplacian = [&](const std::vector<double>& x, std::vector<double>& y) {
+        SCAI_REGION("SpectralPartition.getBlockFiedlerVectors.applyLaplacian");
+        halo.updateHalo( haloX, scai::hmemo::HArray<double>(localN, x.data()), *comm );
+        scai::hmemo::ReadAccess<double> rHaloX( haloX );
+        for( IndexType i=0; i<localN; i++) {
+            double sum = degree[i]*x[i];
+            for( IndexType j=blockIA[i]; j<blockIA[i+1]; j++) {
+                const IndexType index = blockJA[j];
+                sum -= blockValues[j]*( index<localN ? x[index] : rHaloX[index-localN] );
+            }
+            y[i] = sum;
+        }
+    };
+
+    // all dot products of all blocks in a single reduction; result[p][b] is the product of pairs[p] in block b
+    auto blockDots = [&](const std::vector<std::pair<const std::vector<double>*, const std::vector<double>*>>& pairs) {
+        SCAI_REGION("SpectralPartition.getBlockFiedlerVectors.blockDots");
+        const IndexType numPairs = pairs.size();
+        std::vector<double> sums( numPairs*numBlocks, 0.0 );
+        for( IndexType p=0; p<numPairs; p++) {
+            const std::vector<double>& a = *pairs[p].first;
+            const std::vector<double>& c = *pairs[p].second;
+            for( IndexType i=0; i<localN; i++) {
+                sums[p*numBlocks + localBlock[i]] += a[i]*c[i];
+            }
+        }
+        comm->sumImpl( sums.data(), sums.data(), sums.size(), scai::common::TypeTraits<double>::stype );
 
-    scai::lama::DenseVector<ValueType> r(u);
-    r[0]= 0.0;
-    scai::lama::DenseVector<ValueType> s(v);
-    s[0]= 0.0;
-    auto t = scai::lama::fill<scai::lama::DenseVector<ValueType>>( laplacian.getRowDistributionPtr(), 1.0);
+        std::vector<std::vector<double>> result( numPairs );
+        for( IndexType p=0; p<numPairs; p++) {
+            result[p].assign( sums.begin()+p*numBlocks, sums.begin()+(p+1)*numBlocks );
+        }
+        return result;
+    };
 
-    scai::lama::DenseVector<ValueType> y;
-    scai::lama::DenseVector<ValueType> diff;
+    // the constant vector of every block is in the kernel of L, remove it
+    std::vector<double> blockCount( numBlocks, 0.0 );
+    for( IndexType i=0; i<localN; i++) {
+        blockCount[localBlock[i]] += 1;
+    }
+    comm->sumImpl( blockCount.data(), blockCount.data(), numBlocks, scai::common::TypeTraits<double>::stype );
 
-    t[0] = 0.0;
-    scai::lama::DenseVector<ValueType> z(t);
+    auto projectOutConstant = [&](std::vector<double>& v) {
+        std::vector<double> sums( numBlocks, 0.0 );
+        for( IndexType i=0; i<localN; i++) {
+            sums[localBlock[i]] += v[i];
+        }
+        comm->sumImpl( sums.data(), sums.data(), numBlocks, scai::common::TypeTraits<double>::stype );
+        for( IndexType i=0; i<localN; i++) {
+            v[i] -= sums[localBlock[i]]/blockCount[localBlock[i]];
+        }
+    };
+
+    // scale v and Lv so that v has norm 1 in every block; returns false for blocks where v vanishes
+    auto normalize = [&](std::vector<double>& v, std::vector<double>& Lv) {
+        const std::vector<double> norms = blockDots( {{&v, &v}} )[0];
+        std::vector<bool> valid( numBlocks );
+        for( IndexType b=0; b<numBlocks; b++) {
+            valid[b] = norms[b] > 1e-24;
+        }
+        for( IndexType i=0; i<localN; i++) {
+            const IndexType b = localBlock[i];
+            const double factor = valid[b] ? 1/std::sqrt(norms[b]) : 0.0;
+            v[i] *= factor;
+            Lv[i] *= factor;
+        }
+        return valid;
+    };
 
-    IndexType kmax = 200;        // maximal number of iterations
-    ValueType eps  = 1e-7;       // accuracy for maxNorm
-    ValueType lambda = 0.0;   // the eigenvalue (?) TODO: make sure
+    //
+    // LOBPCG: in every iteration, x is replaced by the best approximation of the Fiedler vector from span{x, w, p}
+    // where w is the preconditioned residual and p the previous search direction
+    //
 
-    // temporary vector outside of loop for reuse, avoids alloc/dealloc
-    scai::lama::DenseVector<ValueType> res;
-    scai::lama::DenseVector<ValueType> x;
+    std::vector<double> x( localN ), Lx( localN );
+    std::vector<double> w( localN, 0.0 ), Lw( localN );
+    std::vector<double> p( localN, 0.0 ), Lp( localN, 0.0 );
 
-    for(IndexType k=0; k<kmax; k++) {
-        // normalize t
-        t = t/t.l2Norm();
+    // pseudo random start vector depending only on the global index, so that the result is independent of the number of PEs
+    for( IndexType i=0; i<localN; i++) {
+        const unsigned long long h = ( (unsigned long long)(dist->local2Global(i))+1 )*2654435761ULL % 4294967296ULL;
+        x[i] = active[localBlock[i]] ? h/4294967296.0 - 0.5 : 0.0;
+    }
+    projectOutConstant( x );
+    applyLaplacian( x, Lx );
+    normalize( x, Lx );
+
+    std::vector<bool> converged( numBlocks );
+    std::vector<bool> hasP( numBlocks, false );
+    for( IndexType b=0; b<numBlocks; b++) {
+        converged[b] = !active[b];
+    }
+    std::vector<double> lambda( numBlocks, 0.0 );
 
-        y= laplacian*t;
-        y[0] = 0.0;                  // fill element as we actually use L[2:n,2:n]
-        y -= s.dotProduct( t ) * r;
-        y -= r.dotProduct( t ) * s;
+    IndexType iter = 0;
+    for( ; iter<maxIterations; iter++) {
+        lambda = blockDots( {{&x, &Lx}} )[0];
 
-        lambda = t.dotProduct( y );
-        diff = y - lambda * t;
-        ValueType  diffNorm = diff.maxNorm();
+        // residual, preconditioned with the inverse of the diagonal
+        for( IndexType i=0; i<localN; i++) {
+            const IndexType b = localBlock[i];
+            w[i] = converged[b] ? 0.0 : Lx[i] - lambda[b]*x[i];
+        }
+        const std::vector<double> residualNorms = blockDots( {{&w, &w}} )[0];
 
-        if( diffNorm<eps) {
+        bool allConverged = true;
+        for( IndexType b=0; b<numBlocks; b++) {
+            const double residual = std::sqrt( residualNorms[b] );
+            if( !converged[b] and (residual <= tolerance*lambda[b] or residual < 1e-12) ) {
+                converged[b] = true;
+            }
+            allConverged = allConverged and converged[b];
+        }
+        if( allConverged ) {
             break;
         }
 
-        //solve
-        //set res
-        res = t - laplacian * z;
-        res += s.dotProduct(z) * r;
-        res += r.dotProduct(z) * s;
-        res[0] = 0.0;
-
-        scai::lama::DenseVector<ValueType> d(res);
-
-        ValueType rOld  = res.dotProduct( res );
-        ValueType rNorm = res.l2Norm();
-
-        IndexType maxIter= 100;
-
+        for( IndexType i=0; i<localN; i++) {
+            if( converged[localBlock[i]] ) {
+                w[i] = 0.0;
+            } else if( degree[i] > 0 ) {
+                w[i] /= degree[i];
+            }
+        }
+        projectOutConstant( w );
 
-        for(IndexType kk=0; kk<maxIter and rNorm>eps; kk++) {
-            x = laplacian*d;
+        // orthonormalize w against x
+        {
+            const std::vector<double> xw = blockDots( {{&x, &w}} )[0];
+            for( IndexType i=0; i<localN; i++) {
+                w[i] -= xw[localBlock[i]]*x[i];
+            }
+        }
+        applyLaplacian( w, Lw );
+        const std::vector<bool> hasW = normalize( w, Lw );
+
+        // orthonormalize p against x and w
+        {
+            const std::vector<std::vector<double>> dots = blockDots( {{&x, &p}, {&w, &p}} );
+            for( IndexType i=0; i<localN; i++) {
+                const IndexType b = localBlock[i];
+                p[i] -= dots[0][b]*x[i] + dots[1][b]*w[i];
+                Lp[i] -= dots[0][b]*Lx[i] + dots[1][b]*Lw[i];
+            }
+            const std::vector<bool> validP = normalize( p, Lp );
+            for( IndexType b=0; b<numBlocks; b++) {
+                hasP[b] = hasP[b] and validP[b];
+            }
+        }
 
-            x -= s.dotProduct(d) * r;
-            x -= r.dotProduct(d) * s;
-            x[0] = 0.0;
+        // Rayleigh-Ritz for every block: smallest eigenpair of the projection of L onto span{x,w,p}
+        const std::vector<std::vector<double>> G = blockDots( {{&x, &Lx}, {&x, &Lw}, {&x, &Lp}, {&w, &Lw}, {&w, &Lp}, {&p, &Lp}} );
+        std::vector<std::vector<double>> coefficients( numBlocks, std::vector<double>{1.0, 0.0, 0.0} );
 
-            ValueType tmpSc = rOld/ d.dotProduct(x);
-            z = z + tmpSc*d;
-            res = res - tmpSc*x;
-            ValueType rNew = res.dotProduct(res);
-            ValueType beta = rNew/ rOld;
-            d = res + beta*d;
-            rOld = rNew;
-            rNorm = res.l2Norm();
+        for( IndexType b=0; b<numBlocks; b++) {
+            if( converged[b] or !hasW[b] ) {
+                continue;
+            }
+            std::vector<double> eigenvector;
+            if( hasP[b] ) {
+                smallestEigenpair( { {G[0][b], G[1][b], G[2][b]}, {G[1][b], G[3][b], G[4][b]}, {G[2][b], G[4][b], G[5][b]} }, eigenvector );
+            } else {
+                smallestEigenpair( { {G[0][b], G[1][b]}, {G[1][b], G[3][b]} }, eigenvector );
+                eigenvector.push_back( 0.0 );
+            }
+            coefficients[b] = eigenvector;
         }
 
-        t = z;
+        for( IndexType i=0; i<localN; i++) {
+            const IndexType b = localBlock[i];
+            if( converged[b] or !hasW[b] ) {
+                continue;
+            }
+            const std::vector<double>& c = coefficients[b];
+            p[i] = c[1]*w[i] + c[2]*p[i];
+            Lp[i] = c[1]*Lw[i] + c[2]*Lp[i];
+            x[i] = c[0]*x[i] + p[i];
+            Lx[i] = c[0]*Lx[i] + Lp[i];
+        }
+        for( IndexType b=0; b<numBlocks; b++) {
+            hasP[b] = hasW[b] and !converged[b];
+        }
+        normalize( x, Lx );
     }
 
-    t[0] = 0.0;
-    ValueType beta = u.dotProduct(t) / alpha;
-    t = t- beta*u;
-
-    eigenvalue = lambda;
+    if( iter==maxIterations ) {
+        PRINT0("Warning: LOBPCG did not converge for all blocks after " << maxIterations << " iterations");
+    }
 
-    return t;
+    eigenvalues = std::vector<ValueType>( lambda.begin(), lambda.end() );
+    return x;
 }
+//---------------------------------------------------------------------------------------
 
-/*
 template<typename IndexType, typename ValueType>
-scai::lama::DenseVector<ValueType> SpectralPartition<IndexType, ValueType>::getFiedlerVector2(const scai::lama::CSRSparseMatrix<ValueType>& adjM, ValueType& eigenvalue ){
-    SCAI_REGION("SpectralPartition.getFiedlerVector2");
-
-    IndexType globalN= adjM.getNumRows();
-    SCAI_ASSERT_EQ_ERROR( globalN, adjM.getNumColumns(), "Matrix not square, numRows != numColumns");
-
-    scai::lama::CSRSparseMatrix<ValueType> laplacian = GraphUtils::constructLaplacian<IndexType, ValueType>( adjM );
-
-    // set u=[ 1+sqrt(n), 1, 1, 1, ... ]
-    ValueType n12 = scai::common::Math::sqrt( ValueType( globalN ));
+double SpectralPartition<IndexType, ValueType>::smallestEigenpair(std::vector<std::vector<double>> A, std::vector<double>& eigenvector) {
+    const IndexType m = A.size();
 
-    auto u = scai::lama::fill<scai::lama::DenseVector<ValueType>>( laplacian.getRowDistributionPtr(), 1);
-    u[0] = n12 + 1;
-
-    ValueType alpha= globalN + n12;
-
-    scai::HouseholderTransformedMatrix<ValueType> HLH( L, u, alpha );
-
-    auto t = fill<DenseVector<ValueType>>( L.getRowDistributionPtr(), 1.0 );
-
-    DenseVector<ValueType> y;
-    DenseVector<ValueType> diff;
+    // V accumulates the rotations, its columns converge to the eigenvectors
+    std::vector<std::vector<double>> V( m, std::vector<double>(m, 0.0) );
+    for( IndexType i=0; i<m; i++) {
+        V[i][i] = 1.0;
+    }
 
-    t[0] = 0.0;
+    for( IndexType sweep=0; sweep<50; sweep++) {
+        double offDiagonal = 0.0;
+        double diagonal = 0.0;
+        for( IndexType i=0; i<m; i++) {
+            diagonal += A[i][i]*A[i][i];
+            for( IndexType j=i+1; j<m; j++) {
+                offDiagonal += A[i][j]*A[i][j];
+            }
+        }
+        if( offDiagonal <= 1e-30*diagonal ) {
+            break;
+        }
 
-    DenseVector<ValueType> z( t );
+        for( IndexType p=0; p<m; p++) {
+            for( IndexType q=p+1; q<m; q++) {
+                if( A[p][q]==0 ) {
+                    continue;
+                }
+                const double theta = (A[q][q]-A[p][p])/(2*A[p][q]);
+                const double t = std::abs(theta) > 1e150 ? 1/(2*theta) : (theta>=0 ? 1.0 : -1.0)/( std::abs(theta) + std::sqrt(theta*theta+1) );
+                const double c = 1/std::sqrt(t*t+1);
+                const double s = t*c;
+
+                for( IndexType r=0; r<m; r++) {
+                    const double arp = A[r][p];
+                    const double arq = A[r][q];
+                    A[r][p] = c*arp - s*arq;
+                    A[r][q] = s*arp + c*arq;
+                }
+                for( IndexType r=0; r<m; r++) {
+                    const double apr = A[p][r];
+                    const double aqr = A[q][r];
+                    A[p][r] = c*apr - s*aqr;
+                    A[q][r] = s*apr + c*aqr;
+                }
+                for( IndexType r=0; r<m; r++) {
+                    const double vrp = V[r][p];
+                    const double vrq = V[r][q];
+                    V[r][p] = c*vrp - s*vrq;
+                    V[r][q] = s*vrp + c*vrq;
+                }
+            }
+        }
+    }
 
+    IndexType smallest = 0;
+    for( IndexType i=1; i<m; i++) {
+        if( A[i][i] < A[smallest][smallest] ) {
+            smallest = i;
+        }
+    }
 
+    eigenvector.resize( m );
+    for( IndexType i=0; i<m; i++) {
+        eigenvector[i] = V[i][smallest];
+    }
+    return A[smallest][smallest];
 }
-*/
 //---------------------------------------------------------------------------------------
 
-template class SpectralPartition<IndexType, ValueType>;
+template class SpectralPartition<IndexType, double>;
+template class SpectralPartition<IndexType, float>;
 
 };
@@ -7,56 +7,85 @@
 
 #pragma once
 
+#include <scai/lama.hpp>
+#include <scai/lama/matrix/CSRSparseMatrix.hpp>
+#include <scai/lama/DenseVector.hpp>
 #include <scai/dmemo/Distribution.hpp>
-#include <scai/dmemo/BlockDistribution.hpp>
-#include <scai/dmemo/GenBlockDistribution.hpp>
-#include <scai/sparsekernel/openmp/OpenMPCSRUtils.hpp>
+#include <scai/dmemo/HaloExchangePlan.hpp>
 #include <scai/tracing.hpp>
 
-#include <assert.h>
 #include <cmath>
-#include <climits>
-#include <queue>
-#include <string>
-#include <unordered_set>
-#include <numeric>
-#include <iterator>
-#include <algorithm>
-#include <tuple>
+#include <vector>
 #include <chrono>
 
-#include "PrioQueue.h"
-#include "MultiLevel.h"
 #include "Settings.h"
 
 namespace ITI {
 
-/** @brief Partition a graph using the spectral partitioning method.
-@warning This class is heavily unstable and not further developed.
+using scai::lama::CSRSparseMatrix;
+using scai::lama::DenseVector;
+
+/** @brief Partition a graph using recursive spectral bisection.
+
+All computations are distributed: the Laplacian is applied using only the local rows and a halo exchange,
+and the eigenvectors are computed with the LOBPCG method (locally optimal block preconditioned conjugate gradient)
+with a Jacobi preconditioner. The graph is never replicated.
 */
 
 template <typename IndexType, typename ValueType>
 class SpectralPartition {
 public:
-    /** Returns a spectral partition of the input graph
+    /** Returns a partition into settings.numBlocks blocks using recursive spectral bisection; the number of blocks does not
+     * need to be equal to the number of PEs.
+     *
+     * In every round, all current blocks are bisected at once: the Fiedler vectors of all blocks (i.e., of the graph without
+     * the edges between blocks) are computed by one call to getBlockFiedlerVectors() and every block is split at the
+     * weighted quantile of its Fiedler vector that corresponds to the number of final blocks on each side.
+     *
      * @param[in] adjM The adjacency matrix of the input graph to partition.
-     * @param[in] coordinates Node positions
+     * @param[in] nodeWeights The weights of the vertices, must have the same distribution as the rows of adjM.
+     * @param[in] settings The settings; numBlocks is the number of blocks.
+     * @return The partition, with the same distribution as the rows of adjM.
      */
-    static scai::lama::DenseVector<IndexType> getPartition(const CSRSparseMatrix<ValueType> &adjM, const std::vector<DenseVector<ValueType>> &coordinates, Settings settings);
+    static DenseVector<IndexType> getPartition(const CSRSparseMatrix<ValueType> &adjM, const DenseVector<ValueType> &nodeWeights, Settings settings);
 
-    /**Main program to determine the Fiedler vector for a Laplacian matrix
-     *
-     *  Method: Inverse power method incorporated with Householder deflation
+    /** Computes the Fiedler vector, i.e., the eigenvector of the second smallest eigenvalue of the Laplacian of the graph.
      *
-     *  Paper: An efficient and accurate method to compute the Fiedler vector based on
-     *         Householder deflation and inverse power iteration
-     *         Jian-ping Wu, Jun-qiang Song, Wei-min Zhang
      * @param[in] adjM The adjacency matrix of the input graph to get the Fiedler eigenvector.
-     * @param[out] eigenvalue The second smallest eigenvalue that corresponds to the fiedler vector.
-     * @return The Fiedler eigenvector, aka the vector corresponding to the second smallest eigenvalue of adjM.
+     * @param[out] eigenvalue The second smallest eigenvalue that corresponds to the Fiedler vector.
+     * @return The Fiedler eigenvector with the same distribution as the rows of adjM; it has mean 0 and l2 norm 1.
+     */
+    static DenseVector<ValueType> getFiedlerVector(const CSRSparseMatrix<ValueType>& adjM, ValueType& eigenvalue );
+
+    /** Computes the Fiedler vectors of all blocks of a partition simultaneously. The graph is considered without the edges
+     * between different blocks, so its Laplacian is block diagonal and every block has its own Fiedler vector.
+     * The dot products of all blocks are combined into one reduction, so the number of global reductions does not depend
+     * on the number of blocks.
+     *
+     * @param[in] adjM The adjacency matrix of the graph.
+     * @param[in] localBlock For every local vertex, the block it belongs to. Values must be in [0, active.size()).
+     * @param[in] active The Fiedler vector is only computed for blocks with active[b]==true; the result is 0 for the vertices of the other blocks.
+     * @param[out] eigenvalues For every block, the eigenvalue of its Fiedler vector.
+     * @param[in] maxIterations The maximum number of LOBPCG iterations.
+     * @param[in] tolerance The iterations stop for a block when the norm of the residual is below tolerance*eigenvalue.
+     * @return For every local vertex, its entry in the Fiedler vector of its block. The vector of every block has mean 0 and l2 norm 1.
+     */
+    static std::vector<double> getBlockFiedlerVectors(
+        const CSRSparseMatrix<ValueType>& adjM,
+        const std::vector<IndexType>& localBlock,
+        const std::vector<bool>& active,
+        std::vector<ValueType>& eigenvalues,
+        const IndexType maxIterations = 500,
+        const double tolerance = 1e-4);
+
+private:
+    /** Computes the smallest eigenvalue and its eigenvector of a small, dense, symmetric matrix using Jacobi rotations.
+     *
+     * @param[in] A The matrix, A.size()==A[i].size().
+     * @param[out] eigenvector The normalized eigenvector of the smallest eigenvalue.
+     * @return The smallest eigenvalue.
      */
-    static scai::lama::DenseVector<ValueType> getFiedlerVector(const scai::lama::CSRSparseMatrix<ValueType>& adjM,
-            ValueType& eigenvalue );
+    static double smallestEigenpair(std::vector<std::vector<double>> A, std::vector<double>& eigenvector);
 };
 
 }
@@ -0,0 +1,403 @@
+/*
+ * StreamingPartition.cpp
+ *
+ * Partitioning of point sets that are too large to be held in memory more than once, read in slices from binary files.
+ */
+
+#include <scai/common/TypeTraits.hpp>
+#include <scai/dmemo/BlockDistribution.hpp>
+#include <scai/dmemo/GenBlockDistribution.hpp>
+#include <scai/hmemo/ReadAccess.hpp>
+#include <scai/hmemo/WriteAccess.hpp>
+#include <scai/lama/DenseVector.hpp>
+#include <scai/tracing.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "StreamingPartition.h"
+#include "HilbertCurve.h"
+#include "KMeans.h"
+#include "Metrics.h"
+#include "Telemetry.h"
+
+namespace ITI {
+
+template<typename IndexType, typename ValueType>
+StreamingPartition<IndexType, ValueType>::MappedSlice::MappedSlice(const std::string filename, const std::size_t firstValue, const std::size_t numValues) {
+    if (numValues == 0) {
+        return;
+    }
+
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("File " + filename + " failed.");
+    }
+
+    // the offset of a mapping must be a multiple of the page size
+    const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+    const std::size_t begin = firstValue*sizeof(double);
+    const std::size_t alignedBegin = begin - begin % pageSize;
+    mappedBytes = begin + numValues*sizeof(double) - alignedBegin;
+
+    mapping = mmap(nullptr, mappedBytes, PROT_READ, MAP_PRIVATE, fd, alignedBegin);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::runtime_error("Could not map " + std::to_string(numValues) + " values of file " + filename + " from value " + std::to_string(firstValue));
+    }
+    madvise(mapping, mappedBytes, MADV_SEQUENTIAL);
+
+    values = reinterpret_cast<const double*>(static_cast<const char*>(mapping) + (begin - alignedBegin));
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+StreamingPartition<IndexType, ValueType>::MappedSlice::~MappedSlice() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappedBytes);
+    }
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+IndexType StreamingPartition<IndexType, ValueType>::getNumPoints(const std::string coordFile) {
+    struct stat fileStat;
+    if (stat(coordFile.c_str(), &fileStat) != 0) {
+        throw std::runtime_error("File " + coordFile + " failed.");
+    }
+    const std::size_t pointBytes = fileDimensions*sizeof(double);
+    if (fileStat.st_size % pointBytes != 0) {
+        throw std::runtime_error("Size of binary coordinate file " + coordFile + " is not a multiple of " + std::to_string(pointBytes) + " bytes.");
+    }
+    return fileStat.st_size / pointBytes;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+std::string StreamingPartition<IndexType, ValueType>::getHeader(const IndexType globalN) {
+    return "% " + std::to_string(globalN) + "\n";
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+IndexType StreamingPartition<IndexType, ValueType>::getLineWidth(const IndexType k) {
+    return std::to_string(std::max<IndexType>(k-1, 0)).size();
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+void StreamingPartition<IndexType, ValueType>::writePartitionSlice(const std::string partFile, const IndexType globalN, const IndexType k, const IndexType firstIndex, const std::vector<IndexType>& blocks) {
+    SCAI_REGION( "StreamingPartition.writePartitionSlice" )
+
+    const IndexType width = getLineWidth(k);
+    std::string buffer(blocks.size()*(width+1), ' ');
+    for (std::size_t i = 0; i < blocks.size(); i++) {
+        const std::string id = std::to_string(blocks[i]);
+        SCAI_ASSERT_LE_ERROR( IndexType(id.size()), width, "Block ID " << blocks[i] << " too large for " << k << " blocks" );
+        // right-aligned, std::stoi in FileIO::readPartition skips the leading spaces
+        std::copy(id.begin(), id.end(), buffer.begin() + i*(width+1) + width - id.size());
+        buffer[i*(width+1) + width] = '\n';
+    }
+
+    const int fd = open(partFile.c_str(), O_WRONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not write to file " + partFile);
+    }
+    std::size_t offset = getHeader(globalN).size() + std::size_t(firstIndex)*(width+1);
+    std::size_t written = 0;
+    while (written < buffer.size()) {
+        const ssize_t result = pwrite(fd, buffer.data() + written, buffer.size() - written, offset + written);
+        if (result < 0) {
+            close(fd);
+            throw std::runtime_error("Could not write to file " + partFile);
+        }
+        written += result;
+    }
+    close(fd);
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+std::vector<double> StreamingPartition<IndexType, ValueType>::getSplitters(const std::vector<double>& localKeys, const std::vector<ValueType>& localWeights, const IndexType k, const scai::dmemo::CommunicatorPtr comm) {
+    SCAI_REGION( "StreamingPartition.getSplitters" )
+    SCAI_ASSERT_EQ_ERROR( localKeys.size(), localWeights.size(), "Every sample point needs a weight" );
+
+    // the sample is small, so every PE gets all of it
+    const IndexType numPEs = comm->getSize();
+    std::vector<IndexType> sampleSizes(numPEs, 0);
+    sampleSizes[comm->getRank()] = localKeys.size();
+    comm->sumImpl( sampleSizes.data(), sampleSizes.data(), numPEs, scai::common::TypeTraits<IndexType>::stype );
+
+    const IndexType offset = std::accumulate(sampleSizes.begin(), sampleSizes.begin() + comm->getRank(), IndexType(0));
+    const IndexType sampleN = std::accumulate(sampleSizes.begin(), sampleSizes.end(), IndexType(0));
+
+    std::vector<double> keys(sampleN, 0);
+    std::vector<ValueType> weights(sampleN, 0);
+    std::copy(localKeys.begin(), localKeys.end(), keys.begin() + offset);
+    std::copy(localWeights.begin(), localWeights.end(), weights.begin() + offset);
+    comm->sumImpl( keys.data(), keys.data(), sampleN, scai::common::TypeTraits<double>::stype );
+    comm->sumImpl( weights.data(), weights.data(), sampleN, scai::common::TypeTraits<ValueType>::stype );
+
+    std::vector<IndexType> order(sampleN);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&keys](IndexType a, IndexType b) {
+        return keys[a] < keys[b];
+    });
+    const ValueType totalWeight = std::accumulate(weights.begin(), weights.end(), ValueType(0));
+
+    // splitter j is the key of the first sample after the samples with (j+1)/k of the weight
+    std::vector<double> splitters(k-1, std::numeric_limits<double>::max());
+    ValueType prefixWeight = 0;
+    IndexType j = 0;
+    for (IndexType s = 0; s < sampleN and j < k-1; s++) {
+        prefixWeight += weights[order[s]];
+        while (j < k-1 and prefixWeight >= (j+1)*totalWeight/k) {
+            splitters[j] = s+1 < sampleN ? keys[order[s+1]] : std::numeric_limits<double>::max();
+            j++;
+        }
+    }
+    return splitters;
+}
+//---------------------------------------------------------------------------------------
+
+template<typename IndexType, typename ValueType>
+ValueType StreamingPartition<IndexType, ValueType>::partitionFile(const std::string coordFile, const std::string weightFile, const std::string partFile, Settings settings, const scai::dmemo::CommunicatorPtr comm) {
+    SCAI_REGION( "StreamingPartition.partitionFile" )
+    Telemetry::ScopedTimer timer( "StreamingPartition.partitionFile" );
+
+    const IndexType dimensions = settings.dimensions;
+    const IndexType k = settings.numBlocks;
+    if (dimensions > fileDimensions) {
+        throw std::runtime_error("Binary coordinate files have at most " + std::to_string(fileDimensions) + " dimensions.");
+    }
+    const bool weighted = weightFile != "-";
+    const bool useSFC = settings.initialPartition == Tool::geoSFC;
+
+    const IndexType globalN = getNumPoints(coordFile);
+    if (weighted) {
+        struct stat fileStat;
+        if (stat(weightFile.c_str(), &fileStat) != 0) {
+            throw std::runtime_error("File " + weightFile + " failed.");
+        }
+        if (std::size_t(fileStat.st_size) != std::size_t(globalN)*sizeof(double)) {
+            throw std::runtime_error("Size of binary weight file " + weightFile + " is " + std::to_string(fileStat.st_size) + " bytes, expected one double for each of the " + std::to_string(globalN) + " points.");
+        }
+    }
+    IndexType beginLocalRange, endLocalRange;
+    scai::dmemo::BlockDistribution::getLocalRange(beginLocalRange, endLocalRange, globalN, comm->getRank(), comm->getSize());
+
+    // calls f(i, point, weight) for every local point, chunk by chunk
+    auto forEachChunk = [&](auto beginChunk, auto f) {
+        for (IndexType chunkBegin = beginLocalRange; chunkBegin < endLocalRange; chunkBegin += chunkSize) {
+            const IndexType chunkN = std::min(chunkSize, endLocalRange - chunkBegin);
+            const MappedSlice coords(coordFile, std::size_t(chunkBegin)*fileDimensions, std::size_t(chunkN)*fileDimensions);
+            const MappedSlice weights(weighted ? weightFile : coordFile, chunkBegin, weighted ? chunkN : 0);
+            beginChunk(chunkBegin, chunkN);
+            for (IndexType i = 0; i < chunkN; i++) {
+                f(chunkBegin + i, coords.data() + std::size_t(i)*fileDimensions, weighted ? ValueType(weights.data()[i]) : ValueType(1));
+            }
+        }
+    };
+
+    /*
+     * first sweep: bounding box and an evenly spaced sample
+     */
+    std::vector<ValueType> minCoords(dimensions, std::numeric_limits<ValueType>::max());
+    std::vector<ValueType> maxCoords(dimensions, std::numeric_limits<ValueType>::lowest());
+    std::vector<std::vector<ValueType>> sampleCoords(dimensions);
+    std::vector<ValueType> sampleWeights;
+    const IndexType sampleStride = std::max<IndexType>(1, globalN / std::max<IndexType>(settings.streamingSampleSize, 1));
+    {
+        SCAI_REGION( "StreamingPartition.partitionFile.sample" )
+        Telemetry::ScopedTimer sampleTimer( "StreamingPartition.sample" );
+        forEachChunk([](IndexType, IndexType){}, [&](const IndexType i, const double* point, const ValueType weight) {
+            for (IndexType d = 0; d < dimensions; d++) {
+                minCoords[d] = std::min(minCoords[d], ValueType(point[d]));
+                maxCoords[d] = std::max(maxCoords[d], ValueType(point[d]));
+            }
+            if (i % sampleStride == 0) {
+                for (IndexType d = 0; d < dimensions; d++) {
+                    sampleCoords[d].push_back(point[d]);
+                }
+                sampleWeights.push_back(weight);
+            }
+        });
+        for (IndexType d = 0; d < dimensions; d++) {
+            minCoords[d] = comm->min(minCoords[d]);
+            maxCoords[d] = comm->max(maxCoords[d]);
+        }
+    }
+    const IndexType localSampleN = sampleWeights.size();
+    const IndexType sampleN = comm->sum(localSampleN);
+    PRINT0("Streaming partition of " << globalN << " points into " << k << " blocks with a sample of " << sampleN << " points");
+
+    /*
+     * the splitters or the centers and influence values from the sample
+     */
+    std::vector<double> splitters;
+    std::vector<std::vector<ValueType>> centers(k, std::vector<ValueType>(dimensions, 0));
+    std::vector<ValueType> influence(k, 1);
+    std::vector<bool> emptyBlock(k, false);
+
+    auto getHilbertIndex = [&](const double* point) {
+        ValueType p[fileDimensions];
+        std::copy(point, point + dimensions, p);
+        return HilbertCurve<IndexType, ValueType>::getHilbertIndex(p, dimensions, settings.sfcResolution, minCoords, maxCoords);
+    };
+
+    auto nearestCenter = [&](const double* point) {
+        IndexType best = 0;
+        ValueType bestValue = std::numeric_limits<ValueType>::max();
+        for (IndexType b = 0; b < k; b++) {
+            if (emptyBlock[b]) {
+                continue;
+            }
+            ValueType sqDist = 0;
+            for (IndexType d = 0; d < dimensions; d++) {
+                const ValueType diff = point[d] - centers[b][d];
+                sqDist += diff*diff;
+            }
+            // the effective distance as in KMeans::assignBlocks
+            if (sqDist*influence[b] < bestValue) {
+                best = b;
+                bestValue = sqDist*influence[b];
+            }
+        }
+        return best;
+    };
+
+    {
+        SCAI_REGION( "StreamingPartition.partitionFile.model" )
+        Telemetry::ScopedTimer modelTimer( "StreamingPartition.model" );
+        if (useSFC) {
+            std::vector<double> sampleKeys(localSampleN);
+            std::vector<double> point(fileDimensions, 0);
+            for (IndexType s = 0; s < localSampleN; s++) {
+                for (IndexType d = 0; d < dimensions; d++) {
+                    point[d] = sampleCoords[d][s];
+                }
+                sampleKeys[s] = getHilbertIndex(point.data());
+            }
+            splitters = getSplitters(sampleKeys, sampleWeights, k, comm);
+        } else {
+            // balanced k-means on the sample
+            const scai::dmemo::DistributionPtr sampleDist = scai::dmemo::genBlockDistributionBySize(sampleN, localSampleN, comm);
+            std::vector<DenseVector<ValueType>> sampleCoordVectors(dimensions);
+            for (IndexType d = 0; d < dimensions; d++) {
+                sampleCoordVectors[d] = DenseVector<ValueType>(sampleDist, scai::hmemo::HArray<ValueType>(localSampleN, sampleCoords[d].data()));
+            }
+            const std::vector<DenseVector<ValueType>> sampleWeightVectors = {DenseVector<ValueType>(sampleDist, scai::hmemo::HArray<ValueType>(localSampleN, sampleWeights.data()))};
+            const ValueType sampleWeight = comm->sum(std::accumulate(sampleWeights.begin(), sampleWeights.end(), ValueType(0)));
+            const std::vector<std::vector<ValueType>> blockSizes(1, std::vector<ValueType>(k, sampleWeight/k));
+            Metrics<ValueType> metrics(settings);
+            const DenseVector<IndexType> samplePart = KMeans<IndexType, ValueType>::computePartition(sampleCoordVectors, sampleWeightVectors, blockSizes, settings, metrics);
+
+            // weighted centers of the sample blocks
+            std::vector<ValueType> sums(k*(dimensions+1), 0);
+            {
+                scai::hmemo::ReadAccess<IndexType> rPart(samplePart.getLocalValues());
+                SCAI_ASSERT_EQ_ERROR( rPart.size(), localSampleN, "Sample partition has the wrong distribution" );
+                for (IndexType s = 0; s < localSampleN; s++) {
+                    const IndexType b = rPart[s];
+                    for (IndexType d = 0; d < dimensions; d++) {
+                        sums[b*(dimensions+1) + d] += sampleCoords[d][s]*sampleWeights[s];
+                    }
+                    sums[b*(dimensions+1) + dimensions] += sampleWeights[s];
+                }
+            }
+            comm->sumImpl( sums.data(), sums.data(), sums.size(), scai::common::TypeTraits<ValueType>::stype );
+            for (IndexType b = 0; b < k; b++) {
+                const ValueType blockWeight = sums[b*(dimensions+1) + dimensions];
+                emptyBlock[b] = blockWeight == 0;
+                for (IndexType d = 0; d < dimensions; d++) {
+                    centers[b][d] = emptyBlock[b] ? 0 : sums[b*(dimensions+1) + d] / blockWeight;
+                }
+            }
+
+            /*
+             * The influence values of the k-means run are internal, so they are calibrated again for the assignment
+             * to the nearest center, with the same update rule as in KMeans::assignBlocks.
+             */
+            std::vector<double> point(fileDimensions, 0);
+            for (IndexType iter = 0; iter < settings.balanceIterations; iter++) {
+                std::vector<ValueType> blockWeights(k, 0);
+                for (IndexType s = 0; s < localSampleN; s++) {
+                    for (IndexType d = 0; d < dimensions; d++) {
+                        point[d] = sampleCoords[d][s];
+                    }
+                    blockWeights[nearestCenter(point.data())] += sampleWeights[s];
+                }
+                comm->sumImpl( blockWeights.data(), blockWeights.data(), k, scai::common::TypeTraits<ValueType>::stype );
+
+                const ValueType maxRatio = *std::max_element(blockWeights.begin(), blockWeights.end()) / (sampleWeight/k);
+                if (maxRatio - 1 <= settings.epsilon) {
+                    break;
+                }
+                for (IndexType b = 0; b < k; b++) {
+                    const ValueType ratio = blockWeights[b] / (sampleWeight/k);
+                    influence[b] = std::max(influence[b]*(1-settings.influenceChangeCap),
+                                            std::min(ValueType(influence[b]*std::pow(ratio, settings.influenceExponent)), influence[b]*(1+settings.influenceChangeCap)));
+                }
+            }
+        }
+    }
+
+    /*
+     * second sweep: assign and write the block IDs chunk by chunk
+     */
+    if (comm->getRank() == 0) {
+        std::ofstream outfile(partFile.c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
+        if (outfile.fail()) {
+            throw std::runtime_error("Could not write to file " + partFile);
+        }
+        outfile << getHeader(globalN);
+    }
+    comm->synchronize();
+
+    std::vector<ValueType> blockWeights(k, 0);
+    {
+        SCAI_REGION( "StreamingPartition.partitionFile.assign" )
+        Telemetry::ScopedTimer assignTimer( "StreamingPartition.assign" );
+        std::vector<IndexType> chunkBlocks;
+        IndexType chunkStart = 0;
+        auto flush = [&]() {
+            if (not chunkBlocks.empty()) {
+                writePartitionSlice(partFile, globalN, k, chunkStart, chunkBlocks);
+                chunkBlocks.clear();
+            }
+        };
+        forEachChunk([&](const IndexType chunkBegin, IndexType) {
+            flush();
+            chunkStart = chunkBegin;
+        }, [&](IndexType, const double* point, const ValueType weight) {
+            const IndexType block = useSFC ? std::upper_bound(splitters.begin(), splitters.end(), getHilbertIndex(point)) - splitters.begin() : nearestCenter(point);
+            chunkBlocks.push_back(block);
+            blockWeights[block] += weight;
+        });
+        flush();
+    }
+    comm->synchronize();
+
+    comm->sumImpl( blockWeights.data(), blockWeights.data(), k, scai::common::TypeTraits<ValueType>::stype );
+    const ValueType optWeight = std::accumulate(blockWeights.begin(), blockWeights.end(), ValueType(0)) / k;
+    const ValueType imbalance = (*std::max_element(blockWeights.begin(), blockWeights.end()) - optWeight) / optWeight;
+    PRINT0("Streaming partition written to " << partFile << ", imbalance " << imbalance);
+
+    return imbalance;
+}
+//---------------------------------------------------------------------------------------
+
+template class StreamingPartition<IndexType, double>;
+template class StreamingPartition<IndexType, float>;
+
+} //namespace ITI
@@ -0,0 +1,118 @@
+/*
+ * StreamingPartition.h
+ *
+ * Partitioning of point sets that are too large to be held in memory more than once, read in slices from binary files.
+ */
+
+#pragma once
+
+#include <scai/dmemo/Communicator.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Settings.h"
+
+namespace ITI {
+
+/** @brief Geometric partitioning of a binary coordinate file without a graph and without coordinate vectors.
+
+The coordinate file has the format read by FileIO::readCoordsBinary: three doubles per point, the unused ones are 0 for
+fewer dimensions. The optional weight file has one double per point. Every PE processes the block-distributed range of
+the points in chunks of chunkSize points, each chunk is memory-mapped only while it is processed.
+
+The partition is computed in two sweeps over the local range:
+- The first sweep gets the bounding box and a sample of about settings.streamingSampleSize evenly spaced points.
+- From the sample, either the splitters of the Hilbert curve (settings.initialPartition is geoSFC) or the centers and
+  influence values of balanced k-means (otherwise) are computed. Only the sample is held in memory.
+- The second sweep assigns every point to the block whose splitter interval contains its Hilbert index, or to the
+  center with the smallest effective distance, and writes the block IDs of the chunk to the partition file.
+
+The partition file is a text file in the format of FileIO::readPartition, with the block IDs padded to the same width,
+so every PE writes its lines at a known offset without collecting the partition.
+*/
+
+template <typename IndexType, typename ValueType>
+class StreamingPartition {
+public:
+    /** @brief A read-only memory mapping of a range of a binary file of doubles. Unmapped on destruction. */
+    class MappedSlice {
+    public:
+        /**
+        @param[in] filename The binary file.
+        @param[in] firstValue Index of the first double of the range.
+        @param[in] numValues Number of doubles of the range.
+        */
+        MappedSlice(const std::string filename, const std::size_t firstValue, const std::size_t numValues);
+        ~MappedSlice();
+
+        MappedSlice(const MappedSlice&) = delete;
+        MappedSlice& operator=(const MappedSlice&) = delete;
+
+        /** @return The doubles of the range. */
+        const double* data() const {
+            return values;
+        }
+
+    private:
+        void* mapping = nullptr;
+        std::size_t mappedBytes = 0;
+        const double* values = nullptr;
+    };
+
+    /** @return The number of points in a binary coordinate file, from its size. */
+    static IndexType getNumPoints(const std::string coordFile);
+
+    /** @brief Partitions the points of a binary coordinate file into settings.numBlocks blocks. Global operation.
+
+    @param[in] coordFile Binary coordinate file, three doubles per point.
+    @param[in] weightFile Binary file with one weight per point, or "-" for unit weights.
+    @param[in] partFile The partition is written to this file.
+    @param[in] settings Settings struct, settings.dimensions must be at most 3.
+    @param[in] comm The communicator; every PE processes a contiguous range of the points.
+
+    @return The imbalance of the partition.
+    */
+    static ValueType partitionFile(const std::string coordFile, const std::string weightFile, const std::string partFile, Settings settings, const scai::dmemo::CommunicatorPtr comm);
+
+    /** @brief The splitters of a weighted sample of Hilbert indices. Global operation.
+
+    Splitter j is the index of the first sample point after the sample points that make up (j+1)/k of the sample weight.
+    A point with index x belongs to block b, the number of splitters that are at most x.
+
+    @param[in] localKeys Hilbert indices of the local sample points.
+    @param[in] localWeights Weights of the local sample points.
+    @param[in] k Number of blocks.
+    @param[in] comm Communicator.
+
+    @return k-1 replicated splitters, sorted.
+    */
+    static std::vector<double> getSplitters(const std::vector<double>& localKeys, const std::vector<ValueType>& localWeights, const IndexType k, const scai::dmemo::CommunicatorPtr comm);
+
+    /** @brief Writes the block IDs of a range of points into a partition file. Local operation.
+
+    All lines have the width of the largest block ID, so the position of point i in the file is known. The file must
+    exist; PE 0 creates it and writes the header in partitionFile.
+
+    @param[in] partFile The partition file.
+    @param[in] globalN Total number of points.
+    @param[in] k Number of blocks.
+    @param[in] firstIndex Index of the first point of the range.
+    @param[in] blocks The block IDs of the range.
+    */
+    static void writePartitionSlice(const std::string partFile, const IndexType globalN, const IndexType k, const IndexType firstIndex, const std::vector<IndexType>& blocks);
+
+    /** Number of points per chunk, i.e., per mapped slice. */
+    static constexpr IndexType chunkSize = 1 << 20;
+
+    /** Number of doubles per point in the coordinate file. */
+    static constexpr IndexType fileDimensions = 3;
+
+private:
+    /** The header of the partition file and the width of a line without the line break. */
+    static std::string getHeader(const IndexType globalN);
+    static IndexType getLineWidth(const IndexType k);
+};
+
+} //namespace ITI
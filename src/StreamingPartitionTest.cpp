@@ -0,0 +1,125 @@
+#include <scai/lama.hpp>
+
+#include <scai/dmemo/BlockDistribution.hpp>
+#include <scai/hmemo/ReadAccess.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+#include "gtest/gtest.h"
+#include "FileIO.h"
+#include "GraphUtils.h"
+#include "StreamingPartition.h"
+
+namespace ITI {
+
+template<typename T>
+class StreamingPartitionTest : public ::testing::Test {
+protected:
+    /** Writes n random points, three doubles each, and one weight per point. Only PE 0 writes. */
+    void writeRandomPoints(const IndexType n, const std::string coordFile, const std::string weightFile, const scai::dmemo::CommunicatorPtr comm) {
+        if (comm->getRank() == 0) {
+            std::mt19937 generator(42);
+            std::uniform_real_distribution<double> coordDist(0, 1);
+            std::uniform_real_distribution<double> weightDist(0.5, 1.5);
+            std::ofstream coords(coordFile, std::ios::binary | std::ios::out);
+            std::ofstream weights(weightFile, std::ios::binary | std::ios::out);
+            for (IndexType i = 0; i < n; i++) {
+                const double point[3] = {coordDist(generator), coordDist(generator), 0};
+                const double weight = weightDist(generator);
+                coords.write(reinterpret_cast<const char*>(point), sizeof(point));
+                weights.write(reinterpret_cast<const char*>(&weight), sizeof(weight));
+            }
+        }
+        comm->synchronize();
+    }
+};
+
+using testTypes = ::testing::Types<double,float>;
+TYPED_TEST_SUITE(StreamingPartitionTest, testTypes);
+
+//-----------------------------------------------------------------
+
+TYPED_TEST(StreamingPartitionTest, testPartitionFile) {
+    using ValueType = TypeParam;
+
+    const scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType n = 20000;
+    const std::string coordFile = "streamingTest.xyz.bin";
+    const std::string weightFile = "streamingTest.weights.bin";
+    const std::string partFile = "streamingTest.part";
+    this->writeRandomPoints(n, coordFile, weightFile, comm);
+
+    EXPECT_EQ( (StreamingPartition<IndexType, ValueType>::getNumPoints(coordFile)), n );
+
+    Settings settings;
+    settings.dimensions = 2;
+    settings.numBlocks = 2*comm->getSize() + 3;
+    settings.epsilon = 0.05;
+    settings.streamingSampleSize = n/4;
+
+    //the weights of the local points, in the block distribution of FileIO::readPartition
+    const scai::dmemo::DistributionPtr dist(new scai::dmemo::BlockDistribution(n, comm));
+    std::vector<double> localWeights(dist->getLocalSize());
+    {
+        std::ifstream file(weightFile, std::ios::binary | std::ios::in);
+        file.seekg(dist->local2Global(0)*sizeof(double));
+        file.read(reinterpret_cast<char*>(localWeights.data()), localWeights.size()*sizeof(double));
+    }
+    const DenseVector<ValueType> weights(dist, scai::hmemo::HArray<ValueType>(localWeights.size(), std::vector<ValueType>(localWeights.begin(), localWeights.end()).data()));
+
+    for (const Tool tool : {Tool::geoSFC, Tool::geoKmeans}) {
+        settings.initialPartition = tool;
+        const ValueType imbalance = StreamingPartition<IndexType, ValueType>::partitionFile(coordFile, weightFile, partFile, settings, comm);
+
+        const DenseVector<IndexType> part = FileIO<IndexType, ValueType>::readPartition(partFile, n);
+        EXPECT_GE( part.min(), 0 );
+        EXPECT_LT( part.max(), settings.numBlocks );
+
+        //the returned imbalance is the one of the written partition
+        const ValueType writtenImbalance = GraphUtils<IndexType, ValueType>::computeImbalance(part, settings.numBlocks, weights);
+        EXPECT_NEAR( imbalance, writtenImbalance, 1e-3 );
+
+        //the blocks are computed from a sample, so the balance is only approximate
+        EXPECT_LE( imbalance, 0.2 ) << "for tool " << tool;
+    }
+
+    //a weight file with the wrong number of values is rejected
+    const std::string shortWeightFile = "streamingTest.short.bin";
+    if (comm->getRank() == 0) {
+        std::ofstream shortWeights(shortWeightFile, std::ios::binary | std::ios::out);
+        const double weight = 1;
+        shortWeights.write(reinterpret_cast<const char*>(&weight), sizeof(weight));
+    }
+    comm->synchronize();
+    EXPECT_THROW( (StreamingPartition<IndexType, ValueType>::partitionFile(coordFile, shortWeightFile, partFile, settings, comm)), std::runtime_error );
+
+    comm->synchronize();
+    if (comm->getRank() == 0) {
+        for (const std::string file : {coordFile, weightFile, partFile, shortWeightFile}) {
+            std::remove(file.c_str());
+        }
+    }
+}
+//-----------------------------------------------------------------
+
+TYPED_TEST(StreamingPartitionTest, testGetSplitters) {
+    using ValueType = TypeParam;
+
+    const scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType k = 4;
+
+    //every PE has the keys rank, rank+p, rank+2p, ... of 0,...,99 with unit weights
+    std::vector<double> keys;
+    for (IndexType key = comm->getRank(); key < 100; key += comm->getSize()) {
+        keys.push_back(key);
+    }
+    const std::vector<ValueType> weights(keys.size(), 1);
+
+    const std::vector<double> splitters = StreamingPartition<IndexType, ValueType>::getSplitters(keys, weights, k, comm);
+    ASSERT_EQ( splitters.size(), k-1 );
+    EXPECT_EQ( splitters, std::vector<double>({25, 50, 75}) );
+}
+
+} //namespace ITI
@@ -0,0 +1,263 @@
+/*
+ * Telemetry.cpp
+ *
+ * Per-phase timers and counters of a run, aggregated over all PEs and threads and written as JSON.
+ */
+
+#include <scai/common/TypeTraits.hpp>
+#include <scai/tracing.hpp>
+
+#include <omp.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <set>
+
+#include "Telemetry.h"
+
+namespace ITI {
+
+std::map<std::string, Telemetry::Timer> Telemetry::timers;
+std::map<std::string, double> Telemetry::counters;
+std::mutex Telemetry::mutex;
+
+namespace {
+
+/** The name as a JSON string. */
+std::string quote(const std::string& name) {
+    std::string result = "\"";
+    for (const char c : name) {
+        if (c == '"' or c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result + "\"";
+}
+
+} // anonymous namespace
+
+//---------------------------------------------------------------------------------------
+
+Telemetry::ScopedTimer::ScopedTimer(const std::string& name) : name(name), start(std::chrono::steady_clock::now()) {
+}
+
+Telemetry::ScopedTimer::~ScopedTimer() {
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    addTime(name, elapsed.count());
+}
+//---------------------------------------------------------------------------------------
+
+void Telemetry::addTime(const std::string& name, const double seconds) {
+    const int thread = omp_get_thread_num();
+    std::lock_guard<std::mutex> lock(mutex);
+    Timer& timer = timers[name];
+    timer.calls++;
+    timer.threadSeconds[thread] += seconds;
+}
+//---------------------------------------------------------------------------------------
+
+void Telemetry::addCounter(const std::string& name, const double value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters[name] += value;
+}
+//---------------------------------------------------------------------------------------
+
+double Telemetry::getCounter(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = counters.find(name);
+    return it == counters.end() ? 0 : it->second;
+}
+//---------------------------------------------------------------------------------------
+
+void Telemetry::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    timers.clear();
+    counters.clear();
+}
+//---------------------------------------------------------------------------------------
+
+long Telemetry::getPeakRSS() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // in kB on Linux
+}
+//---------------------------------------------------------------------------------------
+
+std::vector<std::string> Telemetry::mergeNames(const std::vector<std::string>& names, const scai::dmemo::CommunicatorPtr comm) {
+    const IndexType rootPE = 0;
+    const IndexType numPEs = comm->getSize();
+
+    //the names are sent as one array of characters, every name is terminated by 0
+    std::vector<IndexType> myChars;
+    for (const std::string& name : names) {
+        myChars.insert(myChars.end(), name.begin(), name.end());
+        myChars.push_back(0);
+    }
+    const IndexType mySize = myChars.size();
+
+    std::vector<IndexType> allSizes(numPEs, 0);
+    allSizes[comm->getRank()] = mySize;
+    comm->sumImpl( allSizes.data(), allSizes.data(), numPEs, scai::common::TypeTraits<IndexType>::stype );
+
+    const IndexType sumSize = std::accumulate(allSizes.begin(), allSizes.end(), IndexType(0));
+    std::vector<IndexType> allChars(comm->getRank() == rootPE ? std::max<IndexType>(sumSize, 1) : 1);
+    comm->gatherV( allChars.data(), mySize, rootPE, myChars.data(), allSizes.data() );
+
+    std::vector<IndexType> mergedChars;
+    if (comm->getRank() == rootPE) {
+        std::set<std::string> merged;
+        std::string current;
+        for (IndexType i = 0; i < sumSize; i++) {
+            if (allChars[i] == 0) {
+                merged.insert(current);
+                current.clear();
+            } else {
+                current += char(allChars[i]);
+            }
+        }
+        for (const std::string& name : merged) {
+            mergedChars.insert(mergedChars.end(), name.begin(), name.end());
+            mergedChars.push_back(0);
+        }
+    }
+
+    IndexType mergedSize = mergedChars.size();
+    comm->bcast( &mergedSize, 1, rootPE );
+    mergedChars.resize(std::max<IndexType>(mergedSize, 1));
+    comm->bcast( mergedChars.data(), mergedSize, rootPE );
+
+    std::vector<std::string> result;
+    std::string current;
+    for (IndexType i = 0; i < mergedSize; i++) {
+        if (mergedChars[i] == 0) {
+            result.push_back(current);
+            current.clear();
+        } else {
+            current += char(mergedChars[i]);
+        }
+    }
+    return result;
+}
+//---------------------------------------------------------------------------------------
+
+void Telemetry::writeJSON(std::ostream& out, const scai::dmemo::CommunicatorPtr comm, const std::map<std::string, double>& metrics) {
+    SCAI_REGION( "Telemetry.writeJSON" )
+
+    std::map<std::string, Timer> myTimers;
+    std::map<std::string, double> myCounters;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        myTimers = timers;
+        myCounters = counters;
+    }
+
+    std::vector<std::string> myTimerNames, myCounterNames;
+    for (const auto& timer : myTimers) {
+        myTimerNames.push_back(timer.first);
+    }
+    for (const auto& counter : myCounters) {
+        myCounterNames.push_back(counter.first);
+    }
+    const std::vector<std::string> timerNames = mergeNames(myTimerNames, comm);
+    const std::vector<std::string> counterNames = mergeNames(myCounterNames, comm);
+
+    /*
+     * every value is reduced with sum, max and min; the minimum is the negated maximum of the negated values
+     * a PE that did not record a timer does not take part in its statistics, a missing counter is 0
+     */
+    const double lowest = std::numeric_limits<double>::lowest();
+    std::vector<double> sums, maxima, negMinima;
+    auto addValue = [&](const bool recorded, const double value) {
+        sums.push_back(recorded ? value : 0);
+        maxima.push_back(recorded ? value : lowest);
+        negMinima.push_back(recorded ? -value : lowest);
+    };
+
+    const int numThreads = omp_get_max_threads();
+    for (const std::string& name : timerNames) {
+        const auto it = myTimers.find(name);
+        const bool recorded = it != myTimers.end();
+        double maxThread = 0, minThread = 0, sumThread = 0;
+        if (recorded) {
+            minThread = std::numeric_limits<double>::max();
+            for (const auto& thread : it->second.threadSeconds) {
+                maxThread = std::max(maxThread, thread.second);
+                minThread = std::min(minThread, thread.second);
+                sumThread += thread.second;
+            }
+        }
+        addValue(true, recorded);
+        addValue(true, recorded ? it->second.calls : 0);
+        addValue(recorded, maxThread); // the time of a PE is the time of its slowest thread
+        addValue(recorded, minThread);
+        addValue(recorded, recorded ? sumThread / it->second.threadSeconds.size() : 0);
+        addValue(recorded, maxThread);
+    }
+    for (const std::string& name : counterNames) {
+        const auto it = myCounters.find(name);
+        addValue(true, it != myCounters.end() ? it->second : 0);
+    }
+    addValue(true, getPeakRSS());
+
+    const IndexType numValues = sums.size();
+    comm->sumImpl( sums.data(), sums.data(), numValues, scai::common::TypeTraits<double>::stype );
+    comm->maxImpl( maxima.data(), maxima.data(), numValues, scai::common::TypeTraits<double>::stype );
+    comm->maxImpl( negMinima.data(), negMinima.data(), numValues, scai::common::TypeTraits<double>::stype );
+
+    if (comm->getRank() != 0) {
+        return;
+    }
+
+    const IndexType numPEs = comm->getSize();
+    IndexType v = 0;
+    auto writeStats = [&](const IndexType count) {
+        out << "\"min\": " << -negMinima[v] << ", \"mean\": " << (count > 0 ? sums[v] / count : 0) << ", \"max\": " << maxima[v];
+        v++;
+    };
+
+    const auto oldPrecision = out.precision(std::numeric_limits<double>::max_digits10);
+    out << "{" << std::endl;
+    out << "  \"numRanks\": " << numPEs << "," << std::endl;
+    out << "  \"numThreads\": " << numThreads << "," << std::endl;
+
+    out << "  \"timers\": {";
+    for (IndexType t = 0; t < IndexType(timerNames.size()); t++) {
+        const IndexType ranks = sums[v];
+        v++;
+        out << (t > 0 ? "," : "") << std::endl << "    " << quote(timerNames[t]) << ": {\"ranks\": " << ranks << ", \"calls\": " << sums[v] << ", ";
+        v++;
+        writeStats(ranks);
+        //the thread statistics: the minimum and maximum over all threads of all PEs and the mean over the PEs of the thread means
+        out << ", \"threadMin\": " << -negMinima[v] << ", \"threadMean\": " << (ranks > 0 ? sums[v+1] / ranks : 0) << ", \"threadMax\": " << maxima[v+2] << "}";
+        v += 3;
+    }
+    out << std::endl << "  }," << std::endl;
+
+    out << "  \"counters\": {";
+    for (IndexType c = 0; c < IndexType(counterNames.size()); c++) {
+        out << (c > 0 ? "," : "") << std::endl << "    " << quote(counterNames[c]) << ": {\"sum\": " << sums[v] << ", ";
+        writeStats(numPEs);
+        out << "}";
+    }
+    out << std::endl << "  }," << std::endl;
+
+    out << "  \"peakRSS_kB\": {";
+    writeStats(numPEs);
+    out << "}," << std::endl;
+
+    out << "  \"metrics\": {";
+    bool first = true;
+    for (const auto& metric : metrics) {
+        out << (first ? "" : ",") << std::endl << "    " << quote(metric.first) << ": " << metric.second;
+        first = false;
+    }
+    out << std::endl << "  }" << std::endl;
+    out << "}" << std::endl;
+    out.precision(oldPrecision);
+}
+//---------------------------------------------------------------------------------------
+
+} //namespace ITI
@@ -0,0 +1,85 @@
+/*
+ * Telemetry.h
+ *
+ * Per-phase timers and counters of a run, aggregated over all PEs and threads and written as JSON.
+ */
+
+#pragma once
+
+#include <scai/dmemo/Communicator.hpp>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Settings.h"
+
+namespace ITI {
+
+/** @brief Collects timers and counters of the phases of a run, e.g., the initial partition, k-means, local refinement or a migration.
+
+Timers and counters are identified by their name and are recorded locally, i.e., without communication, so they can be used
+anywhere, also inside OpenMP parallel regions and in code that is only executed by some PEs. A timer keeps the time of every
+thread separately; the time of a PE is the time of its slowest thread. Counters should be summed locally first, e.g., after
+a loop, since every call takes a lock.
+
+writeJSON() is the only global operation: the names are merged over all PEs and every timer and counter is reduced to its
+minimum, mean and maximum over the PEs that recorded it, so imbalances between PEs and between threads are visible.
+*/
+
+class Telemetry {
+public:
+    /** @brief Adds the time between its construction and destruction to the timer with the given name. */
+    class ScopedTimer {
+    public:
+        ScopedTimer(const std::string& name);
+        ~ScopedTimer();
+
+    private:
+        std::string name;
+        std::chrono::time_point<std::chrono::steady_clock> start;
+    };
+
+    /** @brief Adds seconds to the timer with the given name for the calling thread. Local operation. */
+    static void addTime(const std::string& name, const double seconds);
+
+    /** @brief Adds value to the counter with the given name. Local operation. */
+    static void addCounter(const std::string& name, const double value);
+
+    /** @brief The current value of a counter of this PE, 0 if it was never set. Local operation. */
+    static double getCounter(const std::string& name);
+
+    /** @brief Removes all timers and counters, e.g., between two runs. Local operation. */
+    static void reset();
+
+    /** @return The peak resident set size of this process in kB. */
+    static long getPeakRSS();
+
+    /** @brief Writes all timers and counters, aggregated over all PEs, and the given metrics as one JSON object. Global operation.
+
+    Only the root PE writes; all PEs must call it.
+
+    @param[in] out The stream to write to, only used on PE 0.
+    @param[in] comm The communicator of all PEs that recorded data.
+    @param[in] metrics Additional values of the run, e.g., the quality metrics; written unchanged.
+    */
+    static void writeJSON(std::ostream& out, const scai::dmemo::CommunicatorPtr comm, const std::map<std::string, double>& metrics = {});
+
+private:
+    struct Timer {
+        IndexType calls = 0;
+        std::map<int, double> threadSeconds; // thread id -> accumulated seconds
+    };
+
+    /** The sorted union of the given names of all PEs. Global operation. */
+    static std::vector<std::string> mergeNames(const std::vector<std::string>& names, const scai::dmemo::CommunicatorPtr comm);
+
+    static std::map<std::string, Timer> timers;
+    static std::map<std::string, double> counters;
+    static std::mutex mutex;
+};
+
+} //namespace ITI
@@ -5,6 +5,7 @@
 
 #include <scai/dmemo/BlockDistribution.hpp>
 #include <scai/dmemo/Distribution.hpp>
+#include <scai/dmemo/CyclicDistribution.hpp>
 
 #include <scai/hmemo/Context.hpp>
 #include <scai/hmemo/HArray.hpp>
@@ -15,6 +16,7 @@
 #include <memory>
 #include <cstdlib>
 #include <numeric>
+#include <sstream>
 #include <chrono>
 #include <vector>
 
@@ -25,8 +27,10 @@
 #include "SpectralPartition.h"
 #include "GraphUtils.h"
 #include "AuxiliaryFunctions.h"
+#include "Migration.h"
 #include "KMeans.h"
 #include "Metrics.h"
+#include "Telemetry.h"
 
 #include "gtest/gtest.h"
 
@@ -483,6 +487,148 @@ TYPED_TEST(auxTest, testRedistributeFromPartition) {
 }
 
 
+TYPED_TEST(auxTest, testRenumberBlocksToPEs) {
+    using ValueType = TypeParam;
+
+    const scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType numPEs = comm->getSize();
+    const IndexType thisPE = comm->getRank();
+    const IndexType N = 100*numPEs;
+    const scai::dmemo::DistributionPtr dist( new scai::dmemo::BlockDistribution(N, comm) );
+
+    // most points of every PE are in the block of the next PE, a few in the block of the previous one
+    DenseVector<IndexType> partition( dist, (thisPE+1)%numPEs );
+    {
+        scai::hmemo::WriteAccess<IndexType> wPart( partition.getLocalValues() );
+        for (IndexType i = 0; i < wPart.size(); i += 10) {
+            wPart[i] = (thisPE+numPEs-1)%numPEs;
+        }
+    }
+
+    Settings settings;
+    const std::vector<IndexType> renumbering = aux<IndexType,ValueType>::renumberBlocksToPEs( partition, settings );
+
+    ASSERT_EQ( numPEs, renumbering.size() );
+    std::vector<IndexType> sorted( renumbering );
+    std::sort( sorted.begin(), sorted.end() );
+    for (IndexType b = 0; b < numPEs; b++) {
+        EXPECT_EQ( b, sorted[b] );
+    }
+    // every PE keeps its heaviest block
+    EXPECT_EQ( thisPE, renumbering[(thisPE+1)%numPEs] );
+
+    // with a single round, the leftover blocks are paired greedily and the result is still a permutation
+    const std::vector<IndexType> oneRound = aux<IndexType,ValueType>::renumberBlocksToPEs( partition, settings, 4, 1 );
+    sorted = oneRound;
+    std::sort( sorted.begin(), sorted.end() );
+    for (IndexType b = 0; b < numPEs; b++) {
+        EXPECT_EQ( b, sorted[b] );
+    }
+    // in the first round every block is offered to its heaviest proposer
+    EXPECT_EQ( thisPE, oneRound[(thisPE+1)%numPEs] );
+}
+//-----------------------------------------------------------------
+
+TYPED_TEST(auxTest, testMigrationAgreesWithRedistribute) {
+    using ValueType = TypeParam;
+
+    std::string file = auxTest<ValueType>::graphPath + "trace-00008.graph";
+    const IndexType dimensions = 2;
+    const scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+
+    CSRSparseMatrix<ValueType> graph = FileIO<IndexType, ValueType>::readGraph(file, comm);
+    const IndexType N = graph.getNumRows();
+    std::vector<DenseVector<ValueType>> coordinates = FileIO<IndexType, ValueType>::readCoords( std::string(file + ".xyz"), N, dimensions, comm);
+    DenseVector<IndexType> ids( graph.getRowDistributionPtr(), 0 );
+    graph.getRowDistributionPtr()->getOwnedIndexes( ids.getLocalValues() );
+
+    const scai::dmemo::DistributionPtr target( new scai::dmemo::CyclicDistribution(N, 3, comm) );
+
+    // reference: one LAMA redistribution per object
+    CSRSparseMatrix<ValueType> refGraph = graph;
+    refGraph.redistribute( target, graph.getColDistributionPtr() );
+    std::vector<DenseVector<ValueType>> refCoordinates = coordinates;
+    for (IndexType d = 0; d < dimensions; d++) {
+        refCoordinates[d].redistribute( target );
+    }
+
+    Migration<IndexType, ValueType>::migrateToDistribution( target, &graph, {&coordinates[0], &coordinates[1]}, {&ids} );
+
+    ASSERT_TRUE( graph.getRowDistributionPtr()->isEqual(*target) );
+    ASSERT_TRUE( ids.getDistributionPtr()->isEqual(*target) );
+    const IndexType localN = target->getLocalSize();
+
+    {
+        scai::hmemo::ReadAccess<IndexType> rIds( ids.getLocalValues() );
+        for (IndexType i = 0; i < localN; i++) {
+            EXPECT_EQ( target->local2Global(i), rIds[i] );
+        }
+    }
+    for (IndexType d = 0; d < dimensions; d++) {
+        scai::hmemo::ReadAccess<ValueType> rCoords( coordinates[d].getLocalValues() );
+        scai::hmemo::ReadAccess<ValueType> rRef( refCoordinates[d].getLocalValues() );
+        for (IndexType i = 0; i < localN; i++) {
+            EXPECT_EQ( rRef[i], rCoords[i] );
+        }
+    }
+
+    // the rows must have the same neighbors, in any order
+    const scai::lama::CSRStorage<ValueType>& storage = graph.getLocalStorage();
+    const scai::lama::CSRStorage<ValueType>& refStorage = refGraph.getLocalStorage();
+    scai::hmemo::ReadAccess<IndexType> ia( storage.getIA() ), refIA( refStorage.getIA() );
+    scai::hmemo::ReadAccess<IndexType> ja( storage.getJA() ), refJA( refStorage.getJA() );
+    for (IndexType i = 0; i < localN; i++) {
+        std::vector<IndexType> neighbors( ja.get()+ia[i], ja.get()+ia[i+1] );
+        std::vector<IndexType> refNeighbors( refJA.get()+refIA[i], refJA.get()+refIA[i+1] );
+        std::sort( neighbors.begin(), neighbors.end() );
+        std::sort( refNeighbors.begin(), refNeighbors.end() );
+        EXPECT_EQ( refNeighbors, neighbors );
+    }
+}
+//-----------------------------------------------------------------
+
+TYPED_TEST(auxTest, testTelemetryJSON) {
+    using ValueType = TypeParam;
+
+    std::string file = auxTest<ValueType>::graphPath + "trace-00008.graph";
+    const IndexType dimensions = 2;
+    const scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+
+    CSRSparseMatrix<ValueType> graph = FileIO<IndexType, ValueType>::readGraph(file, comm);
+    const IndexType N = graph.getNumRows();
+    std::vector<DenseVector<ValueType>> coordinates = FileIO<IndexType, ValueType>::readCoords( std::string(file + ".xyz"), N, dimensions, comm);
+
+    Telemetry::reset();
+    const scai::dmemo::DistributionPtr target( new scai::dmemo::CyclicDistribution(N, 3, comm) );
+    Migration<IndexType, ValueType>::migrateToDistribution( target, &graph, {&coordinates[0], &coordinates[1]}, {} );
+    EXPECT_EQ( 3, Telemetry::getCounter("Migration.collectives") );
+
+    // a timer that only rank 0 records and a counter with a different value on every rank
+    if (comm->getRank() == 0) {
+        Telemetry::ScopedTimer timer("onlyRoot");
+    }
+    Telemetry::addCounter("rank", comm->getRank());
+
+    std::ostringstream out;
+    Telemetry::writeJSON( out, comm, {{"finalCut", 42}} );
+
+    if (comm->getRank() == 0) {
+        const std::string json = out.str();
+        const IndexType p = comm->getSize();
+        EXPECT_NE( json.find("\"numRanks\": " + std::to_string(p)), std::string::npos );
+        EXPECT_NE( json.find("\"Migration.migrate\": {\"ranks\": " + std::to_string(p) + ", \"calls\": " + std::to_string(p)), std::string::npos );
+        EXPECT_NE( json.find("\"onlyRoot\": {\"ranks\": 1, \"calls\": 1"), std::string::npos );
+        EXPECT_NE( json.find("\"rank\": {\"sum\": " + std::to_string(p*(p-1)/2) + ", \"min\": 0, "), std::string::npos );
+        EXPECT_NE( json.find("\"Migration.bytesSent\""), std::string::npos );
+        EXPECT_NE( json.find("\"peakRSS_kB\""), std::string::npos );
+        EXPECT_NE( json.find("\"finalCut\": 42"), std::string::npos );
+    } else {
+        EXPECT_TRUE( out.str().empty() );
+    }
+    Telemetry::reset();
+}
+//-----------------------------------------------------------------
+
 TYPED_TEST(auxTest, benchmarkRedistributeFromPartition) {
 
     using ValueType = TypeParam;
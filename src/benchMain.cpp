@@ -0,0 +1,334 @@
+#include <scai/lama.hpp>
+
+#include <scai/dmemo/BlockDistribution.hpp>
+#include <scai/dmemo/Distribution.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <sstream>
+
+#include <omp.h>
+
+#include <cxxopts.hpp>
+
+#include "FileIO.h"
+#include "GraphUtils.h"
+#include "HilbertCurve.h"
+#include "KMeans.h"
+#include "LocalRefinement.h"
+#include "MultiLevel.h"
+#include "MultiSection.h"
+#include "ParcoRepart.h"
+#include "Settings.h"
+#include "Metrics.h"
+#include "parseArgs.h"
+#include "mainHeader.h"
+
+/**
+ *  GeographerBench runs the phases of the partitioner in isolation, every phase on the same input, and reports
+ *  the time, the throughput and the scaling efficiency of every phase.
+ *
+ *  Examples of use:
+ *
+ *  strong scaling of all phases on a generated 1000x1000 mesh, compared to an earlier run on 4 PEs:
+ *  ./GeographerBench --generate --numX=1000 --numY=1000 --dimensions=2 --numBlocks=16 --repeatTimes=5 --benchFile=p16.bench --baselineFile=p4.bench
+ *
+ *  weak scaling of k-means and the SFC with 1M points per PE:
+ *  ./GeographerBench --generate --pointsPerPE=1000000 --dimensions=3 --phases=sfc,kmeans --scaling=weak --benchFile=p16.bench --baselineFile=p1.bench
+ *
+ *  The inputs are identical for identical options, so the output files of different releases or machines can be compared directly.
+ */
+
+namespace {
+
+using ITI::IndexType;
+
+const std::vector<std::string> allPhases = {"sfc", "kmeans", "kmeansMixed", "hierKmeans", "multisection", "coarsening", "fm", "labelProp", "metrics", "io"};
+
+/** Runs setup() and run() warmup+repetitions times and returns the times of run() for the repetitions.
+ *  The time of a repetition is the time of the slowest PE. */
+std::vector<double> timePhase( const std::function<void()>& setup, const std::function<void()>& run, const IndexType warmup, const IndexType repetitions, const scai::dmemo::CommunicatorPtr comm) {
+    std::vector<double> times;
+    for (IndexType r = 0; r < warmup + repetitions; r++) {
+        setup();
+        comm->synchronize();
+        std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const double time = comm->max( elapsed.count() );
+        if (r >= warmup) {
+            times.push_back(time);
+        }
+    }
+    return times;
+}
+
+/** The mean time of every phase in a file written by an earlier run, and the number of PEs of that run. */
+std::map<std::string, std::pair<IndexType, double>> readBaseline( const std::string& fileName ) {
+    std::map<std::string, std::pair<IndexType, double>> baseline;
+    std::ifstream file( fileName );
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open baseline file " + fileName);
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() or line[0] == '#') {
+            continue;
+        }
+        std::istringstream tokens(line);
+        std::string phase;
+        IndexType numPEs, numThreads, N, M, repetitions;
+        double minTime, meanTime;
+        tokens >> phase >> numPEs >> numThreads >> N >> M >> repetitions >> minTime >> meanTime;
+        if (!tokens.fail()) {
+            baseline[phase] = std::make_pair(numPEs, meanTime);
+        }
+    }
+    return baseline;
+}
+
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+
+    using namespace ITI;
+    typedef double ValueType;   //use double
+
+    scai::dmemo::CommunicatorPtr comm = scai::dmemo::Communicator::getCommunicatorPtr();
+    const IndexType numPEs = comm->getSize();
+
+    const int prevArgc = argc; // options.parse(argc, argv) changed argc
+
+    cxxopts::Options options = ITI::populateOptions();
+    options.add_options("benchmark")
+    ("phases", "Comma separated list of the phases to run, default is all of: sfc,kmeans,kmeansMixed,hierKmeans,multisection,coarsening,fm,labelProp,metrics,io", cxxopts::value<std::string>())
+    ("warmup", "Number of untimed runs of every phase before the timed runs given by --repeatTimes", cxxopts::value<IndexType>()->default_value("1"))
+    ("pointsPerPE", "For weak scaling: with --generate, the mesh is chosen with about this many points per PE", cxxopts::value<IndexType>())
+    ("scaling", "strong or weak: how the efficiency is computed from the baseline", cxxopts::value<std::string>()->default_value("strong"))
+    ("baselineFile", "A file written with --benchFile by an earlier run; the efficiency of every phase is computed relative to it", cxxopts::value<std::string>())
+    ("benchFile", "Write the results into this file", cxxopts::value<std::string>())
+    ("ioFile", "Prefix of the temporary files of the io phase", cxxopts::value<std::string>()->default_value("geographerBench.tmp"))
+    ;
+    cxxopts::ParseResult vm = options.parse(argc, argv);
+
+    if (vm.count("help")) {
+        std::cout << options.help({"", "benchmark"}) << std::endl;
+        return 0;
+    }
+
+    Settings settings = initialize( prevArgc, argv, vm, comm);
+
+    if (vm.count("pointsPerPE")) {
+        SCAI_ASSERT_ERROR( vm.count("generate"), "--pointsPerPE can only be used with --generate" );
+        const IndexType side = std::round( std::pow( double(vm["pointsPerPE"].as<IndexType>())*numPEs, 1.0/settings.dimensions ) );
+        settings.numX = side;
+        settings.numY = side;
+        settings.numZ = side;
+    }
+
+    std::vector<std::string> phases = allPhases;
+    if (vm.count("phases")) {
+        phases.clear();
+        std::stringstream ss( vm["phases"].as<std::string>() );
+        std::string phase;
+        while (!std::getline(ss, phase, ',').fail()) {
+            if (std::find(allPhases.begin(), allPhases.end(), phase) == allPhases.end()) {
+                throw std::invalid_argument("Unknown phase " + phase);
+            }
+            phases.push_back(phase);
+        }
+    }
+    const std::string scaling = vm["scaling"].as<std::string>();
+    if (scaling != "strong" and scaling != "weak") {
+        throw std::invalid_argument("Scaling must be strong or weak, not " + scaling);
+    }
+    const IndexType warmup = vm["warmup"].as<IndexType>();
+    const IndexType repetitions = std::max<IndexType>( settings.repeatTimes, 1 );
+
+    printInfo( std::cout, comm, settings);
+
+    //---------------------------------------------------------
+    //
+    // generate or read the input, it is the same for all phases
+    //
+
+    scai::lama::CSRSparseMatrix<ValueType> graph;
+    std::vector<scai::lama::DenseVector<ValueType>> coordinates(settings.dimensions);
+    std::vector<scai::lama::DenseVector<ValueType>> nodeWeights;
+
+    const IndexType N = readInput<ValueType>( vm, settings, comm, graph, coordinates, nodeWeights );
+    const IndexType M = graph.getNumValues()/2;
+    const scai::dmemo::DistributionPtr inputDist = graph.getRowDistributionPtr();
+
+    ITI::CommTree<IndexType,ValueType> commTree;
+    commTree.createFlatHomogeneous( settings.numBlocks, nodeWeights.size() );
+    commTree.adaptWeights( nodeWeights );
+    const std::vector<std::vector<ValueType>> blockSizes = commTree.getBalanceVectors();
+
+    // the hierarchy for hierKmeans: the given levels or two levels, the first with the smallest factor of k
+    std::vector<IndexType> hierLevels = settings.hierLevels;
+    if (hierLevels.empty()) {
+        IndexType firstLevel = 2;
+        while (settings.numBlocks % firstLevel != 0) {
+            firstLevel++;
+        }
+        hierLevels = firstLevel < settings.numBlocks ? std::vector<IndexType>{firstLevel, settings.numBlocks/firstLevel} : std::vector<IndexType>{settings.numBlocks};
+    }
+    ITI::CommTree<IndexType,ValueType> hierTree;
+    hierTree.createFromLevels( hierLevels, nodeWeights.size() );
+    hierTree.adaptWeights( nodeWeights );
+
+    std::map<std::string, std::pair<IndexType, double>> baseline;
+    if (vm.count("baselineFile")) {
+        baseline = readBaseline( vm["baselineFile"].as<std::string>() );
+    }
+
+    //---------------------------------------------------------
+    //
+    // run every phase in isolation; the setup of every repetition is not timed
+    //
+
+    std::ostringstream results;
+    results << "# commit:" << version << " machine:" << settings.machine << " input:" << (vm.count("graphFile") ? vm["graphFile"].as<std::string>() : "generate")
+            << " p:" << numPEs << " k:" << settings.numBlocks << " warmup:" << warmup << " scaling:" << scaling << std::endl;
+    results << "# phase numPEs numThreads N M repetitions minTime meanTime maxTime pointsPerSec edgesPerSec efficiency" << std::endl;
+
+    for (const std::string& phase : phases) {
+        PRINT0("Benchmarking phase " << phase);
+
+        Metrics<ValueType> metrics(settings);
+        scai::lama::DenseVector<IndexType> partition;
+        scai::lama::CSRSparseMatrix<ValueType> phaseGraph;
+        std::vector<scai::lama::DenseVector<ValueType>> phaseCoordinates;
+        std::vector<scai::lama::DenseVector<ValueType>> phaseWeights;
+        scai::lama::DenseVector<IndexType> fineToCoarse;
+        scai::dmemo::HaloExchangePlan halo;
+        std::function<void()> setup = [](){};
+        std::function<void()> run;
+
+        if (phase == "sfc") {
+            run = [&](){ partition = HilbertCurve<IndexType,ValueType>::computePartition( coordinates, nodeWeights[0], settings ); };
+        } else if (phase == "kmeans") {
+            run = [&](){ partition = KMeans<IndexType,ValueType>::computePartition( coordinates, nodeWeights, blockSizes, settings, metrics ); };
+        } else if (phase == "kmeansMixed") {
+            // k-means with float coordinates, compare time and quality with kmeans
+            Settings mixedSettings = settings;
+            mixedSettings.mixedPrecision = true;
+            run = [&, mixedSettings](){ partition = KMeans<IndexType,ValueType>::computePartition( coordinates, nodeWeights, blockSizes, mixedSettings, metrics ); };
+        } else if (phase == "hierKmeans") {
+            // the hierarchical version redistributes its input
+            setup = [&](){ phaseCoordinates = coordinates; phaseWeights = nodeWeights; };
+            run = [&](){ partition = KMeans<IndexType,ValueType>::computeHierarchicalPartition( phaseCoordinates, phaseWeights, hierTree, settings, metrics ); };
+        } else if (phase == "multisection") {
+            run = [&](){ partition = MultiSection<IndexType,ValueType>::computePartition( graph, coordinates, nodeWeights[0], settings ); };
+        } else if (phase == "coarsening") {
+            halo = GraphUtils<IndexType,ValueType>::buildNeighborHalo( graph );
+            run = [&](){ MultiLevel<IndexType,ValueType>::coarsen( graph, nodeWeights[0], halo, coordinates, phaseGraph, fineToCoarse, settings, settings.coarseningStepsBetweenRefinement ); };
+        } else if (phase == "fm") {
+            if (numPEs != settings.numBlocks) {
+                PRINT0("Skipping phase fm, it needs as many PEs as blocks");
+                continue;
+            }
+            // refine an SFC partition; the input is moved to its blocks once, every repetition starts from a copy
+            scai::lama::CSRSparseMatrix<ValueType> blockGraph = graph;
+            std::vector<scai::lama::DenseVector<ValueType>> blockCoordinates = coordinates;
+            std::vector<scai::lama::DenseVector<ValueType>> blockWeights = nodeWeights;
+            scai::lama::DenseVector<IndexType> initialPartition = HilbertCurve<IndexType,ValueType>::computePartition( coordinates, nodeWeights[0], settings );
+            initialPartition.redistribute( inputDist );
+            aux<IndexType,ValueType>::redistributeFromPartition( initialPartition, blockGraph, blockCoordinates, blockWeights, settings );
+            setup = [&, blockGraph, blockCoordinates, blockWeights, initialPartition](){
+                phaseGraph = blockGraph;
+                phaseCoordinates = blockCoordinates;
+                phaseWeights = blockWeights;
+                partition = initialPartition;
+            };
+            // the input is already distributed by the blocks, so the refinement is the multilevel step of ParcoRepart::partitionGraph
+            run = [&](){
+                const scai::dmemo::HaloExchangePlan halo = GraphUtils<IndexType,ValueType>::buildNeighborHalo( phaseGraph );
+                MultiLevel<IndexType,ValueType>::multiLevelStep( phaseGraph, partition, phaseWeights, phaseCoordinates, halo, settings, metrics );
+            };
+        } else if (phase == "labelProp") {
+            // refine an SFC partition without redistribution, for any number of blocks; compare time and quality with fm
+            scai::lama::DenseVector<IndexType> initialPartition = HilbertCurve<IndexType,ValueType>::computePartition( coordinates, nodeWeights[0], settings );
+            initialPartition.redistribute( inputDist );
+            setup = [&, initialPartition](){ partition = initialPartition; };
+            run = [&](){ LocalRefinement<IndexType,ValueType>::labelPropagation( graph, partition, nodeWeights[0], settings ); };
+        } else if (phase == "metrics") {
+            scai::lama::DenseVector<IndexType> sfcPartition = HilbertCurve<IndexType,ValueType>::computePartition( coordinates, nodeWeights[0], settings );
+            sfcPartition.redistribute( inputDist );
+            setup = [&](){ metrics = Metrics<ValueType>(settings); };
+            run = [&, sfcPartition](){ metrics.getMetrics( graph, sfcPartition, nodeWeights, settings ); };
+        } else if (phase == "io") {
+            // read the graph and the coordinates that were written before
+            const std::string ioFile = vm["ioFile"].as<std::string>();
+            FileIO<IndexType,ValueType>::writeGraph( graph, ioFile );
+            FileIO<IndexType,ValueType>::writeCoords( coordinates, ioFile + ".xyz" );
+            comm->synchronize();
+            run = [&](){
+                phaseGraph = FileIO<IndexType,ValueType>::readGraph( ioFile, comm );
+                phaseCoordinates = FileIO<IndexType,ValueType>::readCoords( ioFile + ".xyz", N, settings.dimensions, comm );
+            };
+        }
+
+        const std::vector<double> times = timePhase( setup, run, warmup, repetitions, comm );
+
+        const double minTime = *std::min_element( times.begin(), times.end() );
+        const double maxTime = *std::max_element( times.begin(), times.end() );
+        const double meanTime = std::accumulate( times.begin(), times.end(), 0.0 ) / times.size();
+
+        // strong scaling: the same input on more PEs, weak scaling: the same input per PE
+        double efficiency = -1;
+        if (baseline.count(phase)) {
+            const IndexType baselinePEs = baseline[phase].first;
+            const double baselineTime = baseline[phase].second;
+            efficiency = scaling == "strong" ? (baselineTime*baselinePEs) / (meanTime*numPEs) : baselineTime / meanTime;
+        }
+
+        results << phase << " " << numPEs << " " << omp_get_max_threads() << " " << N << " " << M << " " << times.size() << " "
+                << minTime << " " << meanTime << " " << maxTime << " " << N/meanTime << " " << M/meanTime << " " << efficiency << std::endl;
+
+        // the quality of the last partition, to compare variants of the same phase
+        if (partition.size() == N) {
+            partition.redistribute( inputDist );
+            const ValueType cut = GraphUtils<IndexType,ValueType>::computeCut( graph, partition );
+            const ValueType imbalance = GraphUtils<IndexType,ValueType>::computeImbalance( partition, settings.numBlocks, nodeWeights[0] );
+            results << "# quality " << phase << " cut:" << cut << " imbalance:" << imbalance << std::endl;
+        }
+
+        if (phase == "io" and comm->getRank() == 0) {
+            const std::string ioFile = vm["ioFile"].as<std::string>();
+            std::remove( ioFile.c_str() );
+            std::remove( (ioFile + ".xyz").c_str() );
+        }
+    }
+
+    //---------------------------------------------------------
+    //
+    // report
+    //
+
+    if (comm->getRank() == 0) {
+        std::cout << results.str();
+        if (vm.count("benchFile")) {
+            const std::string benchFile = vm["benchFile"].as<std::string>();
+            std::ofstream outF( benchFile, std::ios::out );
+            if (outF.is_open()) {
+                outF << results.str();
+                std::cout << "Results written to file " << benchFile << std::endl;
+            } else {
+                std::cout << "Could not open file " << benchFile << " results not stored" << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}
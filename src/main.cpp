@@ -25,6 +25,9 @@
 #include "Settings.h"
 #include "Metrics.h"
 #include "GraphUtils.h"
+#include "Telemetry.h"
+#include "Mapping.h"
+#include "StreamingPartition.h"
 #include "parseArgs.h"
 #include "mainHeader.h"
 
@@ -77,6 +80,26 @@ int main(int argc, char** argv) {
 
     printInfo( std::cout, comm, settings);
 
+    //---------------------------------------------------------
+    //
+    // partition a binary coordinate file in slices, no graph or coordinate vectors are built
+    //
+
+    if (settings.streamCoordinates) {
+        const std::string weightFile = vm.count("weightFile") ? vm["weightFile"].as<std::string>() : "-";
+        const std::string partOutFile = settings.outFile + ".part";
+        ITI::StreamingPartition<IndexType, ValueType>::partitionFile( vm["coordFile"].as<std::string>(), weightFile, partOutFile, settings, comm );
+
+        if( settings.telemetryFile!="-" ) {
+            std::ofstream outF;
+            if( comm->getRank()==0 ) {
+                outF.open( settings.telemetryFile, std::ios::out);
+            }
+            ITI::Telemetry::writeJSON( outF, comm, {} );
+        }
+        return 0;
+    }
+
     //---------------------------------------------------------
     //
     // generate or read graph and coordinates
@@ -90,7 +113,7 @@ int main(int argc, char** argv) {
     const IndexType N = readInput<ValueType>( vm, settings, comm, graph, coordinates, nodeWeights );
 
     if( settings.setAutoSettings ){
-        settings = settings.setDefault( graph );
+        settings = settings.setDefault( graph, coordinates );
         if( !settings.isValid )
                return -1;
     }
@@ -237,6 +260,7 @@ int main(int argc, char** argv) {
         }
 
         metricsVec.push_back( Metrics<ValueType>( settings ) );
+        ITI::Telemetry::reset();
 
         std::chrono::time_point<std::chrono::steady_clock> beforePartTime =  std::chrono::steady_clock::now();
 
@@ -302,6 +326,22 @@ int main(int argc, char** argv) {
             }
         }
 
+        if( settings.telemetryFile!="-" ) {
+            std::string fileName = settings.telemetryFile;
+            if (repeatTimes > 1) {
+                fileName += "_r"+ std::to_string(r);
+            }
+            std::ofstream outF;
+            if( comm->getRank()==0 ) {
+                outF.open( fileName, std::ios::out);
+                if(!outF.is_open()) {
+                    std::cout<< "Could not open file " << fileName << " telemetry not stored"<< std::endl;
+                }
+            }
+            std::map<std::string, double> runMetrics( metricsVec[r].MM.begin(), metricsVec[r].MM.end() );
+            ITI::Telemetry::writeJSON( outF, comm, runMetrics );
+        }
+
         comm->synchronize();
     }// repeat loop
 
@@ -312,6 +352,11 @@ int main(int argc, char** argv) {
     // writing results in a file and std::cout
     //
 
+    //the measurements of the last run refine the automatic settings of the next one
+    if( settings.setAutoSettings and not metricsVec.empty() ){
+        settings.storeAutoSettingsProfile( metricsVec.back(), N, comm );
+    }
+
     //aggregate metrics in one struct
     const Metrics<ValueType> aggrMetrics = aggregateVectorMetrics( metricsVec, comm );
 
@@ -372,6 +417,28 @@ int main(int argc, char** argv) {
             ITI::FileIO<IndexType, ValueType>::writePartitionParallel( partition, partOutFile );
         }
 
+        //the position of every vertex inside its block in the local vertex order
+        if( settings.localVertexOrder!="none" ) {
+            const scai::dmemo::DistributionPtr distFromPartition = scai::dmemo::generalDistributionByNewOwners( partition.getDistribution(), partition.getLocalValues() );
+            scai::lama::CSRSparseMatrix<ValueType> blockGraph( graph );
+            blockGraph.redistribute( distFromPartition, noDistPtr );
+            std::vector<scai::lama::DenseVector<ValueType>> blockCoordinates( coordinates );
+            for( IndexType d=0; d<blockCoordinates.size(); d++) {
+                blockCoordinates[d].redistribute( distFromPartition );
+            }
+            std::vector<scai::lama::DenseVector<ValueType>> noWeights;
+
+            const scai::dmemo::DistributionPtr orderDist = ITI::Mapping<IndexType, ValueType>::applyLocalVertexOrder( blockGraph, blockCoordinates, noWeights, settings );
+            std::vector<IndexType> localPositions( orderDist->getLocalSize() );
+            std::iota( localPositions.begin(), localPositions.end(), 0 );
+            scai::lama::DenseVector<IndexType> positions( orderDist, scai::hmemo::HArray<IndexType>( localPositions.size(), localPositions.data() ) );
+            positions.redistribute( partition.getDistributionPtr() );
+
+            const std::string orderOutFile = settings.outFile+".order";
+            ITI::FileIO<IndexType, ValueType>::writePartitionParallel( positions, orderOutFile );
+            PRINT0( "Local vertex order " << settings.localVertexOrder << " written to file " << orderOutFile );
+        }
+
         std::chrono::duration<double> writePartTime =  std::chrono::steady_clock::now() - beforePartWrite;
         if( comm->getRank()==0 ) {
             std::cout << " and last partition of the series in file " << partOutFile << std::endl;
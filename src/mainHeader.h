@@ -103,47 +103,38 @@ IndexType readInput(
 
     }else if(vm.count("generate")) {
 
-        N = settings.numX * settings.numY * settings.numZ;
+        N = settings.numX * settings.numY * (settings.dimensions==3 ? settings.numZ : 1);
 
-        std::vector<ValueType> maxCoord(settings.dimensions); // the max coordinate in every dimensions, used only for 3D
+        std::vector<ValueType> maxCoord(settings.dimensions); // the max coordinate in every dimensions
         maxCoord[0] = settings.numX;
         maxCoord[1] = settings.numY;
         if(settings.dimensions==3) {
             maxCoord[2] = settings.numZ;
         }
 
-        std::vector<IndexType> numPoints(3); // number of points in each dimension, used only for 3D
+        std::vector<IndexType> numPoints(settings.dimensions); // number of points in each dimension
 
         for (IndexType i = 0; i < settings.dimensions; i++) {
             numPoints[i] = maxCoord[i];
         }
 
+        const ValueType meshParameter = settings.meshType==ITI::MeshType::graded ? settings.meshGrading : settings.meshPerturbation;
+
         if( comm->getRank()== 0) {
-            std::cout<< "Generating for dim= "<< settings.dimensions << " and numPoints= "<< settings.numX << ", " << settings.numY << ", "<< settings.numZ << ", in total "<< N << " number of points" << std::endl;
-            std::cout<< "\t\t and maxCoord= "; //<< maxCoord[0] << ", "<< maxCoord[1] << ", " << maxCoord[2]<< std::endl;
+            std::cout<< "Generating " << settings.meshType << " mesh for dim= "<< settings.dimensions << " and numPoints= ";
             for (IndexType i = 0; i < settings.dimensions; i++) {
-                std::cout << maxCoord[i] << ", ";
+                std::cout << numPoints[i] << ", ";
             }
-            std::cout << std::endl;
-        }
-
-        scai::dmemo::DistributionPtr rowDistPtr ( scai::dmemo::Distribution::getDistributionPtr( "BLOCK", comm, N) );
-        scai::dmemo::DistributionPtr noDistPtr(new scai::dmemo::NoDistribution(N));
-        graph = scai::lama::zero<scai::lama::CSRSparseMatrix<ValueType>>( rowDistPtr, noDistPtr );
-
-        scai::dmemo::DistributionPtr coordDist ( scai::dmemo::Distribution::getDistributionPtr( "BLOCK", comm, N) );
-        for(IndexType i=0; i<settings.dimensions; i++) {
-            coords[i].allocate(coordDist);
-            coords[i] = static_cast<ValueType>( 0 );
+            std::cout << "in total "<< N << " number of points" << std::endl;
         }
 
-        // create the adjacency matrix and the coordinates
-        ITI::MeshGenerator<IndexType, ValueType>::createStructuredMesh_dist( graph, coords, maxCoord, numPoints, settings.dimensions );
+        // create the adjacency matrix and the coordinates, both block distributed
+        ITI::MeshGenerator<IndexType, ValueType>::createMesh_dist( graph, coords, maxCoord, numPoints, settings.meshType, comm, meshParameter, static_cast<IndexType>(settings.seed) );
 
         IndexType nodes= graph.getNumRows();
         IndexType edges= graph.getNumValues()/2;
         if(comm->getRank()==0) {
-            std::cout<< "Generated random 3D graph with "<< nodes<< " and "<< edges << " edges."<< std::endl;
+            std::cout<< "Generated " << settings.meshType << " graph with "<< nodes<< " and "<< edges << " edges."<< std::endl;
         }
 
         nodeWeights.resize(1);
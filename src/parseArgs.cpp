@@ -27,15 +27,19 @@ Options populateOptions() {
     ("fileFormat", "Format of graph file, available are AUTO, METIS, ADCRIC and MatrixMarket format. See Readme.md and src/Settings.h for more details.", value<ITI::Format>())
     ("coordFormat", "format of coordinate file: AUTO, METIS, ADCIRC and MATRIXMARKET. See src/Settings.h for more details.", value<ITI::Format>())
     ("numNodeWeights", "Number of node weights to use. If the input graph contains more node weights, only the first ones are used.", value<IndexType>())
+    ("streamCoordinates", "Partition the points of the binary coordinate file --coordFile without reading a graph. The points are processed in memory-mapped slices and the partition is written to --outFile.part; --initialPartition geoSFC uses the Hilbert curve, otherwise balanced k-means on a sample")
+    ("streamingSampleSize", "Number of sampled points from which the streaming partition is computed", value<IndexType>())
+    ("weightFile", "With --streamCoordinates, a binary file with one double weight per point", value<std::string>())
     ("seed", "random seed, default is current time", value<double>()->default_value(std::to_string(time(NULL))))
     //mapping
     ("PEgraphFile", "read communication graph from file", value<std::string>())
     ("blockSizesFile", "file to read the block sizes for every block", value<std::string>() )
     ("mappingRenumbering", "map blocks to PEs using the SFC index of the block's center. This works better when PUs are numbered consecutively." )
+    ("localVertexOrder", "Order the vertices inside every block for cache locality in the solver: none, sfc (Hilbert order) or rcm (reverse Cuthill-McKee on the block). Interface vertices are placed last. With --storePartition, the position of every vertex in its block is written to --outFile.order", value<std::string>())
     //repartitioning
     ("previousPartition", "file of previous partition, used for repartitioning", value<std::string>())
     //multi-level and local refinement
-    ("initialPartition", "Choose initial partitioning method between space-filling curves (geoSFC), balanced k-means (geoKmeans) or the hierarchical version (geoHierKM) and MultiJagged (geoMS). If parmetis or zoltan are installed, you can also choose to partition with them using for example, parMetisGraph or zoltanMJ. For more information, see src/Settings.h file.", value<std::string>())
+    ("initialPartition", "Choose initial partitioning method between space-filling curves (geoSFC), balanced k-means (geoKmeans) or the hierarchical version (geoHierKM) MultiJagged (geoMS) and recursive spectral bisection (geoSpectral). If parmetis or zoltan are installed, you can also choose to partition with them using for example, parMetisGraph or zoltanMJ. For more information, see src/Settings.h file.", value<std::string>())
     ("initialMigration", "The preprocessing step to distribute data before calling the partitioning algorithm", value<std::string>())
     ("noRefinement", "skip local refinement steps")
     ("multiLevelRounds", "Tuning Parameter: How many multi-level rounds with coarsening to perform", value<IndexType>()->default_value(std::to_string(settings.multiLevelRounds)))
@@ -47,8 +51,13 @@ Options populateOptions() {
     ("useDiffusionTieBreaking", "Tuning Parameter: Use diffusion to break ties in Fiduccia-Mattheyes algorithm", value<bool>())
     ("useGeometricTieBreaking", "Tuning Parameter: Use distances to block center for tie breaking", value<bool>())
     ("skipNoGainColors", "Tuning Parameter: Skip Colors that didn't result in a gain in the last global round", value<bool>())
+    ("fmTrials", "Tuning Parameter: Number of independent FM trials per process, run in parallel on the OpenMP threads with different tie breaking (configured, diffusion, random); the best one is kept", value<IndexType>())
+    ("refineCommVolume", "FM local refinement reduces the communication volume, i.e., the number of boundary vertices per neighboring block, instead of the cut")
+    ("minMaxCommVolume", "With refineCommVolume, FM reduces the larger communication volume of the two blocks, i.e., the maximum communication volume")
     ("nnCoarsening", "When coarsening, pick the nearest neighbor based on the euclidean distance", value<bool>())
-    ("localRefAlgo", "With which algorithm to do local refinement.", value<Tool>() )
+    ("localRefAlgo", "With which algorithm to do local refinement: geographer (FM between pairs of blocks), geoLabelProp (size-constrained label propagation, also for k != p) or parMetisRefine.", value<Tool>() )
+    ("labelPropagationRounds", "Tuning parameter: Maximum number of rounds of the label propagation refinement", value<IndexType>())
+    ("topologyAwareRefinement", "Label propagation refinement weights every cut edge with the distance of its blocks in the communication tree (see hierLevels), i.e., it reduces hop-bytes instead of the cut")
     //multisection
     ("bisect", "Used for the multisection method. If set to true the algorithm perfoms bisections (not multisection) until the desired number of parts is reached", value<bool>())
     ("cutsPerDim", "If MultiSection is chosen, then provide d values that define the number of cuts per dimension. You must provide as many numbers as the dimensions separated with commas. For example, --cutsPerDim=3,4,10 for 3 dimensions resulting in 3*4*10=120 blocks", value<std::string>())
@@ -63,10 +72,12 @@ Options populateOptions() {
     ("maxKMeansIterations", "Tuning parameter for K-Means", value<IndexType>())
     ("tightenBounds", "Tuning parameter for K-Means")
     ("erodeInfluence", "Tuning parameter for K-Means, in case of large deltas and imbalances.")
+    ("mixedPrecision", "K-Means stores the coordinates as float to halve the memory traffic; distances and centers are still computed in double")
     // using '/' to separate the lines breaks the output message
     ("hierLevels", "The number of blocks per level. Total number of PEs (=number of leaves) is the product for all hierLevels[i] and there are hierLevels.size() hierarchy levels. Example: --hierLevels 3,4,10 there are 3 levels. In the first one, each node has 3 children, in the next one each node has 4 and in the last, each node has 10. In total 3*4*10= 120 leaves/PEs", value<std::string>())
     //output
     ("outFile", "write result partition into file", value<std::string>())
+    ("telemetryFile", "write timers and counters of every phase, aggregated over all PEs and threads, as JSON into this file; with repeatTimes>1, one file per run", value<std::string>())
     //debug
     ("writeDebugCoordinates", "Write Coordinates of nodes in each block", value<bool>())
     ("writePEgraph", "Write the processor graph to a file", value<bool>())
@@ -82,15 +93,19 @@ Options populateOptions() {
     ("maxCGIterations", "max number of iterations of the CG solver in metrics",  value<IndexType>())
     ("metricsDetail", "no: no metrics, easy:cut, imbalance, communication volume and diameter if possible, all: easy + SpMV time and communication time in SpMV", value<std::string>())
     ("autoSettings", "Set some settings automatically to some values possibly overwriting some user passed parameters. ", value<bool>() )
+    ("autoSettingsProfile", "With --autoSettings, a file with the tuned parameters and measurements of the previous run. It is read to refine the parameters and overwritten after the run", value<std::string>())
     ("partition", "file of partition (typically used by tools/analyzePartition)", value<std::string>())
     //used for the competitors main
     ("outDir", "write result partition into folder", value<std::string>())
     ("tools", "choose which supported tools to use. For multiple tool use comma to separate without spaces. See in Settings::Tools for the supported tools and how to call them.", value<std::string>() )
     //mesh generation
-    ("generate", "generate uniform mesh as input graph")
+    ("generate", "generate a 2D or 3D mesh as input graph, see --meshType")
     ("numX", "Number of points in x dimension of generated graph", value<IndexType>())
     ("numY", "Number of points in y dimension of generated graph", value<IndexType>())
     ("numZ", "Number of points in z dimension of generated graph", value<IndexType>())
+    ("meshType", "Type of generated mesh: structured, perturbed or graded. See Settings::MeshType", value<ITI::MeshType>())
+    ("meshPerturbation", "For perturbed meshes, the maximum displacement of a point as a fraction of the grid spacing, in [0,1)", value<double>())
+    ("meshGrading", "For graded meshes, the exponent of the point spacing", value<double>())
     // exotic test cases
     ("quadTreeFile", "read QuadTree from file", value<std::string>())
     ("useDiffusionCoordinates", "Use coordinates based from diffusive systems instead of loading from file", value<bool>())
@@ -114,18 +129,24 @@ Settings interpretSettings(cxxopts::ParseResult vm) {
         return settings;
     }
 
-    if (vm.count("generate") + vm.count("graphFile") + vm.count("quadTreeFile") != 1) {
+    // streaming partitioning reads only the coordinates
+    if (!vm.count("streamCoordinates") && vm.count("generate") + vm.count("graphFile") + vm.count("quadTreeFile") != 1) {
         std::cout << "Call with --graphFile <input>. Use --help for more parameters." << std::endl;
         settings.isValid = false;
         //return 126;
     }
 
-    if (vm.count("generate") && (vm["dimensions"].as<IndexType>() != 3)) {
-        std::cout << "Mesh generation currently only supported for three dimensions" << std::endl;
+    if (vm.count("generate") && (vm["dimensions"].as<IndexType>() != 2) && (vm["dimensions"].as<IndexType>() != 3)) {
+        std::cout << "Mesh generation currently only supported for two or three dimensions" << std::endl;
         settings.isValid = false;
         //return 126;
     }
 
+    if (vm.count("streamCoordinates") && !(vm.count("coordFile") && vm.count("outFile"))) {
+        std::cout << "Streaming partitioning with --streamCoordinates needs a binary coordinate file --coordFile and an output file --outFile." << std::endl;
+        settings.isValid = false;
+    }
+
     if (vm.count("coordFile") && vm.count("useDiffusionCoords")) {
         std::cout << "Cannot both load coordinates from file with --coordFile or generate them with --useDiffusionCoords." << std::endl;
         settings.isValid = false;
@@ -151,6 +172,10 @@ Settings interpretSettings(cxxopts::ParseResult vm) {
         settings.storeInfo = true;
     }
 
+    if (vm.count("telemetryFile")) {
+        settings.telemetryFile = vm["telemetryFile"].as<std::string>();
+    }
+
     if (vm.count("outDir")) {
         settings.outDir = vm["outDir"].as<std::string>();
         settings.storeInfo = true;
@@ -169,6 +194,16 @@ Settings interpretSettings(cxxopts::ParseResult vm) {
         }
     }
 
+    if( vm.count("localVertexOrder") ) {
+        settings.localVertexOrder = vm["localVertexOrder"].as<std::string>();
+        if( not (settings.localVertexOrder=="none" or settings.localVertexOrder=="sfc" or settings.localVertexOrder=="rcm") ) {
+            if(comm->getRank() ==0 ) {
+                std::cout<<"ERROR: wrong value for parameter localVertexOrder= " << settings.localVertexOrder << ", must be none, sfc or rcm" <<std::endl;
+            }
+            settings.isValid = false;
+        }
+    }
+
     if( vm.count("noComputeDiameter") ) {
         settings.computeDiameter = false;
     } else {
@@ -182,7 +217,12 @@ Settings interpretSettings(cxxopts::ParseResult vm) {
     settings.storePartition = vm.count("storePartition");
     settings.erodeInfluence = vm.count("erodeInfluence");
     settings.tightenBounds = vm.count("tightenBounds");
+    settings.mixedPrecision = vm.count("mixedPrecision");
     settings.noRefinement = vm.count("noRefinement");
+    settings.streamCoordinates = vm.count("streamCoordinates");
+    settings.topologyAwareRefinement = vm.count("topologyAwareRefinement");
+    settings.refineCommVolume = vm.count("refineCommVolume") or vm.count("minMaxCommVolume");
+    settings.minMaxCommVolume = vm.count("minMaxCommVolume");
     settings.useDiffusionCoordinates = vm.count("useDiffusionCoordinates");
     settings.gainOverBalance = vm.count("gainOverBalance");
     settings.useDiffusionTieBreaking = vm.count("useDiffusionTieBreaking");
@@ -193,6 +233,9 @@ Settings interpretSettings(cxxopts::ParseResult vm) {
     settings.writeDebugCoordinates = vm.count("writeDebugCoordinates");
     settings.writePEgraph = vm.count("writePEgraph");
     settings.setAutoSettings = vm.count("autoSettings");
+    if (vm.count("autoSettingsProfile")) {
+        settings.autoSettingsProfile = vm["autoSettingsProfile"].as<std::string>();
+    }
     settings.mappingRenumbering = vm.count("mappingRenumbering");
 
     //28/11/19, deprecate storeInfo parameter. Leaving it as an option for backwards compatibility.    
@@ -219,6 +262,9 @@ Settings interpretSettings(cxxopts::ParseResult vm) {
     if (vm.count("numNodeWeights")) {
         settings.numNodeWeights = vm["numNodeWeights"].as<IndexType>();
     }
+    if (vm.count("streamingSampleSize")) {
+        settings.streamingSampleSize = vm["streamingSampleSize"].as<IndexType>();
+    }
     if (vm.count("dimensions")) {
         settings.dimensions = vm["dimensions"].as<IndexType>();
     }
@@ -231,6 +277,15 @@ Settings interpretSettings(cxxopts::ParseResult vm) {
     if (vm.count("numZ")) {
         settings.numZ = vm["numZ"].as<IndexType>();
     }
+    if (vm.count("meshType")) {
+        settings.meshType = vm["meshType"].as<ITI::MeshType>();
+    }
+    if (vm.count("meshPerturbation")) {
+        settings.meshPerturbation = vm["meshPerturbation"].as<double>();
+    }
+    if (vm.count("meshGrading")) {
+        settings.meshGrading = vm["meshGrading"].as<double>();
+    }
     if (vm.count("numBlocks")) {
         settings.numBlocks = vm["numBlocks"].as<IndexType>();
     } else {
@@ -257,6 +312,9 @@ Settings interpretSettings(cxxopts::ParseResult vm) {
     if (vm.count("multiLevelRounds")) {
         settings.multiLevelRounds = vm["multiLevelRounds"].as<IndexType>();
     }
+    if (vm.count("labelPropagationRounds")) {
+        settings.labelPropagationRounds = vm["labelPropagationRounds"].as<IndexType>();
+    }
     if (vm.count("minBorderNodes")) {
         settings.minBorderNodes = vm["minBorderNodes"].as<IndexType>();
     }
@@ -266,6 +324,9 @@ Settings interpretSettings(cxxopts::ParseResult vm) {
     if (vm.count("stopAfterNoGainRounds")) {
         settings.stopAfterNoGainRounds = vm["stopAfterNoGainRounds"].as<IndexType>();
     }
+    if (vm.count("fmTrials")) {
+        settings.fmTrials = vm["fmTrials"].as<IndexType>();
+    }
     if (vm.count("minGainForNextGlobalRound")) {
         settings.minGainForNextRound = vm["minGainForNextGlobalRound"].as<IndexType>();
     }